@@ -9,6 +9,7 @@
 
 #include "BLEManager.h"
 #include <ArduinoJson.h>
+#include <esp_gap_ble_api.h>
 
 // Note: SensorManager is NOT available on Gateway builds.
 // sendEnvironmentalData() is wrapped in #if DEVICE_ROLE == ROLE_NODE below.
@@ -35,6 +36,7 @@ void BLEManager::init(const char *deviceName)
   pDataChar = pService->createCharacteristic(
       BLEUUID(IMU_DATA_CHAR_UUID), BLECharacteristic::PROPERTY_NOTIFY);
   pDataChar->addDescriptor(new BLE2902());
+  pDataChar->setCallbacks(this); // onStatus(): notify failures
 
   // Config characteristic (read/write)
   pConfigChar = pService->createCharacteristic(
@@ -110,11 +112,46 @@ void BLEManager::onConnect(BLEServer *pServer)
   // No explicit API call needed - the controller handles this transparently
   SAFE_PRINTLN("[BLE] Connection established - PHY auto-negotiated by BLE controller");
   SAFE_PRINTLN("[BLE] (2M PHY used if both devices support BLE 5.0, otherwise 1M PHY)");
+
+  notifyLen = 0;
+  notifyFrames = 0;
+  notifyBudget = SYNC_BUDGET_INITIAL;
+  notifyCredits = 0;
+  cleanIntervals = 0;
+  if (frameRing != nullptr)
+  {
+    frameRing->attach(FRAME_SINK_BLE);
+  }
+}
+
+void BLEManager::onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param)
+{
+  // Connection interval in 1.25 ms units; paces the sync stream
+  uint16_t interval = param->connect.conn_params.interval;
+  connIntervalUs =
+      (interval > 0) ? (uint32_t)interval * 1250 : SYNC_DEFAULT_CONN_INTERVAL_US;
+  SAFE_LOG("[BLE] Connection interval: %lu us\n", (unsigned long)connIntervalUs);
+}
+
+void BLEManager::onMtuChanged(BLEServer *pServer,
+                              esp_ble_gatts_cb_param_t *param)
+{
+  // The peer's MTU exchange usually completes after onConnect()
+  if (param->mtu.mtu >= 23)
+  {
+    negotiatedMtu = param->mtu.mtu;
+    SAFE_LOG("[BLE] MTU updated: %d (max payload: %d bytes)\n", negotiatedMtu,
+             getMaxPayload());
+  }
 }
 
 void BLEManager::onDisconnect(BLEServer *pServer)
 {
   deviceConnected = false;
+  if (frameRing != nullptr)
+  {
+    frameRing->detach(FRAME_SINK_BLE);
+  }
   SAFE_PRINTLN("[BLE] Client disconnected");
   delay(500);
   startAdvertising();
@@ -135,6 +172,164 @@ void BLEManager::sendRawData(const uint8_t *data, size_t len)
   pDataChar->notify();
 }
 
+void BLEManager::onStatus(BLECharacteristic *pCharacteristic, Status s,
+                          uint32_t code)
+{
+  if (pCharacteristic == pDataChar && s != Status::SUCCESS_NOTIFY &&
+      s != Status::SUCCESS_INDICATE)
+  {
+    notifyFailed = true;
+  }
+}
+
+// ============================================================================
+// SYNC STREAM
+// ============================================================================
+
+void BLEManager::setFrameRing(SyncFrameRing *ring)
+{
+  frameRing = ring;
+}
+
+void BLEManager::pumpSyncFrames()
+{
+  if (frameRing == nullptr || !deviceConnected ||
+      !frameRing->isAttached(FRAME_SINK_BLE))
+    return;
+
+  uint32_t nowUs = micros();
+  if (nowUs - intervalStartUs >= connIntervalUs)
+  {
+    // New connection interval: additive increase after a run of intervals
+    // that used their whole budget without a failure
+    if (!intervalCongested && notifyCredits == 0 &&
+        notifyBudget < SYNC_BUDGET_MAX &&
+        ++cleanIntervals >= SYNC_BUDGET_RAMP_INTERVALS)
+    {
+      notifyBudget++;
+      cleanIntervals = 0;
+    }
+    intervalStartUs = nowUs;
+    notifyCredits = notifyBudget;
+    intervalCongested = false;
+  }
+
+  while (notifyCredits > 0)
+  {
+    uint16_t packed = packSyncFrames();
+    if (packed == 0)
+      break;
+
+    // Hold a partial notification for at most one interval to fill it
+    bool full = frameRing->pending(FRAME_SINK_BLE) > 0;
+    if (!full && nowUs - notifyOpenedUs < connIntervalUs)
+      break;
+
+    if (esp_ble_get_cur_sendable_packets_num(pServer->getConnId()) == 0)
+    {
+      syncStats.bufferStalls++;
+      onIntervalCongested();
+      break;
+    }
+    if (!sendPackedNotify())
+    {
+      syncStats.notifyFailures++;
+      onIntervalCongested();
+      break;
+    }
+    notifyCredits--;
+  }
+
+  uint32_t nowMs = millis();
+  if (nowMs - lastStatsLogMs >= SYNC_STATS_LOG_INTERVAL_MS)
+  {
+    uint32_t elapsedMs = nowMs - lastStatsLogMs;
+    SyncStreamStats st;
+    getSyncStreamStats(st);
+    if (st.framesSent != lastStatsFrames && lastStatsLogMs != 0)
+    {
+      SAFE_LOG("[BLE] Sync stream: %lu frames/s %lu B/s budget=%u/%luus "
+               "failures=%lu stalls=%lu dropped=%lu\n",
+               (unsigned long)((st.framesSent - lastStatsFrames) * 1000ULL /
+                               elapsedMs),
+               (unsigned long)((st.bytesSent - lastStatsBytes) * 1000ULL /
+                               elapsedMs),
+               st.notifyBudget, (unsigned long)st.connIntervalUs,
+               (unsigned long)st.notifyFailures,
+               (unsigned long)st.bufferStalls,
+               (unsigned long)st.framesDropped);
+    }
+    lastStatsLogMs = nowMs;
+    lastStatsFrames = st.framesSent;
+    lastStatsBytes = st.bytesSent;
+  }
+}
+
+uint16_t BLEManager::packSyncFrames()
+{
+  uint16_t maxPayload = getMaxPayload();
+  if (maxPayload > sizeof(notifyBuffer))
+    maxPayload = sizeof(notifyBuffer);
+
+  while (notifyLen < maxPayload)
+  {
+    SyncFrameMeta meta;
+    size_t n = frameRing->read(FRAME_SINK_BLE, notifyBuffer + notifyLen,
+                               maxPayload - notifyLen, &meta);
+    if (n == 0)
+    {
+      // Next record can never fit in one notification: drop it, not the link
+      if (notifyLen == 0 && frameRing->skip(FRAME_SINK_BLE))
+        continue;
+      break;
+    }
+    if (notifyLen == 0)
+      notifyOpenedUs = meta.publishedUs;
+    notifyLen += n;
+    notifyFrames++;
+  }
+  return notifyLen;
+}
+
+bool BLEManager::sendPackedNotify()
+{
+  notifyFailed = false;
+  pDataChar->setValue(notifyBuffer, notifyLen);
+  pDataChar->notify();
+  if (notifyFailed)
+    return false; // Keep the packed frames; retried next interval
+
+  syncStats.notifies++;
+  syncStats.framesSent += notifyFrames;
+  syncStats.bytesSent += notifyLen;
+  notifyLen = 0;
+  notifyFrames = 0;
+  return true;
+}
+
+void BLEManager::onIntervalCongested()
+{
+  // Multiplicative decrease; skip the rest of this interval
+  notifyBudget = (notifyBudget > 1) ? notifyBudget / 2 : 1;
+  notifyCredits = 0;
+  cleanIntervals = 0;
+  intervalCongested = true;
+}
+
+void BLEManager::getSyncStreamStats(SyncStreamStats &out) const
+{
+  out = syncStats;
+  out.notifyBudget = notifyBudget;
+  out.connIntervalUs = connIntervalUs;
+  out.framesDropped = 0;
+  if (frameRing != nullptr)
+  {
+    SyncFrameRing::SinkStats sink;
+    frameRing->getSinkStats(FRAME_SINK_BLE, sink);
+    out.framesDropped = sink.framesDropped;
+  }
+}
+
 void BLEManager::onWrite(BLECharacteristic *pCharacteristic)
 {
   // Handle OTA data (binary, no string conversion)
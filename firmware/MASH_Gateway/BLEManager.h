@@ -8,6 +8,17 @@
  *   0x01 - Raw IMU data (accel + gyro floats)
  *   0x02 - Quaternion data (int16 scaled by 16384)
  *   0x03 - Extended quaternion (quaternion + accel + gyro int16)
+ *
+ * SYNC STREAM (Gateway, ENABLE_BLE_SYNC_STREAM): pumpSyncFrames() reads 0x25
+ * frames through the BLE cursor of the shared SyncFrameRing and packs as
+ * many whole [len lo][len hi][frame] records as fit in one notification
+ * (negotiated MTU - 3), the same byte stream as USB and WebSocket.
+ *
+ * Notifications are paced per connection interval: each interval grants
+ * notifyBudget sends, which grows by one after SYNC_BUDGET_RAMP_INTERVALS
+ * clean intervals and halves when a notify fails or the controller has no
+ * free ACL buffers. A failed notification is retried, never split; frames
+ * the link cannot keep up with are lapped in the ring and counted as drops.
  *****************************************************************************/
 
 #ifndef BLE_MANAGER_H
@@ -19,6 +30,7 @@
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
+#include "SyncFrameRing.h"
 
 // Forward declarations
 class SensorManager;
@@ -121,12 +133,43 @@ public:
    */
   void sendOTAProgress(uint32_t current, uint32_t total);
 
+  /**
+   * Source of the sync stream. The BLE sink is attached while a client is
+   * connected.
+   */
+  void setFrameRing(SyncFrameRing *ring);
+
+  /**
+   * Send pending sync frames as MTU-packed notifications, paced to the
+   * connection interval. Non-blocking; call every loop().
+   */
+  void pumpSyncFrames();
+
+  struct SyncStreamStats
+  {
+    uint32_t framesSent;
+    uint32_t bytesSent;
+    uint32_t notifies;
+    uint32_t notifyFailures; // Notify errors (congestion signal)
+    uint32_t bufferStalls;   // Intervals cut short: no free ACL buffers
+    uint32_t framesDropped;  // Lapped in the ring or larger than one MTU
+    uint8_t notifyBudget;    // Current notifications per interval
+    uint32_t connIntervalUs;
+  };
+
+  void getSyncStreamStats(SyncStreamStats &out) const;
+
   // BLEServerCallbacks overrides
   void onConnect(BLEServer *pServer) override;
+  void onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param) override;
   void onDisconnect(BLEServer *pServer) override;
+  void onMtuChanged(BLEServer *pServer,
+                    esp_ble_gatts_cb_param_t *param) override;
 
   // BLECharacteristicCallbacks overrides
   void onWrite(BLECharacteristic *pCharacteristic) override;
+  void onStatus(BLECharacteristic *pCharacteristic, Status s,
+                uint32_t code) override;
 
 private:
   BLEServer *pServer;
@@ -143,6 +186,34 @@ private:
   BLECommandCallback commandCallback;
   BLEOTADataCallback otaDataCallback;
 
+  // Sync stream pacing
+  static constexpr uint32_t SYNC_DEFAULT_CONN_INTERVAL_US = 7500;
+  static constexpr uint8_t SYNC_BUDGET_INITIAL = 2;
+  static constexpr uint8_t SYNC_BUDGET_MAX = 6;
+  static constexpr uint8_t SYNC_BUDGET_RAMP_INTERVALS = 8;
+  static constexpr uint32_t SYNC_STATS_LOG_INTERVAL_MS = 10000;
+
+  SyncFrameRing *frameRing = nullptr;
+  uint8_t notifyBuffer[BLE_MTU_SIZE];
+  uint16_t notifyLen = 0;      // Packed bytes awaiting a notification
+  uint8_t notifyFrames = 0;    // Frames in notifyBuffer
+  uint32_t notifyOpenedUs = 0; // Publish time of the first packed frame
+  bool notifyFailed = false;   // Set by onStatus() inside notify()
+  uint32_t connIntervalUs = SYNC_DEFAULT_CONN_INTERVAL_US;
+  uint32_t intervalStartUs = 0;
+  uint8_t notifyBudget = SYNC_BUDGET_INITIAL;
+  uint8_t notifyCredits = 0;
+  uint8_t cleanIntervals = 0;
+  bool intervalCongested = false;
+  SyncStreamStats syncStats = {};
+  uint32_t lastStatsLogMs = 0;
+  uint32_t lastStatsFrames = 0;
+  uint32_t lastStatsBytes = 0;
+
+  uint16_t packSyncFrames();
+  bool sendPackedNotify();
+  void onIntervalCongested();
+
   // ========================================================================
   // REMOVED: Legacy packet packing methods (0x01/0x02/0x03)
   // ========================================================================
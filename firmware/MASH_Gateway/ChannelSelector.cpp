@@ -0,0 +1,278 @@
+/**
+ * ChannelSelector.cpp - Interference-aware WiFi channel scoring (Gateway)
+ */
+
+// IMPORTANT: Define DEVICE_ROLE before including Config.h
+#define DEVICE_ROLE DEVICE_ROLE_GATEWAY
+
+#include "ChannelSelector.h"
+#include "Config.h"
+#include <WiFi.h>
+#include <esp_wifi.h>
+
+ChannelSelector::ChannelSelector()
+    : activeChannel(ESP_NOW_CHANNEL), lastHopMs(0), surveyIndex(-1),
+      nextSurveyIndex(0), lastSurveyMs(0)
+{
+  memset(stats, 0, sizeof(stats));
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT; i++)
+  {
+    stats[i].channel = tdmaHopChannel(i);
+  }
+}
+
+void ChannelSelector::setActiveChannel(uint8_t channel)
+{
+  if (channel != activeChannel)
+  {
+    lastHopMs = millis();
+  }
+  activeChannel = channel;
+}
+
+ChannelSelector::ChannelStats *ChannelSelector::find(uint8_t channel)
+{
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT; i++)
+  {
+    if (stats[i].channel == channel)
+      return &stats[i];
+  }
+  return nullptr;
+}
+
+const ChannelSelector::ChannelStats *
+ChannelSelector::find(uint8_t channel) const
+{
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT; i++)
+  {
+    if (stats[i].channel == channel)
+      return &stats[i];
+  }
+  return nullptr;
+}
+
+// ============================================================================
+// IDLE-TIME SURVEY
+// ============================================================================
+// One candidate per scan, SURVEY_DWELL_MS passive dwell, so the radio is off
+// the TDMA channel for ~3 beacon periods at most. Callers only allow scans
+// while nothing is being recorded; nodes freewheel through the gap.
+// ============================================================================
+
+bool ChannelSelector::isSurveyComplete() const
+{
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT; i++)
+  {
+    if (!isSurveyFresh(stats[i]))
+      return false;
+  }
+  return true;
+}
+
+bool ChannelSelector::serviceSurvey(bool allowScan, bool surveyAllNow)
+{
+  if (surveyIndex >= 0)
+  {
+    if (WiFi.scanComplete() == WIFI_SCAN_RUNNING)
+      return true;
+    harvestSurvey();
+    return false;
+  }
+
+  if (!allowScan)
+    return false;
+
+  uint32_t now = millis();
+  bool due = surveyAllNow ? !isSurveyComplete()
+                          : (now - lastSurveyMs >= SURVEY_INTERVAL_MS);
+  if (!due)
+    return false;
+
+  // Someone else (WiFiManager network list) is scanning — try later
+  if (WiFi.scanComplete() == WIFI_SCAN_RUNNING)
+    return false;
+
+  uint8_t index = nextSurveyIndex;
+  nextSurveyIndex = (nextSurveyIndex + 1) % TDMA_HOP_CHANNEL_COUNT;
+  lastSurveyMs = now;
+
+  int16_t result = WiFi.scanNetworks(true /* async */, true /* hidden */,
+                                     true /* passive */, SURVEY_DWELL_MS,
+                                     stats[index].channel);
+  if (result == WIFI_SCAN_FAILED)
+    return false;
+
+  surveyIndex = index;
+  return true;
+}
+
+void ChannelSelector::harvestSurvey()
+{
+  ChannelStats &s = stats[surveyIndex];
+  int16_t count = WiFi.scanComplete();
+
+  if (count >= 0)
+  {
+    uint32_t congestion = 0;
+    uint8_t aps = 0;
+    for (int16_t i = 0; i < count; i++)
+    {
+      int32_t distance = abs((int32_t)WiFi.channel(i) - (int32_t)s.channel);
+      int32_t strength = WiFi.RSSI(i) + 90;
+      if (distance >= 5 || strength <= 0)
+        continue;
+      // 20 MHz channels 5 apart do not overlap; closer ones share airtime
+      congestion += (uint32_t)(strength * (5 - distance)) / 5;
+      aps++;
+    }
+    s.congestion = (congestion > 1000) ? 1000 : (uint16_t)congestion;
+    s.apCount = aps;
+    s.surveyedMs = millis() | 1; // 0 is reserved for "never"
+  }
+
+  WiFi.scanDelete();
+  surveyIndex = -1;
+
+  // A scan on an unassociated STA leaves the radio on the scanned channel
+  esp_wifi_set_channel(activeChannel, WIFI_SECOND_CHAN_NONE);
+}
+
+// ============================================================================
+// LINK METRICS (active channel only)
+// ============================================================================
+
+void ChannelSelector::recordDelivery(uint32_t expectedPackets,
+                                     uint32_t receivedPackets)
+{
+  ChannelStats *s = find(activeChannel);
+  if (s == nullptr || expectedPackets == 0)
+    return;
+
+  uint32_t received =
+      (receivedPackets > expectedPackets) ? expectedPackets : receivedPackets;
+  uint16_t loss =
+      (uint16_t)(((expectedPackets - received) * 1000) / expectedPackets);
+
+  s->lossPermille = (s->lossUpdatedMs == 0)
+                        ? loss
+                        : (uint16_t)((3 * (uint32_t)s->lossPermille + loss) / 4);
+  s->lossUpdatedMs = millis() | 1;
+}
+
+void ChannelSelector::recordSignal(int32_t rssiSum, int32_t noiseSum,
+                                   uint32_t count)
+{
+  ChannelStats *s = find(activeChannel);
+  if (s == nullptr || count == 0)
+    return;
+
+  int8_t rssi = (int8_t)(rssiSum / (int32_t)count);
+  int8_t noise = (int8_t)(noiseSum / (int32_t)count);
+  if (!s->signalValid)
+  {
+    s->rssiDbm = rssi;
+    s->noiseFloorDbm = noise;
+    s->signalValid = true;
+  }
+  else
+  {
+    s->rssiDbm = (int8_t)((3 * (int32_t)s->rssiDbm + rssi) / 4);
+    s->noiseFloorDbm = (int8_t)((3 * (int32_t)s->noiseFloorDbm + noise) / 4);
+  }
+}
+
+// ============================================================================
+// SCORING / HOP DECISION
+// ============================================================================
+
+bool ChannelSelector::isSurveyFresh(const ChannelStats &s) const
+{
+  return s.surveyedMs != 0 && millis() - s.surveyedMs < SURVEY_STALE_MS;
+}
+
+uint16_t ChannelSelector::score(const ChannelStats &s) const
+{
+  uint32_t now = millis();
+  uint32_t total = 0;
+
+  if (s.lossUpdatedMs != 0)
+  {
+    uint32_t halvings = (now - s.lossUpdatedMs) / LOSS_HALF_LIFE_MS;
+    total += 2 * ((uint32_t)s.lossPermille >> (halvings > 15 ? 15 : halvings));
+  }
+  if (isSurveyFresh(s))
+  {
+    total += s.congestion;
+  }
+  if (s.signalValid)
+  {
+    int32_t snr = (int32_t)s.rssiDbm - (int32_t)s.noiseFloorDbm;
+    if (snr < 25)
+      total += 4 * (uint32_t)(25 - snr);
+  }
+  return (total > 0xFFFF) ? 0xFFFF : (uint16_t)total;
+}
+
+uint16_t ChannelSelector::getScore(uint8_t channel) const
+{
+  const ChannelStats *s = find(channel);
+  return s ? score(*s) : 0xFFFF;
+}
+
+uint8_t ChannelSelector::evaluate(bool streaming)
+{
+  uint32_t now = millis();
+  if (lastHopMs != 0 && now - lastHopMs < HOP_MIN_DWELL_MS)
+    return 0;
+
+  const ChannelStats *current = find(activeChannel);
+  if (streaming)
+  {
+    // Survey scores alone never justify interrupting a recording
+    if (current == nullptr || current->lossUpdatedMs == 0 ||
+        current->lossPermille < HOP_STREAMING_LOSS_PERMILLE)
+      return 0;
+  }
+  else if (!isSurveyComplete())
+  {
+    return 0;
+  }
+
+  uint16_t currentScore = current ? score(*current) : 0xFFFF;
+  const ChannelStats *best = nullptr;
+  uint16_t bestScore = 0xFFFF;
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT; i++)
+  {
+    // An unmeasured channel would score 0 and look like the best one:
+    // only hop to a candidate whose congestion survey is current
+    if (stats[i].channel == activeChannel || !isSurveyFresh(stats[i]))
+      continue;
+    uint16_t sc = score(stats[i]);
+    if (best == nullptr || sc < bestScore)
+    {
+      best = &stats[i];
+      bestScore = sc;
+    }
+  }
+
+  if (best != nullptr && (uint32_t)bestScore + HOP_SCORE_MARGIN < currentScore)
+    return best->channel;
+  return 0;
+}
+
+void ChannelSelector::logScores() const
+{
+  char line[192];
+  int n = snprintf(line, sizeof(line), "[Channel] active=%u |", activeChannel);
+  for (uint8_t i = 0; i < TDMA_HOP_CHANNEL_COUNT && n > 0 &&
+                      n < (int)sizeof(line);
+       i++)
+  {
+    const ChannelStats &s = stats[i];
+    n += snprintf(line + n, sizeof(line) - n,
+                  " ch%u score=%u loss=%u aps=%u snr=%d |", s.channel,
+                  score(s), s.lossPermille, s.apCount,
+                  s.signalValid ? (int)(s.rssiDbm - s.noiseFloorDbm) : -1);
+  }
+  SAFE_LOG("%s\n", line);
+}
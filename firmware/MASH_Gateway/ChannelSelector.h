@@ -0,0 +1,100 @@
+/**
+ * ChannelSelector.h - Interference-aware WiFi channel scoring (Gateway)
+ *
+ * PURPOSE:
+ * ESP_NOW_CHANNEL is only the boot channel. In gyms and clinics the 2.4 GHz
+ * band is shared with busy WiFi networks, and bursty co-channel traffic
+ * causes losses no buffer can absorb. ChannelSelector keeps a score for each
+ * TDMA hop candidate (tdmaHopChannel) and tells SyncManager when moving to a
+ * different one is worth a coordinated hop.
+ *
+ * INPUTS (per candidate channel):
+ *   - Congestion: passive single-channel surveys (WiFi.scanNetworks) run in
+ *     idle time only (discovery / warm standby, never while streaming).
+ *     Each AP adds max(0, rssi + 90) weighted by channel overlap.
+ *   - Loss: 0x26 delivery ratio observed while operating on the channel
+ *     (EWMA, fed from SyncManager::reportNodeDelivery windows).
+ *   - SNR: mean RSSI and noise floor of received node packets.
+ *
+ * SCORE (lower is better, roughly "permille of expected trouble"):
+ *   score = 2 × loss(decayed) + congestion + 4 × max(0, 25 - SNR)
+ * A channel with no survey inside SURVEY_STALE_MS is never a hop target:
+ * missing inputs would otherwise score as a perfectly clean channel. Long
+ * recordings can therefore outlive their last survey and stop hopping.
+ *
+ * Not thread-safe on its own: SyncManager drives it from update() (Core 0)
+ * and hands over RX signal/delivery snapshots taken under its own locks.
+ */
+
+#ifndef CHANNEL_SELECTOR_H
+#define CHANNEL_SELECTOR_H
+
+#include "../libraries/IMUConnectCore/src/TDMAProtocol.h"
+#include <Arduino.h>
+
+class ChannelSelector
+{
+public:
+  ChannelSelector();
+
+  // Current operating channel (set at boot and after every completed hop)
+  void setActiveChannel(uint8_t channel);
+  uint8_t getActiveChannel() const { return activeChannel; }
+
+  // Idle-time survey. Starts at most one single-channel passive scan per
+  // call and harvests finished results. allowScan=false only harvests.
+  // Returns true while a survey scan is in flight (radio may be off-channel).
+  bool serviceSurvey(bool allowScan, bool surveyAllNow);
+  bool isSurveyComplete() const; // Every candidate surveyed at least once
+
+  // Link metrics for the active channel
+  void recordDelivery(uint32_t expectedPackets, uint32_t receivedPackets);
+  void recordSignal(int32_t rssiSum, int32_t noiseSum, uint32_t count);
+
+  // Returns a candidate channel worth hopping to, or 0 to stay. Only
+  // candidates with a fresh survey are eligible; streaming=true only hops
+  // away from a channel with measured loss.
+  uint8_t evaluate(bool streaming);
+
+  uint16_t getScore(uint8_t channel) const;
+  void logScores() const;
+
+private:
+  struct ChannelStats
+  {
+    uint8_t channel;
+    uint16_t congestion;    // AP-weighted survey score
+    uint8_t apCount;        // APs heard in the last survey
+    uint32_t surveyedMs;    // millis() of the last survey (0 = never)
+    uint16_t lossPermille;  // EWMA delivery loss while active here
+    uint32_t lossUpdatedMs; // millis() of the last loss sample (0 = never)
+    int8_t rssiDbm;         // Mean node RSSI while active here
+    int8_t noiseFloorDbm;   // Mean noise floor while active here
+    bool signalValid;
+  };
+
+  ChannelStats stats[TDMA_HOP_CHANNEL_COUNT];
+  uint8_t activeChannel;
+  uint32_t lastHopMs;
+
+  // Survey state
+  int8_t surveyIndex;       // Candidate being scanned (-1 = idle)
+  uint8_t nextSurveyIndex;  // Round-robin cursor
+  uint32_t lastSurveyMs;
+
+  ChannelStats *find(uint8_t channel);
+  const ChannelStats *find(uint8_t channel) const;
+  bool isSurveyFresh(const ChannelStats &s) const;
+  uint16_t score(const ChannelStats &s) const;
+  void harvestSurvey();
+
+  static const uint32_t SURVEY_DWELL_MS = 60;         // Passive dwell per scan
+  static const uint32_t SURVEY_INTERVAL_MS = 15000;   // Background cadence
+  static const uint32_t SURVEY_STALE_MS = 300000;     // Congestion ages out
+  static const uint32_t LOSS_HALF_LIFE_MS = 300000;   // Old loss forgiven
+  static const uint32_t HOP_MIN_DWELL_MS = 60000;     // No ping-ponging
+  static const uint16_t HOP_SCORE_MARGIN = 40;        // Hysteresis
+  static const uint16_t HOP_STREAMING_LOSS_PERMILLE = 20; // 2% loss
+};
+
+#endif // CHANNEL_SELECTOR_H
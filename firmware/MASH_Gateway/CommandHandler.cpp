@@ -16,6 +16,16 @@
  *   {"cmd": "SET_OUTPUT_MODE", "mode": "quaternion"} - Set output to
  * raw/quaternion
  *   {"cmd": "SET_FILTER_BETA", "beta": 0.1}   - Set Madgwick filter gain
+ *   {"cmd": "GET_LATENCY", "reset": false}    - Pipeline latency p50/p99/p99.9
+ *                                               (+ 0x08 histogram frames)
+ *   {"cmd": "TRACE", "action": "start"}       - Trace ring start/stop/dump
+ *                                               (dump streams 0x07 frames)
+ *   {"cmd": "RECORD", "action": "start"}      - Session recorder start/stop/
+ *                                               status/list/download/delete
+ *                                               (download streams 0x0A frames)
+ *   {"cmd": "GAP_FILL", "mode": "gyro"}       - Synthesize missing sensors in
+ *                                               0x25 frames (off/hold/linear/
+ *                                               gyro)
  *
  * Responses:
  *   {"success": true, "message": "..."}
@@ -42,7 +52,9 @@ CommandHandler::CommandHandler()
       wifiScanCallback(nullptr), startSoftAPCallback(nullptr),
       stopSoftAPCallback(nullptr), getSoftAPStatusCallback(nullptr),
       clearCalibrationCallback(nullptr), tdmaRescanCallback(nullptr),
-      clearTopologyCallback(nullptr) {}
+      clearTopologyCallback(nullptr), latencyStatsCallback(nullptr),
+      traceCallback(nullptr), recorderCallback(nullptr),
+      gapFillCallback(nullptr) {}
 
 String CommandHandler::processCommand(const String &command)
 {
@@ -687,6 +699,70 @@ String CommandHandler::processCommand(const String &command)
     return errorResponse("Clear topology callback not set");
   }
 
+  // GET_LATENCY — capture-to-USB latency percentiles per pipeline stage
+  if (strcmp(cmd, "GET_LATENCY") == 0)
+  {
+    if (latencyStatsCallback)
+    {
+      StaticJsonDocument<1024> response;
+      response["type"] = "latency";
+      latencyStatsCallback(response, doc["reset"] | false);
+      String output;
+      serializeJson(response, output);
+      return output;
+    }
+    return errorResponse("Latency stats callback not set");
+  }
+
+  // TRACE — per-core event trace ring on the Gateway and all Nodes.
+  // "dump" streams the Gateway ring as 0x07 frames; Nodes print theirs
+  // on their own USB console.
+  if (strcmp(cmd, "TRACE") == 0)
+  {
+    const char *action = doc["action"] | "";
+    if (traceCallback)
+    {
+      return traceCallback(action) ? successResponse("Trace command applied")
+                                   : errorResponse("Unknown trace action");
+    }
+    return errorResponse("Trace not enabled in this build");
+  }
+
+  // RECORD — on-gateway session recorder (SessionRecorder.h). "download"
+  // streams the session as 0x0A frames after this response.
+  if (strcmp(cmd, "RECORD") == 0)
+  {
+    const char *action = doc["action"] | "status";
+    if (recorderCallback)
+    {
+      StaticJsonDocument<2048> response;
+      response["type"] = "recorder";
+      response["action"] = action;
+      if (!recorderCallback(action, doc, response))
+      {
+        return errorResponse("Recorder busy or unknown action");
+      }
+      String output;
+      serializeJson(response, output);
+      return output;
+    }
+    return errorResponse("Session recorder not enabled in this build");
+  }
+
+  // GAP_FILL — records for sensors a sync frame leaves without are
+  // synthesized (INTERPOLATED) and corrected later if the real sample
+  // arrives (SyncFrameBuffer.h)
+  if (strcmp(cmd, "GAP_FILL") == 0)
+  {
+    const char *mode = doc["mode"] | "";
+    if (gapFillCallback)
+    {
+      return gapFillCallback(mode) ? successResponse("Gap fill mode set")
+                                   : errorResponse("Unknown gap fill mode");
+    }
+    return errorResponse("Gap fill callback not set");
+  }
+
   // Unknown command
   char msg[100];
   snprintf(msg, sizeof(msg), "Unknown command: %s", cmd);
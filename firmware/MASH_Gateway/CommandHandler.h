@@ -50,6 +50,19 @@ typedef std::function<bool(uint8_t)> AcceptRejectNodeCallback;
 typedef std::function<void(JsonDocument &)> PendingNodesCallback;
 typedef std::function<void(uint8_t)> ExpectedNodesCallback;
 
+// Latency percentiles (response, reset after reading)
+typedef std::function<void(JsonDocument &, bool)> LatencyStatsCallback;
+
+// Trace ring control: "start" | "stop" | "dump" -> accepted
+typedef std::function<bool(const char *)> TraceCallback;
+
+// Sync frame gap fill: "off" | "hold" | "linear" | "gyro" -> applied
+typedef std::function<bool(const char *)> GapFillCallback;
+
+// Session recorder: (action, request, response) -> accepted
+typedef std::function<bool(const char *, JsonDocument &, JsonDocument &)>
+    RecorderCallback;
+
 class CommandHandler
 {
 public:
@@ -136,6 +149,13 @@ public:
   {
     clearTopologyCallback = cb;
   }
+  void setLatencyStatsCallback(LatencyStatsCallback cb)
+  {
+    latencyStatsCallback = cb;
+  }
+  void setTraceCallback(TraceCallback cb) { traceCallback = cb; }
+  void setRecorderCallback(RecorderCallback cb) { recorderCallback = cb; }
+  void setGapFillCallback(GapFillCallback cb) { gapFillCallback = cb; }
 
 private:
   VoidCallback startCallback;
@@ -172,6 +192,10 @@ private:
   PendingNodesCallback pendingNodesCallback;
   ExpectedNodesCallback expectedNodesCallback;
   VoidCallback clearTopologyCallback;
+  LatencyStatsCallback latencyStatsCallback;
+  TraceCallback traceCallback;
+  RecorderCallback recorderCallback;
+  GapFillCallback gapFillCallback;
 
   String successResponse(const char *message);
   String errorResponse(const char *message);
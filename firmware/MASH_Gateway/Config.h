@@ -19,6 +19,38 @@
 // Gateway does not use FreeRTOS sensor task (sensor reads happen on Nodes)
 #define USE_FREERTOS_TASKS 0
 
+// Per-core event trace ring (TraceRing.h). Idle until a TRACE start command;
+// set to 0 to compile every TRACE_EVENT out of the hot paths.
+#define ENABLE_TRACE_RING 1
+
+// Stream 0x25 sync frames over BLE notifications (BLEManager, FRAME_SINK_BLE)
+// for phone hosts without USB. Off by default: BLE shares the radio with
+// ESP-NOW and WiFi, so enable only on builds that need it.
+#ifndef ENABLE_BLE_SYNC_STREAM
+#define ENABLE_BLE_SYNC_STREAM 0
+#endif
+
+// Record 0x25 sync frames on the Gateway (SessionRecorder, FRAME_SINK_RECORDER)
+// for download after the session. Idle until a RECORD start command. Needs
+// an SD card unless SESSION_RECORDER_INTERNAL_FLASH is set.
+#ifndef ENABLE_SESSION_RECORDER
+#define ENABLE_SESSION_RECORDER 0
+#endif
+
+// SD card chip-select for the session recorder (-1: no SD card)
+#ifndef SESSION_RECORDER_SD_CS_PIN
+#define SESSION_RECORDER_SD_CS_PIN -1
+#endif
+
+// Let the recorder fall back to the internal LittleFS data partition. Off by
+// default: every LittleFS erase/program turns the flash cache off on BOTH
+// cores, so ProtocolTask, the ESP-NOW RX path and SerialTxTask stall on every
+// page (datasheet: ~45 ms per 4 KB sector erase, ~1 ms per 256 B program).
+// The longest page write seen is reported as maxPageWriteUs (RECORD status).
+#ifndef SESSION_RECORDER_INTERNAL_FLASH
+#define SESSION_RECORDER_INTERNAL_FLASH 0
+#endif
+
 // Output mode for data streaming (Gateway-specific)
 enum OutputMode
 {
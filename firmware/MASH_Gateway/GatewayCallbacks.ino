@@ -89,7 +89,9 @@ void onStartStreaming()
     if (!isStreaming)
     {
         SAFE_PRINTLN("[Gateway] Streaming enabled");
+        resetLatencyHistograms(); // Latency stats cover one recording
     }
+    resetSerialCreditFlow("streaming started");
     isStreaming = true;
     suppressSerialLogs = true;
     // LED color driven by updateGatewayLED() — no manual set here
@@ -161,6 +163,7 @@ void onStopStreaming()
     suppressSerialLogs = false;
     // LED color driven by updateGatewayLED() — no manual set here
     SAFE_PRINTLN("[Gateway] Streaming disabled");
+    resetSerialCreditFlow("streaming stopped");
 
     syncManager.setStreaming(false);
     pendingSyncReset = false; // Cancel any pending deferred sync reset
@@ -263,6 +266,8 @@ void onGetSyncStatus(JsonDocument &response)
     // Node registry
     uint8_t nodeCount = syncManager.getRegisteredNodeCount();
     response["nodeCount"] = nodeCount;
+    // Bumps on every topology change; compactBase values below belong to it
+    response["routeGeneration"] = syncManager.getSensorRouteGeneration();
 
     JsonArray nodes = response["nodes"].to<JsonArray>();
     const TDMANodeInfo *regNodes = syncManager.getRegisteredNodes();
@@ -305,13 +310,19 @@ void onGetSyncStatus(JsonDocument &response)
     sfb["dropped"] = syncFrameBuffer.getDroppedFrames();
     sfb["incomplete"] = syncFrameBuffer.getIncompleteFrames();
     sfb["trueSyncRate"] = syncFrameBuffer.getTrueSyncRate();
+    sfb["gapFillMode"] = syncFrameBuffer.getGapFillMode();
+    sfb["gapFilled"] = syncFrameBuffer.getGapFilledRecords();
+    sfb["corrections"] = syncFrameBuffer.getCorrectionRecords();
 
     // Serial TX health
     JsonObject tx = response["serialTx"].to<JsonObject>();
     tx["frames"] = serialTxFrameCount;
     tx["drops"] = serialTxDropCount;
     tx["queueFree"] = serialTxQueue ? uxQueueSpacesAvailable(serialTxQueue) : 0;
-    tx["paused"] = serialTxPaused;
+    tx["paused"] = serialFlowMode != TELEMETRY_FLOW_OPEN &&
+                   serialCreditBalance() == 0;
+    tx["credits"] = serialCreditBalance();
+    tx["flowMode"] = serialFlowMode;
 
     // ============================================================================
     // Composite readiness assessment
@@ -542,12 +553,202 @@ void onSetZupt(float gyroThresh, float accelThresh, int minFrames)
     Serial.println("[Gateway] ZUPT command received (ignored)");
 }
 
+// ============================================================================
+// End-to-End Latency
+// ============================================================================
+// Percentiles per pipeline stage (µs, or bytes for serialBatchBytes; highest
+// value in the percentile's bucket, so within 12.5%). The full histograms go
+// out as 0x08 frames at the same time for host-side analysis.
+// ============================================================================
+
+void onGetLatency(JsonDocument &response, bool reset)
+{
+    static const char *const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+        "air",      "ingestQueue", "syncWait",        "serialQueue",
+        "endToEnd", "serialFlush", "serialBatchBytes", "addSampleCycles"};
+
+    JsonArray stages = response["stages"].to<JsonArray>();
+    for (uint8_t s = 0; s < LATENCY_STAGE_COUNT; s++)
+    {
+        LatencyHistogram snapshot;
+        portENTER_CRITICAL(&latencyHistLock);
+        memcpy(&snapshot, &latencyHist[s], sizeof(snapshot));
+        portEXIT_CRITICAL(&latencyHistLock);
+
+        JsonObject stage = stages.add<JsonObject>();
+        stage["stage"] = STAGE_NAMES[s];
+        stage["count"] = snapshot.total;
+        stage["p50"] = snapshot.percentileUs(500);
+        stage["p99"] = snapshot.percentileUs(990);
+        stage["p999"] = snapshot.percentileUs(999);
+        stage["max"] = snapshot.maxUs;
+    }
+
+    emitLatencyHistograms();
+    if (reset)
+    {
+        resetLatencyHistograms();
+    }
+    response["reset"] = reset;
+}
+
+// ============================================================================
+// Sync Frame Gap Fill
+// ============================================================================
+
+bool onGapFillCommand(const char *mode)
+{
+    static const char *const MODE_NAMES[] = {"off", "hold", "linear", "gyro"};
+    for (uint8_t m = GAP_FILL_OFF; m <= GAP_FILL_GYRO; m++)
+    {
+        if (strcmp(mode, MODE_NAMES[m]) == 0)
+        {
+            syncFrameBuffer.setGapFillMode(m);
+            return true;
+        }
+    }
+    return false;
+}
+
+#if ENABLE_TRACE_RING
+// ============================================================================
+// Trace Ring Control
+// ============================================================================
+// start/stop apply locally and are broadcast to every Node (CMD_TRACE_CONTROL)
+// so all rings cover the same window. dump streams the Gateway ring as 0x07
+// frames on USB; Nodes print theirs on their own console (no ESP-NOW bulk
+// transfer while TDMA is running).
+// ============================================================================
+
+bool onTraceCommand(const char *action)
+{
+    if (strcmp(action, "start") == 0)
+    {
+        syncManager.sendNodeCommand(CMD_TRACE_CONTROL, TRACE_CONTROL_START, 0xFF);
+        traceRing.start();
+        return true;
+    }
+    if (strcmp(action, "stop") == 0)
+    {
+        traceRing.stop();
+        syncManager.sendNodeCommand(CMD_TRACE_CONTROL, TRACE_CONTROL_STOP, 0xFF);
+        return true;
+    }
+    if (strcmp(action, "dump") == 0)
+    {
+        syncManager.sendNodeCommand(CMD_TRACE_CONTROL, TRACE_CONTROL_DUMP, 0xFF);
+        uint32_t sent = traceRing.dump(TRACE_ROLE_GATEWAY, 0, writeTraceChunk,
+                                       nullptr);
+        SAFE_LOG("[Trace] Dumped %lu events\n", (unsigned long)sent);
+        return true;
+    }
+    return false;
+}
+#endif
+
+#if ENABLE_SESSION_RECORDER
+// ============================================================================
+// Session Recorder Control
+// ============================================================================
+// start/stop/download are carried out by the recorder task; the response
+// only says the request was accepted. Poll "status" (or watch for the empty
+// 0x0A piece that ends a download) to see it complete.
+// ============================================================================
+
+bool onRecorderCommand(const char *action, JsonDocument &request,
+                       JsonDocument &response)
+{
+    if (strcmp(action, "start") == 0)
+    {
+        return sessionRecorder.start();
+    }
+    if (strcmp(action, "stop") == 0)
+    {
+        return sessionRecorder.stop();
+    }
+    if (strcmp(action, "status") == 0)
+    {
+        sessionRecorder.getStatus(response);
+        return true;
+    }
+    if (strcmp(action, "list") == 0)
+    {
+        sessionRecorder.listSessions(response.createNestedArray("sessions"));
+        return true;
+    }
+
+    uint16_t session = request["session"] | 0;
+    response["session"] = session;
+    if (strcmp(action, "download") == 0)
+    {
+        return sessionRecorder.download(session, request["chunk"] | 0,
+                                        request["count"] | 0);
+    }
+    if (strcmp(action, "delete") == 0)
+    {
+        return sessionRecorder.remove(session);
+    }
+    return false;
+}
+#endif
+
 // ============================================================================
 // USB Serial Command Processing
 // ============================================================================
 
+// Add host credits (sync frames), keeping the balance bounded so a host that
+// over-grants cannot defeat flow control later. A zero-frame CREDIT only
+// keeps credit mode alive (SERIAL_CREDIT_IDLE_OPEN_MS).
+static void grantSerialCredits(uint32_t frames)
+{
+    serialLastCreditMs = millis();
+    if (!serialCreditMode)
+        serialCreditGranted = serialCreditUsed; // Fresh balance
+    uint32_t balance = serialCreditBalance();
+    if (balance >= SERIAL_CREDIT_MAX_BALANCE)
+    {
+        frames = 0;
+    }
+    else if (frames > SERIAL_CREDIT_MAX_BALANCE - balance)
+    {
+        frames = SERIAL_CREDIT_MAX_BALANCE - balance;
+    }
+    serialCreditGranted += frames;
+    serialCreditMode = true;
+    wakeSerialTx();
+}
+
+// Switch USB framing (SerialFraming.h). The ack is always written in legacy
+// framing, so a host that lost track of the mode (gateway reset, reconnect)
+// still finds it; in COBS mode it is preceded by a delimiter to close any
+// partial COBS frame. Every write after the ack uses the new framing.
+static void setSerialFraming(uint8_t mode)
+{
+    char json[48];
+    const int jsonLen = snprintf(json, sizeof(json),
+                                 "{\"type\":\"framing\",\"mode\":\"%s\"}",
+                                 mode == SERIAL_FRAMING_COBS ? "cobs" : "legacy");
+    uint8_t record[1 + 3 + sizeof(json)];
+    record[0] = SERIAL_COBS_DELIMITER;
+    record[1] = (uint8_t)(jsonLen + 1);
+    record[2] = 0;
+    record[3] = 0x06;
+    memcpy(record + 4, json, jsonLen);
+
+    if (serialWriteMutex != nullptr)
+        xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
+    if (serialFramingMode == SERIAL_FRAMING_COBS)
+        ::Serial.write(record, 4 + jsonLen);
+    else
+        ::Serial.write(record + 1, 3 + jsonLen);
+    serialFramingMode = mode;
+    if (serialWriteMutex != nullptr)
+        xSemaphoreGive(serialWriteMutex);
+}
+
 static void processSerialCommands()
 {
+    serviceSerialCreditFlow();
     while (Serial.available() > 0)
     {
         const char c = static_cast<char>(Serial.read());
@@ -558,19 +759,36 @@ static void processSerialCommands()
             cmd.trim();
             if (cmd.length() > 0)
             {
-                // OPP-7: Fast-path PAUSE/RESUME flow control (skip JSON parsing)
-                if (cmd.indexOf("\"PAUSE\"") >= 0 || cmd == "PAUSE")
+                // Fast-path flow control (skip JSON parsing). CREDIT is
+                // sent continuously while streaming and gets no response.
+                if (cmd.indexOf("\"CREDIT\"") >= 0)
+                {
+                    int framesAt = cmd.indexOf("\"frames\":");
+                    if (framesAt >= 0)
+                    {
+                        grantSerialCredits(
+                            strtoul(cmd.c_str() + framesAt + 9, nullptr, 10));
+                    }
+                }
+                else if (cmd.indexOf("\"FRAMING\"") >= 0)
+                {
+                    setSerialFraming(cmd.indexOf("\"cobs\"") >= 0
+                                         ? SERIAL_FRAMING_COBS
+                                         : SERIAL_FRAMING_LEGACY);
+                }
+                else if (cmd.indexOf("\"PAUSE\"") >= 0 || cmd == "PAUSE")
                 {
-                    serialTxPaused = true;
-                    serialPauseCount++;
-                    SAFE_LOG("[FlowCtrl] PAUSED (count=%lu)\n", serialPauseCount);
+                    // Legacy: credit mode with nothing granted
+                    serialCreditGranted = serialCreditUsed;
+                    serialCreditMode = true;
+                    serialLastCreditMs = millis();
+                    SAFE_PRINTLN("[FlowCtrl] PAUSED (credit mode, 0 credits)");
                     enqueueJsonFrame("{\"type\":\"flow\",\"status\":\"paused\"}");
                 }
                 else if (cmd.indexOf("\"RESUME\"") >= 0 || cmd == "RESUME")
                 {
-                    serialTxPaused = false;
-                    serialResumeCount++;
-                    SAFE_LOG("[FlowCtrl] RESUMED (count=%lu)\n", serialResumeCount);
+                    serialCreditMode = false;
+                    SAFE_PRINTLN("[FlowCtrl] RESUMED (open)");
                     enqueueJsonFrame("{\"type\":\"flow\",\"status\":\"resumed\"}");
                 }
                 else
@@ -6,9 +6,10 @@
  *
  * Contents:
  *   - decodeNodeData()       — 0x26 node data packet decoder
- *   - enqueueSerialFrame()   — length-prefixed frame enqueue
+ *   - enqueueSerialFrame()   — length-prefixed frame enqueue (non-sync)
  *   - enqueueJsonFrame()     — JSON command response enqueue
- *   - logJson()              — structured log during streaming
+ *   - logTelemetry()         — binary (0x09) log line during streaming
+ *   - emit*Telemetry()       — periodic binary diagnostics (0x09)
  *   - SerialTxTask()         — USB Serial TX drain (Core 0)
  *   - DataIngestionTask()    — ESP-NOW → SyncFrameBuffer (Core 1)
  *   - ProtocolTask()         — Beacon TX + Sync Frame emission (Core 0)
@@ -18,6 +19,8 @@
 // NODE DATA DECODER (0x26)
 // ============================================================================
 // Decodes 0x26 packets from Nodes and extracts absolute sensor samples.
+// Both sample layouts are accepted: raw TDMABatchedSensorData records, and
+// the lossless delta/varint block flagged NODE_DATA_FLAG_COMPRESSED.
 // ============================================================================
 
 // Decode Node data packet (0x26) to absolute values
@@ -71,6 +74,19 @@ uint8_t decodeNodeData(
         return 0;
     }
 
+    // Compressed sample block (NodeDataCodec.h) — all-or-nothing decode
+    if (flags & NODE_DATA_FLAG_COMPRESSED)
+    {
+        size_t consumed = 0;
+        if (!decodeCompressedSamples(srcData, availableData, outputSamples,
+                                     sampleCount, sensorCount, maxSensors,
+                                     consumed))
+        {
+            return 0;
+        }
+        return sampleCount;
+    }
+
     // All samples are absolute - copy with bounds checking
     uint8_t validSamples = 0;
     for (uint8_t s = 0; s < sampleCount; s++)
@@ -113,6 +129,70 @@ uint8_t decodeNodeData(
 // ============================================================================
 
 static constexpr uint8_t PACKET_JSON = 0x06;
+static constexpr uint8_t PACKET_TRACE = 0x07; // TraceRing dump chunk
+
+// COBS output buffer: a coalesced batch is encoded in pieces of this size,
+// each ending on a frame boundary. Fits any queue-sized record.
+static constexpr size_t SERIAL_COBS_CHUNK_SIZE =
+    1 + SERIAL_COBS_MAX_ENCODED(SERIAL_FRAME_BUFFER_SIZE) * 2;
+
+// Write a [len lo][len hi][frame] record stream in the active USB framing.
+// Caller holds serialWriteMutex (the encode buffer is shared).
+static void writeSerialRecordsLocked(const uint8_t *records, size_t len)
+{
+    if (serialFramingMode != SERIAL_FRAMING_COBS)
+    {
+        ::Serial.write(records, len);
+        return;
+    }
+
+    static uint8_t encoded[SERIAL_COBS_CHUNK_SIZE];
+    size_t offset = 0;
+    while (offset < len)
+    {
+        size_t consumed = 0;
+        size_t n = cobsEncodeRecords(records + offset, len - offset, encoded,
+                                     sizeof(encoded), consumed);
+        if (consumed == 0)
+        {
+            if (len - offset < 2)
+            {
+                return;
+            }
+            // Oversized record (large JSON response): encode it on its own
+            size_t frameLen = records[offset] | (records[offset + 1] << 8);
+            size_t maxLen = 1 + SERIAL_COBS_MAX_ENCODED(frameLen);
+            uint8_t *big = (uint8_t *)malloc(maxLen);
+            if (big == nullptr)
+            {
+                serialTxDropCount++;
+                return;
+            }
+            n = cobsEncodeRecords(records + offset, 2 + frameLen, big, maxLen,
+                                  consumed);
+            ::Serial.write(big, n);
+            free(big);
+            if (consumed == 0)
+            {
+                return;
+            }
+        }
+        else
+        {
+            ::Serial.write(encoded, n);
+        }
+        offset += consumed;
+    }
+}
+
+static void writeSerialRecords(const uint8_t *records, size_t len)
+{
+    if (serialWriteMutex != nullptr)
+        xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
+    writeSerialRecordsLocked(records, len);
+    if (serialWriteMutex != nullptr)
+        xSemaphoreGive(serialWriteMutex);
+}
 
 // Enqueue a complete length-prefixed frame as a single atomic unit.
 // Note: Pause gating is intentionally disabled during bring-up to avoid
@@ -130,7 +210,8 @@ static inline void enqueueSerialFrame(const uint8_t *frame, size_t len,
         {
             if (isStreaming)
             {
-                logJson("error", "Serial frame too large for buffer");
+                logTelemetry(TELEMETRY_LOG_ERROR,
+                             "Serial frame too large for buffer");
             }
             else
             {
@@ -153,13 +234,14 @@ static inline void enqueueSerialFrame(const uint8_t *frame, size_t len,
     if (xQueueSend(serialTxQueue, &f, 0) != pdTRUE)
     {
         serialTxDropCount++;
+        return;
     }
+    wakeSerialTx();
 }
 
-static inline void enqueueJsonFrame(const String &json)
+static inline void enqueueJsonFrame(const char *json, size_t jsonLen)
 {
-    const size_t jsonLen = json.length();
-    if (jsonLen == 0)
+    if (json == nullptr || jsonLen == 0)
     {
         return;
     }
@@ -172,7 +254,7 @@ static inline void enqueueJsonFrame(const String &json)
         // Normal path: fits in queue buffer
         uint8_t buffer[SERIAL_FRAME_BUFFER_SIZE];
         buffer[0] = PACKET_JSON;
-        memcpy(buffer + 1, json.c_str(), jsonLen);
+        memcpy(buffer + 1, json, jsonLen);
         enqueueSerialFrame(buffer, frameLen,
                            true); // OPP-7: Always send command responses
         return;
@@ -193,109 +275,571 @@ static inline void enqueueJsonFrame(const String &json)
     buf[0] = (uint8_t)(frameLen & 0xFF);
     buf[1] = (uint8_t)((frameLen >> 8) & 0xFF);
     buf[2] = PACKET_JSON;
-    memcpy(buf + 3, json.c_str(), jsonLen);
+    memcpy(buf + 3, json, jsonLen);
 
-    if (serialWriteMutex != nullptr)
-        xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
-    ::Serial.write(buf, totalLen);
-    if (serialWriteMutex != nullptr)
-        xSemaphoreGive(serialWriteMutex);
+    writeSerialRecords(buf, totalLen);
 
     free(buf);
 }
 
-static void logJson(const char *level, const char *message)
+static inline void enqueueJsonFrame(const char *json)
+{
+    enqueueJsonFrame(json, json ? strlen(json) : 0);
+}
+
+static inline void enqueueJsonFrame(const String &json)
+{
+    enqueueJsonFrame(json.c_str(), json.length());
+}
+
+// ============================================================================
+// Latency histograms
+// ============================================================================
+
+static inline void recordHistogramValue(LatencyStage stage, uint32_t value)
+{
+    portENTER_CRITICAL(&latencyHistLock);
+    latencyHist[stage].record(value);
+    portEXIT_CRITICAL(&latencyHistLock);
+}
+
+static inline void recordLatency(LatencyStage stage, uint32_t fromUs,
+                                 uint32_t toUs)
+{
+    // Wrap-safe difference; a sample stamped slightly "in the future" (sync
+    // offset noise) counts as zero latency rather than ~71 minutes
+    int32_t delta = (int32_t)(toUs - fromUs);
+    recordHistogramValue(stage, delta > 0 ? (uint32_t)delta : 0);
+}
+
+static void resetLatencyHistograms()
+{
+    portENTER_CRITICAL(&latencyHistLock);
+    for (uint8_t s = 0; s < LATENCY_STAGE_COUNT; s++)
+    {
+        latencyHist[s].reset();
+    }
+    portEXIT_CRITICAL(&latencyHistLock);
+}
+
+// Queue every stage as 0x08 packets (occupied bucket range only; an empty
+// stage still sends one count=0 packet so the host sees every stage)
+static void emitLatencyHistograms()
+{
+    LatencyHistogram snapshot;
+    uint8_t packet[LATENCY_WIRE_HEADER_SIZE + LATENCY_WIRE_MAX_BUCKETS * 4];
+
+    for (uint8_t s = 0; s < LATENCY_STAGE_COUNT; s++)
+    {
+        portENTER_CRITICAL(&latencyHistLock);
+        memcpy(&snapshot, &latencyHist[s], sizeof(snapshot));
+        portEXIT_CRITICAL(&latencyHistLock);
+
+        uint8_t first = 0, last = 0;
+        snapshot.occupiedRange(first, last);
+        uint16_t next = first;
+        do
+        {
+            uint16_t n = (uint16_t)(last - next + 1);
+            if (n > LATENCY_WIRE_MAX_BUCKETS)
+                n = LATENCY_WIRE_MAX_BUCKETS;
+            size_t len = snapshot.writeWirePacket(s, (uint8_t)next, (uint8_t)n,
+                                                  packet, sizeof(packet));
+            if (len > 0)
+                enqueueSerialFrame(packet, len, true);
+            next += n;
+        } while (next <= last);
+    }
+}
+
+#if ENABLE_TRACE_RING
+// TraceRing dump sink: one chunk per 0x07 frame, written directly like the
+// oversized JSON path so a full dump never competes for serialTxQueue slots.
+static void writeTraceChunk(const uint8_t *chunk, size_t len, void *ctx)
+{
+    (void)ctx;
+    uint8_t buf[3 + TRACE_DUMP_CHUNK_MAX];
+    const size_t frameLen = len + 1;
+    buf[0] = (uint8_t)(frameLen & 0xFF);
+    buf[1] = (uint8_t)((frameLen >> 8) & 0xFF);
+    buf[2] = PACKET_TRACE;
+    memcpy(buf + 3, chunk, len);
+
+    writeSerialRecords(buf, len + 3);
+}
+#endif
+
+// ============================================================================
+// Binary telemetry (0x09, GatewayTelemetry.h)
+// ============================================================================
+// Packets are built on the caller's stack and go through the normal serial
+// queue, so periodic diagnostics never allocate while streaming.
+// ============================================================================
+
+static void logTelemetry(TelemetryLogLevel level, const char *message)
 {
     if (!isStreaming)
     {
-        Serial.printf("[%s] %s\n", level, message);
+        static const char *const LEVEL_NAMES[] = {"info", "warn", "error"};
+        Serial.printf("[%s] %s\n",
+                      level <= TELEMETRY_LOG_ERROR ? LEVEL_NAMES[level] : "log",
+                      message);
         return;
     }
 
-    StaticJsonDocument<256> doc;
-    doc["type"] = "log";
-    doc["level"] = level;
-    doc["message"] = message;
-    doc["ts"] = millis();
+    TelemetryLog packet;
+    size_t len = telemetryFormatLog(packet, level, message, millis());
+    enqueueSerialFrame((const uint8_t *)&packet, len, false);
+}
+
+static inline uint16_t clampTelemetryCount(uint32_t value)
+{
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+static void emitSerialTxTelemetry(uint32_t dropsDelta)
+{
+    TelemetrySerialTx packet;
+    telemetryBegin(packet.header, TELEMETRY_KIND_SERIAL_TX, millis());
+    packet.frames = serialTxFrameCount;
+    packet.batches = serialTxBatchCount;
+    packet.drops = serialTxDropCount;
+    packet.dropsDelta = dropsDelta;
+    packet.queueFree = (uint8_t)uxQueueSpacesAvailable(serialTxQueue);
+    packet.queueSize = (uint8_t)SERIAL_TX_QUEUE_SIZE;
+    packet.freeHeapKB = (uint16_t)(ESP.getFreeHeap() / 1024);
+    packet.largestFreeBlockKB = (uint16_t)(ESP.getMaxAllocHeap() / 1024);
+    packet.flags = (serialQueueOverloaded ? TELEMETRY_SERIAL_FLAG_OVERLOADED : 0) |
+                   (isStreaming ? TELEMETRY_SERIAL_FLAG_STREAMING : 0);
+    packet.credits = serialCreditBalance();
+    packet.flowMode = serialFlowMode;
+    packet.batchBudget = (uint16_t)serialBatchBudget;
+    packet.drainBytesPerMs = clampTelemetryCount(serialDrainBytesPerMs);
+    packet.creditsUsed = serialCreditUsed;
+    enqueueSerialFrame((const uint8_t *)&packet, sizeof(packet), false);
+}
+
+static void formatFlowTelemetry(TelemetryFlow &packet, TelemetryFlowEvent event,
+                                uint32_t gapFrames, uint32_t gapFromUs,
+                                uint32_t gapToUs)
+{
+    telemetryBegin(packet.header, TELEMETRY_KIND_FLOW, millis());
+    packet.event = event;
+    packet.mode = serialFlowMode;
+    packet.credits = serialCreditBalance();
+    packet.gapFrames = gapFrames;
+    packet.gapFromUs = gapFromUs;
+    packet.gapToUs = gapToUs;
+}
 
-    String output;
-    serializeJson(doc, output);
-    enqueueJsonFrame(output);
+static void emitSyncTelemetry()
+{
+    TelemetrySync packet;
+    telemetryBegin(packet.header, TELEMETRY_KIND_SYNC, millis());
+    packet.framesCompleted = syncFrameBuffer.getCompletedFrames();
+    packet.framesTrulyComplete = syncFrameBuffer.getTrulyCompleteFrames();
+    packet.framesPartial = syncFrameBuffer.getPartialRecoveryFrames();
+    packet.framesIncomplete = syncFrameBuffer.getIncompleteFrames();
+    packet.framesDropped = syncFrameBuffer.getDroppedFrames();
+    uint32_t rated = packet.framesTrulyComplete + packet.framesPartial;
+    packet.trueSyncRatePermille =
+        rated ? (uint16_t)(((uint64_t)packet.framesTrulyComplete * 1000) / rated)
+              : 0;
+    packet.expectedSensors = syncFrameBuffer.getExpectedSensorCount();
+    packet.effectiveSensors = syncFrameBuffer.getEffectiveSensorCount();
+    packet.syncFramesEmitted = syncFrameEmitCount;
+    packet.beaconsSent = beaconTxCount;
+    packet.espNowRxProcessed = espNowRxProcessedCount;
+    packet.espNowRxDropped = espNowRxDropCount;
+    packet.rxQueueFree = (uint8_t)uxQueueSpacesAvailable(espNowRxQueue);
+    packet.rxQueueSize = (uint8_t)ESPNOW_RX_QUEUE_SIZE;
+    enqueueSerialFrame((const uint8_t *)&packet, sizeof(packet), false);
 }
 
 // ============================================================================
 // SerialTxTask - Batched USB Serial Drain (Core 0)
 // ============================================================================
 
+// SyncFrames in the coalescing buffer, closed out once Serial.write() returns
+struct SerialBatchLatency
+{
+    uint32_t publishedUs[SERIAL_MAX_BATCH_FRAMES];
+    uint32_t sampleTimestampUs[SERIAL_MAX_BATCH_FRAMES];
+    uint8_t count;
+    bool open;
+    uint32_t openedUs; // First record copied into the batch
+
+    void opened()
+    {
+        if (!open)
+        {
+            open = true;
+            openedUs = micros();
+        }
+    }
+
+    bool full() const { return count >= SERIAL_MAX_BATCH_FRAMES; }
+
+    void add(const SyncFrameMeta &meta)
+    {
+        if (count < SERIAL_MAX_BATCH_FRAMES)
+        {
+            publishedUs[count] = meta.publishedUs;
+            sampleTimestampUs[count] = meta.sampleTimestampUs;
+            count++;
+        }
+    }
+
+    void written(size_t bytes)
+    {
+        uint32_t nowUs = micros();
+        for (uint8_t i = 0; i < count; i++)
+        {
+            recordLatency(LATENCY_STAGE_SERIAL_QUEUE, publishedUs[i], nowUs);
+            recordLatency(LATENCY_STAGE_END_TO_END, sampleTimestampUs[i], nowUs);
+        }
+        if (open)
+        {
+            recordLatency(LATENCY_STAGE_SERIAL_FLUSH, openedUs, nowUs);
+        }
+        recordHistogramValue(LATENCY_STAGE_SERIAL_BATCH, (uint32_t)bytes);
+        count = 0;
+        open = false;
+    }
+};
+
+// USB drain rate from the CDC TX buffer: free space grows by exactly what
+// the host has read. Serial.write() returning says nothing about that (it
+// only copies into the buffer), so the rate is the free-space gained
+// between the end of one batch write and the start of the next. Samples
+// are only taken while the buffer stayed non-empty; once it runs dry the
+// host outpaced us and the interval is partly idle.
+struct SerialDrainSampler
+{
+    bool valid;
+    int freeAfterWrite; // availableForWrite() when the last write returned
+    uint32_t afterUs;   // ... and when
+    int capacity;       // Largest free space seen (empty buffer)
+};
+static SerialDrainSampler serialDrain = {};
+static constexpr uint32_t SERIAL_DRAIN_MIN_SAMPLE_US = 1000; // 1 USB frame
+
+// Fold one interval into the USB drain-rate estimate and resize the batch
+// budget
+static void updateSerialDrainRate(size_t bytes, uint32_t intervalUs)
+{
+    uint32_t rate = (uint32_t)((uint64_t)bytes * 1000 / intervalUs);
+    serialDrainBytesPerMs = (serialDrainBytesPerMs * 3 + rate) / 4;
+
+    uint32_t budget = serialDrainBytesPerMs * SERIAL_BATCH_TARGET_US / 1000;
+    if (budget < SERIAL_BATCH_MIN_BYTES)
+        budget = SERIAL_BATCH_MIN_BYTES;
+    if (budget > SERIAL_BATCH_MAX_BYTES)
+        budget = SERIAL_BATCH_MAX_BYTES;
+    serialBatchBudget = budget;
+}
+
+// Sync frames the host will never see (ring lapped, or skipped in LOSSY
+// mode), found from holes in the ring sequence and reported as one marker
+struct SerialGapTracker
+{
+    bool haveLast;
+    uint32_t nextSeq;
+    uint32_t lastSampleUs;
+    uint32_t frames; // Pending report
+    uint32_t fromUs;
+    uint32_t toUs;
+
+    void sent(const SyncFrameMeta &meta)
+    {
+        if (haveLast && meta.seq != nextSeq)
+        {
+            if (frames == 0)
+                fromUs = lastSampleUs;
+            frames += meta.seq - nextSeq;
+            toUs = meta.sampleTimestampUs;
+        }
+        haveLast = true;
+        nextSeq = meta.seq + 1;
+        lastSampleUs = meta.sampleTimestampUs;
+    }
+};
+
+// Credit gate for ring (0x25) frames; queued frames are never gated
+static inline bool serialSyncCreditAvailable()
+{
+    return !serialCreditMode || serialCreditBalance() > 0;
+}
+
+// OPEN / CREDIT / LOSSY transitions, evaluated after every batch. Mode
+// changes are announced with a FLOW packet.
+static void updateSerialFlowMode(uint32_t nowMs, bool &starving,
+                                 uint32_t &lastStarvedMs)
+{
+    uint8_t mode = serialFlowMode;
+    if (!serialCreditMode)
+    {
+        mode = TELEMETRY_FLOW_OPEN;
+        starving = false;
+    }
+    else
+    {
+        bool starvedNow = serialCreditBalance() == 0 &&
+                          syncFrameRing.pending(FRAME_SINK_USB) > 0;
+        if (starvedNow)
+        {
+            if (!starving)
+            {
+                starving = true;
+                lastStarvedMs = nowMs; // Start of this starvation run
+            }
+        }
+        else if (starving)
+        {
+            starving = false;
+            lastStarvedMs = nowMs; // End of the run
+        }
+
+        if (mode == TELEMETRY_FLOW_OPEN)
+        {
+            mode = TELEMETRY_FLOW_CREDIT;
+        }
+        if (mode == TELEMETRY_FLOW_CREDIT && starving &&
+            nowMs - lastStarvedMs >= SERIAL_CREDIT_STARVE_MS)
+        {
+            mode = TELEMETRY_FLOW_LOSSY;
+        }
+        else if (mode == TELEMETRY_FLOW_LOSSY && !starving &&
+                 nowMs - lastStarvedMs >= SERIAL_LOSSY_RECOVER_MS)
+        {
+            mode = TELEMETRY_FLOW_CREDIT;
+        }
+    }
+
+    if (mode != serialFlowMode)
+    {
+        serialFlowMode = mode;
+        TelemetryFlow packet;
+        formatFlowTelemetry(packet, TELEMETRY_FLOW_EVENT_MODE, 0, 0, 0);
+        enqueueSerialFrame((const uint8_t *)&packet, sizeof(packet), false);
+    }
+}
+
+// Back to OPEN with nothing granted; the next CREDIT starts a fresh
+// balance. Command path / loop() only (serialCreditGranted's writer).
+static void resetSerialCreditFlow(const char *reason)
+{
+    if (!serialCreditMode && serialFlowMode == TELEMETRY_FLOW_OPEN)
+        return;
+    serialCreditMode = false;
+    serialCreditGranted = serialCreditUsed;
+    if (serialFlowMode != TELEMETRY_FLOW_OPEN)
+    {
+        serialFlowMode = TELEMETRY_FLOW_OPEN;
+        TelemetryFlow packet;
+        formatFlowTelemetry(packet, TELEMETRY_FLOW_EVENT_MODE, 0, 0, 0);
+        enqueueSerialFrame((const uint8_t *)&packet, sizeof(packet), false);
+    }
+    SAFE_LOG("[FlowCtrl] OPEN (%s)\n", reason);
+}
+
+// Called from loop(): drop credit mode once its host is gone or silent
+static void serviceSerialCreditFlow()
+{
+    if (!serialCreditMode)
+        return;
+    const bool hostConnected = static_cast<bool>(Serial);
+    if (!telemetryCreditFlowExpired(serialCreditMode, hostConnected, millis(),
+                                    serialLastCreditMs,
+                                    SERIAL_CREDIT_IDLE_OPEN_MS))
+        return;
+    resetSerialCreditFlow(hostConnected ? "no CREDIT from host"
+                                        : "USB host disconnected");
+}
+
+static void writeSerialBatch(const uint8_t *data, size_t len,
+                             SerialBatchLatency &batchLatency)
+{
+    if (serialWriteMutex != nullptr)
+    {
+        xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
+    }
+    const int freeBefore = ::Serial.availableForWrite();
+    const uint32_t beforeUs = micros();
+    TRACE_EVENT(TRACE_EV_SERIAL_WRITE, TRACE_BEGIN, len);
+    writeSerialRecordsLocked(data, len);
+    TRACE_EVENT(TRACE_EV_SERIAL_WRITE, TRACE_END, len);
+    const int freeAfter = ::Serial.availableForWrite();
+    const uint32_t afterUs = micros();
+    if (serialWriteMutex != nullptr)
+    {
+        xSemaphoreGive(serialWriteMutex);
+    }
+    batchLatency.written(len);
+
+    if (freeBefore > serialDrain.capacity)
+        serialDrain.capacity = freeBefore;
+    const uint32_t intervalUs = beforeUs - serialDrain.afterUs;
+    if (serialDrain.valid && freeBefore < serialDrain.capacity &&
+        freeBefore > serialDrain.freeAfterWrite &&
+        intervalUs >= SERIAL_DRAIN_MIN_SAMPLE_US)
+    {
+        updateSerialDrainRate(freeBefore - serialDrain.freeAfterWrite,
+                              intervalUs);
+    }
+    serialDrain.valid = true;
+    serialDrain.freeAfterWrite = freeAfter;
+    serialDrain.afterUs = afterUs;
+    serialTxBatchCount++;
+}
+
 void SerialTxTask(void *param)
 {
     SerialFrame frame;
+    SerialBatchLatency batchLatency = {};
+    SerialGapTracker gap = {};
+    SyncFrameRing::SinkStats usbStats = {};
+    uint32_t usbDropsSeen = 0;
+    bool creditStarving = false;
+    uint32_t lastStarvedMs = 0;
     Serial.println("[SerialTx] Task started on Core 0");
 
-    // Local coalescing buffer (fits multiple frames)
-    static uint8_t coalesceBuffer[SERIAL_FRAME_BUFFER_SIZE * 4];
+    // Sync frames come from the shared ring (USB cursor); everything else
+    // (JSON, telemetry, node info) from serialTxQueue
+    syncFrameRing.setNotifyTask(FRAME_SINK_USB, xTaskGetCurrentTaskHandle());
+    syncFrameRing.attach(FRAME_SINK_USB);
+
+    // Local coalescing buffer (largest adaptive batch)
+    static uint8_t coalesceBuffer[SERIAL_BATCH_MAX_BYTES];
 
     for (;;)
     {
-        // Try to receive with short timeout (5ms)
-        // Keep it at 2ms to stay responsive to incoming frames
-        if (xQueueReceive(serialTxQueue, &frame, pdMS_TO_TICKS(2)) == pdTRUE)
+        bool haveFrame = xQueueReceive(serialTxQueue, &frame, 0) == pdTRUE;
+        if (!haveFrame && (syncFrameRing.pending(FRAME_SINK_USB) == 0 ||
+                           !serialSyncCreditAvailable()))
         {
-            uint32_t batchStart = millis();
-            uint32_t framesInBatch = 0;
-            size_t bufferOffset = 0;
+            // Woken by syncFrameRing.publish() and wakeSerialTx(); the idle
+            // tick keeps flow-mode checks and diagnostics serviced
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_IDLE_WAKE_MS));
+            haveFrame = xQueueReceive(serialTxQueue, &frame, 0) == pdTRUE;
+        }
 
-            // Dequeue available frames into coalescing buffer
-            do
+        // Shallow backlog: send exactly what is waiting now. Deep backlog:
+        // coalesce up to the drain-rate byte budget.
+        uint32_t backlog = uxQueueMessagesWaiting(serialTxQueue) +
+                           (haveFrame ? 1 : 0);
+        if (serialSyncCreditAvailable())
+        {
+            backlog += syncFrameRing.pending(FRAME_SINK_USB);
+        }
+        const bool shallow = backlog <= SERIAL_SHALLOW_BACKLOG;
+        const uint32_t recordLimit = shallow ? (backlog > 0 ? backlog : 1)
+                                             : UINT32_MAX;
+        const size_t byteBudget = shallow ? sizeof(coalesceBuffer)
+                                          : serialBatchBudget;
+
+        uint32_t framesInBatch = 0;
+        size_t bufferOffset = 0;
+
+        // Coalesce queued frames and ring frames until the record limit or
+        // byte budget is reached or both sources are empty
+        while (framesInBatch < recordLimit && bufferOffset < byteBudget &&
+               !batchLatency.full())
+        {
+            size_t added = 0;
+            if (haveFrame)
             {
-                // Guard: check if next frame fits in the coalescing buffer
                 if (bufferOffset + frame.len > sizeof(coalesceBuffer))
                 {
-                    // Buffer full - ship what we have and then process this frame
-                    if (serialWriteMutex != nullptr)
-                        xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
-                    Serial.write(coalesceBuffer, bufferOffset);
-                    if (serialWriteMutex != nullptr)
-                        xSemaphoreGive(serialWriteMutex);
-
+                    writeSerialBatch(coalesceBuffer, bufferOffset, batchLatency);
                     bufferOffset = 0;
-                    serialTxBatchCount++;
                 }
-
                 memcpy(coalesceBuffer + bufferOffset, frame.data, frame.len);
-                bufferOffset += frame.len;
-
-                serialTxFrameCount++;
-                framesInBatch++;
+                added = frame.len;
+                haveFrame = false;
+            }
+            else if (serialSyncCreditAvailable())
+            {
+                if (serialFlowMode == TELEMETRY_FLOW_LOSSY)
+                {
+                    // Newest frames only; the skipped backlog shows up as
+                    // a gap marker
+                    syncFrameRing.skipBacklog(FRAME_SINK_USB,
+                                              SERIAL_LOSSY_BACKLOG_FRAMES);
+                }
+                SyncFrameMeta meta;
+                added = syncFrameRing.read(FRAME_SINK_USB,
+                                           coalesceBuffer + bufferOffset,
+                                           sizeof(coalesceBuffer) - bufferOffset,
+                                           &meta);
+                if (added == 0 && bufferOffset > 0 &&
+                    syncFrameRing.pending(FRAME_SINK_USB) > 0)
+                {
+                    // Next record does not fit: ship what we have, retry
+                    writeSerialBatch(coalesceBuffer, bufferOffset, batchLatency);
+                    bufferOffset = 0;
+                    added = syncFrameRing.read(FRAME_SINK_USB, coalesceBuffer,
+                                               sizeof(coalesceBuffer), &meta);
+                }
+                if (added > 0)
+                {
+                    batchLatency.add(meta);
+                    gap.sent(meta);
+                    if (serialCreditMode)
+                    {
+                        serialCreditUsed++;
+                    }
+                }
+            }
 
-                // Batch limits: max frames or max time
-                if (framesInBatch >= SERIAL_MAX_BATCH_FRAMES)
-                    break;
-                if ((millis() - batchStart) >= SERIAL_BATCH_INTERVAL_MS)
+            if (added == 0)
+            {
+                haveFrame = xQueueReceive(serialTxQueue, &frame, 0) == pdTRUE;
+                if (!haveFrame)
                     break;
+                continue;
+            }
 
-                // Try to peek next frame without blocking
-            } while (xQueueReceive(serialTxQueue, &frame, 0) == pdTRUE);
+            batchLatency.opened();
+            bufferOffset += added;
+            serialTxFrameCount++;
+            framesInBatch++;
+        }
 
-            // Final write of coalesced buffer
-            if (bufferOffset > 0)
+        // Gap marker after the frames that closed the gap
+        if (gap.frames > 0)
+        {
+            TelemetryFlow marker;
+            formatFlowTelemetry(marker, TELEMETRY_FLOW_EVENT_GAP, gap.frames,
+                                gap.fromUs, gap.toUs);
+            if (bufferOffset + 2 + sizeof(marker) > sizeof(coalesceBuffer))
             {
-                if (serialWriteMutex != nullptr)
-                {
-                    xSemaphoreTake(serialWriteMutex, portMAX_DELAY);
-                }
+                writeSerialBatch(coalesceBuffer, bufferOffset, batchLatency);
+                bufferOffset = 0;
+            }
+            coalesceBuffer[bufferOffset++] = (uint8_t)sizeof(marker);
+            coalesceBuffer[bufferOffset++] = 0;
+            memcpy(coalesceBuffer + bufferOffset, &marker, sizeof(marker));
+            bufferOffset += sizeof(marker);
+            gap.frames = 0;
+        }
 
-                Serial.write(coalesceBuffer, bufferOffset);
+        // Final write of coalesced buffer
+        if (bufferOffset > 0)
+        {
+            writeSerialBatch(coalesceBuffer, bufferOffset, batchLatency);
+        }
 
-                if (serialWriteMutex != nullptr)
-                {
-                    xSemaphoreGive(serialWriteMutex);
-                }
-                serialTxBatchCount++;
-            }
+        // Frames the USB cursor lost to a lapping producer count as drops
+        syncFrameRing.getSinkStats(FRAME_SINK_USB, usbStats);
+        if (usbStats.framesDropped != usbDropsSeen)
+        {
+            serialTxDropCount += usbStats.framesDropped - usbDropsSeen;
+            usbDropsSeen = usbStats.framesDropped;
         }
 
         uint32_t now = millis();
+        updateSerialFlowMode(now, creditStarving, lastStarvedMs);
 
         // Periodic diagnostics with overflow detection (every 5 seconds)
         static uint32_t lastDiagTime = 0;
@@ -310,8 +854,8 @@ void SerialTxTask(void *param)
             {
                 if (isStreaming)
                 {
-                    logJson("error",
-                            "Serial queue overloaded: drops > critical threshold");
+                    logTelemetry(TELEMETRY_LOG_ERROR,
+                                 "Serial queue overloaded: drops > critical threshold");
                 }
                 else
                 {
@@ -332,7 +876,8 @@ void SerialTxTask(void *param)
             {
                 if (isStreaming)
                 {
-                    logJson("warn", "Serial queue pressure: drops > warning threshold");
+                    logTelemetry(TELEMETRY_LOG_WARN,
+                                 "Serial queue pressure: drops > warning threshold");
                 }
                 else
                 {
@@ -350,14 +895,7 @@ void SerialTxTask(void *param)
             // Standard diagnostics
             if (isStreaming)
             {
-                char buffer[160];
-                snprintf(buffer, sizeof(buffer),
-                         "SerialTx stats: frames=%lu batches=%lu drops=%lu (+%lu) "
-                         "free=%u/%d heap=%uKB",
-                         serialTxFrameCount, serialTxBatchCount, serialTxDropCount,
-                         dropsDelta, uxQueueSpacesAvailable(serialTxQueue),
-                         SERIAL_TX_QUEUE_SIZE, ESP.getFreeHeap() / 1024);
-                logJson("info", buffer);
+                emitSerialTxTelemetry(dropsDelta);
             }
             else
             {
@@ -382,7 +920,10 @@ void SerialTxTask(void *param)
 //
 // This task handles:
 // 1. 0x23 (TDMA batched) → extract samples → addSample()
-// 2. 0x26 (Node delta) → decode → addSample()
+// 2. 0x26 (Node delta) → decode → addSample() (+ inline mag/baro, if any)
+// 3. 0x26 with NODE_DATA_FLAG_HISTORICAL (black box backfill) → forwarded
+//    verbatim to the host; never enters SyncFrameBuffer (its frames are long
+//    past the assembly window)
 // ============================================================================
 
 void DataIngestionTask(void *param)
@@ -393,6 +934,9 @@ void DataIngestionTask(void *param)
     EspNowRxPacket rxPacket;
     uint32_t lastDiagTime = millis();
     uint32_t lastNodeDiagTime = millis();
+    // Adaptive PHY rate is only fed windows where streaming held throughout,
+    // so idle/paused periods never read as packet loss.
+    bool streamingAtWindowStart = isStreaming;
 
     struct NodeIngestStats
     {
@@ -400,6 +944,7 @@ void DataIngestionTask(void *param)
         uint32_t packets;
         uint32_t samplesAdded;
         uint32_t sampleAddFails;
+        uint32_t historicalPackets;
         bool used;
     };
     NodeIngestStats nodeStats[TDMA_MAX_NODES] = {};
@@ -424,6 +969,7 @@ void DataIngestionTask(void *param)
                 nodeStats[i].packets = 0;
                 nodeStats[i].samplesAdded = 0;
                 nodeStats[i].sampleAddFails = 0;
+                nodeStats[i].historicalPackets = 0;
                 return &nodeStats[i];
             }
         }
@@ -441,12 +987,38 @@ void DataIngestionTask(void *param)
             // SIMP-2: 0x23 handler removed — nodes exclusively use 0x26 format.
             // Legacy 0x23 packets are silently dropped.
 
-            if (packetType == TDMA_PACKET_NODE_DATA && useSyncFrameMode &&
-                syncFrameBufferInitialized)
+            if (packetType == TDMA_PACKET_NODE_DATA &&
+                rxPacket.len >= sizeof(TDMANodeDataPacket) &&
+                (rxPacket.data[offsetof(TDMANodeDataPacket, flags)] &
+                 NODE_DATA_FLAG_HISTORICAL))
+            {
+                // ====================================================================
+                // 0x26 Historical (black box backfill) → host passthrough
+                // ====================================================================
+                // Live fusion has moved on, so the webapp only frames and
+                // skips these. The on-gateway session keeps them and
+                // session_tool.py splices them over the recording's gaps,
+                // de-duplicated by (nodeId, sensor, sample time). Validate
+                // CRC here so a corrupt backfill never reaches the session.
+                if (verifyCRC8(rxPacket.data, rxPacket.len))
+                {
+                    NodeIngestStats *ns = getNodeStatSlot(
+                        rxPacket.data[offsetof(TDMANodeDataPacket, nodeId)]);
+                    if (ns)
+                    {
+                        ns->historicalPackets++;
+                    }
+                    sessionRecorder.recordHistorical(rxPacket.data, rxPacket.len);
+                    enqueueSerialFrame(rxPacket.data, rxPacket.len, false);
+                }
+            }
+            else if (packetType == TDMA_PACKET_NODE_DATA && useSyncFrameMode &&
+                     syncFrameBufferInitialized)
             {
                 // ====================================================================
                 // 0x26 Node Data → Decode → SyncFrameBuffer
                 // ====================================================================
+                const uint32_t ingestUs = micros();
                 TDMABatchedSensorData decodedSamples[TDMA_SAMPLES_PER_FRAME][MAX_SENSORS]; // Max samples × max sensors per node
                 uint8_t nodeIdOut, sensorCountOut;
                 uint32_t frameNumberOut;
@@ -465,6 +1037,41 @@ void DataIngestionTask(void *param)
                 // already handles sample-level dedup via timestamp slot matching.
                 if (decodedCount > 0)
                 {
+                    recordLatency(LATENCY_STAGE_INGEST_QUEUE, rxPacket.rxUs, ingestUs);
+                    for (uint8_t sampleIdx = 0; sampleIdx < decodedCount; sampleIdx++)
+                    {
+                        recordLatency(LATENCY_STAGE_AIR,
+                                      decodedSamples[sampleIdx][0].timestampUs,
+                                      rxPacket.rxUs);
+                    }
+
+                    // One lock-free routing lookup per packet: every sample in
+                    // it maps through the same table generation
+                    uint8_t compactIds[MAX_SENSORS];
+                    syncManager.getNodeRoutes(nodeIdOut, compactIds, sensorCountOut);
+
+                    // Inline mag/baro reading: last section before the CRC8.
+                    // It joins the slot of the sample it was taken next to,
+                    // carried by the first of that sample's sensors that
+                    // addSample() accepts; if none is, it counts as dropped.
+                    NodeEnviroSample enviro;
+                    bool hasEnviro = false;
+                    if ((rxPacket.data[offsetof(TDMANodeDataPacket, flags)] &
+                         NODE_DATA_FLAG_ENVIRO) &&
+                        rxPacket.len >= TDMA_NODE_DATA_HEADER_SIZE +
+                                            sizeof(NodeEnviroSample) + 1)
+                    {
+                        memcpy(&enviro,
+                               rxPacket.data + rxPacket.len - 1 -
+                                   sizeof(NodeEnviroSample),
+                               sizeof(NodeEnviroSample));
+                        hasEnviro = enviro.contents != 0 &&
+                                    enviro.sampleIndex < decodedCount;
+                    }
+
+                    bool enviroPending = hasEnviro;
+                    uint16_t packetSamplesAdded = 0;
+                    TRACE_EVENT(TRACE_EV_ADD_SAMPLE, TRACE_BEGIN, nodeIdOut);
                     for (uint8_t sampleIdx = 0; sampleIdx < decodedCount; sampleIdx++)
                     {
                         for (uint8_t sensorIdx = 0; sensorIdx < sensorCountOut;
@@ -473,8 +1080,7 @@ void DataIngestionTask(void *param)
                             TDMABatchedSensorData *sample =
                                 &decodedSamples[sampleIdx][sensorIdx];
 
-                            const uint8_t compactSensorId =
-                                syncManager.getCompactSensorId(nodeIdOut, sensorIdx);
+                            const uint8_t compactSensorId = compactIds[sensorIdx];
                             if (compactSensorId == 0)
                             {
                                 if (ns)
@@ -484,11 +1090,30 @@ void DataIngestionTask(void *param)
                                 continue;
                             }
 
+                            const bool carryEnviro =
+                                enviroPending &&
+                                sampleIdx == enviro.sampleIndex;
+                            // CPU cycles per call. Slot lookup reads SRAM
+                            // metadata only; PSRAM cache misses on the
+                            // payload store (and lock waits) form the tail.
+                            const uint32_t addStartCycles = ESP.getCycleCount();
                             bool added = syncFrameBuffer.addSample(
                                 compactSensorId, nodeIdOut, sensorIdx,
                                 sample->timestampUs,
                                 frameNumberOut, sampleIdx,
-                                sample->a, sample->g);
+                                sample->a, sample->g,
+                                carryEnviro ? &enviro : nullptr);
+                            recordHistogramValue(
+                                LATENCY_STAGE_ADD_SAMPLE,
+                                ESP.getCycleCount() - addStartCycles);
+                            if (added)
+                            {
+                                packetSamplesAdded++;
+                                if (carryEnviro)
+                                {
+                                    enviroPending = false;
+                                }
+                            }
                             if (ns)
                             {
                                 if (added)
@@ -501,7 +1126,14 @@ void DataIngestionTask(void *param)
                                 }
                             }
                         }
+
+                        if (enviroPending && sampleIdx == enviro.sampleIndex)
+                        {
+                            syncFrameBuffer.countEnviroDropped();
+                            enviroPending = false;
+                        }
                     }
+                    TRACE_EVENT(TRACE_EV_ADD_SAMPLE, TRACE_END, packetSamplesAdded);
                 }
             }
         }
@@ -519,11 +1151,25 @@ void DataIngestionTask(void *param)
 
         if (now - lastNodeDiagTime > 5000)
         {
+            uint32_t windowMs = now - lastNodeDiagTime;
+            bool rateWindowValid = streamingAtWindowStart && isStreaming;
+            streamingAtWindowStart = isStreaming;
             lastNodeDiagTime = now;
             Serial.println("[DataIngestion] Node contribution (5s window):");
             bool any = false;
-            String json = "{\"type\":\"gateway_ingest_diag\",\"window_ms\":5000,\"nodes\":[";
-            bool firstJsonNode = true;
+            TelemetryIngest ingest;
+            telemetryBegin(ingest.header, TELEMETRY_KIND_INGEST, now);
+            ingest.windowMs = clampTelemetryCount(windowMs);
+            ingest.channel = syncManager.getActiveChannel();
+            {
+                SyncManager::BeaconTimingStats bt;
+                syncManager.getBeaconTiming(bt);
+                memcpy(ingest.jitterHist, bt.jitterHist, sizeof(ingest.jitterHist));
+                ingest.jitterMaxUs = bt.jitterMaxUs;
+                ingest.txLatencyLastUs = bt.txLatencyLastUs;
+                ingest.txLatencyMaxUs = bt.txLatencyMaxUs;
+            }
+            ingest.nodeCount = 0;
             for (uint8_t i = 0; i < TDMA_MAX_NODES; i++)
             {
                 if (!nodeStats[i].used)
@@ -531,39 +1177,56 @@ void DataIngestionTask(void *param)
                 any = true;
                 float pktHz = nodeStats[i].packets / 5.0f;
                 float sampleHz = nodeStats[i].samplesAdded / 5.0f;
+                uint8_t phyRate =
+                    rateWindowValid
+                        ? syncManager.reportNodeDelivery(nodeStats[i].nodeId,
+                                                         nodeStats[i].packets,
+                                                         windowMs)
+                        : syncManager.getNodePhyRate(nodeStats[i].nodeId);
                 Serial.printf(
-                    "  node=%u packets=%lu (%.1f/s) added=%lu (%.1f/s) fails=%lu\n",
+                    "  node=%u packets=%lu (%.1f/s) added=%lu (%.1f/s) fails=%lu hist=%lu phy=%uM\n",
                     nodeStats[i].nodeId,
                     (unsigned long)nodeStats[i].packets,
                     pktHz,
                     (unsigned long)nodeStats[i].samplesAdded,
                     sampleHz,
-                    (unsigned long)nodeStats[i].sampleAddFails);
-
-                if (!firstJsonNode)
-                {
-                    json += ",";
-                }
-                firstJsonNode = false;
-                char nodeJson[160];
-                snprintf(nodeJson, sizeof(nodeJson),
-                         "{\"nodeId\":%u,\"packets\":%lu,\"samplesAdded\":%lu,\"sampleAddFails\":%lu}",
-                         nodeStats[i].nodeId,
-                         (unsigned long)nodeStats[i].packets,
-                         (unsigned long)nodeStats[i].samplesAdded,
-                         (unsigned long)nodeStats[i].sampleAddFails);
-                json += nodeJson;
+                    (unsigned long)nodeStats[i].sampleAddFails,
+                    (unsigned long)nodeStats[i].historicalPackets,
+                    tdmaPhyRateMbps(phyRate));
+
+                TelemetryNodeStats &nt = ingest.nodes[ingest.nodeCount++];
+                nt.nodeId = nodeStats[i].nodeId;
+                nt.phyMbps = tdmaPhyRateMbps(phyRate);
+                nt.packets = clampTelemetryCount(nodeStats[i].packets);
+                // Host derives per-node loss from packets vs expected
+                nt.expectedPackets = rateWindowValid
+                                         ? clampTelemetryCount(windowMs / TDMA_FRAME_PERIOD_MS)
+                                         : 0;
+                nt.samplesAdded = clampTelemetryCount(nodeStats[i].samplesAdded);
+                nt.sampleAddFails = clampTelemetryCount(nodeStats[i].sampleAddFails);
+                nt.historical = clampTelemetryCount(nodeStats[i].historicalPackets);
 
                 nodeStats[i].packets = 0;
                 nodeStats[i].samplesAdded = 0;
                 nodeStats[i].sampleAddFails = 0;
+                nodeStats[i].historicalPackets = 0;
             }
             if (!any)
             {
                 Serial.println("  (no TDMA data packets in window)");
             }
-            json += "]}";
-            enqueueJsonFrame(json);
+            enqueueSerialFrame((const uint8_t *)&ingest,
+                               telemetryIngestSize(ingest.nodeCount), false);
+            if (syncFrameBufferInitialized)
+            {
+                emitSyncTelemetry();
+            }
+
+            // Cumulative latency histograms (0x08) for host-side percentiles
+            if (isStreaming)
+            {
+                emitLatencyHistograms();
+            }
         }
     }
 }
@@ -572,9 +1235,11 @@ void DataIngestionTask(void *param)
 // PROTOCOL TASK - Jitter-Free Beacon & Sync Frame Management (Core 0)
 // ============================================================================
 // This task handles all timing-critical operations:
-// 1. TDMA beacon transmission at exactly 20ms intervals (50Hz)
-// 2. SyncFrameBuffer update and complete frame detection
-// 3. Sync Frame (0x25) packet emission when frames are complete
+// 1. TDMA beacon transmission at exactly 20ms intervals (50Hz), paced by a
+//    periodic esp_timer that notifies this task (polled micros() fallback)
+// 2. SyncFrameBuffer update (stale slot expiry)
+// 3. Sync Frame (0x25) packet emission — DataIngestionTask detects completion
+//    in addSample() and notifies this task, which drains the ready queue
 //
 // MUST run on Core 0 because syncManager.update() calls esp_now_send()
 // which interacts with the WiFi stack pinned to Core 0. SyncManager
@@ -583,6 +1248,17 @@ void DataIngestionTask(void *param)
 // DataIngestionTask on Core 1.
 // ============================================================================
 
+// ProtocolTask notification bits (eSetBits)
+#define PROTOCOL_NOTIFY_BEACON 0x01      // Beacon timer fired
+#define PROTOCOL_NOTIFY_FRAME_READY 0x02 // SyncFrameBuffer completed a slot
+
+// Runs in the esp_timer task (Core 0, priority 22). Only wakes ProtocolTask;
+// all SyncManager work stays on the task.
+static void beaconTimerCallback(void *arg)
+{
+    xTaskNotify((TaskHandle_t)arg, PROTOCOL_NOTIFY_BEACON, eSetBits);
+}
+
 void ProtocolTask(void *param)
 {
     Serial.println(
@@ -591,6 +1267,38 @@ void ProtocolTask(void *param)
     uint32_t lastBeaconUs = micros();
     const uint32_t BEACON_INTERVAL_US =
         TDMA_FRAME_PERIOD_MS * 1000; // 20ms = 20000µs
+
+    // ========================================================================
+    // BEACON TIMER: esp_timer alarms are absolute, so a late wakeup never
+    // shifts the next one, and the notify preempts the 1ms housekeeping
+    // wait instead of being discovered up to 1ms late by polling.
+    // ========================================================================
+    esp_timer_handle_t beaconTimer = nullptr;
+    esp_timer_create_args_t beaconTimerArgs = {};
+    beaconTimerArgs.callback = beaconTimerCallback;
+    beaconTimerArgs.arg = xTaskGetCurrentTaskHandle();
+    beaconTimerArgs.dispatch_method = ESP_TIMER_TASK;
+    beaconTimerArgs.name = "beacon";
+    beaconTimerArgs.skip_unhandled_events = true;
+    if (esp_timer_create(&beaconTimerArgs, &beaconTimer) != ESP_OK ||
+        esp_timer_start_periodic(beaconTimer, BEACON_INTERVAL_US) != ESP_OK)
+    {
+        Serial.println(
+            "[Protocol] WARNING: beacon timer unavailable - polling micros()");
+        beaconTimer = nullptr;
+    }
+    bool beaconTick = false;
+
+    // Completed frames wake us the moment their last sample is stored.
+    // Without the beacon timer the loop runs on a fixed 1ms delay and just
+    // drains whatever is ready each pass.
+    if (beaconTimer != nullptr)
+    {
+        syncFrameBuffer.setReadyNotify(xTaskGetCurrentTaskHandle(),
+                                       PROTOCOL_NOTIFY_FRAME_READY);
+    }
+    uint32_t lastExpireUs = micros();
+
     uint32_t suppressedPreRunningSyncFrames = 0;
     uint32_t lastSuppressedSyncFrameLogMs = 0;
     bool lastTDMARunningState = false;
@@ -613,18 +1321,18 @@ void ProtocolTask(void *param)
         // ========================================================================
         if (syncManager.isTDMAActive())
         {
-            uint32_t elapsedUs = nowUs - lastBeaconUs;
+            bool beaconDue = (beaconTimer != nullptr)
+                                 ? beaconTick
+                                 : (nowUs - lastBeaconUs >= BEACON_INTERVAL_US);
 
-            if (elapsedUs >= BEACON_INTERVAL_US)
+            if (beaconDue)
             {
-                // Track jitter for diagnostics
-                int32_t jitterUs = (int32_t)elapsedUs - (int32_t)BEACON_INTERVAL_US;
-                if (abs(jitterUs) > (int32_t)beaconJitterMaxUs)
+                // Send beacon via SyncManager (it handles all the packet
+                // building and period jitter accounting)
+                if (beaconTimer != nullptr)
                 {
-                    beaconJitterMaxUs = abs(jitterUs);
+                    syncManager.onBeaconTick();
                 }
-
-                // Send beacon via SyncManager (it handles all the packet building)
                 syncManager.update();
 
                 lastBeaconUs = nowUs;
@@ -647,8 +1355,13 @@ void ProtocolTask(void *param)
                     tdmaRunning ? "ENABLED" : "SUPPRESSED");
             }
 
-            // Update buffer (expire stale slots)
-            syncFrameBuffer.update();
+            // Update buffer (expire stale slots). Frame-ready wakeups come
+            // at the sample rate; the stale-slot sweep only needs ~1ms.
+            if (nowUs - lastExpireUs >= 1000)
+            {
+                lastExpireUs = nowUs;
+                syncFrameBuffer.update();
+            }
 
             // Product contract: SyncFrames are only allowed to leave the
             // gateway once TDMA is fully RUNNING. Discovery/SYNC-phase frames
@@ -656,8 +1369,11 @@ void ProtocolTask(void *param)
             // instead of being forwarded to the webapp.
             while (syncFrameBuffer.hasCompleteFrame())
             {
+                SyncFrameTiming frameTiming;
+                TRACE_EVENT(TRACE_EV_FRAME_COMPLETE, TRACE_BEGIN, 0);
                 size_t frameLen = syncFrameBuffer.getCompleteFrame(
-                    syncFramePacket, sizeof(syncFramePacket));
+                    syncFramePacket, sizeof(syncFramePacket), &frameTiming);
+                TRACE_EVENT(TRACE_EV_FRAME_COMPLETE, TRACE_END, frameLen);
 
                 if (frameLen == 0)
                 {
@@ -666,7 +1382,11 @@ void ProtocolTask(void *param)
 
                 if (tdmaRunning)
                 {
-                    enqueueSerialFrame(syncFramePacket, frameLen, false);
+                    recordLatency(LATENCY_STAGE_SYNC_WAIT,
+                                  frameTiming.firstArrivalUs, micros());
+                    // One publish feeds every output (USB, WebSocket, ...)
+                    syncFrameRing.publish(syncFramePacket, frameLen,
+                                          frameTiming.timestampUs);
                     syncFrameEmitCount++;
                 }
                 else
@@ -718,16 +1438,37 @@ void ProtocolTask(void *param)
         {
             if (syncManager.isTDMAActive())
             {
+                SyncManager::BeaconTimingStats bt;
+                syncManager.getBeaconTiming(bt);
                 SAFE_LOG_NB(
-                    "[Protocol] Beacons: %lu, MaxJitter: %luµs, SyncFrames: %lu\n",
-                    beaconTxCount, beaconJitterMaxUs, syncFrameEmitCount);
-                beaconJitterMaxUs = 0; // Reset max jitter tracking
+                    "[Protocol] Beacons: %lu, MaxJitter: %luµs, TxLatency: %lu/%luµs, "
+                    "SyncFrames: %lu\n",
+                    beaconTxCount, bt.jitterMaxUs, bt.txLatencyLastUs,
+                    bt.txLatencyMaxUs, syncFrameEmitCount);
+                SAFE_LOG_NB(
+                    "[Protocol] Jitter hist <10/25/50/100/250/500/1000/>=1000µs: "
+                    "%lu/%lu/%lu/%lu/%lu/%lu/%lu/%lu\n",
+                    bt.jitterHist[0], bt.jitterHist[1], bt.jitterHist[2],
+                    bt.jitterHist[3], bt.jitterHist[4], bt.jitterHist[5],
+                    bt.jitterHist[6], bt.jitterHist[7]);
             }
             lastProtocolDiag = nowMs;
         }
 
-        // FIX: vTaskDelayUntil ensures deterministic 1ms wake cadence, reducing
-        // beacon timing jitter vs vTaskDelay which drifts from "now".
-        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(1));
+        if (beaconTimer != nullptr)
+        {
+            // Beacon tick or a completed frame wakes us immediately;
+            // otherwise 1ms housekeeping. A missed beacon shows up in the
+            // period histogram as >= 1ms jitter.
+            uint32_t notifyBits = 0;
+            xTaskNotifyWait(0, ULONG_MAX, &notifyBits, pdMS_TO_TICKS(1));
+            beaconTick = (notifyBits & PROTOCOL_NOTIFY_BEACON) != 0;
+        }
+        else
+        {
+            // FIX: vTaskDelayUntil ensures deterministic 1ms wake cadence, reducing
+            // beacon timing jitter vs vTaskDelay which drifts from "now".
+            vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(1));
+        }
     }
 }
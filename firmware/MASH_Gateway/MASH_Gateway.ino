@@ -23,6 +23,7 @@
 // caused zero-byte reads in the webapp. Set Arduino IDE > Tools > USB Mode >
 // "Hardware CDC and JTAG".
 #include <Wire.h>
+#include <esp_timer.h> // Beacon timer (ProtocolTask)
 #include <esp_wifi.h> // For esp_wifi_set_channel() - ESP-NOW/WiFi channel sync
 #include <stdarg.h>
 
@@ -31,12 +32,23 @@
 
 // Include shared modules (copied into this folder for Arduino IDE)
 #include "../libraries/IMUConnectCore/src/TDMAProtocol.h"
+#include "../libraries/IMUConnectCore/src/NodeDataCodec.h"
+#include "../libraries/IMUConnectCore/src/LatencyHistogram.h"
+#include "../libraries/IMUConnectCore/src/GatewayTelemetry.h"
+#include "../libraries/IMUConnectCore/src/SerialFraming.h"
 #include "CommandHandler.h"
 #include "Config.h"
 #include "SyncFrameBuffer.h"
+#include "SyncFrameRing.h"
 #include "SyncManager.h"
 #include "DisplayManager.h"
 #include "WebSocketManager.h"
+#if ENABLE_BLE_SYNC_STREAM
+#include "BLEManager.h"
+#endif
+#if ENABLE_SESSION_RECORDER
+#include "SessionRecorder.h"
+#endif
 #include "WiFiManager.h"
 #include "WiFiOTAServer.h"
 
@@ -72,14 +84,27 @@ static constexpr int SAFE_BOOT_PIN = 0; // ESP32-S3 BOOT strap pin
 // which triggers the Task Watchdog Timer (TWDT) after ~5 seconds â†’ reboot.
 SemaphoreHandle_t serialWriteMutex = nullptr;
 
+static inline void enqueueJsonFrame(const char *json, size_t jsonLen);
+static inline void enqueueJsonFrame(const char *json);
 static inline void enqueueJsonFrame(const String &json);
 static inline void enqueueSerialFrame(const uint8_t *frame, size_t len,
                                       bool isCommandResponse = false);
-static void logJson(const char *level, const char *message);
+static inline void recordLatency(LatencyStage stage, uint32_t fromUs,
+                                 uint32_t toUs);
+static void resetLatencyHistograms();
+static void emitLatencyHistograms();
+static void logTelemetry(TelemetryLogLevel level, const char *message);
 static inline size_t writeUsbFifoDirect(const uint8_t *data, size_t len);
+static inline void writeUsbRecordDirect(const uint8_t *record, size_t len);
+static void writeSerialRecords(const uint8_t *records, size_t len);
+static void resetSerialCreditFlow(const char *reason);
+static void serviceSerialCreditFlow();
 // SIMP-1: sendFramedPacketDirect removed — SyncFrames now routed through enqueueSerialFrame
 static inline void emitCompactSyncStatusDirect();
 static inline void emitPipelineDiagDirect();
+#if ENABLE_TRACE_RING
+static void writeTraceChunk(const uint8_t *chunk, size_t len, void *ctx);
+#endif
 static inline void emitBootJsonFrameDirect(const char *phase);
 
 class SerialLogGate
@@ -192,10 +217,20 @@ Preferences preferences;
 SyncManager syncManager;
 WiFiManagerESP wifiManager;
 WebSocketManager wsManager;
+#if ENABLE_BLE_SYNC_STREAM
+BLEManager bleManager;
+#endif
+#if ENABLE_SESSION_RECORDER
+SessionRecorder sessionRecorder;
+#endif
 CommandHandler commandHandler;
 
 WiFiOTAServer wifiOTAServer;
 
+#if ENABLE_TRACE_RING
+TraceRing traceRing;
+#endif
+
 // ============================================================================
 // SYNC FRAME BUFFER - Cross-Node Timestamp Synchronization (Phase 5)
 // ============================================================================
@@ -205,6 +240,8 @@ WiFiOTAServer wifiOTAServer;
 // packet level, eliminating the need for web app timestamp correlation.
 // ============================================================================
 SyncFrameBuffer syncFrameBuffer;
+// Every emitted 0x25 frame, read by each output through its own cursor
+SyncFrameRing syncFrameRing;
 bool syncFrameBufferInitialized = false;
 
 // Enable/disable Sync Frame mode (can be toggled via command for debugging)
@@ -269,13 +306,23 @@ static constexpr size_t SERIAL_TX_QUEUE_SIZE =
         // when multiple stale slots complete simultaneously. USB CDC at
         // 12 Mbit/s drains faster than enqueue, so extra depth is free
         // headroom.
-static constexpr uint32_t SERIAL_BATCH_INTERVAL_MS =
-    5; // 200 batches/sec â€” halved from 10ms to reduce transport latency.
-       // At <1KB per batch (200Hz Ã— ~130B/frame), USB CDC 12 Mbit/s handles
-       // this trivially.
+
+// Adaptive batching (SerialTxTask). The task sleeps on a task notification
+// (ring publish, queued frame, new credits) and drains whatever is waiting:
+// with a shallow backlog that is one or two records, written at once, so a
+// light topology pays no batching delay. When a backlog forms (stale slots
+// completing together, a slow host), records are coalesced up to a byte
+// budget of SERIAL_BATCH_TARGET_US worth of USB drain rate (host reads
+// measured from CDC TX buffer space, updateSerialDrainRate), so one write
+// never holds serialWriteMutex much longer than that.
+static constexpr size_t SERIAL_BATCH_MAX_BYTES = SERIAL_FRAME_BUFFER_SIZE * 8;
+static constexpr size_t SERIAL_BATCH_MIN_BYTES = SERIAL_FRAME_BUFFER_SIZE;
+static constexpr uint32_t SERIAL_BATCH_TARGET_US = 2000;
+static constexpr uint32_t SERIAL_SHALLOW_BACKLOG = 2;      // Records
+static constexpr uint32_t SERIAL_DRAIN_INITIAL_BPMS = 600; // Bytes/ms
+static constexpr uint32_t SERIAL_IDLE_WAKE_MS = 20;        // Flow/diag tick
 static constexpr uint32_t SERIAL_MAX_BATCH_FRAMES =
-    16; // Cap per-batch drain to avoid starving other tasks when backlog
-        // spikes.
+    64; // Sync frames tracked per batch for latency histograms
 
 struct SerialFrame
 {
@@ -283,13 +330,49 @@ struct SerialFrame
   uint8_t data[SERIAL_FRAME_BUFFER_SIZE];
 };
 
-// Compile-time check: largest SyncFrame (0x25 absolute) must fit in serial
-// buffer 0x25 packet = 10 header + SYNC_MAX_SENSORS x 16 bytes/sensor + 2
-// length prefix
-static_assert(10 + SYNC_MAX_SENSORS * 16 + 2 <= SERIAL_FRAME_BUFFER_SIZE,
-              "SERIAL_FRAME_BUFFER_SIZE too small for SYNC_MAX_SENSORS!");
+// ============================================================================
+// END-TO-END LATENCY HISTOGRAMS (LatencyHistogram.h)
+// ============================================================================
+// One histogram per pipeline stage, each written by a single task
+// (AIR/INGEST_QUEUE/ADD_SAMPLE: DataIngestionTask, SYNC_WAIT: ProtocolTask,
+// SERIAL_QUEUE/END_TO_END/SERIAL_FLUSH/SERIAL_BATCH: SerialTxTask). The
+// spinlock only guards against torn snapshots/resets from the command path.
+// Cumulative since the last reset (START streaming or GET_LATENCY with
+// "reset":true); streamed as 0x08 packets every 5s while streaming.
+// ============================================================================
+static LatencyHistogram latencyHist[LATENCY_STAGE_COUNT];
+static portMUX_TYPE latencyHistLock = portMUX_INITIALIZER_UNLOCKED;
+
+// The largest 0x25 frame (sensor, enviro and correction records) is bounded
+// by SYNC_FRAME_MAX_PACKET_SIZE in SyncFrameBuffer.h. Sync frames reach USB
+// from the ring, not serialTxQueue, so one ring record must fit a batch.
+static_assert(SYNC_FRAME_RING_RECORD_MAX <= SERIAL_BATCH_MAX_BYTES,
+              "SERIAL_BATCH_MAX_BYTES too small for one sync frame record!");
+
+// Binary telemetry (0x09, GatewayTelemetry.h) mirrors these TDMA limits
+static_assert(TELEMETRY_JITTER_BUCKETS == TDMA_BEACON_JITTER_BUCKETS,
+              "GatewayTelemetry jitter buckets out of sync with TDMAProtocol");
+static_assert(TELEMETRY_MAX_NODES == TDMA_MAX_NODES,
+              "GatewayTelemetry node count out of sync with TDMAProtocol");
+static_assert(sizeof(TelemetryIngest) + 2 <= SERIAL_FRAME_BUFFER_SIZE &&
+                  sizeof(TelemetryLog) + 2 <= SERIAL_FRAME_BUFFER_SIZE,
+              "SERIAL_FRAME_BUFFER_SIZE too small for telemetry packets");
 
 static QueueHandle_t serialTxQueue = nullptr;
+static TaskHandle_t serialTxTaskHandle = nullptr;
+
+// Adaptive batching state (written by SerialTxTask only)
+static uint32_t serialDrainBytesPerMs = SERIAL_DRAIN_INITIAL_BPMS;
+static uint32_t serialBatchBudget = SERIAL_BATCH_MAX_BYTES;
+
+// Wake SerialTxTask: a frame was queued or the host granted credits
+static inline void wakeSerialTx()
+{
+  if (serialTxTaskHandle != nullptr)
+  {
+    xTaskNotifyGive(serialTxTaskHandle);
+  }
+}
 
 // Diagnostic counters
 static volatile uint32_t serialTxDropCount = 0;
@@ -306,15 +389,56 @@ static volatile bool serialQueueOverloaded =
     false; // Flag for potential throttle signaling
 
 // ============================================================================
-// OPP-7: USB Serial Flow Control
+// USB Serial Flow Control — credit window over the sync-frame ring
+// ============================================================================
+// The host grants sync-frame credits with {"cmd":"CREDIT","frames":N}\n as it
+// consumes frames. SerialTxTask sends one 0x25 frame per credit; without
+// credits, frames wait in the USB cursor of syncFrameRing. Control, JSON and
+// telemetry frames are never gated, so commands always get answers.
+//
+// If the host leaves frames waiting for SERIAL_CREDIT_STARVE_MS, the stream
+// declares LOSSY mode (0x09 FLOW packet): each credit then buys the newest
+// frame, the skipped backlog is reported as an explicit gap marker, and
+// CREDIT mode returns after SERIAL_LOSSY_RECOVER_MS without starvation.
+//
+// Until the first CREDIT the stream is OPEN (legacy hosts). Legacy PAUSE
+// enters credit mode with a zero balance; RESUME returns to OPEN.
+// START/STOP streaming, a USB host disconnect, and SERIAL_CREDIT_IDLE_OPEN_MS
+// without a CREDIT (or PAUSE) also return to OPEN with nothing granted, so a
+// departed host cannot leave the next one throttled. A credit host that is
+// withholding credits keeps the mode alive with zero-frame CREDITs.
+// Granted/used are monotonic counters with one writer each (command path /
+// SerialTxTask), so the balance needs no lock. SERIAL_TX telemetry reports
+// used as-is; the host diffs it against frames it received to write off
+// credits spent on frames lost in transit.
+// ============================================================================
+static constexpr uint32_t SERIAL_CREDIT_MAX_BALANCE = 1024;
+static constexpr uint32_t SERIAL_CREDIT_STARVE_MS = 250;
+static constexpr uint32_t SERIAL_LOSSY_RECOVER_MS = 1000;
+static constexpr uint32_t SERIAL_LOSSY_BACKLOG_FRAMES = 4;
+static constexpr uint32_t SERIAL_CREDIT_IDLE_OPEN_MS = 3000;
+static volatile bool serialCreditMode = false;
+static volatile uint32_t serialCreditGranted = 0; // Written by command path
+static volatile uint32_t serialLastCreditMs = 0;  // Written by command path
+static volatile uint32_t serialCreditUsed = 0;    // Written by SerialTxTask
+static volatile uint8_t serialFlowMode = TELEMETRY_FLOW_OPEN;
+
+static inline uint32_t serialCreditBalance()
+{
+  return serialCreditGranted - serialCreditUsed;
+}
+
+// ============================================================================
+// USB Serial Framing — legacy length prefix or COBS + CRC-32
 // ============================================================================
-// When the webapp can't keep up with 200Hz data, it sends {"cmd":"PAUSE"}\n
-// to temporarily stop enqueuing frames. {"cmd":"RESUME"}\n resumes.
-// This prevents silent frame drops and gives the app control over data flow.
+// {"cmd":"FRAMING","mode":"cobs"}\n switches the USB stream to
+// self-synchronising COBS frames (SerialFraming.h): a lost or corrupted byte
+// then costs one frame instead of a resync scan. Records stay in the legacy
+// [len lo][len hi][frame] form everywhere (queue, sync-frame ring, WebSocket,
+// BLE) and are re-encoded only when written to USB, so the mode is read once
+// per write under serialWriteMutex. Boots in legacy framing.
 // ============================================================================
-static volatile bool serialTxPaused = false;
-static volatile uint32_t serialPauseCount = 0;  // Times paused
-static volatile uint32_t serialResumeCount = 0; // Times resumed
+static volatile uint8_t serialFramingMode = SERIAL_FRAMING_LEGACY;
 
 // ============================================================================
 // PROTOCOL TASK (Core 0) - Jitter-Free Beacon & Sync Frame Emission
@@ -332,7 +456,6 @@ static volatile bool protocolTaskRunning = false;
 
 // Protocol task statistics
 static volatile uint32_t beaconTxCount = 0;
-static volatile uint32_t beaconJitterMaxUs = 0;
 static volatile uint32_t syncFrameEmitCount = 0;
 
 // Forward declaration
@@ -366,6 +489,7 @@ struct EspNowRxPacket
 {
   uint8_t data[ESPNOW_RX_BUFFER_SIZE];
   uint16_t len; // uint16_t to hold sizes > 255
+  uint32_t rxUs; // micros() in the RX callback (latency stats)
 };
 
 static constexpr size_t ESPNOW_RX_QUEUE_SIZE =
@@ -411,6 +535,19 @@ static inline size_t writeUsbFifoDirect(const uint8_t *data, size_t len)
   return offset;
 }
 
+// Direct-path emitters: raw FIFO writes in legacy framing; in COBS framing
+// the record goes through the mutex-protected encoder instead, so it cannot
+// land inside another COBS frame
+static inline void writeUsbRecordDirect(const uint8_t *record, size_t len)
+{
+  if (serialFramingMode == SERIAL_FRAMING_COBS)
+  {
+    writeSerialRecords(record, len);
+    return;
+  }
+  writeUsbFifoDirect(record, len);
+}
+
 static inline void emitCompactSyncStatusDirect()
 {
   const uint32_t now = millis();
@@ -476,7 +613,7 @@ static inline void emitCompactSyncStatusDirect()
       "{\"type\":\"sync_status\",\"tdmaState\":\"%s\",\"isStreaming\":%s,"
       "\"nodeCount\":%u,\"nodes\":%s,"
       "\"syncBuffer\":{\"initialized\":%s,\"expectedSensors\":%u,\"authoritativeExpectedSensors\":%u,\"activeStreamingSensors\":%u,\"completedFrames\":%lu,\"trulyComplete\":%lu,\"partialRecovery\":%lu,\"dropped\":%lu,\"incomplete\":%lu,\"trueSyncRate\":%.2f},"
-      "\"serialTx\":{\"frames\":%lu,\"drops\":%lu,\"queueFree\":%u,\"paused\":%s},"
+      "\"serialTx\":{\"frames\":%lu,\"drops\":%lu,\"queueFree\":%u,\"paused\":%s,\"credits\":%lu,\"flowMode\":%u},"
       "\"ready\":%s,\"readiness\":{\"tdmaRunning\":%s,\"hasAliveNodes\":%s,\"bufferReady\":%s,\"syncQualityOk\":%s,\"syncRate\":%.2f}}",
       syncManager.getTDMAStateName(),
       isStreaming ? "true" : "false",
@@ -495,7 +632,11 @@ static inline void emitCompactSyncStatusDirect()
       (unsigned long)serialTxFrameCount,
       (unsigned long)serialTxDropCount,
       (unsigned int)(serialTxQueue ? uxQueueSpacesAvailable(serialTxQueue) : 0),
-      serialTxPaused ? "true" : "false",
+      serialFlowMode != TELEMETRY_FLOW_OPEN && serialCreditBalance() == 0
+          ? "true"
+          : "false",
+      (unsigned long)serialCreditBalance(),
+      (unsigned int)serialFlowMode,
       ready ? "true" : "false",
       tdmaRunning ? "true" : "false",
       hasAliveNodes ? "true" : "false",
@@ -521,7 +662,7 @@ static inline void emitCompactSyncStatusDirect()
   frame[2] = 0x06;
   memcpy(frame + 3, json, safeLen);
 
-  writeUsbFifoDirect(frame, 3 + safeLen);
+  writeUsbRecordDirect(frame, 3 + safeLen);
 }
 
 static inline void emitPipelineDiagDirect()
@@ -557,7 +698,7 @@ static inline void emitPipelineDiagDirect()
   frame[2] = 0x06;
   memcpy(frame + 3, json, safeLen);
 
-  writeUsbFifoDirect(frame, 3 + safeLen);
+  writeUsbRecordDirect(frame, 3 + safeLen);
 }
 
 static inline void emitBootJsonFrameDirect(const char *phase)
@@ -587,7 +728,7 @@ static inline void emitBootJsonFrameDirect(const char *phase)
   frame[2] = 0x06;
   memcpy(frame + 3, json, (size_t)jsonLen);
 
-  writeUsbFifoDirect(frame, (size_t)(3 + jsonLen));
+  writeUsbRecordDirect(frame, (size_t)(3 + jsonLen));
 }
 
 // ============================================================================
@@ -755,6 +896,10 @@ void setup()
   {
     Serial.println("[Setup] CRITICAL: SyncFrameBuffer slot allocation failed!");
   }
+  if (!syncFrameRing.allocate())
+  {
+    Serial.println("[Setup] CRITICAL: SyncFrameRing allocation failed!");
+  }
 
   // Initialize NeoPixel
   if (boardHasNeoPixel)
@@ -802,6 +947,14 @@ void setup()
   commandHandler.setTDMARescanCallback(onTDMARescan);
   commandHandler.setExpectedNodesCallback(onSetExpectedNodes);
   commandHandler.setClearTopologyCallback(onClearTopology);
+  commandHandler.setLatencyStatsCallback(onGetLatency);
+  commandHandler.setGapFillCallback(onGapFillCommand);
+#if ENABLE_TRACE_RING
+  commandHandler.setTraceCallback(onTraceCommand);
+#endif
+#if ENABLE_SESSION_RECORDER
+  commandHandler.setRecorderCallback(onRecorderCommand);
+#endif
   commandHandler.setAcceptNodeCallback(onAcceptNode);
   commandHandler.setRejectNodeCallback(onRejectNode);
   commandHandler.setPendingNodesCallback(onGetPendingNodes);
@@ -892,13 +1045,13 @@ void setup()
   // Serial TX Task: Batched USB writes
   // Priority 2 = above idle, below critical tasks
   // Pin to Core 0 to keep Core 1 free for VQF/Data processing
-  xTaskCreatePinnedToCore(SerialTxTask,   // Task function
-                          "SerialTxTask", // Name
-                          8192,           // Stack size
-                          nullptr,        // Parameters
-                          2,              // Priority
-                          nullptr,        // Task handle (not needed)
-                          0               // Core 0 (System Core)
+  xTaskCreatePinnedToCore(SerialTxTask,        // Task function
+                          "SerialTxTask",      // Name
+                          8192,                // Stack size
+                          nullptr,             // Parameters
+                          2,                   // Priority
+                          &serialTxTaskHandle, // Woken by wakeSerialTx()
+                          0                    // Core 0 (System Core)
   );
   Serial.println("[Setup] Serial TX task pinned to Core 0");
 
@@ -943,12 +1096,13 @@ void setup()
   // while DataIngestionTask writes from Core 1.
   //
   // Sync/Protocol Task: Handles Beacons and TDMA state (Core 0 only)
-  // Priority 3 = Real-time radio operations
+  // Priority 12 = above every application task (AsyncTCP runs at 10) so the
+  // beacon timer notify preempts them; below lwIP, esp_timer and WiFi tasks.
   xTaskCreatePinnedToCore(ProtocolTask,        // Task function
                           "ProtocolTask",      // Name
                           8192,                // Stack size (bytes)
                           nullptr,             // Parameters
-                          3,                   // Priority
+                          12,                  // Priority
                           &protocolTaskHandle, // Task handle
                           0                    // Core 0 (WiFi/ESP-NOW stack)
   );
@@ -1081,7 +1235,7 @@ void setup()
                  packet.lastResetReason,
                  packet.recoveryActive ? "true" : "false",
                  (unsigned long)packet.uptimeMs);
-        enqueueJsonFrame(String(json));
+        enqueueJsonFrame(json);
 
         Serial.printf("[Gateway] PowerDiag node=%u brownouts=%lu reason=%u\n",
                       packet.nodeId,
@@ -1117,7 +1271,7 @@ void setup()
                  packet.staleIncompleteDrops,
                  packet.maxQueueDepth,
                  (unsigned long)packet.currentFrame);
-        enqueueJsonFrame(String(json));
+        enqueueJsonFrame(json);
 
         Serial.printf("[Gateway] TDMADiag node=%u attempts=%u success=%u fail=%u stalls=%u staleDrops=%u qMax=%u\n",
                       packet.nodeId,
@@ -1139,6 +1293,35 @@ void setup()
       return;
     }
 
+    // IMU calibration progress (0x0C) should ALWAYS be forwarded as JSON event
+    if (packetType == IMU_CALIB_PACKET) {
+      if (len == sizeof(ESPNowImuCalibPacket)) {
+        ESPNowImuCalibPacket packet;
+        memcpy(&packet, data, sizeof(packet));
+
+        char json[256];
+        int n = snprintf(json, sizeof(json),
+                         "{\"type\":\"imu_calibration_progress\",\"nodeId\":%u,\"calibratingMask\":%u,\"failedMask\":%u,\"calibratedMask\":%u,\"progress\":[",
+                         packet.nodeId,
+                         packet.calibratingMask,
+                         packet.failedMask,
+                         packet.calibratedMask);
+        uint8_t count = min<uint8_t>(packet.sensorCount, MAX_SENSORS);
+        for (uint8_t i = 0; i < count; i++) {
+          n += snprintf(json + n, sizeof(json) - n, "%s%u", i ? "," : "",
+                        packet.progress[i]);
+        }
+        n += snprintf(json + n, sizeof(json) - n, "],\"motionResets\":[");
+        for (uint8_t i = 0; i < count; i++) {
+          n += snprintf(json + n, sizeof(json) - n, "%s%u", i ? "," : "",
+                        packet.motionResets[i]);
+        }
+        snprintf(json + n, sizeof(json) - n, "]}");
+        enqueueJsonFrame(json);
+      }
+      return;
+    }
+
     // Magnetometer Calibration Progress (0x07) should ALWAYS be processed
     if (packetType == MAG_CALIB_PACKET) {
       if (len == sizeof(ESPNowMagCalibPacket)) {
@@ -1219,6 +1402,7 @@ void setup()
       if (espNowRxQueue != nullptr && useSyncFrameMode &&
           syncFrameBufferInitialized) {
         EspNowRxPacket rxPkt;
+        rxPkt.rxUs = micros();
         rxPkt.len = (len <= sizeof(rxPkt.data)) ? len : sizeof(rxPkt.data);
         memcpy(rxPkt.data, data, rxPkt.len);
         if (len > sizeof(rxPkt.data)) {
@@ -1290,7 +1474,7 @@ void setup()
       snprintf(json, sizeof(json),
                "{\"type\":\"node_registered\",\"nodeId\":%u,\"sensorCount\":%u,\"compactBase\":%u}",
                nodeId, sensorCount, compactBase);
-      enqueueJsonFrame(String(json));
+      enqueueJsonFrame(json);
     } });
 
   // Set callback for when inactive nodes are pruned (NVS stale topology fix)
@@ -1330,7 +1514,7 @@ void setup()
         snprintf(json, sizeof(json),
                  "{\"type\":\"node_pruned\",\"nodeId\":%u}",
                  prunedNodeIds[i]);
-        enqueueJsonFrame(String(json));
+        enqueueJsonFrame(json);
       }
     } });
 
@@ -1363,11 +1547,28 @@ void setup()
 
   // Initialize WebSocket
   // wsManager.begin(); // Removed: method does not exist
+  wsManager.setFrameRing(&syncFrameRing);
   wsManager.setMessageCallback([&](const String &msg)
                                {
     String response = commandHandler.processCommand(msg);
     wsManager.broadcast(response); });
 
+#if ENABLE_BLE_SYNC_STREAM
+  // BLE output for phone hosts: same 0x25 stream, MTU-packed notifications
+  bleManager.setFrameRing(&syncFrameRing);
+  bleManager.setCommandCallback([&](const String &msg)
+                                {
+    String response = commandHandler.processCommand(msg);
+    bleManager.sendResponse(response); });
+  bleManager.init(deviceName.c_str());
+  bleManager.startAdvertising();
+#endif
+
+#if ENABLE_SESSION_RECORDER
+  // Local copy of the 0x25 stream on flash/SD; idle until RECORD start
+  sessionRecorder.begin(&syncFrameRing, writeSerialRecords);
+#endif
+
   // WiFi connection is OPTIONAL - only connect if user explicitly requests it
   // Without WiFi router connection, ESP-NOW uses default channel 1
   // To enable auto-connect, uncomment the lines below:
@@ -1511,9 +1712,9 @@ void loop()
       hb["type"] = "usb_keepalive";
       hb["uptime_ms"] = nowMs;
       hb["heap_kb"] = ESP.getFreeHeap() / 1024;
-      String hbJson;
-      serializeJson(hb, hbJson);
-      enqueueJsonFrame(hbJson);
+      char hbJson[96];
+      size_t hbLen = serializeJson(hb, hbJson, sizeof(hbJson));
+      enqueueJsonFrame(hbJson, hbLen);
 
       lastUsbKeepaliveMs = nowMs;
     }
@@ -1568,6 +1769,10 @@ void loop()
     wsManager.loop();
   }
 
+#if ENABLE_BLE_SYNC_STREAM
+  bleManager.pumpSyncFrames();
+#endif
+
   // NOTE (BUG 1 FIX): syncManager.update() is NOT called here.
   // ProtocolTask on Core 0 already calls it at 50Hz with precise timing.
   // Calling it from loop() (Core 1) simultaneously caused unsynchronized
@@ -1624,12 +1829,17 @@ void loop()
     magPacketReceived = false; // Clear flag
 
     // Process the buffered packet (safe context)
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<768> doc;
     doc["type"] = "mag_calibration_progress";
     doc["nodeId"] = magPacketBuffer.nodeId;
     doc["progress"] = magPacketBuffer.progress;
     doc["isCalibrating"] = magPacketBuffer.isCalibrating ? true : false;
     doc["isCalibrated"] = magPacketBuffer.isCalibrated ? true : false;
+    doc["coverage"] = magPacketBuffer.coverage;
+    if (magPacketBuffer.fitErrorTenths != 255)
+    {
+      doc["fitErrorPct"] = magPacketBuffer.fitErrorTenths / 10.0f;
+    }
 
     // Include calibration data if calibrated
     if (magPacketBuffer.isCalibrated)
@@ -1644,6 +1854,12 @@ void loop()
       softIron["y"] = magPacketBuffer.softIronScaleY;
       softIron["z"] = magPacketBuffer.softIronScaleZ;
 
+      JsonArray matrix = doc.createNestedArray("softIron");
+      for (uint8_t i = 0; i < 9; i++)
+      {
+        matrix.add(magPacketBuffer.softIron[i]);
+      }
+
       doc["sampleCount"] = magPacketBuffer.sampleCount;
     }
 
@@ -0,0 +1,554 @@
+/**
+ * SessionRecorder.cpp - Sync-frame session recorder (Gateway)
+ */
+
+// IMPORTANT: Define DEVICE_ROLE before including Config.h
+#define DEVICE_ROLE DEVICE_ROLE_GATEWAY
+
+#include "SessionRecorder.h"
+#include "Config.h"
+#if SESSION_RECORDER_INTERNAL_FLASH
+#include <LittleFS.h>
+#endif
+#if SESSION_RECORDER_SD_CS_PIN >= 0
+#include <SD.h>
+#include <SPI.h>
+#endif
+
+SessionRecorder::SessionRecorder()
+    : fs(nullptr), onSd(false), ring(nullptr), writer(nullptr),
+      task(nullptr), historicalQueue(nullptr), page(nullptr),
+      request(REQUEST_NONE), recording(false),
+      downloading(false), sessionId(0), nextSessionId(1), startDrops(0),
+      chunkDrops(0), startedMs(0), downloadId(0), downloadFirst(0),
+      downloadCount(0), chunksWritten(0), bytesWritten(0), sessionFreeBytes(0),
+      maxPageWriteUs(0), historicalRecords(0), historicalDropped(0),
+      lastStopReason("none")
+{
+  memset(&header, 0, sizeof(header));
+}
+
+bool SessionRecorder::begin(SyncFrameRing *frameRing, SessionWriteFn write)
+{
+  ring = frameRing;
+  writer = write;
+
+#if SESSION_RECORDER_SD_CS_PIN >= 0
+  if (SD.begin(SESSION_RECORDER_SD_CS_PIN))
+  {
+    fs = &SD;
+    onSd = true;
+  }
+#endif
+#if SESSION_RECORDER_INTERNAL_FLASH
+  if (fs == nullptr)
+  {
+    // Formats the data partition on first boot
+    if (!LittleFS.begin(true))
+    {
+      SAFE_PRINTLN("[Recorder] No SD card and LittleFS mount failed - disabled");
+      return false;
+    }
+    fs = &LittleFS;
+  }
+#endif
+  if (fs == nullptr)
+  {
+    SAFE_PRINTLN("[Recorder] No SD card - disabled (internal flash needs "
+                 "SESSION_RECORDER_INTERNAL_FLASH)");
+    return false;
+  }
+
+  page = (uint8_t *)heap_caps_malloc(SESSION_PAGE_SIZE, MALLOC_CAP_SPIRAM);
+  if (page == nullptr)
+  {
+    page = (uint8_t *)heap_caps_malloc(SESSION_PAGE_SIZE, MALLOC_CAP_INTERNAL);
+  }
+  if (page == nullptr)
+  {
+    SAFE_PRINTLN("[Recorder] CRITICAL: Failed to allocate page buffer!");
+    return false;
+  }
+
+  if (!fs->exists(SESSION_DIR))
+  {
+    fs->mkdir(SESSION_DIR);
+  }
+
+  // Continue numbering after the newest session on the card
+  fs::File dir = fs->open(SESSION_DIR);
+  for (fs::File f = dir.openNextFile(); f; f = dir.openNextFile())
+  {
+    unsigned id = 0;
+    if (sscanf(f.name(), "s%u.idx", &id) == 1 && id >= nextSessionId &&
+        id < 0xFFFF)
+    {
+      nextSessionId = id + 1;
+    }
+  }
+  dir.close();
+
+  historicalQueue =
+      xQueueCreate(SESSION_HISTORICAL_QUEUE, sizeof(HistoricalRecord));
+
+  xTaskCreatePinnedToCore(taskEntry, "Recorder", 4096, this, 1, &task, 1);
+
+  SAFE_LOG("[Recorder] %s, %u KB free, next session %u\n",
+           onSd ? "SD card" : "LittleFS", (unsigned)(freeBytes() / 1024),
+           nextSessionId);
+  return true;
+}
+
+// ============================================================================
+// Requests (command context)
+// ============================================================================
+
+bool SessionRecorder::start()
+{
+  if (task == nullptr || recording || downloading ||
+      freeBytes() < SESSION_MIN_FREE_BYTES)
+  {
+    return false;
+  }
+  request = REQUEST_START;
+  xTaskNotifyGive(task);
+  return true;
+}
+
+bool SessionRecorder::stop()
+{
+  if (task == nullptr || !recording)
+  {
+    return false;
+  }
+  request = REQUEST_STOP;
+  xTaskNotifyGive(task);
+  return true;
+}
+
+bool SessionRecorder::download(uint16_t id, uint32_t firstChunk,
+                               uint32_t chunkCount)
+{
+  if (task == nullptr || recording || downloading)
+  {
+    return false;
+  }
+  char path[32];
+  sessionPath(path, sizeof(path), id, "idx");
+  if (!fs->exists(path))
+  {
+    return false;
+  }
+  downloadId = id;
+  downloadFirst = firstChunk;
+  downloadCount = chunkCount;
+  downloading = true;
+  request = REQUEST_DOWNLOAD;
+  xTaskNotifyGive(task);
+  return true;
+}
+
+bool SessionRecorder::remove(uint16_t id)
+{
+  if (fs == nullptr || downloading || (recording && id == sessionId))
+  {
+    return false;
+  }
+  char path[32];
+  sessionPath(path, sizeof(path), id, "idx");
+  bool removed = fs->remove(path);
+  sessionPath(path, sizeof(path), id, "msr");
+  removed = fs->remove(path) && removed;
+  return removed;
+}
+
+void SessionRecorder::recordHistorical(const uint8_t *packet, size_t len)
+{
+  if (!recording || len == 0 || len > SESSION_HISTORICAL_MAX)
+  {
+    return;
+  }
+  HistoricalRecord rec;
+  rec.len = (uint8_t)len;
+  memcpy(rec.data, packet, len);
+  if (historicalQueue == nullptr ||
+      xQueueSend(historicalQueue, &rec, 0) != pdTRUE)
+  {
+    historicalDropped++;
+  }
+}
+
+void SessionRecorder::getStatus(JsonDocument &out) const
+{
+  out["enabled"] = fs != nullptr;
+  out["storage"] = onSd ? "sd" : "littlefs";
+  out["recording"] = (bool)recording;
+  out["downloading"] = (bool)downloading;
+  out["session"] = recording ? sessionId : 0;
+  out["chunks"] = chunksWritten;
+  out["bytes"] = bytesWritten;
+  out["durationMs"] = recording ? millis() - startedMs : 0;
+  out["droppedFrames"] = header.droppedFrames;
+  out["maxPageWriteUs"] = maxPageWriteUs;
+  out["historicalRecords"] = historicalRecords;
+  out["historicalDropped"] = historicalDropped;
+  out["freeBytes"] = (uint32_t)(recording ? sessionFreeBytes : freeBytes());
+  out["lastStop"] = lastStopReason;
+}
+
+void SessionRecorder::listSessions(JsonArray out)
+{
+  if (fs == nullptr)
+  {
+    return;
+  }
+  fs::File dir = fs->open(SESSION_DIR);
+  for (fs::File f = dir.openNextFile(); f; f = dir.openNextFile())
+  {
+    unsigned id = 0;
+    if (sscanf(f.name(), "s%u.idx", &id) != 1)
+    {
+      continue;
+    }
+    uint32_t chunks = f.size() / sizeof(SessionChunkHeader);
+    JsonObject s = out.createNestedObject();
+    s["session"] = id;
+    s["chunks"] = chunks;
+    s["bytes"] = chunks * SESSION_PAGE_SIZE;
+    s["active"] = recording && id == sessionId;
+    if (chunks == 0)
+    {
+      continue;
+    }
+
+    // First and last index entries give the session's frame/time range
+    SessionChunkHeader first, last;
+    f.seek(0);
+    f.read((uint8_t *)&first, sizeof(first));
+    f.seek((chunks - 1) * sizeof(SessionChunkHeader));
+    f.read((uint8_t *)&last, sizeof(last));
+    s["firstFrame"] = first.firstFrame;
+    s["lastFrame"] = last.lastFrame;
+    s["durationMs"] = (last.lastTimestampUs - first.firstTimestampUs) / 1000;
+    s["droppedFrames"] = last.droppedFrames;
+    s["complete"] = (last.flags & SESSION_CHUNK_FLAG_FINAL) != 0;
+  }
+  dir.close();
+}
+
+// ============================================================================
+// Recorder task
+// ============================================================================
+
+void SessionRecorder::taskEntry(void *param)
+{
+  static_cast<SessionRecorder *>(param)->taskLoop();
+}
+
+void SessionRecorder::taskLoop()
+{
+  for (;;)
+  {
+    // Commands notify; while recording, wake anyway to batch the ring
+    ulTaskNotifyTake(pdTRUE, recording ? pdMS_TO_TICKS(SESSION_POLL_MS)
+                                       : portMAX_DELAY);
+
+    Request pending = request;
+    request = REQUEST_NONE;
+    if (pending == REQUEST_START && !recording)
+    {
+      openSession();
+    }
+    else if (pending == REQUEST_DOWNLOAD)
+    {
+      runDownload();
+      downloading = false;
+    }
+
+    if (recording)
+    {
+      drainRing();
+      if (recording && pending == REQUEST_STOP)
+      {
+        closeSession("stopped");
+      }
+    }
+  }
+}
+
+void SessionRecorder::openSession()
+{
+  char path[32];
+  sessionId = nextSessionId++;
+  sessionPath(path, sizeof(path), sessionId, "msr");
+  dataFile = fs->open(path, FILE_WRITE);
+  sessionPath(path, sizeof(path), sessionId, "idx");
+  indexFile = fs->open(path, FILE_WRITE);
+  if (!dataFile || !indexFile)
+  {
+    SAFE_LOG("[Recorder] Cannot create session %u\n", sessionId);
+    dataFile.close();
+    indexFile.close();
+    lastStopReason = "open failed";
+    return;
+  }
+
+  ring->attach(FRAME_SINK_RECORDER);
+  SyncFrameRing::SinkStats stats;
+  ring->getSinkStats(FRAME_SINK_RECORDER, stats);
+  startDrops = stats.framesDropped;
+  chunkDrops = startDrops;
+  chunksWritten = 0;
+  bytesWritten = 0;
+  sessionFreeBytes = freeBytes(); // Counted down per page from here on
+  maxPageWriteUs = 0;
+  historicalRecords = 0;
+  historicalDropped = 0;
+  if (historicalQueue != nullptr)
+  {
+    xQueueReset(historicalQueue);
+  }
+  startedMs = millis();
+  sessionChunkBegin(header, sessionId, 0);
+  recording = true;
+
+  SAFE_LOG("[Recorder] Session %u started\n", sessionId);
+}
+
+void SessionRecorder::drainRing()
+{
+  if (!drainHistorical())
+  {
+    closeSession("storage full");
+    return;
+  }
+  for (;;)
+  {
+    // Read straight into the page; 0 with frames pending means it is full
+    uint8_t *dst = page + sizeof(SessionChunkHeader) + header.usedBytes;
+    size_t room = SESSION_CHUNK_PAYLOAD_MAX - header.usedBytes;
+    size_t n = ring->read(FRAME_SINK_RECORDER, dst, room);
+    if (n > 0)
+    {
+      if (header.recordCount == 0)
+      {
+        // Drops are attributed to the chunk that follows them
+        SyncFrameRing::SinkStats stats;
+        ring->getSinkStats(FRAME_SINK_RECORDER, stats);
+        if (stats.framesDropped != chunkDrops)
+        {
+          header.flags |= SESSION_CHUNK_FLAG_GAP;
+          chunkDrops = stats.framesDropped;
+        }
+        header.droppedFrames = chunkDrops - startDrops;
+      }
+      sessionChunkAddRecord(header, dst, n);
+      continue;
+    }
+    if (ring->pending(FRAME_SINK_RECORDER) == 0)
+    {
+      return;
+    }
+    if (!writePage(false))
+    {
+      closeSession("storage full");
+      return;
+    }
+  }
+}
+
+// Move queued historical packets into the page. false if storage ran out.
+bool SessionRecorder::drainHistorical()
+{
+  HistoricalRecord rec;
+  while (historicalQueue != nullptr &&
+         xQueuePeek(historicalQueue, &rec, 0) == pdTRUE)
+  {
+    if (!appendRecord(rec.data, rec.len))
+    {
+      if (!writePage(false))
+      {
+        return false;
+      }
+      continue; // Fits in the fresh page
+    }
+    xQueueReceive(historicalQueue, &rec, 0);
+    historicalRecords++;
+  }
+  return true;
+}
+
+// Copy one [len][frame] record into the page; false if it does not fit
+bool SessionRecorder::appendRecord(const uint8_t *frame, size_t len)
+{
+  if (header.usedBytes + 2 + len > SESSION_CHUNK_PAYLOAD_MAX)
+  {
+    return false;
+  }
+  uint8_t *dst = page + sizeof(SessionChunkHeader) + header.usedBytes;
+  dst[0] = (uint8_t)(len & 0xFF);
+  dst[1] = (uint8_t)((len >> 8) & 0xFF);
+  memcpy(dst + 2, frame, len);
+  sessionChunkAddRecord(header, dst, 2 + len);
+  return true;
+}
+
+bool SessionRecorder::writePage(bool final)
+{
+  if (final)
+  {
+    header.flags |= SESSION_CHUNK_FLAG_FINAL;
+  }
+  sessionChunkSeal(header, page + sizeof(SessionChunkHeader));
+  memcpy(page, &header, sizeof(header));
+  size_t used = sizeof(SessionChunkHeader) + header.usedBytes;
+  memset(page + used, 0xFF, SESSION_PAGE_SIZE - used);
+
+  uint32_t t0 = micros();
+  bool ok = dataFile.write(page, SESSION_PAGE_SIZE) == SESSION_PAGE_SIZE &&
+            indexFile.write((const uint8_t *)&header, sizeof(header)) ==
+                sizeof(header);
+  if (ok && (header.chunkIndex + 1) % SESSION_SYNC_CHUNKS == 0)
+  {
+    dataFile.flush();
+    indexFile.flush();
+  }
+  uint32_t elapsed = micros() - t0;
+  if (elapsed > maxPageWriteUs)
+  {
+    maxPageWriteUs = elapsed;
+  }
+  if (!ok)
+  {
+    return false;
+  }
+
+  chunksWritten++;
+  bytesWritten += SESSION_PAGE_SIZE;
+  const size_t pageCost = SESSION_PAGE_SIZE + sizeof(header);
+  sessionFreeBytes =
+      sessionFreeBytes > pageCost ? sessionFreeBytes - pageCost : 0;
+  sessionChunkBegin(header, sessionId, header.chunkIndex + 1);
+  return sessionFreeBytes >= 2 * SESSION_PAGE_SIZE;
+}
+
+void SessionRecorder::closeSession(const char *reason)
+{
+  ring->detach(FRAME_SINK_RECORDER);
+  if (header.usedBytes > 0 || chunksWritten == 0)
+  {
+    writePage(true);
+  }
+  dataFile.close();
+  indexFile.close();
+  recording = false;
+  lastStopReason = reason;
+
+  SAFE_LOG("[Recorder] Session %u %s: %lu chunks, %lu dropped, "
+           "%lu backfill packets, max page write %lu us\n",
+           sessionId, reason, (unsigned long)chunksWritten,
+           (unsigned long)header.droppedFrames,
+           (unsigned long)historicalRecords, (unsigned long)maxPageWriteUs);
+}
+
+// ============================================================================
+// Download (0x0A stream, SessionFormat.h)
+// ============================================================================
+
+void SessionRecorder::runDownload()
+{
+  char path[32];
+  sessionPath(path, sizeof(path), downloadId, "idx");
+  fs::File index = fs->open(path, FILE_READ);
+  sessionPath(path, sizeof(path), downloadId, "msr");
+  fs::File data = fs->open(path, FILE_READ);
+  if (!index || !data)
+  {
+    index.close();
+    data.close();
+    return;
+  }
+
+  // Whole index first, so the host can place and verify every chunk
+  uint32_t chunks = data.size() / SESSION_PAGE_SIZE;
+  uint32_t first = downloadFirst < chunks ? downloadFirst : chunks;
+  uint32_t count = chunks - first;
+  if (downloadCount > 0 && downloadCount < count)
+  {
+    count = downloadCount;
+  }
+  bool ok = streamFile(index, SESSION_FILE_INDEX, 0, index.size()) &&
+            streamFile(data, SESSION_FILE_DATA, first * SESSION_PAGE_SIZE,
+                       count * SESSION_PAGE_SIZE);
+  index.close();
+  data.close();
+
+  SAFE_LOG("[Recorder] Download of session %u %s (%lu chunks)\n", downloadId,
+           ok ? "done" : "failed", (unsigned long)count);
+}
+
+bool SessionRecorder::streamFile(fs::File &file, uint8_t kind, uint32_t offset,
+                                 uint32_t length)
+{
+  // Not recording, so the page buffer holds one piece at a time
+  uint8_t *record = page;
+  const uint32_t fileSize = file.size();
+  const uint32_t end = offset + length;
+  file.seek(offset);
+
+  for (;;)
+  {
+    uint32_t n = end - offset;
+    if (n > SESSION_DOWNLOAD_PIECE_MAX)
+    {
+      n = SESSION_DOWNLOAD_PIECE_MAX;
+    }
+    uint8_t *body = record + 2 + SESSION_DOWNLOAD_HEADER_SIZE;
+    if (n > 0 && file.read(body, n) != n)
+    {
+      return false;
+    }
+
+    const size_t frameLen = SESSION_DOWNLOAD_HEADER_SIZE + n;
+    record[0] = (uint8_t)(frameLen & 0xFF);
+    record[1] = (uint8_t)(frameLen >> 8);
+    record[2] = SESSION_PACKET_TYPE;
+    record[3] = kind;
+    memcpy(record + 4, &downloadId, 2);
+    memcpy(record + 6, &offset, 4);
+    memcpy(record + 10, &fileSize, 4);
+    writer(record, 2 + frameLen);
+
+    if (n == 0)
+    {
+      return true; // Empty piece marks the end of this file
+    }
+    offset += n;
+  }
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+size_t SessionRecorder::freeBytes() const
+{
+#if SESSION_RECORDER_SD_CS_PIN >= 0
+  if (onSd)
+  {
+    uint64_t free = SD.totalBytes() - SD.usedBytes();
+    return free > SIZE_MAX ? SIZE_MAX : (size_t)free;
+  }
+#endif
+#if SESSION_RECORDER_INTERNAL_FLASH
+  return (fs != nullptr) ? LittleFS.totalBytes() - LittleFS.usedBytes() : 0;
+#else
+  return 0;
+#endif
+}
+
+void SessionRecorder::sessionPath(char *out, size_t len, uint16_t id,
+                                  const char *ext)
+{
+  snprintf(out, len, SESSION_DIR "/s%04u.%s", id, ext);
+}
@@ -0,0 +1,168 @@
+/**
+ * SessionRecorder.h - On-gateway recording of sync frames to flash or SD
+ *
+ * PURPOSE:
+ * Keeps a copy of every emitted 0x25 frame on the Gateway itself, so a
+ * session survives a host that disconnects, sleeps or drops USB data, and
+ * can be downloaded afterwards. The recorder is one more SyncFrameRing sink
+ * (FRAME_SINK_RECORDER); ProtocolTask does no extra work while it runs.
+ *
+ * STORAGE:
+ * SD card when SESSION_RECORDER_SD_CS_PIN is set and a card mounts. The
+ * internal LittleFS data partition is only a fallback on builds with
+ * SESSION_RECORDER_INTERNAL_FLASH: its writes disable the flash cache on
+ * both cores and stall the real-time tasks (Config.h). File layout, chunk
+ * index and the 0x0A download stream are described in SessionFormat.h.
+ *
+ * WRITES:
+ * A low-priority task on Core 1 wakes every SESSION_POLL_MS, copies pending
+ * records from the ring straight into a one-page buffer and writes the page
+ * (one erase block) when the next record no longer fits. The ring absorbs
+ * the write stall (~1.3 s in PSRAM); anything beyond that is lapped and
+ * counted in the chunk headers (SESSION_CHUNK_FLAG_GAP). Files are synced
+ * every SESSION_SYNC_CHUNKS pages, which bounds the loss on power-off.
+ * Free space is read once per session and counted down per page; the
+ * filesystem is not queried from the write path.
+ *
+ * BACKFILL:
+ * Historical 0x26 packets (Node black box, NODE_DATA_FLAG_HISTORICAL) are
+ * handed over by DataIngestionTask through recordHistorical() and written
+ * into the same pages. session_tool.py splices them over the gaps of the
+ * recorded frames on export.
+ *
+ * Internal flash holds only short sessions (~67 KB/s at 20 sensors, 200 Hz);
+ * use an SD card for long recordings. Recording stops cleanly when the
+ * storage is full.
+ *
+ * COMMANDS ({"cmd":"RECORD","action":...}):
+ *   start | stop | status | list
+ *   download  "session":n ["chunk":k, "count":c]  (index, then data chunks)
+ *   delete    "session":n
+ */
+
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include "../libraries/IMUConnectCore/src/SessionFormat.h"
+#include "SyncFrameRing.h"
+
+#define SESSION_DIR "/sessions"
+
+// Writes one [len lo][len hi][frame] record stream to the host (USB)
+typedef void (*SessionWriteFn)(const uint8_t *records, size_t len);
+
+class SessionRecorder
+{
+public:
+  SessionRecorder();
+
+  /**
+   * Mount storage, allocate the page buffer and start the recorder task.
+   * @return false if no storage could be mounted (recorder stays disabled)
+   */
+  bool begin(SyncFrameRing *ring, SessionWriteFn writer);
+
+  /**
+   * Requests, carried out by the recorder task. Each returns false when
+   * the request cannot be accepted now (busy, no storage, bad session).
+   */
+  bool start();
+  bool stop();
+  bool download(uint16_t sessionId, uint32_t firstChunk, uint32_t chunkCount);
+  bool remove(uint16_t sessionId);
+
+  void getStatus(JsonDocument &out) const;
+  void listSessions(JsonArray out);
+
+  bool isRecording() const { return recording; }
+
+  /**
+   * Queue a CRC-checked historical 0x26 packet for the active session.
+   * Never blocks; dropped (and counted) when not recording or the queue
+   * is full. Called from DataIngestionTask.
+   */
+  void recordHistorical(const uint8_t *packet, size_t len);
+
+private:
+  // Poll period of the recorder task while recording (~10 frames at 200 Hz)
+  static constexpr uint32_t SESSION_POLL_MS = 50;
+  // Data + index files are synced every this many pages
+  static constexpr uint32_t SESSION_SYNC_CHUNKS = 8;
+  // Refuse to start a session with less free space than this
+  static constexpr size_t SESSION_MIN_FREE_BYTES = 64 * 1024;
+  // Historical packets waiting for the recorder task (~3 backfill frames
+  // per poll at one per TDMA frame)
+  static constexpr uint8_t SESSION_HISTORICAL_QUEUE = 16;
+  static constexpr size_t SESSION_HISTORICAL_MAX = 250; // ESP-NOW payload
+
+  struct HistoricalRecord
+  {
+    uint8_t len;
+    uint8_t data[SESSION_HISTORICAL_MAX];
+  };
+
+  enum Request : uint8_t
+  {
+    REQUEST_NONE,
+    REQUEST_START,
+    REQUEST_STOP,
+    REQUEST_DOWNLOAD
+  };
+
+  static void taskEntry(void *param);
+  void taskLoop();
+
+  void openSession();
+  void drainRing();
+  bool drainHistorical();
+  bool appendRecord(const uint8_t *frame, size_t len);
+  bool writePage(bool final);
+  void closeSession(const char *reason);
+  void runDownload();
+  bool streamFile(fs::File &file, uint8_t kind, uint32_t offset,
+                  uint32_t length);
+
+  size_t freeBytes() const;
+  static void sessionPath(char *out, size_t len, uint16_t id, const char *ext);
+
+  fs::FS *fs;
+  bool onSd;
+  SyncFrameRing *ring;
+  SessionWriteFn writer;
+  TaskHandle_t task;
+  QueueHandle_t historicalQueue;
+  uint8_t *page; // SESSION_PAGE_SIZE, header + records
+
+  volatile Request request;
+  volatile bool recording;
+  volatile bool downloading;
+
+  // Active session (recorder task only)
+  fs::File dataFile;
+  fs::File indexFile;
+  SessionChunkHeader header;
+  uint16_t sessionId;
+  uint16_t nextSessionId;
+  uint32_t startDrops;
+  uint32_t chunkDrops;
+  uint32_t startedMs;
+
+  // Pending download
+  uint16_t downloadId;
+  uint32_t downloadFirst;
+  uint32_t downloadCount;
+
+  // Status
+  uint32_t chunksWritten;
+  uint32_t bytesWritten;
+  size_t sessionFreeBytes; // At session start, minus pages written
+  uint32_t maxPageWriteUs;
+  volatile uint32_t historicalRecords;
+  volatile uint32_t historicalDropped;
+  const char *lastStopReason;
+};
+
+#endif // SESSION_RECORDER_H
@@ -42,70 +42,97 @@ namespace
 // ============================================================================
 
 SyncFrameBuffer::SyncFrameBuffer()
-    : expectedSensorCount(0), effectiveSensorCount(0), oldestSlotIndex(0),
+    : expectedSensorCount(0), effectiveSensorCount(0), readyHead(0),
+      readyTail(0), sweepHead(0), sweepTail(0), readyNotifyTask(nullptr),
+      readyNotifyBits(0), readyOverflowCount(0), oldestSlotIndex(0),
       outputFrameNumber(0), completedFrameCount(0), trulyCompleteFrameCount(0),
       partialRecoveryFrameCount(0), droppedFrameCount(0),
-      incompleteFrameCount(0), lastUpdateMs(0), latestObservedSampleOrdinal(0),
-      slots(nullptr),
+      incompleteFrameCount(0), earlyEmitCount(0), lateSampleDropCount(0),
+      gapFilledCount(0), correctionRecordCount(0), correctionDroppedCount(0),
+      enviroRecordCount(0), enviroDroppedCount(0),
+      lastUpdateMs(0), latestObservedSampleOrdinal(0),
+      payload(nullptr), enviroPayload(nullptr),
       slotsAllocated(false)
 {
   // Initialize spinlock for thread safety
   portMUX_INITIALIZE(&_lock);
 
   memset(expectedSensorIds, 0, sizeof(expectedSensorIds));
+  memset(sensorColumn, -1, sizeof(sensorColumn));
   memset(sensorLastSeenMs, 0, sizeof(sensorLastSeenMs));
-  // Note: slots is allocated later via allocateSlots()
+  memset(slots, 0, sizeof(slots));
+  memset(lateness, 0, sizeof(lateness));
+  memset(arrivalTag, 0, sizeof(arrivalTag));
+  memset(arrivalFirstUs, 0, sizeof(arrivalFirstUs));
+  memset(arrivalEmitted, 0, sizeof(arrivalEmitted));
+  gapFillMode = SYNC_GAP_FILL_DEFAULT_MODE;
+  memset(gapHistory, 0, sizeof(gapHistory));
+  memset(arrivalFilled, 0, sizeof(arrivalFilled));
+  memset(arrivalOutputFrame, 0, sizeof(arrivalOutputFrame));
+  memset(correctionQueue, 0, sizeof(correctionQueue));
+  correctionHead = 0;
+  correctionTail = 0;
+  // Note: the payload is allocated later via allocateSlots()
 }
 
 SyncFrameBuffer::~SyncFrameBuffer()
 {
-  if (slots != nullptr)
+  if (payload != nullptr)
   {
-    heap_caps_free(slots);
-    slots = nullptr;
+    heap_caps_free(payload); // enviroPayload shares the allocation
+    payload = nullptr;
+    enviroPayload = nullptr;
   }
 }
 
 bool SyncFrameBuffer::allocateSlots()
 {
-  if (slotsAllocated && slots != nullptr)
+  if (slotsAllocated && payload != nullptr)
   {
     return true; // Already allocated
   }
 
-  size_t slotSize = sizeof(SyncTimestampSlot) * SYNC_TIMESTAMP_SLOTS;
+  // One block: sensor-major sample matrix, then the per-slot enviro records
+  const size_t payloadSize =
+      sizeof(SyncSensorSample) * SYNC_MAX_SENSORS * SYNC_TIMESTAMP_SLOTS;
+  const size_t enviroSize =
+      sizeof(SyncFrameEnviroData) * SYNC_SLOT_MAX_ENVIRO * SYNC_TIMESTAMP_SLOTS;
+  const size_t blockSize = payloadSize + enviroSize;
+  uint8_t *block = nullptr;
 
   // Try PSRAM first (2MB available on QT Py ESP32-S3)
   if (psramFound())
   {
-    slots = (SyncTimestampSlot *)heap_caps_malloc(slotSize, MALLOC_CAP_SPIRAM);
-    if (slots != nullptr)
+    block = (uint8_t *)heap_caps_malloc(blockSize, MALLOC_CAP_SPIRAM);
+    if (block != nullptr)
     {
-      SAFE_LOG("[SyncFrame] Allocated %d slots (%u bytes) in PSRAM\n",
-               SYNC_TIMESTAMP_SLOTS, slotSize);
+      SAFE_LOG("[SyncFrame] Allocated %d slots: %u bytes payload in PSRAM, "
+               "%u bytes metadata in SRAM\n",
+               SYNC_TIMESTAMP_SLOTS, blockSize, sizeof(slots));
     }
   }
 
   // Fallback to internal SRAM if PSRAM unavailable
-  if (slots == nullptr)
+  if (block == nullptr)
   {
-    slots =
-        (SyncTimestampSlot *)heap_caps_malloc(slotSize, MALLOC_CAP_INTERNAL);
-    if (slots != nullptr)
+    block = (uint8_t *)heap_caps_malloc(blockSize, MALLOC_CAP_INTERNAL);
+    if (block != nullptr)
     {
       SAFE_LOG("[SyncFrame] WARNING: PSRAM unavailable, allocated %d slots (%u "
-               "bytes) in internal SRAM\n",
-               SYNC_TIMESTAMP_SLOTS, slotSize);
+               "bytes payload) in internal SRAM\n",
+               SYNC_TIMESTAMP_SLOTS, blockSize);
     }
   }
 
-  if (slots == nullptr)
+  if (block == nullptr)
   {
     SAFE_PRINTLN("[SyncFrame] CRITICAL: Failed to allocate slot buffer!");
     return false;
   }
 
-  memset(slots, 0, slotSize);
+  memset(block, 0, blockSize);
+  payload = (SyncSensorSample *)block;
+  enviroPayload = (SyncFrameEnviroData *)(block + payloadSize);
   slotsAllocated = true;
   return true;
 }
@@ -138,8 +165,17 @@ void SyncFrameBuffer::setExpectedSensors(const uint8_t *sensorIds,
   portENTER_CRITICAL(&_lock);
   expectedSensorCount = count;
   memcpy(expectedSensorIds, sensorIds, count);
+  memset(sensorColumn, -1, sizeof(sensorColumn));
+  for (uint8_t i = count; i-- > 0;)
+  {
+    sensorColumn[sensorIds[i]] = (int8_t)i; // First occurrence wins
+  }
   effectiveSensorCount = count; // Initially assume all are active
   memset(sensorLastSeenMs, 0, sizeof(sensorLastSeenMs));
+  for (uint8_t i = 0; i < SYNC_MAX_SENSORS; i++)
+  {
+    lateness[i].reset(); // Columns may now belong to other sensors
+  }
   portEXIT_CRITICAL(&_lock);
 
   // Log OUTSIDE the spinlock (SAFE_LOG takes serialWriteMutex)
@@ -151,6 +187,27 @@ void SyncFrameBuffer::setExpectedSensors(const uint8_t *sensorIds,
   SAFE_PRINTLN("]");
 }
 
+void SyncFrameBuffer::setGapFillMode(uint8_t mode)
+{
+  if (mode > GAP_FILL_GYRO)
+    return;
+  gapFillMode = mode;
+  SAFE_LOG("[SyncFrame] Gap fill mode: %d\n", mode);
+}
+
+void SyncFrameBuffer::setReadyNotify(TaskHandle_t task, uint32_t bits)
+{
+  __atomic_store_n(&readyNotifyBits, bits, __ATOMIC_RELAXED);
+  __atomic_store_n(&readyNotifyTask, task, __ATOMIC_RELEASE);
+}
+
+void SyncFrameBuffer::countEnviroDropped()
+{
+  portENTER_CRITICAL(&_lock);
+  enviroDroppedCount++;
+  portEXIT_CRITICAL(&_lock);
+}
+
 // ============================================================================
 // Sample Ingestion
 // ============================================================================
@@ -159,10 +216,11 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
                                 uint8_t localSensorIndex,
                                 uint32_t timestampUs,
                                 uint32_t frameNumber, uint8_t sampleIndex,
-                                const int16_t *a, const int16_t *g)
+                                const int16_t *a, const int16_t *g,
+                                const NodeEnviroSample *enviro)
 {
-  // Guard: slots must be allocated before use
-  if (slots == nullptr)
+  // Guard: slot payload must be allocated before use
+  if (payload == nullptr)
     return false;
 
   // =========================================================================
@@ -219,12 +277,19 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
   }
 
   // Snapshot expected sensor configuration under lock to avoid races with
-  // setExpectedSensors() updates from another task/core.
+  // setExpectedSensors() updates from another task/core. The column comes
+  // from the sensorColumn[] map (O(1)) instead of a scan of the ID list.
+  int8_t sensorIndex = -1;
+#if SYNC_DEBUG
   uint8_t localExpectedSensorCount = 0;
   uint8_t localExpectedSensorIds[SYNC_MAX_SENSORS] = {0};
+#endif
   portENTER_CRITICAL(&_lock);
+  sensorIndex = sensorColumn[sensorId];
+#if SYNC_DEBUG
   localExpectedSensorCount = expectedSensorCount;
   memcpy(localExpectedSensorIds, expectedSensorIds, localExpectedSensorCount);
+#endif
   portEXIT_CRITICAL(&_lock);
 
   // =========================================================================
@@ -369,15 +434,6 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
   // =========================================================================
 
   // Validate sensor is expected
-  int8_t sensorIndex = -1;
-  for (uint8_t i = 0; i < localExpectedSensorCount; i++)
-  {
-    if (localExpectedSensorIds[i] == sensorId)
-    {
-      sensorIndex = i;
-      break;
-    }
-  }
   if (sensorIndex < 0)
   {
     // Unknown sensor - log occasionally
@@ -435,14 +491,68 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
   }
 #endif // SYNC_DEBUG
 
-  // Find or create a slot for this (frameNumber, sampleIndex) pair — the TDMA-authoritative key
   portENTER_CRITICAL(&_lock);
-  SyncTimestampSlot *slot = findOrCreateSlot(normalizedTs, frameNumber, sampleIndex);
   const uint64_t sampleOrdinal = getSampleOrdinal(frameNumber, sampleIndex);
   if (sampleOrdinal > latestObservedSampleOrdinal)
   {
     latestObservedSampleOrdinal = sampleOrdinal;
   }
+
+  // Lateness against the first arrival of this (frameNumber, sampleIndex),
+  // which is remembered past the slot's emission
+  const uint32_t arrivalUs = micros();
+  const uint32_t arrivalKey = (uint32_t)sampleOrdinal + 1;
+  const uint8_t arrivalIdx =
+      (uint8_t)(sampleOrdinal & (SYNC_ARRIVAL_HISTORY - 1));
+  if (arrivalTag[arrivalIdx] != arrivalKey)
+  {
+    arrivalTag[arrivalIdx] = arrivalKey;
+    arrivalFirstUs[arrivalIdx] = arrivalUs;
+    arrivalEmitted[arrivalIdx] = false;
+  }
+  lateness[sensorIndex].record(arrivalUs - arrivalFirstUs[arrivalIdx]);
+  sensorLastSeenMs[sensorIndex] = millis(); // Late or not, it is alive
+
+  // Its frame already left (deadline or timeout): never open a second,
+  // partial slot for the same moment. If that frame carried a synthesized
+  // record for this sensor, the real sample follows as a correction.
+  if (arrivalEmitted[arrivalIdx])
+  {
+    const uint32_t filledBit = 1u << sensorIndex;
+    if (!(arrivalFilled[arrivalIdx] & filledBit))
+    {
+      lateSampleDropCount++;
+      portEXIT_CRITICAL(&_lock);
+      return false;
+    }
+    arrivalFilled[arrivalIdx] &= ~filledBit;
+    if (correctionHead - correctionTail >= SYNC_CORRECTION_QUEUE_SIZE)
+    {
+      correctionDroppedCount++;
+      portEXIT_CRITICAL(&_lock);
+      return false;
+    }
+    SyncPendingCorrection &pending =
+        correctionQueue[correctionHead & (SYNC_CORRECTION_QUEUE_SIZE - 1)];
+    pending.sampleOrdinal = (uint32_t)sampleOrdinal;
+    pending.outputFrame = arrivalOutputFrame[arrivalIdx];
+    pending.column = (uint8_t)sensorIndex;
+    pending.sample.sensorId = sensorId;
+    pending.sample.rawNodeId = rawNodeId;
+    pending.sample.localSensorIndex = localSensorIndex;
+    memcpy(pending.sample.a, a, sizeof(pending.sample.a));
+    memcpy(pending.sample.g, g, sizeof(pending.sample.g));
+    correctionHead++;
+    if (enviro != nullptr)
+    {
+      enviroDroppedCount++; // Corrections carry IMU data only
+    }
+    portEXIT_CRITICAL(&_lock);
+    return true;
+  }
+
+  // Find or create a slot for this (frameNumber, sampleIndex) pair — the TDMA-authoritative key
+  SyncTimestampSlot *slot = findOrCreateSlot(normalizedTs, frameNumber, sampleIndex);
   if (!slot)
   {
     // Buffer full, oldest slot not yet complete
@@ -452,7 +562,8 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
   }
 
   // Check if this sensor already reported for this timestamp
-  if (slot->sensors[sensorIndex].present)
+  const uint32_t sensorBit = 1u << sensorIndex;
+  if (slot->presentMask & sensorBit)
   {
     portEXIT_CRITICAL(&_lock);
     // Duplicate - this shouldn't happen with proper timestamps
@@ -467,19 +578,78 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
     return false;
   }
 
-  // Store the sample
-  SyncSensorSample &sample = slot->sensors[sensorIndex];
-  sample.present = true;
+  // Store the sample (the only PSRAM write on this path)
+  const uint8_t slotIndex = (uint8_t)(slot - slots);
+  SyncSensorSample &sample = payloadAt((uint8_t)sensorIndex, slotIndex);
   sample.sensorId = sensorId;
   sample.rawNodeId = rawNodeId;               // S1-FIX: Physical identity
   sample.localSensorIndex = localSensorIndex; // S1-FIX: Local sensor index
   memcpy(sample.a, a, sizeof(sample.a));
   memcpy(sample.g, g, sizeof(sample.g));
-  sensorLastSeenMs[sensorIndex] = millis();
 
+  slot->presentMask |= sensorBit;
   slot->sensorsPresent++;
+
+  // Multi-rate extension: the node's mag/baro reading joins the slot in the
+  // same critical section, so it cannot miss a frame that this very sample
+  // completes.
+  if (enviro != nullptr)
+  {
+    if (slot->enviroCount < SYNC_SLOT_MAX_ENVIRO)
+    {
+      SyncFrameEnviroData &rec =
+          enviroPayload[slotIndex * SYNC_SLOT_MAX_ENVIRO + slot->enviroCount++];
+      rec.sensorId = sensorId;
+      memcpy(rec.mag, enviro->mag, sizeof(rec.mag));
+      rec.pressureCPa = enviro->pressureCPa;
+      rec.temperatureC = enviro->temperatureC;
+      rec.flags = SYNC_SENSOR_FLAG_ENVIRO;
+      rec.rawNodeId = rawNodeId;
+      rec.contents = enviro->contents;
+    }
+    else
+    {
+      enviroDroppedCount++;
+    }
+  }
+
+  // Completion is detected here, by the sample that completes the slot, so
+  // the frame can leave as soon as its last sensor arrives.
+  int16_t readyIndex = -1;
+  if (!slot->queued && isSlotComplete(*slot))
+  {
+    slot->queued = true;
+    readyIndex = slotIndex;
+  }
   portEXIT_CRITICAL(&_lock);
 
+  if (readyIndex >= 0)
+  {
+    const uint32_t head = readyHead;
+    const uint32_t tail = __atomic_load_n(&readyTail, __ATOMIC_ACQUIRE);
+    if (head - tail < SYNC_READY_QUEUE_SIZE)
+    {
+      readyQueue[head & (SYNC_READY_QUEUE_SIZE - 1)] = (uint8_t)readyIndex;
+      __atomic_store_n(&readyHead, head + 1, __ATOMIC_RELEASE);
+
+      TaskHandle_t task = __atomic_load_n(&readyNotifyTask, __ATOMIC_ACQUIRE);
+      if (task != nullptr)
+      {
+        xTaskNotify(task, __atomic_load_n(&readyNotifyBits, __ATOMIC_RELAXED),
+                    eSetBits);
+      }
+    }
+    else
+    {
+      // Cannot happen with one entry per slot; if it does, un-mark the slot
+      // so the consumer's next sweep picks it up instead.
+      portENTER_CRITICAL(&_lock);
+      slots[readyIndex].queued = false;
+      readyOverflowCount++;
+      portEXIT_CRITICAL(&_lock);
+    }
+  }
+
   return true;
 }
 
@@ -489,66 +659,143 @@ bool SyncFrameBuffer::addSample(uint8_t sensorId, uint8_t rawNodeId,
 
 bool SyncFrameBuffer::hasCompleteFrame() const
 {
-  if (slots == nullptr)
-    return false;
-  portENTER_CRITICAL(&_lock);
-  for (uint8_t i = 0; i < SYNC_TIMESTAMP_SLOTS; i++)
-  {
-    if (slots[i].active && isSlotComplete(slots[i]))
-    {
-      portEXIT_CRITICAL(&_lock);
-      return true;
-    }
-  }
-  portEXIT_CRITICAL(&_lock);
-  return false;
+  return sweepHead != sweepTail ||
+         __atomic_load_n(&readyHead, __ATOMIC_ACQUIRE) != readyTail;
 }
 
-size_t SyncFrameBuffer::getCompleteFrame(uint8_t *outputBuffer, size_t maxLen)
+size_t SyncFrameBuffer::getCompleteFrame(uint8_t *outputBuffer, size_t maxLen,
+                                         SyncFrameTiming *timing)
 {
-  // Find the oldest complete slot (maintain ordering)
-  SyncTimestampSlot *completeSlot = nullptr;
-  uint8_t completeSlotIndex = 0;
-  uint32_t oldestTimestamp = UINT32_MAX;
+  if (payload == nullptr)
+    return 0;
 
-  portENTER_CRITICAL(&_lock);
-  for (uint8_t i = 0; i < SYNC_TIMESTAMP_SLOTS; i++)
+  // Pop the next queued slot. Swept (timed-out / late-completing) slots go
+  // first: they are older than anything addSample() has just completed.
+  SyncFrameSnapshot frame;
+  bool found = false;
+  while (!found)
   {
-    if (slots[i].active && isSlotComplete(slots[i]))
+    uint8_t index;
+    if (sweepHead != sweepTail)
+    {
+      index = sweepQueue[sweepTail & (SYNC_READY_QUEUE_SIZE - 1)];
+      sweepTail++;
+    }
+    else
+    {
+      const uint32_t head = __atomic_load_n(&readyHead, __ATOMIC_ACQUIRE);
+      if (head == readyTail)
+        return 0;
+      index = readyQueue[readyTail & (SYNC_READY_QUEUE_SIZE - 1)];
+      __atomic_store_n(&readyTail, readyTail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Gather slot data under lock, then release so addSample() isn't
+    // blocked during the relatively expensive packet building. Only the
+    // present sensors' payload cells are read from PSRAM.
+    portENTER_CRITICAL(&_lock);
+    SyncTimestampSlot &completeSlot = slots[index];
+    if (completeSlot.active && completeSlot.queued)
     {
-      if (slots[i].timestampUs < oldestTimestamp)
+      frame.slot = completeSlot;
+      for (uint32_t mask = completeSlot.presentMask; mask != 0;
+           mask &= mask - 1)
       {
-        oldestTimestamp = slots[i].timestampUs;
-        completeSlot = &slots[i];
-        completeSlotIndex = i;
+        const uint8_t column = (uint8_t)__builtin_ctz(mask);
+        frame.sensors[column] = payloadAt(column, index);
+      }
+      memcpy(frame.enviro, &enviroPayload[index * SYNC_SLOT_MAX_ENVIRO],
+             completeSlot.enviroCount * sizeof(SyncFrameEnviroData));
+
+      // Gap fill: pending corrections ride this frame and update the
+      // history before this frame's fills are chosen from it
+      frame.correctionCount = 0;
+      while (correctionTail != correctionHead &&
+             frame.correctionCount < SYNC_FRAME_MAX_CORRECTIONS)
+      {
+        const SyncPendingCorrection &pending =
+            correctionQueue[correctionTail & (SYNC_CORRECTION_QUEUE_SIZE - 1)];
+        correctionTail++;
+        const uint32_t framesBack = outputFrameNumber - pending.outputFrame;
+        if (framesBack == 0 || framesBack > UINT8_MAX)
+        {
+          correctionDroppedCount++; // reset() since, or beyond the field
+          continue;
+        }
+        SyncFrameCorrectionData &rec =
+            frame.corrections[frame.correctionCount++];
+        rec.sensorId = pending.sample.sensorId;
+        memcpy(rec.a, pending.sample.a, sizeof(rec.a));
+        memcpy(rec.g, pending.sample.g, sizeof(rec.g));
+        rec.flags = SYNC_SENSOR_FLAG_CORRECTION;
+        rec.rawNodeId = pending.sample.rawNodeId;
+        rec.framesBack = (uint8_t)framesBack;
+        gapHistory[pending.column].push(
+            pending.sampleOrdinal, pending.sample.sensorId,
+            pending.sample.rawNodeId, pending.sample.localSensorIndex,
+            pending.sample.a, pending.sample.g);
       }
-    }
-  }
 
-  if (!completeSlot)
-  {
-    portEXIT_CRITICAL(&_lock);
-    return 0;
-  }
+      const uint64_t ordinal =
+          getSampleOrdinal(completeSlot.frameNumber, completeSlot.sampleIndex);
+      frame.fillMask = 0;
+      if (gapFillMode != GAP_FILL_OFF)
+      {
+        for (uint8_t j = 0; j < expectedSensorCount; j++)
+        {
+          const GapFillHistory &history = gapHistory[j];
+          const uint32_t gap = history.gapTo((uint32_t)ordinal);
+          if (!(completeSlot.presentMask & (1u << j)) && gap > 0 &&
+              gap <= SYNC_GAP_FILL_MAX_SAMPLES &&
+              history.sensorId == expectedSensorIds[j])
+          {
+            frame.fillMask |= 1u << j;
+          }
+        }
+      }
 
-  // Copy slot data under lock, then release so addSample() isn't blocked
-  // during the relatively expensive packet building
-  SyncTimestampSlot localSlot;
-  memcpy(&localSlot, completeSlot, sizeof(SyncTimestampSlot));
+      // Later samples for this moment are dropped, not re-slotted (or sent
+      // as corrections for the columns filled here)
+      const uint8_t arrivalIdx =
+          (uint8_t)(ordinal & (SYNC_ARRIVAL_HISTORY - 1));
+      if (arrivalTag[arrivalIdx] == (uint32_t)ordinal + 1)
+      {
+        arrivalEmitted[arrivalIdx] = true;
+        arrivalFilled[arrivalIdx] = frame.fillMask;
+        arrivalOutputFrame[arrivalIdx] = outputFrameNumber;
+      }
 
-  // Mark slot as consumed while still under lock
-  completeSlot->active = false;
-  completeSlot->sensorsPresent = 0;
-  for (uint8_t i = 0; i < SYNC_MAX_SENSORS; i++)
-  {
-    completeSlot->sensors[i].present = false;
+      // Mark slot as consumed while still under lock
+      completeSlot.active = false;
+      completeSlot.queued = false;
+      completeSlot.forceEmit = false;
+      completeSlot.sensorsPresent = 0;
+      completeSlot.presentMask = 0;
+      found = true;
+    }
+    portEXIT_CRITICAL(&_lock);
   }
-  portEXIT_CRITICAL(&_lock);
 
   size_t packetSize = 0;
 
   // Build absolute 0x25 frame
-  packetSize = buildAbsoluteFrame(localSlot, outputBuffer, maxLen);
+  packetSize = buildAbsoluteFrame(frame, outputBuffer, maxLen);
+
+  // The real samples of this frame become the gap fill history
+  const uint32_t frameOrdinal = (uint32_t)getSampleOrdinal(
+      frame.slot.frameNumber, frame.slot.sampleIndex);
+  for (uint32_t mask = frame.slot.presentMask; mask != 0; mask &= mask - 1)
+  {
+    const uint8_t column = (uint8_t)__builtin_ctz(mask);
+    const SyncSensorSample &sample = frame.sensors[column];
+    gapHistory[column].push(frameOrdinal, sample.sensorId, sample.rawNodeId,
+                            sample.localSensorIndex, sample.a, sample.g);
+  }
+  if (timing != nullptr)
+  {
+    timing->timestampUs = frame.slot.timestampUs;
+    timing->firstArrivalUs = frame.slot.firstArrivalUs;
+  }
 
   if (packetSize > 0)
   {
@@ -565,15 +812,24 @@ size_t SyncFrameBuffer::getCompleteFrame(uint8_t *outputBuffer, size_t maxLen)
               ? (float)trulyCompleteFrameCount / totalEmitted * 100.0f
               : 0.0f;
 
-      SAFE_LOG("[SYNC QUALITY] TrulyComplete: %lu, Partial: %lu, Incomplete: "
-               "%lu, Dropped: %lu\n",
+      SAFE_LOG("[SYNC QUALITY] TrulyComplete: %lu, Partial: %lu (early %lu), "
+               "Incomplete: %lu, Dropped: %lu, Late samples: %lu\n",
                trulyCompleteFrameCount, partialRecoveryFrameCount,
-               incompleteFrameCount, droppedFrameCount);
+               earlyEmitCount, incompleteFrameCount, droppedFrameCount,
+               lateSampleDropCount);
+      if (gapFillMode != GAP_FILL_OFF)
+      {
+        SAFE_LOG("               Gap fill (mode %d): %lu filled, %lu "
+                 "corrections (dropped %lu)\n",
+                 gapFillMode, gapFilledCount, correctionRecordCount,
+                 correctionDroppedCount);
+      }
       SAFE_LOG("               TRUE SYNC RATE: %.1f%% (frames with ALL %d "
                "sensors, effective=%d)\n",
                trueCompleteRate, expectedSensorCount, effectiveSensorCount);
-      SAFE_LOG("               Total frames emitted: %lu\n",
-               completedFrameCount);
+      SAFE_LOG("               Total frames emitted: %lu, enviro records: "
+               "%lu (dropped %lu)\n",
+               completedFrameCount, enviroRecordCount, enviroDroppedCount);
     }
 
     // Slot already cleared under lock above — no need to clear again
@@ -586,7 +842,7 @@ size_t SyncFrameBuffer::getCompleteFrame(uint8_t *outputBuffer, size_t maxLen)
     // completeness and avoids falsely penalizing expected-but-inactive sensors.
     const uint8_t requiredSensors =
         (effectiveSensorCount > 0) ? effectiveSensorCount : expectedSensorCount;
-    if (localSlot.sensorsPresent >= requiredSensors)
+    if (frame.slot.sensorsPresent >= requiredSensors)
     {
       trulyCompleteFrameCount++;
     }
@@ -649,6 +905,7 @@ void SyncFrameBuffer::update()
 void SyncFrameBuffer::expireStaleSlots()
 {
   uint32_t now = millis();
+  const uint32_t nowUs = micros();
 
   // ========================================================================
   // DIAGNOSTIC: Track which sensors are consistently missing
@@ -692,6 +949,13 @@ void SyncFrameBuffer::expireStaleSlots()
   {
     if (slots[i].active)
     {
+      // Complete but never handed off: effectiveSensorCount dropped under
+      // it, or addSample() found the ready queue full
+      if (!slots[i].queued && isSlotComplete(slots[i]))
+      {
+        sweepSlot(i);
+      }
+
       uint32_t age = now - slots[i].receivedAtMs;
       const uint64_t slotOrdinal =
           getSampleOrdinal(slots[i].frameNumber, slots[i].sampleIndex);
@@ -702,8 +966,16 @@ void SyncFrameBuffer::expireStaleSlots()
       const bool lateByStreamAdvance =
           lagSamples >= SYNC_SLOT_ADVANCE_TIMEOUT_SAMPLES;
       const bool lateByHardTimeout = age > SYNC_SLOT_TIMEOUT_MS;
+#if SYNC_ADAPTIVE_DEADLINES
+      const bool lateByDeadline = !slots[i].forceEmit &&
+                                  !isSlotComplete(slots[i]) &&
+                                  adaptiveDeadlinePassed(slots[i], nowUs, now);
+#else
+      const bool lateByDeadline = false;
+      (void)nowUs;
+#endif
 
-      if (lateByStreamAdvance || lateByHardTimeout)
+      if (lateByDeadline || lateByStreamAdvance || lateByHardTimeout)
       {
         // Skip if already forced (avoid double processing)
         if (slots[i].forceEmit)
@@ -718,9 +990,10 @@ void SyncFrameBuffer::expireStaleSlots()
           // Track which sensors were missing
           for (uint8_t j = 0; j < expectedSensorCount; j++)
           {
-            if (!slots[i].sensors[j].present)
+            if (!(slots[i].presentMask & (1u << j)))
             {
               missCountBySensor[j]++;
+              lateness[j].noteMissed();
             }
           }
 
@@ -729,6 +1002,13 @@ void SyncFrameBuffer::expireStaleSlots()
           if (slots[i].sensorsPresent > 0)
           {
             slots[i].forceEmit = true;
+            sweepSlot(i);
+            if (!lateByStreamAdvance && !lateByHardTimeout)
+            {
+              earlyEmitCount++;
+            }
+            TRACE_EVENT(TRACE_EV_FORCE_EMIT, TRACE_INSTANT,
+                        slots[i].sensorsPresent);
 
             // Collect log data (will log outside lock)
             if (now - lastPartialLog > 2000)
@@ -745,17 +1025,14 @@ void SyncFrameBuffer::expireStaleSlots()
             }
 
             // CRITICAL: Prevent slot clearing so it can be picked up by
-            // getCompleteFrame
+            // getCompleteFrame (via sweepQueue)
             continue;
           }
 
           // Clear empty slot (no data to recover)
           slots[i].active = false;
           slots[i].sensorsPresent = 0;
-          for (uint8_t j = 0; j < SYNC_MAX_SENSORS; j++)
-          {
-            slots[i].sensors[j].present = false;
-          }
+          slots[i].presentMask = 0;
         }
 
         // Periodic miss summary: snapshot data under lock
@@ -846,10 +1123,12 @@ void SyncFrameBuffer::expireStaleSlots()
 void SyncFrameBuffer::reset()
 {
   portENTER_CRITICAL(&_lock);
-  if (slots != nullptr && slotsAllocated)
-  {
-    memset(slots, 0, sizeof(SyncTimestampSlot) * SYNC_TIMESTAMP_SLOTS);
-  }
+  // Clearing the metadata is enough: payload cells are only read where
+  // presentMask is set
+  memset(slots, 0, sizeof(slots));
+  // The handoff queues keep their head/tail (each owned by one task); any
+  // index still in them now points at a slot with queued == false and is
+  // skipped by getCompleteFrame().
   oldestSlotIndex = 0;
   outputFrameNumber = 0;
   completedFrameCount = 0;
@@ -857,6 +1136,20 @@ void SyncFrameBuffer::reset()
   partialRecoveryFrameCount = 0;
   droppedFrameCount = 0;
   incompleteFrameCount = 0;
+  enviroRecordCount = 0;
+  enviroDroppedCount = 0;
+  earlyEmitCount = 0;
+  lateSampleDropCount = 0;
+  gapFilledCount = 0;
+  correctionRecordCount = 0;
+  correctionDroppedCount = 0;
+  correctionTail = correctionHead; // Their frames are gone
+  readyOverflowCount = 0;
+  for (uint8_t i = 0; i < SYNC_MAX_SENSORS; i++)
+  {
+    lateness[i].reset();
+  }
+  memset(arrivalTag, 0, sizeof(arrivalTag));
   lastUpdateMs = millis();
   latestObservedSampleOrdinal = 0;
   effectiveSensorCount =
@@ -885,8 +1178,31 @@ void SyncFrameBuffer::printStatus() const
     }
   }
   portEXIT_CRITICAL(&_lock);
-  SAFE_LOG("[SyncFrame] Active slots: %d/%d\n", activeSlots,
-           SYNC_TIMESTAMP_SLOTS);
+  SAFE_LOG("[SyncFrame] Active slots: %d/%d, ready queue: %lu waiting "
+           "(%lu overflows)\n",
+           activeSlots, SYNC_TIMESTAMP_SLOTS,
+           (unsigned long)(__atomic_load_n(&readyHead, __ATOMIC_ACQUIRE) -
+                           __atomic_load_n(&readyTail, __ATOMIC_ACQUIRE)),
+           (unsigned long)readyOverflowCount);
+
+  // Per-sensor lateness behind the adaptive deadlines (snapshot, log outside)
+  LatenessTracker latenessSnapshot[SYNC_MAX_SENSORS];
+  uint8_t sensorIds[SYNC_MAX_SENSORS];
+  portENTER_CRITICAL(&_lock);
+  const uint8_t count = expectedSensorCount;
+  memcpy(latenessSnapshot, lateness, sizeof(latenessSnapshot));
+  memcpy(sensorIds, expectedSensorIds, sizeof(sensorIds));
+  portEXIT_CRITICAL(&_lock);
+  for (uint8_t j = 0; j < count; j++)
+  {
+    const LatenessTracker &t = latenessSnapshot[j];
+    // deadline -1: none, the fixed timeouts apply
+    SAFE_LOG("[SyncFrame]   sensor %d lateness: mean=%lu dev=%lu "
+             "deadline=%ld us (n=%lu%s%s)\n",
+             sensorIds[j], (unsigned long)t.meanUs, (unsigned long)t.devUs,
+             (long)(int32_t)t.deadlineUs(), (unsigned long)t.samples,
+             t.warmedUp() ? "" : ", warming up", t.absent() ? ", absent" : "");
+  }
 }
 
 // ============================================================================
@@ -937,19 +1253,26 @@ SyncTimestampSlot *SyncFrameBuffer::findOrCreateSlot(uint32_t normalizedTs,
       slots[i].frameNumber = frameNumber;
       slots[i].sampleIndex = sampleIndex;
       slots[i].receivedAtMs = millis();
+      slots[i].firstArrivalUs = micros();
+      slots[i].forceEmit = false;
+      slots[i].queued = false;
       slots[i].sensorsPresent = 0;
+      slots[i].presentMask = 0;
+      slots[i].enviroCount = 0;
       return &slots[i];
     }
   }
 
-  // All slots full - find oldest incomplete slot to recycle
+  // All slots full - find oldest incomplete slot to recycle (never one that
+  // is already queued for emission)
   uint32_t oldestTime = UINT32_MAX;
   uint8_t oldestIdx = 0;
   bool foundIncompleteSlot = false;
 
   for (uint8_t i = 0; i < SYNC_TIMESTAMP_SLOTS; i++)
   {
-    if (slots[i].receivedAtMs < oldestTime && !isSlotComplete(slots[i]))
+    if (slots[i].receivedAtMs < oldestTime && !slots[i].queued &&
+        !isSlotComplete(slots[i]))
     {
       oldestTime = slots[i].receivedAtMs;
       oldestIdx = i;
@@ -969,29 +1292,18 @@ SyncTimestampSlot *SyncFrameBuffer::findOrCreateSlot(uint32_t normalizedTs,
     slots[oldestIdx].frameNumber = frameNumber;
     slots[oldestIdx].sampleIndex = sampleIndex;
     slots[oldestIdx].receivedAtMs = millis();
+    slots[oldestIdx].firstArrivalUs = micros();
+    slots[oldestIdx].forceEmit = false;
+    slots[oldestIdx].queued = false;
     slots[oldestIdx].sensorsPresent = 0;
-    for (uint8_t j = 0; j < SYNC_MAX_SENSORS; j++)
-    {
-      slots[oldestIdx].sensors[j].present = false;
-    }
+    slots[oldestIdx].presentMask = 0;
+    slots[oldestIdx].enviroCount = 0;
     return &slots[oldestIdx];
   }
 
   return nullptr;
 }
 
-int8_t SyncFrameBuffer::getSensorIndex(uint8_t sensorId) const
-{
-  for (uint8_t i = 0; i < expectedSensorCount; i++)
-  {
-    if (expectedSensorIds[i] == sensorId)
-    {
-      return i;
-    }
-  }
-  return -1;
-}
-
 bool SyncFrameBuffer::isSlotComplete(const SyncTimestampSlot &slot) const
 {
   if (!slot.active)
@@ -1003,6 +1315,48 @@ bool SyncFrameBuffer::isSlotComplete(const SyncTimestampSlot &slot) const
   return (slot.sensorsPresent >= effectiveSensorCount) || slot.forceEmit;
 }
 
+bool SyncFrameBuffer::adaptiveDeadlinePassed(const SyncTimestampSlot &slot,
+                                             uint32_t nowUs,
+                                             uint32_t nowMs) const
+{
+  // A gap-filled sensor costs an estimate, not a hole: cut tighter
+  const uint16_t permille = gapFillMode != GAP_FILL_OFF
+                                ? SYNC_GAP_FILL_QUANTILE_PERMILLE
+                                : LATENESS_QUANTILE_PERMILLE;
+  uint32_t deadlineUs = 0;
+  for (uint8_t j = 0; j < expectedSensorCount; j++)
+  {
+    if (slot.presentMask & (1u << j))
+      continue;
+    // Never heard from yet: nothing to estimate, keep the fixed timeouts
+    if (sensorLastSeenMs[j] == 0)
+      return false;
+    // Not expected: inactive, or absent for several frames
+    if ((nowMs - sensorLastSeenMs[j]) > SENSOR_INACTIVE_THRESHOLD_MS ||
+        lateness[j].absent())
+      continue;
+    if (!lateness[j].warmedUp())
+      return false;
+    const uint32_t d = lateness[j].deadlineUs(permille);
+    if (d == LATENESS_NO_DEADLINE)
+      return false; // Too often later than the histogram covers
+    if (d > deadlineUs)
+      deadlineUs = d;
+  }
+  return (nowUs - slot.firstArrivalUs) >= deadlineUs;
+}
+
+void SyncFrameBuffer::sweepSlot(uint8_t index)
+{
+  if (sweepHead - sweepTail >= SYNC_READY_QUEUE_SIZE)
+  {
+    return; // Left unqueued; the next sweep retries
+  }
+  slots[index].queued = true;
+  sweepQueue[sweepHead & (SYNC_READY_QUEUE_SIZE - 1)] = index;
+  sweepHead++;
+}
+
 // ============================================================================
 // CRC-8 (polynomial 0x07) for frame integrity detection
 // ============================================================================
@@ -1021,7 +1375,7 @@ static uint8_t computeCRC8(const uint8_t *data, size_t len)
 }
 
 // ============================================================================
-size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncTimestampSlot &slot,
+size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncFrameSnapshot &frame,
                                            uint8_t *outputBuffer,
                                            size_t maxLen)
 {
@@ -1039,17 +1393,19 @@ size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncTimestampSlot &slot,
   memcpy(localSensorLastSeenMs, sensorLastSeenMs,
          sizeof(localSensorLastSeenMs));
 
+  const SyncTimestampSlot &slot = frame.slot;
   uint8_t includedIndices[SYNC_MAX_SENSORS] = {0};
   uint8_t includedCount = 0;
 
   if (slot.forceEmit)
   {
     // PARTIAL-FRAME TRUTHFULNESS: For timeout-recovered slots, advertise
-    // ONLY sensors actually present to avoid overstating availability.
+    // ONLY sensors actually present to avoid overstating availability,
+    // plus gap-filled ones (flagged INTERPOLATED).
     for (uint8_t i = 0; i < localSensorCount && includedCount < SYNC_MAX_SENSORS;
          i++)
     {
-      if (slot.sensors[i].present)
+      if ((slot.presentMask | frame.fillMask) & (1u << i))
       {
         includedIndices[includedCount++] = i;
       }
@@ -1089,9 +1445,16 @@ size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncTimestampSlot &slot,
     return 0;
   }
 
-  // Calculate required size (header + sensors + CRC-8 trailer)
+  const uint8_t enviroCount = (slot.enviroCount <= SYNC_SLOT_MAX_ENVIRO)
+                                  ? slot.enviroCount
+                                  : SYNC_SLOT_MAX_ENVIRO;
+  const uint8_t correctionCount = frame.correctionCount;
+  const uint8_t recordCount = includedCount + enviroCount + correctionCount;
+
+  // Calculate required size (header + sensors + enviro + corrections +
+  // CRC-8 trailer)
   size_t frameDataSize =
-      SYNC_FRAME_HEADER_SIZE + (includedCount * SYNC_FRAME_SENSOR_SIZE);
+      SYNC_FRAME_HEADER_SIZE + (recordCount * SYNC_FRAME_SENSOR_SIZE);
   size_t requiredSize = frameDataSize + 1; // +1 for CRC-8 byte
 
   if (maxLen < requiredSize)
@@ -1106,14 +1469,14 @@ size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncTimestampSlot &slot,
   header->type = SYNC_FRAME_PACKET_TYPE; // 0x25
   header->frameNumber = outputFrameNumber;
   header->timestampUs = slot.timestampUs;
-  header->sensorCount = includedCount;
+  header->sensorCount = recordCount;
 
   // BELT-AND-SUSPENDERS: Write sensorCount directly at byte offset 9.
   // If the compiler mis-handles __attribute__((packed)) struct member
   // access (observed on some toolchains), the struct write above may land
   // at the wrong offset. This raw byte write guarantees byte[9] is correct
   // regardless of compiler behavior.
-  outputBuffer[9] = includedCount;
+  outputBuffer[9] = recordCount;
 
   // Add sensor data in expected order
   SyncFrameSensorData *sensorData =
@@ -1122,24 +1485,71 @@ size_t SyncFrameBuffer::buildAbsoluteFrame(const SyncTimestampSlot &slot,
   for (uint8_t outIdx = 0; outIdx < includedCount; outIdx++)
   {
     const uint8_t i = includedIndices[outIdx];
-    const SyncSensorSample &sample = slot.sensors[i];
+    const SyncSensorSample &sample = frame.sensors[i];
+    const bool present = (slot.presentMask & (1u << i)) != 0;
+    const GapFillHistory &history = gapHistory[i];
+    int16_t fillA[3];
+    int16_t fillG[3];
+    const bool filled =
+        !present && (frame.fillMask & (1u << i)) &&
+        history.extrapolate(gapFillMode,
+                            (uint32_t)getSampleOrdinal(slot.frameNumber,
+                                                       slot.sampleIndex),
+                            fillA, fillG);
 
     // FIX: Use the EXPECTED sensor ID for non-present sensors instead of
     // the memset default (0). This prevents phantom sensorId=0 in 0x25
     // frames which corrupts diagnostics and can cause ghost sensors in
     // the web app if serial corruption flips the valid flag bit.
     sensorData[outIdx].sensorId =
-        sample.present ? sample.sensorId : localSensorIds[i];
-    memcpy(sensorData[outIdx].a, sample.a, sizeof(sensorData[outIdx].a));
-    memcpy(sensorData[outIdx].g, sample.g, sizeof(sensorData[outIdx].g));
-    sensorData[outIdx].flags = sample.present ? SYNC_SENSOR_FLAG_VALID : 0;
+        present ? sample.sensorId : localSensorIds[i];
+    if (present)
+    {
+      memcpy(sensorData[outIdx].a, sample.a, sizeof(sensorData[outIdx].a));
+      memcpy(sensorData[outIdx].g, sample.g, sizeof(sensorData[outIdx].g));
+    }
+    else if (filled)
+    {
+      memcpy(sensorData[outIdx].a, fillA, sizeof(fillA));
+      memcpy(sensorData[outIdx].g, fillG, sizeof(fillG));
+      gapFilledCount++;
+    }
+    else
+    {
+      // Payload cell was never written for this slot (not gathered)
+      memset(sensorData[outIdx].a, 0, sizeof(sensorData[outIdx].a));
+      memset(sensorData[outIdx].g, 0, sizeof(sensorData[outIdx].g));
+    }
+    sensorData[outIdx].flags =
+        present ? SYNC_SENSOR_FLAG_VALID
+                : (filled ? SYNC_SENSOR_FLAG_VALID | SYNC_SENSOR_FLAG_INTERPOLATED
+                          : 0);
     // S1-FIX: Embed physical identity in previously-reserved bytes
     // reserved[0] = rawNodeId (MAC-derived physical node ID)
     // reserved[1] = localSensorIndex (sensor's index within its node, 0-based)
     // This allows the webapp to build stable device keys independent of
     // compact ID assignment order.
-    sensorData[outIdx].reserved[0] = sample.present ? sample.rawNodeId : 0;
-    sensorData[outIdx].reserved[1] = sample.present ? sample.localSensorIndex : 0;
+    sensorData[outIdx].reserved[0] =
+        present ? sample.rawNodeId : (filled ? history.rawNodeId : 0);
+    sensorData[outIdx].reserved[1] =
+        present ? sample.localSensorIndex
+                : (filled ? history.localSensorIndex : 0);
+  }
+
+  // Multi-rate extension: mag/baro records after the IMU records
+  if (enviroCount > 0)
+  {
+    memcpy(&sensorData[includedCount], frame.enviro,
+           enviroCount * SYNC_FRAME_SENSOR_SIZE);
+    enviroRecordCount += enviroCount;
+  }
+
+  // Gap fill: late real samples for earlier synthesized records, last
+  if (correctionCount > 0)
+  {
+    memcpy(&sensorData[includedCount + enviroCount], frame.corrections,
+           correctionCount * SYNC_FRAME_SENSOR_SIZE);
+    correctionRecordCount += correctionCount;
   }
 
   // Append CRC-8 trailing byte for corruption detection.
@@ -24,7 +24,19 @@
  * Header: type(1) + frameNum(4) + timestampUs(4) + sensorCount(1) = 10 bytes
  * Sensor: sensorId(1) + a[3](6) + g[3](6) + flags(1) + reserved(2) = 16 bytes
  *
- * Max packet: 10 + (20 sensors × 16 bytes) = 330 bytes (fits in ESP-NOW v2)
+ * MULTI-RATE EXTENSION: Magnetometer/barometer readings that nodes carry
+ * inline in 0x26 (NODE_DATA_FLAG_ENVIRO) are appended after the IMU records
+ * as 16-byte SyncFrameEnviroData records, counted in sensorCount and marked
+ * SYNC_SENSOR_FLAG_ENVIRO (VALID clear, so older parsers skip them). They
+ * appear only in the frame whose timestamp they were sampled at.
+ *
+ * GAP FILL: with gap fill on, a sensor a frame is missing may instead be
+ * synthesized from its recent samples (VALID | INTERPOLATED). If its real
+ * sample turns up late, a following frame carries it as a
+ * SyncFrameCorrectionData record (SYNC_SENSOR_FLAG_CORRECTION, VALID clear)
+ * pointing back at the frame it corrects.
+ *
+ * Max packet: 10 + ((20 + 4 + 4) records × 16 bytes) + CRC = 459 bytes
  */
 
 #ifndef SYNC_FRAME_BUFFER_H
@@ -36,6 +48,9 @@
 
 #define SYNC_FRAME_MAX_PACKET_SIZE 512
 #include "../libraries/IMUConnectCore/src/TDMAProtocol.h"
+#include "../libraries/IMUConnectCore/src/SyncFrameFormat.h"
+#include "../libraries/IMUConnectCore/src/LatenessTracker.h"
+#include "../libraries/IMUConnectCore/src/GapFill.h"
 
 // ============================================================================
 // Configuration
@@ -54,8 +69,11 @@
 
 // How many timestamp slots to buffer (circular buffer)
 // At 200Hz with PSRAM, 64 slots = 320ms of buffering for excellent jitter tolerance.
-// Previously 16 (80ms) when limited to internal SRAM.
+// Previously 16 (80ms) when limited to internal SRAM. Only the sample payload
+// is in PSRAM; each slot costs 28 bytes of internal SRAM for its metadata.
+#ifndef SYNC_TIMESTAMP_SLOTS
 #define SYNC_TIMESTAMP_SLOTS 64
+#endif
 
 // Primary late-sample tolerance, expressed in logical 5ms samples.
 // With frame-authoritative slot matching, lateness should be judged mainly by
@@ -71,69 +89,89 @@
 // and can safely wait longer for delayed nodes.
 #define SYNC_SLOT_TIMEOUT_MS 180
 
-// ============================================================================
-// Sync Frame Packet Format (0x25 - ABSOLUTE)
-// ============================================================================
-// Original format: 16 bytes per sensor, all values absolute (quaternion removed)
-// Used for: Keyframes, first packet after connection, error recovery
-// Max sensors @ 200Hz: ~20 (limited by BLE 65 KB/s)
+// Adaptive per-sensor deadlines (LatenessTracker.h): an incomplete slot is
+// emitted once every sensor it still waits for is past its own high-quantile
+// lateness, usually long before the two fixed limits above, which remain as
+// backstops. 0 = fixed limits only.
+#ifndef SYNC_ADAPTIVE_DEADLINES
+#define SYNC_ADAPTIVE_DEADLINES 1
+#endif
 
-#define SYNC_FRAME_PACKET_TYPE 0x25
+// First-arrival times kept per (frameNumber, sampleIndex), power of two.
+// Outlives the slot, so a sample that missed its frame is still measured
+// as late. 64 samples = 320ms, beyond SYNC_SLOT_TIMEOUT_MS.
+#define SYNC_ARRIVAL_HISTORY 64
+
+// Gap fill (GapFill.h): a frame leaving without a sensor whose last real
+// sample is at most SYNC_GAP_FILL_MAX_SAMPLES old carries a synthesized
+// record for it instead. GAP_FILL_OFF / _HOLD / _LINEAR / _GYRO, changed at
+// runtime by setGapFillMode() (GAP_FILL command); this is the boot mode.
+#ifndef SYNC_GAP_FILL_DEFAULT_MODE
+#define SYNC_GAP_FILL_DEFAULT_MODE GAP_FILL_OFF
+#endif
+#define SYNC_GAP_FILL_MAX_SAMPLES TDMA_SAMPLES_PER_FRAME // One lost packet
 
-// Per-sensor data in sync frame (16 bytes - fixed size for easy parsing)
-// Quaternion removed: VQF fusion runs in webapp from accel+gyro raw data.
-struct __attribute__((packed)) SyncFrameSensorData
-{
-    uint8_t sensorId;    // Unique sensor ID (nodeId + localIndex)
-    int16_t a[3];        // Accelerometer (x, y, z) scaled by 100 (m/s²)
-    int16_t g[3];        // Gyroscope (x, y, z) scaled by 900 (°/s)
-    uint8_t flags;       // Bit 0: valid, Bit 1: interpolated, Bits 2-7: reserved
-    uint8_t reserved[2]; // Padding to 16 bytes
-};
+// With gap fill on, a missing sensor costs an estimate rather than a hole,
+// so adaptive deadlines use this lower quantile and frames leave sooner
+#ifndef SYNC_GAP_FILL_QUANTILE_PERMILLE
+#define SYNC_GAP_FILL_QUANTILE_PERMILLE 950
+#endif
 
-// Sync Frame packet header
-struct __attribute__((packed)) SyncFramePacket
-{
-    uint8_t type;         // 0x25 = SYNC_FRAME_PACKET_TYPE
-    uint32_t frameNumber; // Monotonic frame counter
-    uint32_t timestampUs; // Synchronized timestamp (beacon-derived)
-    uint8_t sensorCount;  // Number of sensors in this frame
-                          // Followed by sensorCount × SyncFrameSensorData
-};
+// Late real samples for filled records, waiting to ride the next frames
+// (power of two), and how many one frame carries
+#define SYNC_CORRECTION_QUEUE_SIZE 32
+#define SYNC_FRAME_MAX_CORRECTIONS 4
+
+// Completed-slot handoff queue (slot indices, power of two). Each slot is
+// queued at most once while it waits; the headroom over SYNC_TIMESTAMP_SLOTS
+// absorbs stale indices left behind by reset().
+#ifndef SYNC_READY_QUEUE_SIZE
+#define SYNC_READY_QUEUE_SIZE 128
+#endif
 
-#define SYNC_FRAME_HEADER_SIZE sizeof(SyncFramePacket)
-#define SYNC_FRAME_SENSOR_SIZE sizeof(SyncFrameSensorData)
+static_assert(SYNC_MAX_SENSORS <= 32,
+              "SyncTimestampSlot.presentMask holds one bit per sensor!");
+static_assert(SYNC_TIMESTAMP_SLOTS <= 255,
+              "Slot indices are queued as uint8_t!");
+static_assert(SYNC_READY_QUEUE_SIZE >= SYNC_TIMESTAMP_SLOTS &&
+                  (SYNC_READY_QUEUE_SIZE & (SYNC_READY_QUEUE_SIZE - 1)) == 0,
+              "Ready queue must be a power of two holding every slot!");
+
+// 0x25 wire format (SyncFramePacket, SyncFrameSensorData, record flags):
+// SyncFrameFormat.h, shared with host-side decoders
+
+// Enviro records one slot can hold. Nodes read mag/baro at 10Hz with
+// independent phases, so more than one per 5ms slot is already rare.
+#define SYNC_SLOT_MAX_ENVIRO 4
+
+static_assert(SYNC_FRAME_HEADER_SIZE +
+                      (SYNC_MAX_SENSORS + SYNC_SLOT_MAX_ENVIRO +
+                       SYNC_FRAME_MAX_CORRECTIONS) *
+                          SYNC_FRAME_SENSOR_SIZE +
+                      1 <=
+                  SYNC_FRAME_MAX_PACKET_SIZE,
+              "Largest sync frame must fit SYNC_FRAME_MAX_PACKET_SIZE!");
 
 // ============================================================================
-// Compile-time verification of packed struct layout
+// Internal Buffer Structures
 // ============================================================================
-// If these fail, the compiler is NOT respecting __attribute__((packed)) and
-// the webapp parser will read corrupted sensorCount values at byte offset 9.
-static_assert(sizeof(SyncFramePacket) == 10,
-              "SyncFramePacket must be exactly 10 bytes (packed)!");
-static_assert(sizeof(SyncFrameSensorData) == 16,
-              "SyncFrameSensorData must be exactly 16 bytes (packed)!");
-static_assert(offsetof(SyncFramePacket, type) == 0,
-              "SyncFramePacket.type must be at offset 0!");
-static_assert(offsetof(SyncFramePacket, frameNumber) == 1,
-              "SyncFramePacket.frameNumber must be at offset 1!");
-static_assert(offsetof(SyncFramePacket, timestampUs) == 5,
-              "SyncFramePacket.timestampUs must be at offset 5!");
-static_assert(offsetof(SyncFramePacket, sensorCount) == 9,
-              "SyncFramePacket.sensorCount must be at offset 9!");
-
-// Flags for SyncFrameSensorData
-#define SYNC_SENSOR_FLAG_VALID 0x01
-#define SYNC_SENSOR_FLAG_INTERPOLATED 0x02
 
 // ============================================================================
-// Internal Buffer Structures
+// HOT/COLD SLOT SPLIT
+// ============================================================================
+// Every addSample() and every sweep looks at slot keys and completion state
+// of all slots, but only touches the payload of the one sensor/slot it
+// stores or emits. The metadata (SyncTimestampSlot) is a compact array in
+// internal SRAM; the payload is a sensor-major matrix in PSRAM:
+//   payload[sensorColumn * SYNC_TIMESTAMP_SLOTS + slotIndex]
+// so lookups never go through the PSRAM cache, and a node's consecutive
+// sub-samples for one sensor land next to each other.
 // ============================================================================
 
-// Single sensor's data at a specific timestamp
+// Single sensor's data at a specific timestamp (cold, PSRAM). Presence is
+// tracked in SyncTimestampSlot.presentMask.
 struct SyncSensorSample
 {
-    bool present; // Has this sensor reported for this timestamp?
     uint8_t sensorId;
     uint8_t rawNodeId;        // S1-FIX: Physical node ID (MAC-derived) for identity tracking
     uint8_t localSensorIndex; // S1-FIX: Sensor's local index within its node (0-based)
@@ -141,17 +179,47 @@ struct SyncSensorSample
     int16_t g[3];
 };
 
-// A timestamp slot - holds data from all sensors for one moment in time
+// A timestamp slot's metadata (hot, internal SRAM) - one moment in time
 struct SyncTimestampSlot
 {
-    bool active;                                // Is this slot in use?
-    bool forceEmit;                             // Force emission even if incomplete (timeout)
-    uint32_t timestampUs;                       // The synchronized timestamp (stored for output, not used for matching)
-    uint32_t frameNumber;                       // TDMA super-frame number — PRIMARY matching key
-    uint8_t sampleIndex;                        // Sub-sample index within the frame (0..TDMA_SAMPLES_PER_FRAME-1) — PRIMARY matching key
-    uint32_t receivedAtMs;                      // When first sample arrived (for timeout)
-    uint8_t sensorsPresent;                     // Count of sensors with data
-    SyncSensorSample sensors[SYNC_MAX_SENSORS]; // Per-sensor data
+    bool active;             // Is this slot in use?
+    bool forceEmit;          // Force emission even if incomplete (timeout)
+    bool queued;             // Index handed to the consumer, awaiting emission
+    uint8_t sampleIndex;     // Sub-sample index within the frame (0..TDMA_SAMPLES_PER_FRAME-1) — PRIMARY matching key
+    uint8_t sensorsPresent;  // Count of sensors with data
+    uint8_t enviroCount;     // Mag/baro records in this slot
+    uint32_t presentMask;    // Bit j: expected sensor j has reported
+    uint32_t frameNumber;    // TDMA super-frame number — PRIMARY matching key
+    uint32_t timestampUs;    // The synchronized timestamp (stored for output, not used for matching)
+    uint32_t receivedAtMs;   // When first sample arrived (for timeout)
+    uint32_t firstArrivalUs; // micros() of first sample (latency stats)
+};
+
+// A late real sample for a filled record, queued for the next frames
+struct SyncPendingCorrection
+{
+    uint32_t sampleOrdinal;
+    uint32_t outputFrame; // 0x25 frameNumber of the corrected frame
+    uint8_t column;
+    SyncSensorSample sample;
+};
+
+// One slot gathered from metadata + payload for emission
+struct SyncFrameSnapshot
+{
+    SyncTimestampSlot slot;
+    SyncSensorSample sensors[SYNC_MAX_SENSORS]; // Valid where presentMask is set
+    SyncFrameEnviroData enviro[SYNC_SLOT_MAX_ENVIRO];
+    uint32_t fillMask; // Columns to synthesize (gap fill)
+    uint8_t correctionCount;
+    SyncFrameCorrectionData corrections[SYNC_FRAME_MAX_CORRECTIONS];
+};
+
+// Timing of an emitted frame, for the Gateway latency histograms
+struct SyncFrameTiming
+{
+    uint32_t timestampUs;    // Slot timestamp (Gateway clock, sample capture)
+    uint32_t firstArrivalUs; // micros() when the first sample entered the slot
 };
 
 // ============================================================================
@@ -186,6 +254,10 @@ public:
      * @param sampleIndex Sub-sample index within the frame (0..TDMA_SAMPLES_PER_FRAME-1) — used as primary slot-matching key
      * @param a Accelerometer data
      * @param g Gyroscope data
+     * @param enviro Optional: node mag/baro reading taken at this sample,
+     *               stored in the same slot atomically with the sample.
+     *               Consumed (stored or counted in enviroDropped) only when
+     *               this returns true; on false the caller still owns it.
      * @return true if sample was added, false if buffer full or invalid
      */
     bool addSample(
@@ -196,21 +268,37 @@ public:
         uint32_t frameNumber,
         uint8_t sampleIndex,
         const int16_t *a,
-        const int16_t *g);
+        const int16_t *g,
+        const NodeEnviroSample *enviro = nullptr);
 
     /**
-     * Check if a complete sync frame is ready
-     * @return true if all expected sensors have data for at least one timestamp
+     * Consumer (ProtocolTask): wake this task with xTaskNotify(bits, eSetBits)
+     * whenever addSample() completes a slot. nullptr disables the wakeup.
+     */
+    void setReadyNotify(TaskHandle_t task, uint32_t bits);
+
+    /**
+     * Count a mag/baro reading that no accepted sample could carry
+     * (every addSample() for its sample index returned false)
+     */
+    void countEnviroDropped();
+
+    /**
+     * Check if a complete sync frame is ready (consumer only; no lock, no scan)
+     * @return true if a completed slot is waiting in the handoff queues
      */
     bool hasCompleteFrame() const;
 
     /**
-     * Build and retrieve a complete sync frame
+     * Build and retrieve the next completed sync frame (consumer only).
+     * Frames leave in completion order; timed-out partial frames first.
      * @param outputBuffer Buffer to write the sync frame packet
      * @param maxLen Maximum output buffer size
+     * @param timing Optional: receives the emitted slot's timing
      * @return Size of the packet written, or 0 if no complete frame
      */
-    size_t getCompleteFrame(uint8_t *outputBuffer, size_t maxLen);
+    size_t getCompleteFrame(uint8_t *outputBuffer, size_t maxLen,
+                            SyncFrameTiming *timing = nullptr);
 
     /**
      * Periodic maintenance - expire stale slots, update stats
@@ -226,6 +314,14 @@ public:
     uint32_t getPartialRecoveryFrames() const { return partialRecoveryFrameCount; }
     uint32_t getDroppedFrames() const { return droppedFrameCount; }
     uint32_t getIncompleteFrames() const { return incompleteFrameCount; }
+    uint32_t getEarlyEmits() const { return earlyEmitCount; }
+    uint32_t getLateSampleDrops() const { return lateSampleDropCount; }
+    uint32_t getEnviroRecords() const { return enviroRecordCount; }
+    uint32_t getEnviroDropped() const { return enviroDroppedCount; }
+    uint32_t getReadyQueueOverflows() const { return readyOverflowCount; }
+    uint32_t getGapFilledRecords() const { return gapFilledCount; }
+    uint32_t getCorrectionRecords() const { return correctionRecordCount; }
+    uint32_t getCorrectionsDropped() const { return correctionDroppedCount; }
     uint8_t getExpectedSensorCount() const { return expectedSensorCount; }
     uint8_t getEffectiveSensorCount() const { return effectiveSensorCount; }
 
@@ -242,8 +338,16 @@ public:
     }
 
     /**
-     * Allocate slot buffer in PSRAM (call once from setup).
-     * If PSRAM is unavailable, falls back to internal heap.
+     * Gap fill mode for frames emitted from now on (GAP_FILL_OFF, _HOLD,
+     * _LINEAR, _GYRO). Anything else is ignored.
+     */
+    void setGapFillMode(uint8_t mode);
+    uint8_t getGapFillMode() const { return gapFillMode; }
+
+    /**
+     * Allocate the slot payload matrix in PSRAM (call once from setup).
+     * If PSRAM is unavailable, falls back to internal heap. Slot metadata
+     * is a member array and always in internal SRAM.
      * @return true if allocation succeeded
      */
     bool allocateSlots();
@@ -262,6 +366,7 @@ private:
     // Expected sensor configuration
     uint8_t expectedSensorIds[SYNC_MAX_SENSORS];
     uint8_t expectedSensorCount;
+    int8_t sensorColumn[256]; // By sensor ID: index into expectedSensorIds, -1 if not expected
 
     // ========================================================================
     // ACTIVE SENSOR TRACKING (388Hz fix)
@@ -275,18 +380,83 @@ private:
     uint32_t sensorLastSeenMs[SYNC_MAX_SENSORS];               // Per-sensor last-seen timestamps
     static const uint32_t SENSOR_INACTIVE_THRESHOLD_MS = 2000; // 2s without data = inactive
 
+    // ========================================================================
+    // ADAPTIVE LATENESS DEADLINES
+    // ========================================================================
+    // addSample() measures each sample against the first arrival of its
+    // (frameNumber, sampleIndex) and feeds the sensor's LatenessTracker.
+    // expireStaleSlots() emits an incomplete slot early once it has waited
+    // the largest deadline among the sensors it still expects (active, not
+    // absent). A sensor that stops sending turns absent after a few missed
+    // frames, so slots stop waiting for it long before the 2s inactivity
+    // threshold lowers effectiveSensorCount. A sample whose frame has already
+    // been emitted is measured, then dropped. All guarded by _lock.
+    // ========================================================================
+    LatenessTracker lateness[SYNC_MAX_SENSORS];
+    uint32_t arrivalTag[SYNC_ARRIVAL_HISTORY];     // Sample ordinal + 1, 0 = empty
+    uint32_t arrivalFirstUs[SYNC_ARRIVAL_HISTORY]; // micros() of first arrival
+    bool arrivalEmitted[SYNC_ARRIVAL_HISTORY];     // Frame already emitted
+
+    // ========================================================================
+    // GAP FILL
+    // ========================================================================
+    // gapHistory holds each column's last two emitted real samples and is
+    // touched by the consumer (ProtocolTask) only. When getCompleteFrame()
+    // gathers a slot it picks the missing columns it can fill and records
+    // them in arrivalFilled, under _lock. addSample() turns a late sample
+    // for a filled (moment, column) into a pending correction instead of
+    // dropping it; the next gathered frames carry it (at most
+    // SYNC_FRAME_MAX_CORRECTIONS each) and feed it to gapHistory first, so
+    // later fills start from real data.
+    // ========================================================================
+    volatile uint8_t gapFillMode;
+    GapFillHistory gapHistory[SYNC_MAX_SENSORS];
+    uint32_t arrivalFilled[SYNC_ARRIVAL_HISTORY];      // Columns synthesized
+    uint32_t arrivalOutputFrame[SYNC_ARRIVAL_HISTORY]; // 0x25 frameNumber
+    SyncPendingCorrection correctionQueue[SYNC_CORRECTION_QUEUE_SIZE];
+    uint32_t correctionHead; // Both under _lock
+    uint32_t correctionTail;
+
     // ========================================================================
     // THREAD SAFETY: Spinlock for cross-task access
     // ========================================================================
-    // addSample() is called from ESP-NOW callback (WiFi task, high priority)
+    // addSample() is called from DataIngestionTask (Core 1)
     // hasCompleteFrame()/getCompleteFrame()/update() called from ProtocolTask
-    // These can preempt each other on the same core. Spinlock prevents corruption.
+    // (Core 0). Spinlock prevents corruption of the slot array.
     // ========================================================================
     mutable portMUX_TYPE _lock;
 
-    // Circular buffer of timestamp slots (dynamically allocated in PSRAM)
-    SyncTimestampSlot *slots; // Pointer to PSRAM-backed array
-    bool slotsAllocated;      // Whether dynamic allocation succeeded
+    // ========================================================================
+    // COMPLETED-SLOT HANDOFF
+    // ========================================================================
+    // addSample() sees the sample that completes a slot, marks it queued and
+    // pushes its index into readyQueue — single producer (DataIngestionTask),
+    // single consumer (ProtocolTask), head/tail only, no lock. The consumer
+    // finds work without scanning the slots and only takes the spinlock to
+    // copy out the one slot it pops.
+    //
+    // Slots that become emittable on the consumer's side — forceEmit on
+    // timeout, an effectiveSensorCount drop, a push that found readyQueue
+    // full — are found by expireStaleSlots() and go on sweepQueue, which only
+    // ProtocolTask touches. Popped indices are re-checked (active && queued),
+    // so entries made stale by reset() are skipped.
+    // ========================================================================
+    uint8_t readyQueue[SYNC_READY_QUEUE_SIZE];
+    uint32_t readyHead; // Written by producer only
+    uint32_t readyTail; // Written by consumer only
+    uint8_t sweepQueue[SYNC_READY_QUEUE_SIZE];
+    uint32_t sweepHead;
+    uint32_t sweepTail;
+    TaskHandle_t readyNotifyTask;
+    uint32_t readyNotifyBits;
+    uint32_t readyOverflowCount;
+
+    // Timestamp slots: metadata here (internal SRAM, part of the object),
+    // payload matrices dynamically allocated in PSRAM (see HOT/COLD SLOT SPLIT)
+    SyncTimestampSlot slots[SYNC_TIMESTAMP_SLOTS];
+    SyncSensorSample *payload;          // [column * SYNC_TIMESTAMP_SLOTS + slot]
+    SyncFrameEnviroData *enviroPayload; // [slot * SYNC_SLOT_MAX_ENVIRO + k]
+    bool slotsAllocated;                // Whether dynamic allocation succeeded
     uint8_t oldestSlotIndex;
 
     // Frame counter for output packets
@@ -298,29 +468,52 @@ private:
     uint32_t partialRecoveryFrameCount; // Frames emitted via forceEmit (missing sensors)
     uint32_t droppedFrameCount;
     uint32_t incompleteFrameCount;
+    uint32_t earlyEmitCount;      // Partial frames released by adaptive deadline
+    uint32_t lateSampleDropCount; // Samples arriving after their frame left
+    uint32_t gapFilledCount;         // Records synthesized (gap fill)
+    uint32_t correctionRecordCount;  // Late real samples sent as corrections
+    uint32_t correctionDroppedCount; // Correction queue full or too far back
+    uint32_t enviroRecordCount;  // Mag/baro records emitted in sync frames
+    uint32_t enviroDroppedCount; // Slot full, late sample, or no carrier
     uint32_t lastUpdateMs;
     uint64_t latestObservedSampleOrdinal;
 
     // Find or create a slot for the given timestamp
     SyncTimestampSlot *findOrCreateSlot(uint32_t timestampUs, uint32_t frameNumber, uint8_t sampleIndex);
 
-    // Find slot index for a sensor ID (-1 if not expected)
-    int8_t getSensorIndex(uint8_t sensorId) const;
+    // Find slot index for a sensor ID (-1 if not expected). O(1) lookup.
+    int8_t getSensorIndex(uint8_t sensorId) const { return sensorColumn[sensorId]; }
 
     // Check if a slot is complete (all sensors present)
     bool isSlotComplete(const SyncTimestampSlot &slot) const;
 
+    // Consumer side: queue a slot found emittable by expireStaleSlots()
+    // (caller holds _lock)
+    void sweepSlot(uint8_t index);
+
+    // Has an incomplete slot waited out every still-expected sensor's
+    // lateness deadline? false while any of them is unseen or not warmed up.
+    // (caller holds _lock)
+    bool adaptiveDeadlinePassed(const SyncTimestampSlot &slot, uint32_t nowUs,
+                                uint32_t nowMs) const;
+
     // Expire old slots
     void expireStaleSlots();
 
+    // Payload cell of one sensor column in one slot
+    SyncSensorSample &payloadAt(uint8_t column, uint8_t slotIndex)
+    {
+        return payload[(size_t)column * SYNC_TIMESTAMP_SLOTS + slotIndex];
+    }
+
     /**
      * Build an absolute 0x25 packet
-     * @param slot The complete frame slot
+     * @param frame The complete frame, gathered from its slot
      * @param outputBuffer Buffer to write packet
      * @param maxLen Maximum buffer size
      * @return Packet size, or 0 on error
      */
-    size_t buildAbsoluteFrame(const SyncTimestampSlot &slot, uint8_t *outputBuffer, size_t maxLen);
+    size_t buildAbsoluteFrame(const SyncFrameSnapshot &frame, uint8_t *outputBuffer, size_t maxLen);
 };
 
 #endif // SYNC_FRAME_BUFFER_H
@@ -0,0 +1,227 @@
+/**
+ * SyncFrameRing.cpp - Shared sync-frame ring with per-sink cursors (Gateway)
+ */
+
+// IMPORTANT: Define DEVICE_ROLE before including Config.h
+#define DEVICE_ROLE DEVICE_ROLE_GATEWAY
+
+#include "SyncFrameRing.h"
+#include "Config.h"
+
+SyncFrameRing::SyncFrameRing() : slots(nullptr), slotCount(0), head(0)
+{
+  memset(sinks, 0, sizeof(sinks));
+}
+
+SyncFrameRing::~SyncFrameRing()
+{
+  if (slots != nullptr)
+  {
+    heap_caps_free(slots);
+    slots = nullptr;
+  }
+}
+
+bool SyncFrameRing::allocate()
+{
+  if (slots != nullptr)
+  {
+    return true;
+  }
+
+  if (psramFound())
+  {
+    slots = (Slot *)heap_caps_malloc(sizeof(Slot) * SYNC_FRAME_RING_SLOTS_PSRAM,
+                                     MALLOC_CAP_SPIRAM);
+    if (slots != nullptr)
+    {
+      slotCount = SYNC_FRAME_RING_SLOTS_PSRAM;
+    }
+  }
+
+  if (slots == nullptr)
+  {
+    slots = (Slot *)heap_caps_malloc(sizeof(Slot) * SYNC_FRAME_RING_SLOTS_SRAM,
+                                     MALLOC_CAP_INTERNAL);
+    if (slots != nullptr)
+    {
+      slotCount = SYNC_FRAME_RING_SLOTS_SRAM;
+    }
+  }
+
+  if (slots == nullptr)
+  {
+    SAFE_PRINTLN("[FrameRing] CRITICAL: Failed to allocate frame ring!");
+    return false;
+  }
+
+  SAFE_LOG("[FrameRing] %u slots (%u bytes) in %s\n", slotCount,
+           (unsigned)(sizeof(Slot) * slotCount),
+           slotCount == SYNC_FRAME_RING_SLOTS_PSRAM ? "PSRAM" : "internal SRAM");
+  return true;
+}
+
+void SyncFrameRing::publish(const uint8_t *frame, size_t len,
+                            uint32_t sampleTimestampUs)
+{
+  if (slots == nullptr || len == 0 || len > SYNC_FRAME_MAX_PACKET_SIZE)
+  {
+    return;
+  }
+
+  TaskHandle_t notify[FRAME_SINK_COUNT];
+  uint8_t notifyCount = 0;
+
+  portENTER_CRITICAL(&lock);
+  Slot &slot = slots[head & (slotCount - 1)];
+  slot.meta.seq = head;
+  slot.meta.publishedUs = micros();
+  slot.meta.sampleTimestampUs = sampleTimestampUs;
+  slot.record[0] = (uint8_t)(len & 0xFF);
+  slot.record[1] = (uint8_t)((len >> 8) & 0xFF);
+  memcpy(slot.record + 2, frame, len);
+  slot.recordLen = (uint16_t)(len + 2);
+  head = head + 1;
+
+  for (uint8_t s = 0; s < FRAME_SINK_COUNT; s++)
+  {
+    if (sinks[s].attached && sinks[s].notifyTask != nullptr)
+    {
+      notify[notifyCount++] = sinks[s].notifyTask;
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+
+  for (uint8_t i = 0; i < notifyCount; i++)
+  {
+    xTaskNotifyGive(notify[i]);
+  }
+}
+
+void SyncFrameRing::attach(FrameSink sink)
+{
+  portENTER_CRITICAL(&lock);
+  SinkState &s = sinks[sink];
+  if (!s.attached)
+  {
+    s.attached = true;
+    s.stats.attached = true;
+    s.cursor = head;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void SyncFrameRing::detach(FrameSink sink)
+{
+  portENTER_CRITICAL(&lock);
+  sinks[sink].attached = false;
+  sinks[sink].stats.attached = false;
+  portEXIT_CRITICAL(&lock);
+}
+
+void SyncFrameRing::setNotifyTask(FrameSink sink, TaskHandle_t task)
+{
+  portENTER_CRITICAL(&lock);
+  sinks[sink].notifyTask = task;
+  portEXIT_CRITICAL(&lock);
+}
+
+uint32_t SyncFrameRing::pending(FrameSink sink) const
+{
+  portENTER_CRITICAL(&lock);
+  const SinkState &s = sinks[sink];
+  uint32_t backlog = s.attached ? head - s.cursor : 0;
+  portEXIT_CRITICAL(&lock);
+  return (backlog > slotCount) ? slotCount : backlog;
+}
+
+size_t SyncFrameRing::read(FrameSink sink, uint8_t *out, size_t maxLen,
+                           SyncFrameMeta *meta)
+{
+  if (slots == nullptr)
+  {
+    return 0;
+  }
+
+  portENTER_CRITICAL(&lock);
+  SinkState &s = sinks[sink];
+  if (!s.attached || s.cursor == head)
+  {
+    portEXIT_CRITICAL(&lock);
+    return 0;
+  }
+
+  // Lapped by the producer: skip to the oldest frame still in the ring
+  uint32_t backlog = head - s.cursor;
+  if (backlog > slotCount)
+  {
+    s.stats.framesDropped += backlog - slotCount;
+    s.cursor = head - slotCount;
+    backlog = slotCount;
+  }
+  if (backlog > s.stats.maxLag)
+  {
+    s.stats.maxLag = backlog;
+  }
+
+  const Slot &slot = slots[s.cursor & (slotCount - 1)];
+  size_t len = slot.recordLen;
+  if (len > maxLen)
+  {
+    portEXIT_CRITICAL(&lock);
+    return 0;
+  }
+  memcpy(out, slot.record, len);
+  if (meta != nullptr)
+  {
+    *meta = slot.meta;
+  }
+  s.cursor++;
+  s.stats.framesRead++;
+  portEXIT_CRITICAL(&lock);
+  return len;
+}
+
+bool SyncFrameRing::skip(FrameSink sink)
+{
+  portENTER_CRITICAL(&lock);
+  SinkState &s = sinks[sink];
+  if (!s.attached || s.cursor == head)
+  {
+    portEXIT_CRITICAL(&lock);
+    return false;
+  }
+  uint32_t backlog = head - s.cursor;
+  if (backlog > slotCount)
+  {
+    s.stats.framesDropped += backlog - slotCount;
+    s.cursor = head - slotCount;
+  }
+  s.cursor++;
+  s.stats.framesDropped++;
+  portEXIT_CRITICAL(&lock);
+  return true;
+}
+
+uint32_t SyncFrameRing::skipBacklog(FrameSink sink, uint32_t keep)
+{
+  portENTER_CRITICAL(&lock);
+  SinkState &s = sinks[sink];
+  uint32_t backlog = s.attached ? head - s.cursor : 0;
+  uint32_t skipped = 0;
+  if (backlog > keep)
+  {
+    skipped = backlog - keep;
+    s.cursor = head - keep;
+    s.stats.framesDropped += skipped;
+  }
+  portEXIT_CRITICAL(&lock);
+  return skipped;
+}
+
+void SyncFrameRing::getSinkStats(FrameSink sink, SinkStats &out) const
+{
+  portENTER_CRITICAL(&lock);
+  out = sinks[sink].stats;
+  portEXIT_CRITICAL(&lock);
+}
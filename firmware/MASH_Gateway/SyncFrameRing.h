@@ -0,0 +1,147 @@
+/**
+ * SyncFrameRing.h - Shared ring of emitted sync frames with per-sink cursors
+ *
+ * PURPOSE:
+ * ProtocolTask publishes every emitted 0x25 frame exactly once. Each output
+ * (USB serial, WebSocket, BLE, local recorder) reads the same frames through
+ * its own cursor, so adding an output or mirroring a session to two
+ * consumers costs no extra queue, copy on the producer side, or RAM.
+ *
+ * RECORDS:
+ * Frames are stored ready for the wire as [len lo][len hi][0x25 frame], the
+ * framing every transport already uses, so a sink copies a record straight
+ * into its send buffer.
+ *
+ * BACKPRESSURE:
+ * The producer never waits. A sink that falls more than one ring behind
+ * skips forward to the oldest frame still held and the skipped frames are
+ * counted as that sink's drops. Other sinks are unaffected: a stalled BLE
+ * link never delays USB.
+ *
+ * THREADING:
+ * One producer task, one consumer task per sink. A short spinlock covers
+ * each publish/read (one record memcpy), never a transport write.
+ */
+
+#ifndef SYNC_FRAME_RING_H
+#define SYNC_FRAME_RING_H
+
+#include <Arduino.h>
+#include "SyncFrameBuffer.h" // SYNC_FRAME_MAX_PACKET_SIZE
+
+// Ring depth (power of two). PSRAM: ~1.3 s at 200 Hz; internal SRAM
+// fallback keeps a shorter ring.
+#define SYNC_FRAME_RING_SLOTS_PSRAM 256
+#define SYNC_FRAME_RING_SLOTS_SRAM 32
+
+// Largest record a sink may be handed (length prefix + frame)
+#define SYNC_FRAME_RING_RECORD_MAX (2 + SYNC_FRAME_MAX_PACKET_SIZE)
+
+enum FrameSink : uint8_t
+{
+  FRAME_SINK_USB = 0,
+  FRAME_SINK_WEBSOCKET = 1,
+  FRAME_SINK_BLE = 2,
+  FRAME_SINK_RECORDER = 3,
+  FRAME_SINK_COUNT = 4
+};
+
+struct SyncFrameMeta
+{
+  uint32_t seq;               // Publish sequence number
+  uint32_t publishedUs;       // micros() at publish
+  uint32_t sampleTimestampUs; // Frame capture time (Gateway clock)
+};
+
+class SyncFrameRing
+{
+public:
+  struct SinkStats
+  {
+    bool attached;
+    uint32_t framesRead;
+    uint32_t framesDropped; // Overwritten before this sink read them
+    uint32_t maxLag;        // Deepest backlog seen, in frames
+  };
+
+  SyncFrameRing();
+  ~SyncFrameRing();
+
+  /**
+   * Allocate the ring (PSRAM first). Call once from setup().
+   * @return true if allocation succeeded
+   */
+  bool allocate();
+
+  /**
+   * Producer: append one frame. Never blocks; overwrites the oldest slot.
+   */
+  void publish(const uint8_t *frame, size_t len, uint32_t sampleTimestampUs);
+
+  /**
+   * Start/stop a sink. attach() starts at the newest frame (no backlog).
+   * Detached sinks are skipped entirely.
+   */
+  void attach(FrameSink sink);
+  void detach(FrameSink sink);
+  bool isAttached(FrameSink sink) const { return sinks[sink].attached; }
+
+  /**
+   * Optional: task to xTaskNotifyGive() after each publish, so the sink's
+   * consumer can block on ulTaskNotifyTake() instead of polling.
+   */
+  void setNotifyTask(FrameSink sink, TaskHandle_t task);
+
+  /**
+   * Frames waiting for this sink (capped at the ring depth)
+   */
+  uint32_t pending(FrameSink sink) const;
+
+  /**
+   * Consumer: copy the next record into out and advance the cursor.
+   * Returns the record length, or 0 if nothing is pending or the record
+   * does not fit in maxLen (the cursor is left in place; retry with room).
+   */
+  size_t read(FrameSink sink, uint8_t *out, size_t maxLen,
+              SyncFrameMeta *meta = nullptr);
+
+  /**
+   * Consumer: discard the next record (e.g. larger than the sink's MTU).
+   * Counted as a drop for this sink. Returns false if nothing is pending.
+   */
+  bool skip(FrameSink sink);
+
+  /**
+   * Consumer: drop all but the newest keep records (catch up after a
+   * stall). Counted as drops. Returns the number of records skipped.
+   */
+  uint32_t skipBacklog(FrameSink sink, uint32_t keep);
+
+  void getSinkStats(FrameSink sink, SinkStats &out) const;
+  uint32_t getPublishedCount() const { return head; }
+  uint16_t getSlotCount() const { return slotCount; }
+
+private:
+  struct Slot
+  {
+    SyncFrameMeta meta;
+    uint16_t recordLen;
+    uint8_t record[SYNC_FRAME_RING_RECORD_MAX];
+  };
+
+  struct SinkState
+  {
+    bool attached;
+    uint32_t cursor;
+    SinkStats stats;
+    TaskHandle_t notifyTask;
+  };
+
+  Slot *slots;
+  uint16_t slotCount;
+  volatile uint32_t head; // Sequence number of the next publish
+  SinkState sinks[FRAME_SINK_COUNT];
+  mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // SYNC_FRAME_RING_H
@@ -4,6 +4,7 @@
 
 #include "SyncManager.h"
 #include <Preferences.h> // OPP-8: NVS topology persistence
+#include <esp_timer.h>   // esp_timer_get_time() - TSF fallback
 #include <esp_wifi.h>    // For esp_wifi_get_tsf_time() - hardware timestamp
 
 // SensorManager only needed for Node builds (sendIMUData, sendEnviroData,
@@ -37,6 +38,14 @@ void OnDataRecv(const esp_now_recv_info_t *recv_info,
 {
   if (globalSyncManager)
   {
+    TRACE_EVENT(TRACE_EV_ESPNOW_RX, TRACE_INSTANT, len > 0 ? incomingData[0] : 0);
+    // Node link quality for channel scoring (data packets only)
+    if (len > 0 && incomingData[0] == TDMA_PACKET_NODE_DATA &&
+        recv_info->rx_ctrl != nullptr)
+    {
+      globalSyncManager->noteRxSignal(recv_info->rx_ctrl->rssi,
+                                      recv_info->rx_ctrl->noise_floor);
+    }
     globalSyncManager->onPacketReceived(recv_info->src_addr, incomingData, len);
   }
 }
@@ -46,11 +55,53 @@ void OnDataRecv(const uint8_t *mac_addr, const uint8_t *incomingData, int len)
 {
   if (globalSyncManager)
   {
+    TRACE_EVENT(TRACE_EV_ESPNOW_RX, TRACE_INSTANT, len > 0 ? incomingData[0] : 0);
     globalSyncManager->onPacketReceived(mac_addr, incomingData, len);
   }
 }
 #endif
 
+// ============================================================================
+// ESP-NOW Send Callback - closes the TSF stamp of the beacon in flight.
+// Only broadcasts matter: beacons are the only periodic broadcast, and any
+// schedule queued behind a beacon completes after it.
+// ============================================================================
+static bool isBroadcastMac(const uint8_t *mac)
+{
+  static const uint8_t BROADCAST[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  return mac != nullptr && memcmp(mac, BROADCAST, 6) == 0;
+}
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+// New callback signature for ESP-IDF 5.x / Arduino ESP32 3.x
+void OnDataSent(const wifi_tx_info_t *tx_info, esp_now_send_status_t status)
+{
+  if (globalSyncManager && tx_info != nullptr &&
+      isBroadcastMac(tx_info->des_addr))
+  {
+    globalSyncManager->noteBroadcastSent();
+  }
+}
+#else
+// Old callback signature for ESP-IDF 4.x / Arduino ESP32 2.x
+void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status)
+{
+  if (globalSyncManager && isBroadcastMac(mac_addr))
+  {
+    globalSyncManager->noteBroadcastSent();
+  }
+}
+#endif
+
+// Gateway MAC TSF (runs whenever the STA interface is started, associated or
+// not); esp_timer if the radio is not up yet. Only ever differenced against
+// itself on the Gateway, so the fallback never mixes clocks in practice.
+static uint64_t readBeaconClockUs()
+{
+  int64_t tsf = esp_wifi_get_tsf_time(WIFI_IF_STA);
+  return (tsf > 0) ? (uint64_t)tsf : (uint64_t)esp_timer_get_time();
+}
+
 // ============================================================================
 // ESP-NOW SEND TRACKING (for diagnostics)
 // ============================================================================
@@ -72,6 +123,10 @@ SyncManager::SyncManager()
 
   // Initialize registered nodes array
   memset(registeredNodes, 0, sizeof(registeredNodes));
+
+  // Empty routing table (generation 0) until the first node registers
+  memset(routeTables, 0, sizeof(routeTables));
+  activeRoutes = &routeTables[0];
 }
 
 void SyncManager::init(const char *deviceName)
@@ -98,8 +153,9 @@ void SyncManager::init(const char *deviceName)
     return;
   }
 
-  // Register callback
+  // Register callbacks
   esp_now_register_recv_cb(OnDataRecv);
+  esp_now_register_send_cb(OnDataSent);
 
   // If we are a NODE, we need to register the Gateway as a peer to send data
 #if DEVICE_ROLE == DEVICE_ROLE_NODE
@@ -140,6 +196,23 @@ void SyncManager::update()
     saveTopologyToNVS();
   }
 
+  // ============================================================================
+  // DEFERRED RESCHEDULE: reportNodeDelivery() changed a node's PHY rate.
+  // It runs on the ingestion task, so the slot rebuild + broadcast happens
+  // here, in the same context as every other schedule send.
+  // ============================================================================
+  if (pendingRateSchedule && tdmaState == TDMA_STATE_RUNNING)
+  {
+    pendingRateSchedule = false;
+    recalculateSlots();
+    sendTDMASchedule();
+  }
+
+  if (tdmaState != TDMA_STATE_IDLE)
+  {
+    serviceChannelAgility();
+  }
+
   // ============================================================================
   // TDMA Mode - Beacon-based synchronized transmission
   // ============================================================================
@@ -184,6 +257,7 @@ void SyncManager::update()
             }
             if (evicted)
             {
+              rebuildSensorRoutes();
               SAFE_LOG("[TDMA] P3: Ghost eviction complete, %d live nodes remain\n",
                        nodeCount);
             }
@@ -282,10 +356,9 @@ void SyncManager::update()
           }
         }
         // During discovery, still send beacons so nodes can hear us
-        if (now - lastBeaconTime >= TDMA_FRAME_PERIOD_MS * 1000)
+        if (beaconDue(now))
         {
-          sendTDMABeacon();
-          lastBeaconTime = now;
+          sendPeriodicBeacon(now);
           tdmaFrameNumber++; // Always increment frame number for proper node
                              // sync
         }
@@ -305,10 +378,9 @@ void SyncManager::update()
       //     (5 beacon periods of silence = all nodes have their schedule)
       //   - Hard cap at 50 beacons (1000ms) as original safety fallback
       // ====================================================================
-      if (now - lastBeaconTime >= TDMA_FRAME_PERIOD_MS * 1000)
+      if (beaconDue(now))
       {
-        sendTDMABeacon();
-        lastBeaconTime = now;
+        sendPeriodicBeacon(now);
         tdmaFrameNumber++; // Always increment frame number for proper node sync
         syncPhaseCount++;
 
@@ -344,11 +416,10 @@ void SyncManager::update()
 
     case TDMA_STATE_RUNNING:
       // Normal operation: send beacon every frame (50Hz = 20ms)
-      if (now - lastBeaconTime >= TDMA_FRAME_PERIOD_MS * 1000)
+      if (beaconDue(now))
       {
         // Send beacon - 50Hz is sustainable for ESP-NOW
-        sendTDMABeacon();
-        lastBeaconTime = now;
+        sendPeriodicBeacon(now);
         tdmaFrameNumber++;
 
         // Re-send schedule every 50 frames (~1 second) to help nodes that
@@ -567,8 +638,8 @@ void SyncManager::sendRadioModeCommand(uint8_t mode)
            mode == RADIO_MODE_BLE_OFF ? "BLE_OFF" : "BLE_ON");
 }
 
-void SyncManager::sendMagCalibCommand(uint8_t cmdType, uint32_t param,
-                                      uint8_t targetNode)
+void SyncManager::sendNodeCommand(uint8_t cmdType, uint32_t param,
+                                  uint8_t targetNode)
 {
   ESPNowCmdPacket packet;
   packet.type = CMD_FORWARD_PACKET; // 0x08
@@ -590,7 +661,14 @@ void SyncManager::sendMagCalibCommand(uint8_t cmdType, uint32_t param,
   }
 
   esp_now_send(broadcastAddress, (uint8_t *)&packet, sizeof(packet));
-  SAFE_LOG("[Sync] Broadcast mag command: type=%d param=%lu\n", cmdType, param);
+  SAFE_LOG("[Sync] Broadcast node command: type=%d param=%lu target=%u\n",
+           cmdType, param, targetNode);
+}
+
+void SyncManager::sendMagCalibCommand(uint8_t cmdType, uint32_t param,
+                                      uint8_t targetNode)
+{
+  sendNodeCommand(cmdType, param, targetNode);
 }
 
 // ============================================================================
@@ -699,6 +777,10 @@ void SyncManager::startTDMA()
   tdmaState = TDMA_STATE_DISCOVERY;
   tdmaFrameNumber = 0;
   lastBeaconTime = micros();
+  lastPeriodicBeaconTsf = 0; // No jitter sample across a restart
+  portENTER_CRITICAL(&_beaconTimingLock);
+  memset(&beaconTiming, 0, sizeof(beaconTiming));
+  portEXIT_CRITICAL(&_beaconTimingLock);
   discoveryStartTime = millis();
   syncPhaseCount = 0; // Reset sync phase counter
 
@@ -722,6 +804,7 @@ void SyncManager::startTDMA()
   {
     nodeCount = 0;
     memset(registeredNodes, 0, sizeof(registeredNodes));
+    rebuildSensorRoutes();
   }
 
   // Ensure broadcast peer is added
@@ -757,6 +840,7 @@ void SyncManager::restartDiscovery()
   nodeCount = 0;
   memset(registeredNodes, 0, sizeof(registeredNodes));
   memset(pendingNodes, 0, sizeof(pendingNodes));
+  rebuildSensorRoutes();
 
   // Notify webapp so SyncFrameBuffer resets expected sensors
   if (onNodePruned)
@@ -898,7 +982,7 @@ uint8_t SyncManager::getSyncedSensorCount(uint32_t activeThresholdMs) const
   return count;
 }
 
-void SyncManager::sendTDMABeacon()
+uint64_t SyncManager::sendTDMABeacon()
 {
   // ============================================================================
   // EPOCH-BASED DETERMINISTIC TIMESTAMPS (Research-Grade Cross-Node Sync)
@@ -947,6 +1031,21 @@ void SyncManager::sendTDMABeacon()
                 syncEpochUs);
   }
 
+  // ============================================================================
+  // CHANNEL HOP: the last announcing beacon went out on the old channel one
+  // frame ago; nodes retuned in that frame's guard time. Move the Gateway
+  // radio now so this beacon is the first one on the new channel.
+  // ============================================================================
+  if (hopSwitchDue)
+  {
+    hopSwitchDue = false;
+    esp_wifi_set_channel(hopTargetChannel, WIFI_SECOND_CHAN_NONE);
+    channelSelector.setActiveChannel(hopTargetChannel);
+    SAFE_LOG_NB("[Channel] *** Hopped to channel %u at frame %lu ***\n",
+                hopTargetChannel, tdmaFrameNumber);
+    hopTargetChannel = 0;
+  }
+
   TDMABeaconPacket beacon;
   beacon.type = TDMA_PACKET_BEACON;
   beacon.frameNumber = tdmaFrameNumber;
@@ -964,15 +1063,16 @@ void SyncManager::sendTDMABeacon()
   // ============================================================================
   // MICROS-BASED SYNCHRONIZATION
   // ============================================================================
-  // TSF (Timing Synchronization Function) is NOT available without WiFi AP
-  // connection. Instead, we use micros() as the authoritative clock. Nodes
-  // compute their offset at beacon reception: offset = beacon.gatewayTimeUs -
-  // local_micros_at_rx This achieves ~100-500us accuracy (limited by ESP-NOW
-  // latency jitter).
+  // TSF (Timing Synchronization Function) is NOT shared between devices
+  // without a WiFi AP connection. Instead, we use micros() as the
+  // authoritative clock. Nodes compute their offset at beacon reception:
+  // offset = beacon.gatewayTimeUs - local_micros_at_rx. This achieves
+  // ~100-500us accuracy (limited by ESP-NOW latency jitter).
   //
-  // The gatewayTsfUs field is set to same value for backwards compatibility.
+  // gatewayTsfUs carries the Gateway's own TSF, stamped just before
+  // esp_now_send() below, and prevTxLatencyUs how long the previous beacon
+  // took from that stamp to send-done — i.e. when it actually left.
   // ============================================================================
-  beacon.gatewayTsfUs = (uint64_t)beacon.gatewayTimeUs;
 
   // DEBUG: Log beacon timestamp EVERY 2 SECONDS
   static uint32_t lastBeaconTsDebug = 0;
@@ -998,6 +1098,19 @@ void SyncManager::sendTDMABeacon()
   }
   beacon.wifiChannel = currentChannel;
 
+  // Announce a pending hop in every beacon until it takes effect
+  beacon.hopChannel = 0;
+  beacon.hopCountdown = 0;
+  if (hopBeaconsRemaining > 0)
+  {
+    beacon.hopChannel = hopTargetChannel;
+    beacon.hopCountdown = hopBeaconsRemaining;
+    if (--hopBeaconsRemaining == 0)
+    {
+      hopSwitchDue = true;
+    }
+  }
+
   // ============================================================================
   // SYNC RECOVERY: Encode Gateway state and sync protocol version in beacon
   // flags
@@ -1078,6 +1191,16 @@ void SyncManager::sendTDMABeacon()
 
   uint8_t broadcastAddress[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
+  // TSF stamp as late as possible: everything above is packet building
+  uint64_t stampTsf = readBeaconClockUs();
+  portENTER_CRITICAL(&_beaconTimingLock);
+  beacon.prevTxLatencyUs = beaconTxInFlight ? 0xFFFF : beaconTxLatencyUs;
+  beaconTxStampTsf = stampTsf;
+  beaconTxInFlight = true;
+  portEXIT_CRITICAL(&_beaconTimingLock);
+  beacon.gatewayTsfUs = stampTsf;
+  TRACE_EVENT(TRACE_EV_BEACON_TX, TRACE_INSTANT, beacon.frameNumber);
+
   // Direct send - at 50Hz beacon rate, ESP-NOW buffer won't overflow
   esp_err_t result =
       esp_now_send(broadcastAddress, (uint8_t *)&beacon, sizeof(beacon));
@@ -1085,6 +1208,10 @@ void SyncManager::sendTDMABeacon()
   {
     espnowSendFailures++;
     lastSendError = result;
+    portENTER_CRITICAL(&_beaconTimingLock);
+    beaconTxInFlight = false;
+    beaconTxLatencyUs = 0xFFFF;
+    portEXIT_CRITICAL(&_beaconTimingLock);
   }
 
   // Log every 500 frames (once per 10 seconds at 50Hz) to reduce blocking
@@ -1118,6 +1245,72 @@ void SyncManager::sendTDMABeacon()
       }
     }
   }
+  return stampTsf;
+}
+
+// ============================================================================
+// BEACON TIMING
+// ============================================================================
+// With the ProtocolTask timer running, a beacon is due exactly when a tick
+// was delivered — the micros() gate would drop a tick that lands a few µs
+// early relative to a late predecessor. Without ticks (timer creation
+// failed) the original elapsed-time gate applies.
+// ============================================================================
+
+bool SyncManager::beaconDue(uint32_t now)
+{
+  if (beaconTickDriven)
+  {
+    bool due = beaconTickPending;
+    beaconTickPending = false;
+    return due;
+  }
+  return now - lastBeaconTime >= TDMA_FRAME_PERIOD_MS * 1000;
+}
+
+void SyncManager::sendPeriodicBeacon(uint32_t now)
+{
+  uint64_t stampTsf = sendTDMABeacon();
+  lastBeaconTime = now;
+
+  if (lastPeriodicBeaconTsf != 0)
+  {
+    int64_t periodUs = (int64_t)(stampTsf - lastPeriodicBeaconTsf);
+    int64_t jitter = periodUs - (int64_t)TDMA_FRAME_PERIOD_MS * 1000;
+    uint64_t absJitter = (jitter < 0) ? (uint64_t)-jitter : (uint64_t)jitter;
+    uint32_t absJitterUs =
+        (absJitter > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)absJitter;
+    portENTER_CRITICAL(&_beaconTimingLock);
+    beaconTiming.jitterHist[tdmaBeaconJitterBucket(absJitterUs)]++;
+    if (absJitterUs > beaconTiming.jitterMaxUs)
+      beaconTiming.jitterMaxUs = absJitterUs;
+    portEXIT_CRITICAL(&_beaconTimingLock);
+  }
+  lastPeriodicBeaconTsf = stampTsf;
+}
+
+void SyncManager::noteBroadcastSent()
+{
+  uint64_t doneTsf = readBeaconClockUs();
+  TRACE_EVENT(TRACE_EV_BEACON_TX_DONE, TRACE_INSTANT, 0);
+  portENTER_CRITICAL(&_beaconTimingLock);
+  if (beaconTxInFlight)
+  {
+    beaconTxInFlight = false;
+    uint64_t latency = doneTsf - beaconTxStampTsf;
+    beaconTxLatencyUs = (latency >= 0xFFFF) ? 0xFFFE : (uint16_t)latency;
+    beaconTiming.txLatencyLastUs = beaconTxLatencyUs;
+    if (beaconTxLatencyUs > beaconTiming.txLatencyMaxUs)
+      beaconTiming.txLatencyMaxUs = beaconTxLatencyUs;
+  }
+  portEXIT_CRITICAL(&_beaconTimingLock);
+}
+
+void SyncManager::getBeaconTiming(BeaconTimingStats &out)
+{
+  portENTER_CRITICAL(&_beaconTimingLock);
+  out = beaconTiming;
+  portEXIT_CRITICAL(&_beaconTimingLock);
 }
 
 void SyncManager::sendTDMASchedule()
@@ -1126,6 +1319,7 @@ void SyncManager::sendTDMASchedule()
   schedule.type = TDMA_PACKET_SCHEDULE;
   schedule.nodeCount = nodeCount;
   schedule.reserved = 0;
+  memset(schedule.phyRate, TDMA_PHY_RATE_6M, sizeof(schedule.phyRate));
 
   // Serial.printf("[TDMA] Building schedule: nodeCount=%d\n", nodeCount);
 
@@ -1138,6 +1332,7 @@ void SyncManager::sendTDMASchedule()
       schedule.slots[slotIdx].nodeId = registeredNodes[i].nodeId;
       schedule.slots[slotIdx].slotOffsetUs = registeredNodes[i].slotOffsetUs;
       schedule.slots[slotIdx].slotWidthUs = registeredNodes[i].slotWidthUs;
+      schedule.phyRate[slotIdx] = registeredNodes[i].phyRate;
       // Serial.printf("[TDMA]   Slot %d: node %d (offset=%u, width=%u)\n",
       //               slotIdx, registeredNodes[i].nodeId,
       //               registeredNodes[i].slotOffsetUs,
@@ -1252,6 +1447,10 @@ void SyncManager::handleNodeRegistration(const uint8_t *senderMac,
       registeredNodes[i].lastHeard = millis();
       memcpy(registeredNodes[i].mac, senderMac, 6);
       portEXIT_CRITICAL(&_registeredNodesLock);
+      if (sensorCountChanged)
+      {
+        rebuildSensorRoutes();
+      }
 
       // If sensorCount changed (e.g. first registration used fallback MAX_SENSORS
       // but correct count arrived on re-registration), recompute slot widths now
@@ -1368,6 +1567,8 @@ void SyncManager::handleNodeRegistration(const uint8_t *senderMac,
         }
         sensorCounts[projectedCount++] = reg->sensorCount; // candidate node
 
+        // No phyRates: every node is budgeted at 6 Mbps on purpose (see
+        // ADAPTIVE PHY RATE below), so faster rates only free airtime.
         uint32_t projectedFrameUs = calculateFrameTime(projectedCount, sensorCounts);
         uint32_t budgetUs = (uint32_t)TDMA_FRAME_PERIOD_MS * 1000;
 
@@ -1393,8 +1594,10 @@ void SyncManager::handleNodeRegistration(const uint8_t *senderMac,
       registeredNodes[i].lastHeard = millis();
       registeredNodes[i].registered = true;
       memcpy(registeredNodes[i].mac, senderMac, 6);
+      resetNodePhyRate(registeredNodes[i]);
       nodeCount++;
       portEXIT_CRITICAL(&_registeredNodesLock);
+      rebuildSensorRoutes();
 
       SAFE_LOG("[TDMA] *** REGISTERED NEW NODE %d in slot %d (total: %d) ***\n",
                reg->nodeId, i, nodeCount);
@@ -1432,6 +1635,8 @@ bool SyncManager::recalculateSlots()
   // Single source of truth: calculateSlotWidth() from TDMAProtocol.h
   // Slot width = fixed overhead (1500µs) + RF airtime (payload × 8µs/byte)
   // Clamped to TDMA_SLOT_MIN_WIDTH_US floor.
+  // Sized at slotPhyRate, which only catches up with phyRate once a faster
+  // rate has proven itself — a probe always runs in the wider, slower slot.
   // ============================================================================
 
   uint16_t currentOffset =
@@ -1444,11 +1649,15 @@ bool SyncManager::recalculateSlots()
     {
       registeredNodes[i].slotOffsetUs = currentOffset;
       registeredNodes[i].slotWidthUs =
-          calculateSlotWidth(registeredNodes[i].sensorCount);
+          calculateSlotWidth(registeredNodes[i].sensorCount,
+                             TDMA_NODE_DATA_COMPRESSION,
+                             registeredNodes[i].slotPhyRate);
 
-      SAFE_LOG("[TDMA] Slot %d: node=%d, sensors=%d, offset=%u, width=%u us\n",
+      SAFE_LOG("[TDMA] Slot %d: node=%d, sensors=%d, offset=%u, width=%u us, "
+               "phy=%u Mbps\n",
                i, registeredNodes[i].nodeId, registeredNodes[i].sensorCount,
-               registeredNodes[i].slotOffsetUs, registeredNodes[i].slotWidthUs);
+               registeredNodes[i].slotOffsetUs, registeredNodes[i].slotWidthUs,
+               tdmaPhyRateMbps(registeredNodes[i].phyRate));
 
       currentOffset += registeredNodes[i].slotWidthUs + TDMA_INTER_SLOT_GAP_US;
     }
@@ -1471,6 +1680,244 @@ bool SyncManager::recalculateSlots()
   return true;
 }
 
+// ============================================================================
+// ADAPTIVE PHY RATE
+// ============================================================================
+// Per-node rate ladder driven by observed 0x26 delivery (packets received vs
+// one per TDMA frame). Moving up is cautious: PHY_RATE_UP_WINDOWS clean
+// windows, then a probe that keeps the old (wider) slot until one more clean
+// window confirms it. Moving down is immediate on a single lossy window, and
+// a failed probe doubles the clean windows needed before the next attempt.
+//
+// Admission control (calculateFrameTime in handleNodeRegistration) still
+// budgets every node at 6 Mbps, so any node can always fall back to the
+// robust rate without pushing the frame over budget.
+// ============================================================================
+
+void SyncManager::resetNodePhyRate(TDMANodeInfo &node)
+{
+  node.phyRate = TDMA_PHY_RATE_6M;
+  node.slotPhyRate = TDMA_PHY_RATE_6M;
+  node.rateGoodWindows = 0;
+  node.rateUpThreshold = 0;
+  node.rateProbing = false;
+  node.rateChangedMs = 0;
+}
+
+uint8_t SyncManager::reportNodeDelivery(uint8_t nodeId, uint32_t packets,
+                                        uint32_t windowMs)
+{
+  uint32_t expected = windowMs / TDMA_FRAME_PERIOD_MS;
+  if (expected == 0)
+    return TDMA_PHY_RATE_6M;
+
+  uint32_t permille = (packets * 1000) / expected;
+  if (permille > 1000)
+    permille = 1000;
+
+  uint32_t now = millis();
+  uint8_t rate = TDMA_PHY_RATE_6M;
+  uint8_t oldRate = TDMA_PHY_RATE_6M;
+  bool rescheduled = false;
+  bool confirmed = false;
+
+  portENTER_CRITICAL(&_registeredNodesLock);
+  for (int i = 0; i < TDMA_MAX_NODES; i++)
+  {
+    TDMANodeInfo &node = registeredNodes[i];
+    if (!node.registered || node.nodeId != nodeId)
+      continue;
+
+    oldRate = node.phyRate;
+
+    // Channel scoring sees the same windows, aggregated over all nodes
+    deliveryExpected += expected;
+    deliveryReceived += (packets > expected) ? expected : packets;
+
+    // A window that straddles the last change measured a mix of rates
+    if (node.rateChangedMs != 0 && (now - node.rateChangedMs) < windowMs)
+    {
+      rate = node.phyRate;
+      break;
+    }
+
+    uint8_t upWindows =
+        node.rateUpThreshold ? node.rateUpThreshold : PHY_RATE_UP_WINDOWS;
+
+    if (permille >= PHY_RATE_UP_PERMILLE)
+    {
+      if (node.rateProbing)
+      {
+        // Probe survived a full clean window: shrink the slot to match
+        node.rateProbing = false;
+        node.slotPhyRate = node.phyRate;
+        node.rateUpThreshold = 0;
+        node.rateGoodWindows = 0;
+        rescheduled = true;
+        confirmed = true;
+      }
+      else if (node.phyRate + 1 < TDMA_PHY_RATE_COUNT &&
+               ++node.rateGoodWindows >= upWindows)
+      {
+        node.phyRate++;
+        node.rateProbing = true;
+        node.rateGoodWindows = 0;
+        node.rateChangedMs = now;
+        rescheduled = true;
+      }
+    }
+    else if (permille < PHY_RATE_DOWN_PERMILLE)
+    {
+      if (node.rateProbing)
+      {
+        uint16_t backoff = (uint16_t)upWindows * 2;
+        node.rateUpThreshold = (backoff > PHY_RATE_UP_WINDOWS_MAX)
+                                   ? PHY_RATE_UP_WINDOWS_MAX
+                                   : (uint8_t)backoff;
+      }
+      if (node.phyRate > TDMA_PHY_RATE_6M)
+      {
+        node.phyRate--;
+        node.rateChangedMs = now;
+        rescheduled = true;
+      }
+      node.slotPhyRate = node.phyRate;
+      node.rateProbing = false;
+      node.rateGoodWindows = 0;
+    }
+    else
+    {
+      node.rateGoodWindows = 0;
+    }
+
+    rate = node.phyRate;
+    break;
+  }
+  portEXIT_CRITICAL(&_registeredNodesLock);
+
+  if (rescheduled)
+  {
+    pendingRateSchedule = true;
+    if (confirmed)
+    {
+      SAFE_LOG("[TDMA] Node %d PHY rate %u Mbps confirmed (delivery %lu.%lu%%)\n",
+               nodeId, tdmaPhyRateMbps(rate), permille / 10, permille % 10);
+    }
+    else
+    {
+      SAFE_LOG("[TDMA] Node %d PHY rate %u -> %u Mbps (delivery %lu.%lu%%)\n",
+               nodeId, tdmaPhyRateMbps(oldRate), tdmaPhyRateMbps(rate),
+               permille / 10, permille % 10);
+    }
+  }
+
+  return rate;
+}
+
+// ============================================================================
+// CHANNEL AGILITY
+// ============================================================================
+// ChannelSelector scores the TDMA hop candidates; this glue feeds it link
+// metrics, lets it survey only while nothing is being recorded, and turns a
+// decision into a hop announced TDMA_CHANNEL_HOP_LEAD_BEACONS beacons ahead.
+// Hopping is disabled while the Gateway's WiFi is associated with a router or
+// running its own AP — the channel then belongs to that network.
+// ============================================================================
+
+bool SyncManager::canHopChannel() const
+{
+  return WiFi.status() != WL_CONNECTED && !(WiFi.getMode() & WIFI_MODE_AP);
+}
+
+void SyncManager::noteRxSignal(int8_t rssi, int8_t noiseFloor)
+{
+  portENTER_CRITICAL(&_channelStatsLock);
+  rxRssiSum += rssi;
+  rxNoiseSum += noiseFloor;
+  rxSignalCount++;
+  portEXIT_CRITICAL(&_channelStatsLock);
+}
+
+void SyncManager::serviceChannelAgility()
+{
+  bool hopAllowed = canHopChannel();
+  bool hopInProgress = (hopBeaconsRemaining > 0) || hopSwitchDue;
+
+  if (!hopAllowed)
+  {
+    uint8_t ch = WiFi.channel();
+    if (ch >= 1 && ch <= 14)
+      channelSelector.setActiveChannel(ch);
+  }
+
+  // Idle-time survey: back-to-back during discovery, slow background pass in
+  // warm standby, never while streaming or announcing a hop.
+  channelSelector.serviceSurvey(hopAllowed && !isStreaming && !hopInProgress,
+                                tdmaState == TDMA_STATE_DISCOVERY);
+
+  uint32_t now = millis();
+  if (now - lastChannelEvalMs < CHANNEL_EVAL_INTERVAL_MS)
+    return;
+  lastChannelEvalMs = now;
+
+  int32_t rssiSum, noiseSum;
+  uint32_t signalCount, expected, received;
+  portENTER_CRITICAL(&_channelStatsLock);
+  rssiSum = rxRssiSum;
+  noiseSum = rxNoiseSum;
+  signalCount = rxSignalCount;
+  rxRssiSum = rxNoiseSum = 0;
+  rxSignalCount = 0;
+  portEXIT_CRITICAL(&_channelStatsLock);
+
+  portENTER_CRITICAL(&_registeredNodesLock);
+  expected = deliveryExpected;
+  received = deliveryReceived;
+  deliveryExpected = deliveryReceived = 0;
+  portEXIT_CRITICAL(&_registeredNodesLock);
+
+  channelSelector.recordSignal(rssiSum, noiseSum, signalCount);
+  channelSelector.recordDelivery(expected, received);
+
+  static uint32_t lastScoreLog = 0;
+  if (now - lastScoreLog > 60000)
+  {
+    lastScoreLog = now;
+    channelSelector.logScores();
+  }
+
+  if (!hopAllowed || hopInProgress)
+    return;
+
+  uint8_t target = channelSelector.evaluate(isStreaming);
+  if (target == 0)
+    return;
+
+  hopTargetChannel = target;
+  hopBeaconsRemaining = TDMA_CHANNEL_HOP_LEAD_BEACONS;
+  SAFE_LOG("[Channel] Hop %u -> %u announced %u beacons ahead (%s)\n",
+           channelSelector.getActiveChannel(), target,
+           TDMA_CHANNEL_HOP_LEAD_BEACONS,
+           isStreaming ? "loss on active channel" : "idle survey");
+  channelSelector.logScores();
+}
+
+uint8_t SyncManager::getNodePhyRate(uint8_t nodeId) const
+{
+  uint8_t rate = TDMA_PHY_RATE_6M;
+  portENTER_CRITICAL(&_registeredNodesLock);
+  for (int i = 0; i < TDMA_MAX_NODES; i++)
+  {
+    if (registeredNodes[i].registered && registeredNodes[i].nodeId == nodeId)
+    {
+      rate = registeredNodes[i].phyRate;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&_registeredNodesLock);
+  return rate;
+}
+
 void SyncManager::pruneInactiveNodes()
 {
   uint32_t now = millis();
@@ -1502,6 +1949,7 @@ void SyncManager::pruneInactiveNodes()
 
   if (changed)
   {
+    rebuildSensorRoutes();
     if (nodeCount > 0)
     {
       recalculateSlots();
@@ -1587,78 +2035,77 @@ void SyncManager::sendDelayResp(uint8_t nodeId, uint32_t sequenceNum,
 
 uint8_t SyncManager::getExpectedSensorCount() const
 {
-  portENTER_CRITICAL(&_registeredNodesLock);
-  uint8_t totalSensors = 0;
-  for (int i = 0; i < TDMA_MAX_NODES; i++)
-  {
-    if (registeredNodes[i].registered)
-    {
-      // S3-FIX: Treat sensorCount=0 as 1 (consistent with getCompactSensorId)
-      totalSensors += (registeredNodes[i].sensorCount > 0)
-                          ? registeredNodes[i].sensorCount
-                          : 1;
-    }
-  }
-  portEXIT_CRITICAL(&_registeredNodesLock);
-  return totalSensors;
+  uint8_t base, routed, total;
+  readSensorRoute(0, base, routed, total);
+  return total;
 }
 
 uint8_t SyncManager::getExpectedSensorIds(uint8_t *sensorIds,
                                           uint8_t maxCount) const
 {
-  // S2-FIX: Use the SAME sorted order as getCompactSensorId so that
-  // expected sensor IDs match the compact IDs used in the data path.
-  // Without this, the expected list could be in a different order than
-  // the compact IDs, causing the SyncFrameBuffer to reject valid samples.
+  // Compact IDs are dense (1..N) in the routing table's node order, so the
+  // expected list is simply 1..N and column c - 1 holds compact ID c.
+  uint8_t base, routed, total;
+  readSensorRoute(0, base, routed, total);
 
-  // EC-2: Protect registeredNodes[] reads against concurrent writes.
-  portENTER_CRITICAL(&_registeredNodesLock);
-
-  // Build sorted index list (same logic as getCompactSensorId)
-  uint8_t sortedIndices[TDMA_MAX_NODES];
-  uint8_t sortedCount = 0;
-
-  for (int i = 0; i < TDMA_MAX_NODES; i++)
+  uint8_t idx = 0;
+  for (; idx < total && idx < maxCount; idx++)
   {
-    if (registeredNodes[i].registered)
-    {
-      sortedIndices[sortedCount++] = i;
-    }
+    sensorIds[idx] = (uint8_t)(idx + 1);
   }
+  return idx;
+}
 
-  // Insertion sort by nodeId
-  for (uint8_t a = 1; a < sortedCount; a++)
+uint8_t SyncManager::getCompactSensorId(uint8_t nodeId,
+                                        uint8_t localSensorIndex) const
+{
+  uint8_t base, routed, total;
+  readSensorRoute(nodeId, base, routed, total);
+  if (localSensorIndex >= routed)
   {
-    uint8_t key = sortedIndices[a];
-    int8_t b = a - 1;
-    while (b >= 0 && registeredNodes[sortedIndices[b]].nodeId >
-                         registeredNodes[key].nodeId)
-    {
-      sortedIndices[b + 1] = sortedIndices[b];
-      b--;
-    }
-    sortedIndices[b + 1] = key;
+    return 0;
   }
+  return (uint8_t)(base + localSensorIndex + 1);
+}
 
-  uint8_t idx = 0;
-  for (uint8_t s = 0; s < sortedCount && idx < maxCount; s++)
+uint32_t SyncManager::getNodeRoutes(uint8_t nodeId, uint8_t *compactIds,
+                                    uint8_t count) const
+{
+  uint8_t base, routed, total;
+  uint32_t generation = readSensorRoute(nodeId, base, routed, total);
+  for (uint8_t i = 0; i < count; i++)
   {
-    const TDMANodeInfo &node = registeredNodes[sortedIndices[s]];
-    // S3-FIX: Treat sensorCount=0 as 1
-    const uint8_t effectiveCount = (node.sensorCount > 0) ? node.sensorCount : 1;
+    compactIds[i] = (i < routed) ? (uint8_t)(base + i + 1) : 0;
+  }
+  return generation;
+}
 
-    for (uint8_t si = 0; si < effectiveCount && idx < maxCount; si++)
+// Lock-free read of one node's route (and the total sensor count) from a
+// single table generation
+uint32_t SyncManager::readSensorRoute(uint8_t nodeId, uint8_t &base,
+                                      uint8_t &routed, uint8_t &total) const
+{
+  for (;;)
+  {
+    const SensorRouteTable *table =
+        __atomic_load_n(&activeRoutes, __ATOMIC_ACQUIRE);
+    uint32_t generation = __atomic_load_n(&table->generation, __ATOMIC_ACQUIRE);
+    if (generation & 1)
     {
-      sensorIds[idx] = (uint8_t)(idx + 1);
-      idx++;
+      continue; // Recycled and being refilled: reload activeRoutes
+    }
+    base = table->compactBase[nodeId];
+    routed = table->nodeSensors[nodeId];
+    total = table->sensorCount;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&table->generation, __ATOMIC_RELAXED) == generation)
+    {
+      return generation;
     }
   }
-  portEXIT_CRITICAL(&_registeredNodesLock);
-  return idx;
 }
 
-uint8_t SyncManager::getCompactSensorId(uint8_t nodeId,
-                                        uint8_t localSensorIndex) const
+void SyncManager::rebuildSensorRoutes()
 {
   // ==========================================================================
   // S2-FIX: STABLE COMPACT IDs — Sort registered nodes by nodeId before
@@ -1669,8 +2116,8 @@ uint8_t SyncManager::getCompactSensorId(uint8_t nodeId,
   // causing the webapp to lose track of sensor identity.
   // ==========================================================================
 
-  // EC-2: Protect registeredNodes[] reads against concurrent writes from
-  // handleNodeRegistration() on another core.
+  // The lock also serializes writers (registration on Core 0, rescan and
+  // NVS load from loop()).
   portENTER_CRITICAL(&_registeredNodesLock);
 
   // Build a sorted index list of registered nodes (by ascending nodeId)
@@ -1699,9 +2146,15 @@ uint8_t SyncManager::getCompactSensorId(uint8_t nodeId,
     sortedIndices[b + 1] = key;
   }
 
-  // Walk sorted nodes to compute stable compact base
-  uint8_t compactBase = 0;
+  // Refill the oldest table; readers of it see an odd generation and retry
+  const uint32_t generation = routeGeneration + 2;
+  SensorRouteTable &table =
+      routeTables[(generation / 2) % SENSOR_ROUTE_TABLES];
+  __atomic_store_n(&table.generation, generation - 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
 
+  memset(table.nodeSensors, 0, sizeof(table.nodeSensors));
+  uint8_t compactBase = 0;
   for (uint8_t s = 0; s < sortedCount; s++)
   {
     const TDMANodeInfo &node = registeredNodes[sortedIndices[s]];
@@ -1711,22 +2164,22 @@ uint8_t SyncManager::getCompactSensorId(uint8_t nodeId,
     // here would cause the next node's compact base to collide.
     const uint8_t effectiveCount = (node.sensorCount > 0) ? node.sensorCount : 1;
 
-    if (node.nodeId == nodeId)
+    if (table.nodeSensors[node.nodeId] == 0) // First entry wins (as before)
     {
-      if (localSensorIndex >= effectiveCount)
-      {
-        portEXIT_CRITICAL(&_registeredNodesLock);
-        return 0;
-      }
-      portEXIT_CRITICAL(&_registeredNodesLock);
-      return (uint8_t)(compactBase + localSensorIndex + 1);
+      table.compactBase[node.nodeId] = compactBase;
+      table.nodeSensors[node.nodeId] = effectiveCount;
     }
-
     compactBase = (uint8_t)(compactBase + effectiveCount);
   }
+  table.sensorCount = compactBase;
 
+  __atomic_store_n(&table.generation, generation, __ATOMIC_RELEASE);
+  __atomic_store_n(&activeRoutes, &table, __ATOMIC_RELEASE);
+  routeGeneration = generation;
   portEXIT_CRITICAL(&_registeredNodesLock);
-  return 0;
+
+  SAFE_LOG("[TDMA] Sensor routes gen %lu: %u nodes, %u sensors\n",
+           (unsigned long)generation, sortedCount, compactBase);
 }
 // ============================================================================
 
@@ -1916,6 +2369,7 @@ void SyncManager::loadTopologyFromNVS()
       memcpy(registeredNodes[i].mac, entry.mac, 6);
       registeredNodes[i].registered = true;
       registeredNodes[i].lastHeard = 0; // V2-FIX: Mark as NOT recently heard.
+      resetNodePhyRate(registeredNodes[i]);
       portEXIT_CRITICAL(&_registeredNodesLock);
 
       // Log clamping OUTSIDE the spinlock
@@ -1945,6 +2399,7 @@ void SyncManager::loadTopologyFromNVS()
 
   nodeCount = loaded;
   preRegisteredNodeCount = loaded;
+  rebuildSensorRoutes();
 
   // ==========================================================================
   // OPT-2: Auto-infer expectedNodeCount from NVS topology.
@@ -2,7 +2,9 @@
 #define SYNC_MANAGER_H
 
 #include "../libraries/IMUConnectCore/src/TDMAProtocol.h"
+#include "ChannelSelector.h"
 #include "Config.h"
+#include "../libraries/IMUConnectCore/src/TraceRing.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_now.h>
@@ -49,6 +51,14 @@ struct TDMANodeInfo
   bool registered;             // Is this slot active?
   uint8_t mac[6];              // MAC address for collision detection
   uint32_t lastScheduleSentMs; // V4-FIX: Per-node schedule resend rate limiting
+
+  // Adaptive PHY rate (see SyncManager::reportNodeDelivery)
+  uint8_t phyRate;         // TDMAPhyRate the Node is told to transmit at
+  uint8_t slotPhyRate;     // Rate the slot width is sized for (lags increases)
+  uint8_t rateGoodWindows; // Consecutive clean delivery windows at phyRate
+  uint8_t rateUpThreshold; // Clean windows needed to probe up (0 = default)
+  bool rateProbing;        // phyRate was just raised; not yet proven
+  uint32_t rateChangedMs;  // millis() of the last phyRate change
 };
 
 class SyncManager
@@ -93,6 +103,11 @@ public:
   // mode: RADIO_MODE_BLE_OFF (0x00) or RADIO_MODE_BLE_ON (0x01)
   void sendRadioModeCommand(uint8_t mode);
 
+  // Broadcast a CMD_FORWARD_PACKET command to nodes (Gateway mode);
+  // targetNode 0xFF addresses every node
+  void sendNodeCommand(uint8_t cmdType, uint32_t param,
+                       uint8_t targetNode = 0xFF);
+
   // Broadcast mag calibration command to nodes (Gateway mode)
   void sendMagCalibCommand(uint8_t cmdType, uint32_t param,
                            uint8_t targetNode = 0xFF);
@@ -151,6 +166,45 @@ public:
   // Force all nodes to reset their timing state (called when streaming starts)
   void triggerSyncReset();
 
+  // ============================================================================
+  // ADAPTIVE PHY RATE
+  // ============================================================================
+  // Fed once per diagnostics window with the 0x26 packets actually received
+  // from a node. Clean windows step the node's PHY rate up one rung; a lossy
+  // window steps it straight back down. The new rate is pushed to nodes via
+  // the TDMA schedule from update(). Returns the node's current TDMAPhyRate.
+  // ============================================================================
+  uint8_t reportNodeDelivery(uint8_t nodeId, uint32_t packets,
+                             uint32_t windowMs);
+  uint8_t getNodePhyRate(uint8_t nodeId) const;
+
+  // RX signal of a received node packet (ESP-NOW callback context)
+  void noteRxSignal(int8_t rssi, int8_t noiseFloor);
+
+  // ============================================================================
+  // BEACON TIMING
+  // ============================================================================
+  // ProtocolTask calls onBeaconTick() from its 20ms esp_timer notification
+  // before update(). Once ticks arrive, update() emits periodic beacons on
+  // them instead of polling micros(). Each beacon is TSF-stamped as it is
+  // handed to the MAC; the broadcast send-done callback closes the stamp.
+  // Stats are cumulative since startTDMA().
+  // ============================================================================
+  struct BeaconTimingStats
+  {
+    uint32_t jitterHist[TDMA_BEACON_JITTER_BUCKETS]; // |period - 20ms| buckets
+    uint32_t jitterMaxUs;
+    uint32_t txLatencyMaxUs; // Hand-off to send-done
+    uint32_t txLatencyLastUs;
+  };
+  void onBeaconTick() { beaconTickDriven = true; beaconTickPending = true; }
+  void getBeaconTiming(BeaconTimingStats &out);
+  void noteBroadcastSent(); // ESP-NOW send callback context
+  uint8_t getActiveChannel() const
+  {
+    return channelSelector.getActiveChannel();
+  }
+
   // ============================================================================
   // DISCOVERY LOCK — Late-Join Control
   // ============================================================================
@@ -217,6 +271,33 @@ public:
   // Returns 0 if node/index is invalid.
   uint8_t getCompactSensorId(uint8_t nodeId, uint8_t localSensorIndex) const;
 
+  // ============================================================================
+  // SENSOR ROUTING TABLE
+  // ============================================================================
+  // (nodeId, localSensorIndex) -> compact sensor ID, precomputed whenever the
+  // registered node set changes (registration, sensor-count update, prune,
+  // NVS load, rescan) instead of sorting registeredNodes[] on every lookup.
+  // Compact ID c is SyncFrameBuffer column c - 1 (getExpectedSensorIds).
+  //
+  // Tables are published RCU-style: the writer refills a spare table and
+  // swaps activeRoutes, so readers never lock. The generation is odd while
+  // a table is being refilled; a reader that sees it change under it (its
+  // table was recycled) retries, so a mapping is never torn.
+  // ============================================================================
+  struct SensorRouteTable
+  {
+    uint32_t generation;      // Even once published, odd while refilled
+    uint8_t sensorCount;      // Compact IDs are 1..sensorCount
+    uint8_t compactBase[256]; // By nodeId: compact ID of sensor 0, minus 1
+    uint8_t nodeSensors[256]; // By nodeId: routed sensors (0 = unregistered)
+  };
+
+  // Compact IDs of sensors 0..count-1 of one node (0 = unrouted), all from
+  // one table generation. Lock-free; returns that generation.
+  uint32_t getNodeRoutes(uint8_t nodeId, uint8_t *compactIds,
+                         uint8_t count) const;
+  uint32_t getSensorRouteGeneration() const { return routeGeneration; }
+
   // Get the current sync epoch (base timestamp for frame 0)
   // Used by SyncFrameBuffer to normalize timestamps from different nodes
   uint32_t getSyncEpoch() const { return syncEpochUs; }
@@ -250,6 +331,14 @@ private:
   TDMAState tdmaState;
   volatile uint32_t tdmaFrameNumber;          // Monotonic frame counter
   uint32_t lastBeaconTime;                    // micros() of last beacon send
+  volatile bool beaconTickDriven = false;     // ProtocolTask timer is running
+  volatile bool beaconTickPending = false;    // Tick not yet consumed
+  uint64_t lastPeriodicBeaconTsf = 0;         // Stamp of last periodic beacon
+  uint64_t beaconTxStampTsf = 0;              // Stamp of the beacon in flight
+  bool beaconTxInFlight = false;              // Awaiting broadcast send-done
+  uint16_t beaconTxLatencyUs = 0xFFFF;        // Last completed, for the trailer
+  BeaconTimingStats beaconTiming = {};        // Guarded by _beaconTimingLock
+  portMUX_TYPE _beaconTimingLock = portMUX_INITIALIZER_UNLOCKED;
   uint32_t discoveryStartTime;                // When discovery phase started
   uint32_t lastPruneTime;                     // When we last pruned inactive nodes
   volatile uint8_t syncResetBeaconsRemaining; // Number of beacons to broadcast
@@ -265,6 +354,16 @@ private:
   // concurrent writes from handleNodeRegistration (Core 0).
   mutable portMUX_TYPE _registeredNodesLock = portMUX_INITIALIZER_UNLOCKED;
 
+  // Sensor routing (see SENSOR ROUTING TABLE). Three tables: the active
+  // one, the previous one (readers may still hold it) and the spare.
+  static const uint8_t SENSOR_ROUTE_TABLES = 3;
+  SensorRouteTable routeTables[SENSOR_ROUTE_TABLES];
+  SensorRouteTable *activeRoutes;
+  uint32_t routeGeneration = 0;
+  void rebuildSensorRoutes(); // Takes _registeredNodesLock; call after edits
+  uint32_t readSensorRoute(uint8_t nodeId, uint8_t &base, uint8_t &routed,
+                           uint8_t &total) const;
+
   // ====================================================================
   // DISCOVERY TIMING CONSTANTS
   // ====================================================================
@@ -282,7 +381,9 @@ private:
   // TDMA Helper Functions
   // ============================================================================
   void sendSyncPulse();    // Legacy sync pulse
-  void sendTDMABeacon();   // TDMA beacon at start of each frame
+  uint64_t sendTDMABeacon();             // TDMA beacon, returns its TSF stamp
+  bool beaconDue(uint32_t now);           // Timer tick or elapsed-time gate
+  void sendPeriodicBeacon(uint32_t now);  // Beacon + period jitter sample
   void sendTDMASchedule(); // Broadcast slot assignments
   void handleNodeRegistration(const uint8_t *senderMac, const uint8_t *data,
                               int len);
@@ -294,6 +395,30 @@ private:
   // Discovery lock state
   bool discoveryLocked = false;
   volatile bool pendingSaveTopology = false; // Deferred NVS write flag
+  volatile bool pendingRateSchedule = false; // PHY rate changed, reschedule
+
+  // Channel agility (see serviceChannelAgility)
+  ChannelSelector channelSelector;
+  uint8_t hopTargetChannel = 0;    // Announced hop target (0 = none)
+  uint8_t hopBeaconsRemaining = 0; // Announcing beacons still to send
+  bool hopSwitchDue = false;       // Retune before the next beacon
+  uint32_t lastChannelEvalMs = 0;
+  uint32_t deliveryExpected = 0; // Guarded by _registeredNodesLock
+  uint32_t deliveryReceived = 0;
+  portMUX_TYPE _channelStatsLock = portMUX_INITIALIZER_UNLOCKED;
+  int32_t rxRssiSum = 0;
+  int32_t rxNoiseSum = 0;
+  uint32_t rxSignalCount = 0;
+  static const uint32_t CHANNEL_EVAL_INTERVAL_MS = 10000;
+  bool canHopChannel() const;
+  void serviceChannelAgility();
+  void resetNodePhyRate(TDMANodeInfo &node);
+
+  // Adaptive PHY rate thresholds (delivery ratio in permille of expected)
+  static const uint16_t PHY_RATE_UP_PERMILLE = 995;   // Clean window
+  static const uint16_t PHY_RATE_DOWN_PERMILLE = 970; // Lossy window
+  static const uint8_t PHY_RATE_UP_WINDOWS = 3;       // Clean windows to probe up
+  static const uint8_t PHY_RATE_UP_WINDOWS_MAX = 24;  // Backoff cap after failed probes
   PendingNode pendingNodes[MAX_PENDING_NODES];
   uint8_t sessionKnownMACs[TDMA_MAX_NODES][6];
   uint8_t sessionKnownMACCount = 0;
@@ -14,9 +14,12 @@ WebSocketManager *WebSocketManager::instance = nullptr;
 
 WebSocketManager::WebSocketManager()
     : webSocket(nullptr), messageCallback(nullptr), initialized(false),
-      clientCount(0)
+      clientCount(0), frameRing(nullptr), batchBuffer(nullptr),
+      batchOpen(false), batchOpenedMs(0), lastStatsLogMs(0)
 {
   instance = this;
+  memset(clients, 0, sizeof(clients));
+  memset(&binaryStats, 0, sizeof(binaryStats));
 }
 
 void WebSocketManager::init(uint16_t port)
@@ -29,6 +32,13 @@ void WebSocketManager::init(uint16_t port)
 
   SAFE_LOG("[WS] Initializing WebSocket server on port %d\n", port);
 
+  // Allocated once; without it the server still runs, just text-only
+  batchBuffer = (uint8_t *)malloc(BATCH_MAX_BYTES);
+  if (batchBuffer == nullptr)
+  {
+    SAFE_PRINTLN("[WS] Binary sync stream disabled (out of memory)");
+  }
+
   webSocket = new WebSocketsServer(port);
   webSocket->begin();
   webSocket->onEvent(webSocketEventStatic);
@@ -42,6 +52,23 @@ void WebSocketManager::loop()
   if (!initialized || !webSocket)
     return;
   webSocket->loop();
+  flushSyncFrames();
+
+  uint32_t now = millis();
+  if (clientCount > 0 && now - lastStatsLogMs > STATS_LOG_INTERVAL_MS)
+  {
+    lastStatsLogMs = now;
+    BinaryStreamStats st;
+    getBinaryStreamStats(st);
+    if (st.framesRead > 0)
+    {
+      SAFE_LOG("[WS] Binary stream: frames=%lu dropped=%lu batches=%lu "
+               "skipped=%lu slow=%lu clients=%u\n",
+               (unsigned long)st.framesRead, (unsigned long)st.framesDropped,
+               (unsigned long)st.batchesSent, (unsigned long)st.batchesSkipped,
+               (unsigned long)st.slowSends, clientCount);
+    }
+  }
 }
 
 void WebSocketManager::webSocketEventStatic(uint8_t num, WStype_t type,
@@ -62,6 +89,10 @@ void WebSocketManager::webSocketEvent(uint8_t num, WStype_t type,
     SAFE_LOG("[WS] Client #%u disconnected\n", num);
     if (clientCount > 0)
       clientCount--;
+    if (num < WEBSOCKETS_SERVER_CLIENT_MAX)
+      clients[num].connected = false;
+    if (clientCount == 0 && frameRing != nullptr)
+      frameRing->detach(FRAME_SINK_WEBSOCKET);
     break;
 
   case WStype_CONNECTED:
@@ -70,6 +101,14 @@ void WebSocketManager::webSocketEvent(uint8_t num, WStype_t type,
     SAFE_LOG("[WS] Client #%u connected from %s\n", num,
              ip.toString().c_str());
     clientCount++;
+    if (num < WEBSOCKETS_SERVER_CLIENT_MAX)
+    {
+      clients[num].connected = true;
+      clients[num].backoffMs = 0;
+      clients[num].backoffUntilMs = millis();
+    }
+    if (frameRing != nullptr && batchBuffer != nullptr)
+      frameRing->attach(FRAME_SINK_WEBSOCKET);
 
     // Send welcome message
     webSocket->sendTXT(
@@ -106,8 +145,7 @@ void WebSocketManager::broadcast(const String &message)
 {
   if (!initialized || !webSocket)
     return;
-  String msg = message; // Make non-const copy
-  webSocket->broadcastTXT(msg);
+  webSocket->broadcastTXT(message.c_str(), message.length());
 }
 
 void WebSocketManager::broadcastJson(const JsonDocument &doc)
@@ -120,6 +158,125 @@ void WebSocketManager::broadcastJson(const JsonDocument &doc)
   webSocket->broadcastTXT(output);
 }
 
+// ============================================================================
+// BINARY SYNC STREAM
+// ============================================================================
+
+void WebSocketManager::setFrameRing(SyncFrameRing *ring)
+{
+  frameRing = ring;
+}
+
+void WebSocketManager::flushSyncFrames()
+{
+  if (frameRing == nullptr || batchBuffer == nullptr ||
+      !frameRing->isAttached(FRAME_SINK_WEBSOCKET))
+    return;
+
+  uint32_t pending = frameRing->pending(FRAME_SINK_WEBSOCKET);
+  if (pending == 0)
+  {
+    batchOpen = false;
+    return;
+  }
+
+  uint32_t now = millis();
+  if (!batchOpen)
+  {
+    batchOpen = true;
+    batchOpenedMs = now;
+  }
+  if (pending < BATCH_MIN_FRAMES && now - batchOpenedMs < BATCH_MAX_AGE_MS)
+    return;
+
+  // Bounded work per pass; a longer backlog is lapped by the ring
+  for (uint8_t b = 0; b < MAX_BATCHES_PER_LOOP; b++)
+  {
+    size_t len = 0;
+    uint8_t frames = 0;
+    while (frames < BATCH_MAX_FRAMES)
+    {
+      size_t n = frameRing->read(FRAME_SINK_WEBSOCKET, batchBuffer + len,
+                                 BATCH_MAX_BYTES - len);
+      if (n == 0)
+        break;
+      len += n;
+      frames++;
+    }
+    if (len == 0)
+      break;
+    broadcastBinary(batchBuffer, len);
+    if (frames < BATCH_MAX_FRAMES)
+      break;
+  }
+  batchOpen = frameRing->pending(FRAME_SINK_WEBSOCKET) > 0;
+  batchOpenedMs = now;
+}
+
+bool WebSocketManager::sendToClient(uint8_t num, const uint8_t *data,
+                                    size_t len, uint32_t nowMs)
+{
+  ClientState &c = clients[num];
+  if ((int32_t)(nowMs - c.backoffUntilMs) < 0)
+  {
+    binaryStats.batchesSkipped++;
+    return false;
+  }
+
+  uint32_t startUs = micros();
+  bool ok = webSocket->sendBIN(num, data, len);
+  uint32_t elapsedUs = micros() - startUs;
+  if (ok && elapsedUs < SLOW_SEND_US)
+  {
+    c.backoffMs = 0;
+    return true;
+  }
+
+  // Send failed or TCP send buffer was full (write blocked): back off so
+  // one slow tablet cannot stall loop() or the other clients
+  if (c.backoffMs == 0)
+    c.backoffMs = BACKOFF_MIN_MS;
+  else if (c.backoffMs < BACKOFF_MAX_MS / 2)
+    c.backoffMs *= 2;
+  else
+    c.backoffMs = BACKOFF_MAX_MS;
+  c.backoffUntilMs = millis() + c.backoffMs;
+  binaryStats.slowSends++;
+  return ok;
+}
+
+void WebSocketManager::broadcastBinary(const uint8_t *data, size_t len)
+{
+  if (!initialized || !webSocket || len == 0)
+    return;
+
+  uint32_t now = millis();
+  bool sent = false;
+  for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+  {
+    if (clients[num].connected && sendToClient(num, data, len, now))
+    {
+      sent = true;
+    }
+  }
+  if (sent)
+  {
+    binaryStats.batchesSent++;
+  }
+}
+
+void WebSocketManager::getBinaryStreamStats(BinaryStreamStats &out)
+{
+  out = binaryStats;
+  if (frameRing != nullptr)
+  {
+    SyncFrameRing::SinkStats sink;
+    frameRing->getSinkStats(FRAME_SINK_WEBSOCKET, sink);
+    out.framesRead = sink.framesRead;
+    out.framesDropped = sink.framesDropped;
+  }
+}
+
 bool WebSocketManager::hasClients() const { return clientCount > 0; }
 
 uint8_t WebSocketManager::getClientCount() const { return clientCount; }
@@ -2,6 +2,19 @@
  * WebSocketManager.h - WebSocket Server for Real-time Data Streaming
  *
  * Uses WebSockets library by Markus Sattler for better compatibility.
+ *
+ * BINARY SYNC STREAM: while a client is connected, loop() reads 0x25 sync
+ * frames through the WebSocket cursor of the shared SyncFrameRing and
+ * broadcasts them as binary messages of BATCH_MIN_FRAMES..BATCH_MAX_FRAMES
+ * frames. Each message body is the same
+ * byte stream the USB port carries: [len lo][len hi][0x25 frame] repeated,
+ * so hosts can reuse their serial frame parser.
+ *
+ * Backpressure is per client: a send that fails or blocks longer than
+ * SLOW_SEND_US (TCP send buffer full) backs that client off, doubling up to
+ * BACKOFF_MAX_MS. Batches due while backed off are skipped for that client
+ * only. If loop() falls more than a ring behind, the cursor skips to the
+ * oldest frame still held (counted as dropped) without affecting USB.
  ******************************************************************************/
 
 #ifndef WEBSOCKET_MANAGER_H
@@ -11,6 +24,7 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <WebSocketsServer.h>
+#include "SyncFrameRing.h"
 
 
 // Callback type for message processing
@@ -37,6 +51,27 @@ public:
    */
   void broadcast(const String &message);
 
+  /**
+   * Broadcast a binary message to every client that is not backed off
+   */
+  void broadcastBinary(const uint8_t *data, size_t len);
+
+  /**
+   * Source of the binary sync stream. The WebSocket sink is attached while
+   * at least one client is connected.
+   */
+  void setFrameRing(SyncFrameRing *ring);
+
+  struct BinaryStreamStats
+  {
+    uint32_t framesRead;
+    uint32_t framesDropped; // Lapped in the shared ring
+    uint32_t batchesSent;
+    uint32_t batchesSkipped;  // Per-client skips while backed off
+    uint32_t slowSends;       // Sends that triggered a backoff
+  };
+  void getBinaryStreamStats(BinaryStreamStats &out);
+
   /**
    * Broadcast JSON document to all clients
    * @param doc ArduinoJson document
@@ -60,11 +95,42 @@ public:
   void setMessageCallback(WSMessageCallback callback);
 
 private:
+  static constexpr uint8_t BATCH_MIN_FRAMES = 4;
+  static constexpr uint8_t BATCH_MAX_FRAMES = 8;
+  static constexpr size_t BATCH_MAX_BYTES =
+      BATCH_MAX_FRAMES * SYNC_FRAME_RING_RECORD_MAX;
+  static constexpr uint32_t BATCH_MAX_AGE_MS = 20; // Flush partial batches
+  static constexpr uint8_t MAX_BATCHES_PER_LOOP = 2;
+  static constexpr uint32_t SLOW_SEND_US = 5000;
+  static constexpr uint16_t BACKOFF_MIN_MS = 100;
+  static constexpr uint16_t BACKOFF_MAX_MS = 2000;
+  static constexpr uint32_t STATS_LOG_INTERVAL_MS = 10000;
+
+  struct ClientState
+  {
+    bool connected;
+    uint16_t backoffMs;
+    uint32_t backoffUntilMs;
+  };
+
   WebSocketsServer *webSocket;
   WSMessageCallback messageCallback;
   bool initialized;
   uint8_t clientCount;
 
+  ClientState clients[WEBSOCKETS_SERVER_CLIENT_MAX];
+
+  SyncFrameRing *frameRing;
+  uint8_t *batchBuffer;
+  bool batchOpen;         // Unsent frames seen since batchOpenedMs
+  uint32_t batchOpenedMs;
+  BinaryStreamStats binaryStats;
+  uint32_t lastStatsLogMs;
+
+  void flushSyncFrames();
+  bool sendToClient(uint8_t num, const uint8_t *data, size_t len,
+                    uint32_t nowMs);
+
   /**
    * Static event handler (bridges to instance method)
    */
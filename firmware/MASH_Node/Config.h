@@ -22,4 +22,13 @@
 // preventing WiFi/BLE ISR jitter from disrupting 200Hz sample timing.
 #define USE_FREERTOS_TASKS 1
 
+// Flash black box: spill frames the Gateway never ACKed to a raw flash ring
+// while recording, and backfill them as historical 0x26 packets once the link
+// recovers. Runtime-disabled if no "blackbox"/"spiffs" partition exists.
+#define ENABLE_FLASH_BLACKBOX 1
+
+// Per-core event trace ring (TraceRing.h), controlled from the Gateway via
+// CMD_TRACE_CONTROL. Set to 0 to compile every TRACE_EVENT out.
+#define ENABLE_TRACE_RING 1
+
 #endif // CONFIG_H
\ No newline at end of file
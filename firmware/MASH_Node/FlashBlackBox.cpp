@@ -0,0 +1,422 @@
+/*******************************************************************************
+ * FlashBlackBox.cpp - On-node flash ring for unACKed / overflowed frames
+ ******************************************************************************/
+#define DEVICE_ROLE DEVICE_ROLE_NODE
+
+#include "FlashBlackBox.h"
+
+// ============================================================================
+// Constructor / Init
+// ============================================================================
+
+FlashBlackBox::FlashBlackBox()
+    : partition(nullptr), sectorCount(0), stagingIndex(0), stagingRecords(0),
+      pendingValid(false), pendingRecords(0), lastSpillMs(0), headSector(0),
+      tailSector(0), tailRecord(0), tailRecordCount(0), usedSectors(0),
+      tailEpoch(0), erasedAhead(0), nextSequence(0), backlogFrames(0),
+      clearRequested(false), spilledCount(0), backfilledCount(0),
+      droppedCount(0), eraseCount(0), maxProgramUs(0), maxEraseUs(0),
+      flashMutex(nullptr)
+{
+}
+
+bool FlashBlackBox::init()
+{
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                       ESP_PARTITION_SUBTYPE_ANY,
+                                       BLACKBOX_PARTITION_LABEL);
+  if (partition == nullptr)
+  {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         ESP_PARTITION_SUBTYPE_ANY,
+                                         BLACKBOX_FALLBACK_LABEL);
+  }
+
+  if (partition == nullptr || partition->size < 2 * BLACKBOX_PAGE_SIZE)
+  {
+    partition = nullptr;
+    Serial.println("[BlackBox] No 'blackbox'/'spiffs' partition — disabled");
+    return false;
+  }
+
+  flashMutex = xSemaphoreCreateMutex();
+  if (flashMutex == nullptr)
+  {
+    partition = nullptr;
+    Serial.println("[BlackBox] Failed to create flashMutex — disabled");
+    return false;
+  }
+
+  sectorCount = partition->size / BLACKBOX_PAGE_SIZE;
+  if (sectorCount > BLACKBOX_MAX_SECTORS)
+    sectorCount = BLACKBOX_MAX_SECTORS;
+
+  resetRing();
+
+  Serial.printf("[BlackBox] Using partition '%s': %lu sectors x %u B, "
+                "%u frames/page (~%lu s of 200Hz data)\n",
+                partition->label, (unsigned long)sectorCount,
+                BLACKBOX_PAGE_SIZE, (unsigned)BLACKBOX_RECORDS_PER_PAGE,
+                (unsigned long)(sectorCount * BLACKBOX_RECORDS_PER_PAGE *
+                                TDMA_FRAME_PERIOD_MS / 1000));
+  return true;
+}
+
+void FlashBlackBox::resetRing()
+{
+  portENTER_CRITICAL(&ringLock);
+  stagingRecords = 0;
+  pendingValid = false;
+  pendingRecords = 0;
+  headSector = 0;
+  tailSector = 0;
+  tailRecord = 0;
+  tailRecordCount = 0;
+  usedSectors = 0;
+  tailEpoch++;
+  backlogFrames = 0;
+  portEXIT_CRITICAL(&ringLock);
+  erasedAhead = 0; // Head moved: unknown until pre-erased again
+}
+
+void FlashBlackBox::advanceTailSector()
+{
+  tailSector = (tailSector + 1) % sectorCount;
+  tailRecord = 0;
+  tailRecordCount = 0;
+  tailEpoch++;
+  usedSectors--;
+}
+
+// ============================================================================
+// PRODUCER SIDE — RAM staging (hot path, no flash access)
+// ============================================================================
+
+bool FlashBlackBox::spill(const TDMAFrameBufferEntry &entry)
+{
+  if (partition == nullptr)
+    return false;
+
+  bool stored = false;
+  portENTER_CRITICAL(&ringLock);
+  if (stagingRecords >= BLACKBOX_RECORDS_PER_PAGE)
+  {
+    // Staging full: hand it to service() if the pending slot is free
+    if (!pendingValid)
+    {
+      pendingValid = true;
+      pendingRecords = stagingRecords;
+      stagingIndex ^= 1;
+      stagingRecords = 0;
+    }
+  }
+
+  if (stagingRecords < BLACKBOX_RECORDS_PER_PAGE)
+  {
+    uint8_t *dst = pages[stagingIndex] + sizeof(BlackBoxPageHeader) +
+                   stagingRecords * sizeof(TDMAFrameBufferEntry);
+    memcpy(dst, &entry, sizeof(TDMAFrameBufferEntry));
+    stagingRecords++;
+    stored = true;
+  }
+  portEXIT_CRITICAL(&ringLock);
+
+  lastSpillMs = millis();
+  if (stored)
+    spilledCount++;
+  else
+    droppedCount++;
+  return stored;
+}
+
+// ============================================================================
+// FLUSH SIDE — loop() context (blocking flash erase/program)
+// ============================================================================
+
+bool FlashBlackBox::eraseSector(uint32_t sector)
+{
+  const size_t offset = (size_t)sector * BLACKBOX_PAGE_SIZE;
+  xSemaphoreTake(flashMutex, portMAX_DELAY);
+  uint32_t t0 = micros();
+  esp_err_t err = esp_partition_erase_range(partition, offset,
+                                            BLACKBOX_PAGE_SIZE);
+  uint32_t us = micros() - t0;
+  xSemaphoreGive(flashMutex);
+
+  if (us > maxEraseUs)
+    maxEraseUs = us;
+  if (err != ESP_OK)
+    return false;
+  eraseCount++;
+  return true;
+}
+
+// Not streaming: erase the next sector ahead of the head, unless it still
+// holds unread frames
+void FlashBlackBox::preEraseOne()
+{
+  portENTER_CRITICAL(&ringLock);
+  uint32_t free = sectorCount - usedSectors;
+  uint32_t sector = (headSector + erasedAhead) % sectorCount;
+  portEXIT_CRITICAL(&ringLock);
+
+  uint32_t target = free < BLACKBOX_PREERASE_SECTORS
+                        ? free
+                        : BLACKBOX_PREERASE_SECTORS;
+  if (erasedAhead >= target)
+    return;
+  if (eraseSector(sector))
+    erasedAhead++;
+}
+
+bool FlashBlackBox::writePage(const uint8_t *page, uint16_t records)
+{
+  BlackBoxPageHeader *hdr = (BlackBoxPageHeader *)page;
+  hdr->magic = BLACKBOX_PAGE_MAGIC;
+  hdr->sequence = nextSequence++;
+  hdr->recordCount = records;
+  hdr->recordSize = sizeof(TDMAFrameBufferEntry);
+  hdr->reserved = 0;
+
+  // No pre-erased sector (service() only gets here while not streaming):
+  // erase in place. Ring full: overwrite the oldest sector (oldest history
+  // is least useful).
+  uint32_t droppedFrames = 0;
+  portENTER_CRITICAL(&ringLock);
+  if (erasedAhead == 0 && usedSectors >= sectorCount)
+  {
+    uint32_t lost = (uint32_t)(tailRecordCount > tailRecord
+                                   ? tailRecordCount - tailRecord
+                                   : 0);
+    // tailRecordCount is only cached once the reader touched the sector;
+    // fall back to a full page worth of frames otherwise.
+    if (tailRecordCount == 0)
+      lost = BLACKBOX_RECORDS_PER_PAGE;
+    droppedFrames = lost;
+    backlogFrames = (backlogFrames > lost) ? backlogFrames - lost : 0;
+    advanceTailSector();
+  }
+  uint32_t sector = headSector;
+  portEXIT_CRITICAL(&ringLock);
+  droppedCount += droppedFrames;
+
+  bool ok = erasedAhead > 0 || eraseSector(sector);
+
+  // Program one flash page per call: the cache comes back on between
+  // chunks, so the RT tasks stall for one page program at a time
+  const size_t offset = (size_t)sector * BLACKBOX_PAGE_SIZE;
+  esp_err_t err = ok ? ESP_OK : ESP_FAIL;
+  for (size_t done = 0; ok && done < BLACKBOX_PAGE_SIZE;
+       done += BLACKBOX_PROGRAM_CHUNK)
+  {
+    xSemaphoreTake(flashMutex, portMAX_DELAY);
+    uint32_t t0 = micros();
+    err = esp_partition_write(partition, offset + done, page + done,
+                              BLACKBOX_PROGRAM_CHUNK);
+    uint32_t us = micros() - t0;
+    xSemaphoreGive(flashMutex);
+    if (us > maxProgramUs)
+      maxProgramUs = us;
+    ok = (err == ESP_OK);
+  }
+
+  // Programmed (or failed half way): either way the sector is no longer
+  // known-erased
+  if (erasedAhead > 0)
+    erasedAhead--;
+
+  if (!ok)
+  {
+    droppedCount += records;
+    static uint32_t lastErrLog = 0;
+    if (millis() - lastErrLog > 5000)
+    {
+      lastErrLog = millis();
+      Serial.printf("[BlackBox] Flash write failed at sector %lu: 0x%X\n",
+                    (unsigned long)sector, err);
+    }
+    return false;
+  }
+
+  portENTER_CRITICAL(&ringLock);
+  headSector = (headSector + 1) % sectorCount;
+  usedSectors++;
+  backlogFrames += records;
+  portEXIT_CRITICAL(&ringLock);
+  return true;
+}
+
+void FlashBlackBox::service(bool streaming)
+{
+  if (partition == nullptr)
+    return;
+
+  if (clearRequested)
+  {
+    clearRequested = false;
+    resetRing();
+    Serial.println("[BlackBox] Cleared (new sync epoch)");
+    return;
+  }
+
+  // Quiet-period flush: once spills stop (link recovered), push the partial
+  // page to flash so the backlog becomes visible to the backfill reader.
+  portENTER_CRITICAL(&ringLock);
+  if (!pendingValid && stagingRecords > 0 &&
+      (millis() - lastSpillMs) > BLACKBOX_QUIET_FLUSH_MS)
+  {
+    pendingValid = true;
+    pendingRecords = stagingRecords;
+    stagingIndex ^= 1;
+    stagingRecords = 0;
+  }
+  bool havePending = pendingValid;
+  uint16_t records = pendingRecords;
+  uint8_t pendingIndex = stagingIndex ^ 1;
+  portEXIT_CRITICAL(&ringLock);
+
+  if (!havePending)
+  {
+    // Idle: the only time a sector erase is allowed to stall the RT tasks
+    if (!streaming)
+      preEraseOne();
+    return;
+  }
+
+  uint32_t t0 = micros();
+  bool written = false;
+  if (streaming && erasedAhead == 0)
+  {
+    droppedCount += records; // No erased sector, and no erase while live
+  }
+  else
+  {
+    written = writePage(pages[pendingIndex], records);
+  }
+  uint32_t writeUs = micros() - t0;
+
+  portENTER_CRITICAL(&ringLock);
+  pendingValid = false;
+  pendingRecords = 0;
+  portEXIT_CRITICAL(&ringLock);
+
+  static uint32_t lastLog = 0;
+  if (millis() - lastLog > 5000)
+  {
+    lastLog = millis();
+    Serial.printf("[BlackBox] page=%u frames %s in %lu us | backlog=%lu "
+                  "spilled=%lu backfilled=%lu dropped=%lu erases=%lu "
+                  "erased=%lu progMaxUs=%lu eraseMaxUs=%lu\n",
+                  records, written ? "written" : "dropped",
+                  (unsigned long)writeUs, (unsigned long)backlogFrames,
+                  (unsigned long)spilledCount, (unsigned long)backfilledCount,
+                  (unsigned long)droppedCount, (unsigned long)eraseCount,
+                  (unsigned long)erasedAhead, (unsigned long)maxProgramUs,
+                  (unsigned long)maxEraseUs);
+  }
+}
+
+// ============================================================================
+// BACKFILL SIDE — ProtocolTask context
+// ============================================================================
+
+bool FlashBlackBox::peekOldest(TDMAFrameBufferEntry &out,
+                               BlackBoxCursor &cursor)
+{
+  if (partition == nullptr || backlogFrames == 0 || clearRequested)
+    return false;
+
+  // Never stall the TX path behind a sector erase
+  if (xSemaphoreTake(flashMutex, 0) != pdTRUE)
+    return false;
+
+  bool ok = false;
+  portENTER_CRITICAL(&ringLock);
+  uint32_t sector = tailSector;
+  uint16_t record = tailRecord;
+  uint16_t count = tailRecordCount;
+  uint32_t epoch = tailEpoch;
+  bool empty = (usedSectors == 0);
+  portEXIT_CRITICAL(&ringLock);
+
+  if (!empty)
+  {
+    const size_t base = (size_t)sector * BLACKBOX_PAGE_SIZE;
+    if (count == 0)
+    {
+      BlackBoxPageHeader hdr;
+      if (esp_partition_read(partition, base, &hdr, sizeof(hdr)) == ESP_OK &&
+          hdr.magic == BLACKBOX_PAGE_MAGIC &&
+          hdr.recordSize == sizeof(TDMAFrameBufferEntry) &&
+          hdr.recordCount <= BLACKBOX_RECORDS_PER_PAGE)
+      {
+        count = hdr.recordCount;
+        portENTER_CRITICAL(&ringLock);
+        if (tailEpoch == epoch)
+          tailRecordCount = count;
+        portEXIT_CRITICAL(&ringLock);
+      }
+    }
+
+    if (record < count)
+    {
+      const size_t offset = base + sizeof(BlackBoxPageHeader) +
+                            record * sizeof(TDMAFrameBufferEntry);
+      ok = (esp_partition_read(partition, offset, &out,
+                               sizeof(TDMAFrameBufferEntry)) == ESP_OK);
+
+      // writePage() may have given this sector up for erase while we read
+      // it (its erase waits for flashMutex, so the bytes are intact, but
+      // the frame is already counted as dropped): do not send it
+      portENTER_CRITICAL(&ringLock);
+      ok = ok && tailEpoch == epoch && tailRecord == record;
+      portEXIT_CRITICAL(&ringLock);
+      cursor.tailEpoch = epoch;
+      cursor.record = record;
+    }
+    else
+    {
+      // Corrupt or fully consumed header — skip the sector
+      portENTER_CRITICAL(&ringLock);
+      if (tailEpoch == epoch && usedSectors > 0)
+      {
+        advanceTailSector();
+        if (usedSectors == 0)
+          backlogFrames = 0;
+      }
+      portEXIT_CRITICAL(&ringLock);
+    }
+  }
+
+  xSemaphoreGive(flashMutex);
+  return ok;
+}
+
+bool FlashBlackBox::consumeOldest(const BlackBoxCursor &cursor)
+{
+  if (partition == nullptr)
+    return false;
+
+  bool advanced = false;
+  portENTER_CRITICAL(&ringLock);
+  if (usedSectors > 0 && tailEpoch == cursor.tailEpoch &&
+      tailRecord == cursor.record)
+  {
+    advanced = true;
+    tailRecord++;
+    if (backlogFrames > 0)
+      backlogFrames--;
+    if (tailRecordCount > 0 && tailRecord >= tailRecordCount)
+    {
+      advanceTailSector();
+      if (usedSectors == 0)
+        backlogFrames = 0;
+    }
+  }
+  portEXIT_CRITICAL(&ringLock);
+  if (advanced)
+    backfilledCount++;
+  return advanced;
+}
+
+void FlashBlackBox::requestClear() { clearRequested = true; }
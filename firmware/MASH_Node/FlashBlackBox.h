@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * FlashBlackBox.h - On-node flash ring for frames the Gateway never received
+ *
+ * In POLICY_RECORDING the 16-entry frameQueue only covers ~320ms of RF
+ * outage. The black box extends that to tens of seconds without growing RAM:
+ *
+ *   - Frames evicted from a full frameQueue, and frames whose unicast TX was
+ *     never ACKed by the Gateway, are staged into a 4 KB RAM page.
+ *   - Full (or quiet, partially filled) pages are written to a raw flash
+ *     partition from loop() — never from SensorTask or ProtocolTask.
+ *   - Sectors are used strictly round-robin, so every sector sees the same
+ *     erase count (wear levelling by construction, no FS metadata churn).
+ *
+ * FLASH CACHE STALL: every erase or program of the internal flash turns the
+ * flash cache off on BOTH cores, so any task or ISR not in IRAM (SensorTask,
+ * ProtocolTask, the ESP-NOW stack) stalls until it completes, whatever core
+ * loop() runs on. The real-time path is therefore NOT isolated from it; the
+ * black box only bounds the stall:
+ *   - Sector erases (datasheet typ. ~45 ms, max several hundred ms) happen
+ *     only while the Gateway is not streaming. service() keeps up to
+ *     BLACKBOX_PREERASE_SECTORS sectors erased ahead of the head, one per
+ *     call. While streaming, a page that finds no pre-erased sector is
+ *     dropped (counted), and a full ring keeps its oldest data.
+ *   - Pages are programmed in BLACKBOX_PROGRAM_CHUNK pieces, so each stall
+ *     is one flash page program (datasheet typ. ~0.5-1 ms) rather than a
+ *     whole 4 KB page (~10-15 ms).
+ * The longest program and erase calls seen are logged as progMaxUs and
+ * eraseMaxUs; they were not measured on hardware when this was written.
+ *   - Once the link is back, ProtocolTask trickles the backlog out in idle
+ *     slot time as 0x26 packets tagged NODE_DATA_FLAG_HISTORICAL.
+ *
+ * Partition: a data partition labelled "blackbox" is preferred. The Arduino
+ * default "spiffs" partition is used as a fallback (the Node firmware never
+ * mounts a filesystem there). Without either, the black box stays disabled
+ * and the Node behaves exactly as before.
+ *
+ * The ring is session-scoped: it is cleared on boot and on SYNC_RESET, since
+ * frames from a previous Gateway epoch cannot be placed on the new timeline.
+ ******************************************************************************/
+
+#ifndef FLASH_BLACKBOX_H
+#define FLASH_BLACKBOX_H
+
+#include "SyncManager.h"
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <freertos/semphr.h>
+
+// ============================================================================
+// Black Box Configuration
+// ============================================================================
+#define BLACKBOX_PARTITION_LABEL "blackbox"
+#define BLACKBOX_FALLBACK_LABEL "spiffs"
+#define BLACKBOX_PAGE_SIZE 4096       // One flash sector per page
+#define BLACKBOX_PAGE_MAGIC 0x4B424258 // "XBBK"
+#define BLACKBOX_QUIET_FLUSH_MS 250   // Flush a partial page after spill burst
+#define BLACKBOX_MAX_SECTORS 1024     // Cap ring at 4 MB regardless of partition
+
+// Sectors kept erased ahead of the head while not streaming: 64 x 4 KB is
+// ~24 s of spilled frames before a streaming outage starts dropping pages
+#ifndef BLACKBOX_PREERASE_SECTORS
+#define BLACKBOX_PREERASE_SECTORS 64
+#endif
+
+// One esp_partition_write() per flash page program (bounds each stall)
+#define BLACKBOX_PROGRAM_CHUNK 256
+
+// Allow bufferSample() to freewheel through beacon loss for up to 30s while
+// the black box is capturing (vs 2 frames in live mode). 20-40ppm crystal
+// drift over 30s is <1.2ms — acceptable for historical backfill.
+#define BLACKBOX_MAX_FREEWHEEL_FRAMES 1500
+
+// Minimum time left in our slot before a historical packet may be started.
+// Covers ESP-NOW stack latency + airtime of a 4-sensor 0x26 packet at 6 Mbps.
+#define BLACKBOX_BACKFILL_MIN_WINDOW_US 1500
+
+struct __attribute__((packed)) BlackBoxPageHeader
+{
+  uint32_t magic;       // BLACKBOX_PAGE_MAGIC
+  uint32_t sequence;    // Monotonic page sequence (session-local)
+  uint16_t recordCount; // Valid records in this page
+  uint16_t recordSize;  // sizeof(TDMAFrameBufferEntry) at write time
+  uint32_t reserved;
+};
+
+#define BLACKBOX_RECORDS_PER_PAGE                                  \
+  ((BLACKBOX_PAGE_SIZE - sizeof(BlackBoxPageHeader)) /             \
+   sizeof(TDMAFrameBufferEntry))
+
+// Names one flash record from peekOldest() until its consumeOldest(). The
+// tail can move under the reader (loop() overwrites the oldest sector when
+// the ring is full), so consume only advances if the tail is still there.
+struct BlackBoxCursor
+{
+  uint32_t tailEpoch; // Bumped every time the tail leaves a sector
+  uint16_t record;    // Record index within that sector
+};
+
+static_assert(sizeof(BlackBoxPageHeader) == 16,
+              "BlackBoxPageHeader must stay 16 bytes");
+static_assert(BLACKBOX_RECORDS_PER_PAGE >= 8,
+              "Black box page must hold at least 8 frames");
+
+class FlashBlackBox
+{
+public:
+  FlashBlackBox();
+
+  /**
+   * Locate the partition and reset the ring.
+   * @return true if a usable partition was found
+   */
+  bool init();
+
+  bool isReady() const { return partition != nullptr; }
+
+  /**
+   * Stage one frame for flash. Cheap memcpy under a spinlock; safe from
+   * SensorTask (bufferSample) and ProtocolTask (sendTDMAData).
+   * @return false if the frame had to be dropped (both pages busy)
+   */
+  bool spill(const TDMAFrameBufferEntry &entry);
+
+  /**
+   * Write staged pages to flash and, while not streaming, pre-erase the
+   * sectors ahead of the head. Blocking — call from loop() only.
+   * @param streaming Gateway is streaming: no sector erase allowed
+   */
+  void service(bool streaming);
+
+  /**
+   * Read the oldest flash-resident frame without consuming it.
+   * Non-blocking: returns false if a flash write is in progress.
+   * @param cursor Receives the record's position, for consumeOldest()
+   */
+  bool peekOldest(TDMAFrameBufferEntry &out, BlackBoxCursor &cursor);
+
+  /**
+   * Drop the frame peekOldest() returned with this cursor (after TX
+   * success). A no-op if the ring has since overwritten or skipped it.
+   * @return true if the tail advanced
+   */
+  bool consumeOldest(const BlackBoxCursor &cursor);
+
+  /**
+   * Discard everything (SYNC_RESET / new session). Deferred to service().
+   */
+  void requestClear();
+
+  bool hasBacklog() const { return backlogFrames > 0; }
+  uint32_t getBacklogFrames() const { return backlogFrames; }
+  uint32_t getSpilledCount() const { return spilledCount; }
+  uint32_t getBackfilledCount() const { return backfilledCount; }
+  uint32_t getDroppedCount() const { return droppedCount; }
+  uint32_t getEraseCount() const { return eraseCount; }
+  uint32_t getMaxProgramUs() const { return maxProgramUs; }
+  uint32_t getMaxEraseUs() const { return maxEraseUs; }
+
+private:
+  const esp_partition_t *partition;
+  uint32_t sectorCount;
+
+  // Double-buffered RAM pages: producers fill stagingPage; a full page is
+  // handed to service() via pendingPage.
+  uint8_t pages[2][BLACKBOX_PAGE_SIZE];
+  uint8_t stagingIndex;
+  uint16_t stagingRecords;
+  bool pendingValid;
+  uint16_t pendingRecords;
+  uint32_t lastSpillMs;
+
+  // Ring state (sector indices). Protected by ringLock.
+  uint32_t headSector;        // Next sector to write
+  uint32_t tailSector;        // Oldest unread sector
+  uint16_t tailRecord;        // Next record to read in tailSector
+  uint16_t tailRecordCount;   // Records in tailSector (cached header)
+  uint32_t usedSectors;       // Sectors holding unread data
+  uint32_t tailEpoch;         // Bumped whenever tailSector moves
+  uint32_t erasedAhead;       // Erased sectors from headSector on (loop())
+  uint32_t nextSequence;
+  volatile uint32_t backlogFrames;
+  volatile bool clearRequested;
+
+  // Statistics
+  volatile uint32_t spilledCount;
+  volatile uint32_t backfilledCount;
+  volatile uint32_t droppedCount;
+  uint32_t eraseCount;
+  uint32_t maxProgramUs; // Longest single chunk program (cache-off stall)
+  uint32_t maxEraseUs;   // Longest single sector erase (cache-off stall)
+
+  // Serialises flash reads (ProtocolTask) against erase/program (loop).
+  SemaphoreHandle_t flashMutex;
+  portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+
+  void resetRing();
+  void advanceTailSector(); // ringLock held
+  bool eraseSector(uint32_t sector);
+  void preEraseOne();
+  bool writePage(const uint8_t *page, uint16_t records);
+};
+
+#endif // FLASH_BLACKBOX_H
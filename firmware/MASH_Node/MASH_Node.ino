@@ -33,6 +33,7 @@
 
 // Include MASH modules
 #include "CommandHandler.h"
+#include "FlashBlackBox.h"
 #include "OTAManager.h"
 #include "PowerStateManager.h"
 #include "SensorManager.h"
@@ -54,6 +55,14 @@ WebSocketManager wsManager;
 CommandHandler commandHandler;
 OTAManager otaManager;
 PowerStateManager powerManager;
+#if ENABLE_FLASH_BLACKBOX
+FlashBlackBox blackBox;
+#endif
+#if ENABLE_TRACE_RING
+TraceRing traceRing;
+// CMD_TRACE_CONTROL arrives in the WiFi task; loop() applies it (-1 = none)
+volatile int8_t pendingTraceControl = -1;
+#endif
 
 Adafruit_NeoPixel statusLED(1, QTPY_NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 
@@ -283,22 +292,25 @@ void SensorTask(void *parameter)
   uint32_t maxCycleUs = 0;
   uint32_t lastOverrunLog = 0;
 
-  // Track streaming state transitions to reset timing on start
-  bool wasStreaming = false;
+  // Track sampling state transitions to reset timing on start
+  bool wasSampling = false;
 
   while (true)
   {
-    // Reset deadline when streaming starts to avoid catch-up burst
-    if (isStreaming && !wasStreaming)
+    // Sample while streaming, and while a calibration needs the stream
+    bool sampling = isStreaming || sensorManager.isCalibrating();
+
+    // Reset deadline when sampling starts to avoid catch-up burst
+    if (sampling && !wasSampling)
     {
       nextDeadlineUs = micros();
     }
-    wasStreaming = isStreaming;
+    wasSampling = sampling;
 
     // Advance deadline for this cycle
     nextDeadlineUs += sampleIntervalUs;
 
-    if (isStreaming)
+    if (sampling)
     {
       uint32_t cycleStart = micros();
       float dt = sampleIntervalUs / 1000000.0f;
@@ -314,8 +326,10 @@ void SensorTask(void *parameter)
       if (tProc > g_processTimeMax)
         g_processTimeMax = tProc;
 
-      // Buffer for TDMA transmission
-      if (syncManager.isTDMASynced())
+      // Buffer for TDMA transmission (keeps capturing through beacon loss
+      // while the flash black box is recording)
+      if (isStreaming &&
+          (syncManager.isTDMASynced() || syncManager.isBlackBoxCapturing()))
       {
         syncManager.bufferSample(sensorManager);
       }
@@ -404,6 +418,9 @@ void ProtocolTask(void *parameter)
   {
     protocolLoopCount++;
 
+    // Coordinated channel hop: retune in the guard time, before the beacon
+    syncManager.serviceChannelHop();
+
     // =========================================================================
     // TDMA TRANSMISSION: Check if we're in our transmit window
     // =========================================================================
@@ -415,6 +432,12 @@ void ProtocolTask(void *parameter)
         syncManager.sendTDMAData();
         tdmaTxSuccess++;
       }
+      else if (syncManager.isInTransmitWindow() &&
+               syncManager.hasBackfillData())
+      {
+        // Live queue drained: trickle black box history in the idle slot time
+        syncManager.sendBackfillData();
+      }
     }
 
     // Log stats periodically (every 60 seconds) - REDUCED rate to save serial
@@ -590,12 +613,17 @@ void onGetStatus(JsonDocument &response)
                                ? "quaternion"
                                : "raw";
   response["calibratedCount"] = sensorManager.getCalibratedCount();
+  response["isCalibrating"] = sensorManager.isCalibrating();
 
   JsonArray calibration = response.createNestedArray("calibration");
+  JsonArray calibrationProgress =
+      response.createNestedArray("calibrationProgress");
   for (uint8_t i = 0; i < sensorManager.getSensorCount(); i++)
   {
     calibration.add(sensorManager.isCalibrated(i));
+    calibrationProgress.add(sensorManager.getCalibrationProgress(i));
   }
+  response["calibrationFailedMask"] = sensorManager.getCalibrationFailedMask();
 
   response["hasMagnetometer"] = sensorManager.hasMag();
   response["hasBarometer"] = sensorManager.hasBaro();
@@ -720,6 +748,8 @@ void onGetMagCalibration(JsonDocument &response)
   response["hasMagnetometer"] = sensorManager.hasMag();
   response["isCalibrating"] = sensorManager.isMagCalibrating();
   response["progress"] = sensorManager.getMagCalibrationProgress();
+  response["coverage"] = sensorManager.getMagCalibrationCoverage();
+  response["fitErrorPct"] = sensorManager.getMagCalibrationFitError();
 
   MagCalibrationData cal = sensorManager.getMagCalibration();
   response["isCalibrated"] = cal.isCalibrated;
@@ -736,6 +766,12 @@ void onGetMagCalibration(JsonDocument &response)
     softIron["y"] = cal.softIronScaleY;
     softIron["z"] = cal.softIronScaleZ;
 
+    JsonArray matrix = response.createNestedArray("softIron");
+    for (uint8_t i = 0; i < 9; i++)
+    {
+      matrix.add(cal.softIron[i]);
+    }
+
     response["sampleCount"] = cal.sampleCount;
   }
 
@@ -1008,6 +1044,16 @@ void setup()
 
   // Apply policy after all radio init calls (WiFi.mode/ESP-NOW) have settled.
   applyNodeRadioPolicy("setup");
+
+#if ENABLE_FLASH_BLACKBOX
+  // ============================================================================
+  // FLASH BLACK BOX: Spill unACKed frames to flash while recording
+  // ============================================================================
+  if (blackBox.init())
+  {
+    syncManager.setBlackBox(&blackBox);
+  }
+#endif
   // ============================================================================
 
   // WebSocket setup
@@ -1031,17 +1077,19 @@ void setup()
       Serial.println("[Node] Clearing Magnetometer Calibration...");
       sensorManager.clearMagCalibration();
     } else if (cmdType == CMD_GYRO_CALIBRATE) {
-      // param is sensorId, or 0xFF for all
+      // param is sensorId, or 0xFF for all (calibrated in parallel)
       uint8_t sensorId = (uint8_t)param;
-      if (sensorId == 0xFF) {
+      if (sensorId == SensorManager::CAL_ALL_SENSORS) {
         Serial.println("[Node] Zeroing Gyros for ALL sensors...");
-        for (uint8_t i = 0; i < sensorManager.getSensorCount(); i++) {
-          sensorManager.calibrateGyro(i);
-        }
+        sensorManager.calibrateGyro(SensorManager::CAL_ALL_SENSORS);
       } else {
         Serial.printf("[Node] Zeroing Gyros for sensor %d...\n", sensorId);
         sensorManager.calibrateGyro(sensorId);
       }
+    } else if (cmdType == CMD_TRACE_CONTROL) {
+#if ENABLE_TRACE_RING
+      pendingTraceControl = (int8_t)param;
+#endif
     } });
 
   // BEST PRACTICE: Auto-toggle BLE based on TDMA State
@@ -1284,6 +1332,69 @@ void loop()
     }
   }
 
+#if ENABLE_FLASH_BLACKBOX
+  // ============================================================================
+  // FLASH BLACK BOX: Recording policy follows the Gateway streaming flag
+  // ============================================================================
+  // The Gateway has no separate "recording" signal — streaming IS recording.
+  // isStreaming is only updated while synced, so it stays set through an RF
+  // outage and the black box keeps capturing until the Gateway stops.
+  // Page writes happen here, never on the RT tasks; sector erases only while
+  // not streaming (each one stalls the flash cache on both cores).
+  // ============================================================================
+  {
+    BufferPolicy targetPolicy =
+        (isStreaming && blackBox.isReady()) ? POLICY_RECORDING : POLICY_LIVE;
+    if (syncManager.getBufferPolicy() != targetPolicy)
+    {
+      syncManager.setBufferPolicy(targetPolicy);
+      Serial.printf("[BlackBox] Buffer policy -> %s\n",
+                    targetPolicy == POLICY_RECORDING ? "RECORDING" : "LIVE");
+    }
+    blackBox.service(isStreaming);
+  }
+#endif
+
+#if ENABLE_TRACE_RING
+  // ============================================================================
+  // TRACE RING: Apply Gateway trace control; dumps go to the USB console as
+  // "#TRACE <hex>" lines (one dump chunk each) for trace_to_chrome.py
+  // ============================================================================
+  if (pendingTraceControl >= 0)
+  {
+    int8_t action = pendingTraceControl;
+    pendingTraceControl = -1;
+    if (action == TRACE_CONTROL_START)
+    {
+      traceRing.start();
+      Serial.println("[Trace] Recording");
+    }
+    else if (action == TRACE_CONTROL_STOP)
+    {
+      traceRing.stop();
+      Serial.println("[Trace] Stopped");
+    }
+    else if (action == TRACE_CONTROL_DUMP)
+    {
+      uint32_t sent = traceRing.dump(
+          TRACE_ROLE_NODE, syncManager.getNodeId(),
+          [](const uint8_t *chunk, size_t len, void *)
+          {
+            static const char hex[] = "0123456789abcdef";
+            Serial.print("#TRACE ");
+            for (size_t i = 0; i < len; i++)
+            {
+              Serial.write(hex[chunk[i] >> 4]);
+              Serial.write(hex[chunk[i] & 0x0F]);
+            }
+            Serial.println();
+          },
+          nullptr);
+      Serial.printf("[Trace] Dumped %lu events\n", (unsigned long)sent);
+    }
+  }
+#endif
+
   // Send power diagnostics once per boot/recovery when link is stable.
   if (powerDiagPending && syncManager.isTDMASynced())
   {
@@ -1358,13 +1469,39 @@ void loop()
     }
   }
 
-  // Update optional sensors at 10Hz
-  sensorManager.updateOptionalSensors();
+  // Update optional sensors at 10Hz. While streaming, fresh readings ride
+  // inline in the 0x26 data packets instead of separate 0x04 packets.
+  const bool enviroInline = isStreaming && syncManager.isTDMASynced();
+  {
+    uint8_t freshEnviro = sensorManager.updateOptionalSensors();
+    if (freshEnviro != 0 && enviroInline)
+    {
+      syncManager.stageEnviroSample(sensorManager, freshEnviro);
+    }
+  }
 
   // Update magnetometer calibration if in progress
   if (sensorManager.isMagCalibrating())
   {
+    static uint32_t lastMagProgressMs = 0;
     bool stillCalibrating = sensorManager.updateMagCalibration();
+    if (!stillCalibrating || millis() - lastMagProgressMs >= 500)
+    {
+      lastMagProgressMs = millis();
+      syncManager.sendMagCalibProgress(sensorManager);
+    }
+  }
+
+  // Persist finished IMU calibrations; report progress to the Gateway
+  {
+    static uint32_t lastCalibProgressMs = 0;
+    bool calibFinished = sensorManager.serviceCalibration();
+    if (calibFinished || (sensorManager.isCalibrating() &&
+                          millis() - lastCalibProgressMs >= 250))
+    {
+      lastCalibProgressMs = millis();
+      syncManager.sendImuCalibProgress(sensorManager);
+    }
   }
 
   // Main sensor loop
@@ -1373,7 +1510,8 @@ void loop()
   // Core 1
 #if !USE_FREERTOS_TASKS
   unsigned long currentMicros = micros();
-  if (isStreaming && (currentMicros - lastSampleTime >= sampleIntervalUs))
+  if ((isStreaming || sensorManager.isCalibrating()) &&
+      (currentMicros - lastSampleTime >= sampleIntervalUs))
   {
     // Calculate fixed dt based on the sample rate to ensure consistent
     // integration during catch-up bursts If we simply measured time, a delayed
@@ -1398,7 +1536,8 @@ void loop()
     // ============================================================================
     // TDMA Mode: Buffer samples at 200Hz
     // ============================================================================
-    if (syncManager.isTDMASynced())
+    if (isStreaming &&
+        (syncManager.isTDMASynced() || syncManager.isBlackBoxCapturing()))
     {
       syncManager.bufferSample(sensorManager);
     }
@@ -1446,7 +1585,8 @@ void loop()
     }
   }
 
-  // Send Environmental data periodically
+  // Send Environmental data periodically (when not carried inline)
+  if (!enviroInline)
   {
     static unsigned long lastEnvSendTime = 0;
     if (currentTime - lastEnvSendTime >= 100)
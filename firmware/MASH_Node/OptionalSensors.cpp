@@ -6,40 +6,28 @@
 // ============================================================================
 
 #include "SensorManager.h"
+#include "../libraries/IMUConnectCore/src/TDMAProtocol.h" // NODE_ENVIRO_HAS_*
 #include <Preferences.h>
 
 // ============================================================================
 // Optional Sensor Reading (10 Hz)
 // ============================================================================
 
-void SensorManager::updateOptionalSensors()
+uint8_t SensorManager::updateOptionalSensors()
 {
     // Only update at 10Hz to reduce I2C load
     unsigned long now = millis();
     if (now - lastOptionalSensorUpdate < 100)
     {
-        return;
+        return 0;
     }
     lastOptionalSensorUpdate = now;
+    uint8_t fresh = 0;
 
-    // Read magnetometer if present
-    if (hasMagnetometer)
+    // Read magnetometer if present (calibration samples it at its own rate)
+    if (hasMagnetometer && !magCalibrationActive && readMagnetometer())
     {
-        if (useMultiplexer && magChannel >= 0)
-        {
-            selectChannel(magChannel);
-        }
-
-        sensors_event_t event;
-        mag.getEvent(&event);
-        magData.x = event.magnetic.x;
-        magData.y = event.magnetic.y;
-        magData.z = event.magnetic.z;
-
-        float heading = atan2(magData.y, magData.x) * 180.0f / PI;
-        if (heading < 0)
-            heading += 360.0f;
-        magData.heading = heading;
+        fresh |= NODE_ENVIRO_HAS_MAG;
     }
 
     // Read barometer if present
@@ -56,13 +44,64 @@ void SensorManager::updateOptionalSensors()
             baroData.temperature = baro.temperature;
             baroData.altitude =
                 44330.0f * (1.0f - pow(baroData.pressure / 1013.25f, 0.1903f));
+            fresh |= NODE_ENVIRO_HAS_BARO;
         }
     }
+    return fresh;
+}
+
+bool SensorManager::readMagnetometer()
+{
+    if (useMultiplexer && magChannel >= 0)
+    {
+        selectChannel(magChannel);
+    }
+
+    sensors_event_t event;
+    if (!mag.getEvent(&event))
+    {
+        return false;
+    }
+    magData.x = event.magnetic.x;
+    magData.y = event.magnetic.y;
+    magData.z = event.magnetic.z;
+
+    float heading = atan2(magData.y, magData.x) * 180.0f / PI;
+    if (heading < 0)
+        heading += 360.0f;
+    magData.heading = heading;
+    return true;
 }
 
 // ============================================================================
 // Magnetometer Calibration
 // ============================================================================
+// Incremental ellipsoid fit (MagEllipsoidFit.h): every sample updates the
+// least-squares sums in O(1); the fit is re-solved every
+// MAG_CAL_SOLVE_EVERY samples. Calibration ends early once the fit is tight,
+// has stopped moving and the field has been seen from most directions.
+// The requested duration is only the upper bound; at the deadline a valid
+// ellipsoid is still used, else the old min/max extents.
+// ============================================================================
+
+namespace
+{
+constexpr uint32_t MAG_CAL_SAMPLE_INTERVAL_MS = 40; // 25 Hz while calibrating
+constexpr uint32_t MAG_CAL_SOLVE_EVERY = 10;
+constexpr uint32_t MAG_CAL_MIN_SAMPLES = 60;
+constexpr uint8_t MAG_CAL_MIN_COVERAGE = 70;   // % of direction bins
+constexpr float MAG_CAL_MAX_FIT_ERROR = 3.0f;  // % RMS radial residual
+constexpr float MAG_CAL_STABLE_CENTER_UT = 0.5f;
+constexpr float MAG_CAL_STABLE_RADIUS = 0.005f; // Relative
+constexpr uint8_t MAG_CAL_STABLE_SOLVES = 3;
+} // namespace
+
+void SensorManager::resetMagCalibrationData(MagCalibrationData &cal)
+{
+    memset(&cal, 0, sizeof(cal));
+    cal.softIronScaleX = cal.softIronScaleY = cal.softIronScaleZ = 1.0f;
+    cal.softIron[0] = cal.softIron[4] = cal.softIron[8] = 1.0f;
+}
 
 MagData SensorManager::getCalibratedMagData() const
 {
@@ -70,13 +109,14 @@ MagData SensorManager::getCalibratedMagData() const
 
     if (magCalibration.isCalibrated)
     {
-        // Apply hard iron correction (subtract bias)
-        calibrated.x =
-            (magData.x - magCalibration.hardIronX) * magCalibration.softIronScaleX;
-        calibrated.y =
-            (magData.y - magCalibration.hardIronY) * magCalibration.softIronScaleY;
-        calibrated.z =
-            (magData.z - magCalibration.hardIronZ) * magCalibration.softIronScaleZ;
+        // Hard iron (subtract bias), then the full soft-iron matrix
+        const float *w = magCalibration.softIron;
+        float dx = magData.x - magCalibration.hardIronX;
+        float dy = magData.y - magCalibration.hardIronY;
+        float dz = magData.z - magCalibration.hardIronZ;
+        calibrated.x = w[0] * dx + w[1] * dy + w[2] * dz;
+        calibrated.y = w[3] * dx + w[4] * dy + w[5] * dz;
+        calibrated.z = w[6] * dx + w[7] * dy + w[8] * dz;
 
         // Recalculate heading with calibrated values
         float heading = atan2(calibrated.y, calibrated.x) * 180.0f / PI;
@@ -99,16 +139,21 @@ void SensorManager::startMagCalibration(uint32_t durationMs)
     Serial.println("[SensorMgr] Starting magnetometer calibration...");
     Serial.println("[SensorMgr] Move sensor slowly in figure-8 pattern");
 
-    magCalibrationActive = true;
     magCalibrationStartTime = millis();
     magCalibrationDuration = durationMs;
     magCalibration.sampleCount = 0;
+    magFitReset(magFit);
+    memset(&magFitLast, 0, sizeof(magFitLast));
+    magFitLastSolveCount = 0;
+    magFitStableSolves = 0;
+    magCalLastSampleMs = 0;
 
     // Reset min/max trackers with first reading
-    updateOptionalSensors();
+    readMagnetometer();
     magMinX = magMaxX = magData.x;
     magMinY = magMaxY = magData.y;
     magMinZ = magMaxZ = magData.z;
+    magCalibrationActive = true;
 }
 
 bool SensorManager::updateMagCalibration()
@@ -118,14 +163,108 @@ bool SensorManager::updateMagCalibration()
         return false;
     }
 
-    // Check if calibration time is complete
-    uint32_t elapsed = millis() - magCalibrationStartTime;
-    if (elapsed >= magCalibrationDuration)
+    uint32_t now = millis();
+    if (now - magCalLastSampleMs >= MAG_CAL_SAMPLE_INTERVAL_MS &&
+        readMagnetometer())
     {
-        // Calibration complete - calculate offsets
-        Serial.println("[SensorMgr] Magnetometer calibration complete!");
+        magCalLastSampleMs = now;
+        magFitAdd(magFit, magData.x, magData.y, magData.z);
+
+        // Min/max extents: fallback if the ellipsoid never becomes valid
+        if (magData.x < magMinX)
+            magMinX = magData.x;
+        if (magData.x > magMaxX)
+            magMaxX = magData.x;
+        if (magData.y < magMinY)
+            magMinY = magData.y;
+        if (magData.y > magMaxY)
+            magMaxY = magData.y;
+        if (magData.z < magMinZ)
+            magMinZ = magData.z;
+        if (magData.z > magMaxZ)
+            magMaxZ = magData.z;
+
+        magCalibration.sampleCount++;
+
+        if (magFit.count - magFitLastSolveCount >= MAG_CAL_SOLVE_EVERY)
+        {
+            MagEllipsoidSolution fit;
+            magFitSolve(magFit, fit);
+            bool stable = false;
+            if (fit.valid && magFitLast.valid)
+            {
+                float dx = fit.center[0] - magFitLast.center[0];
+                float dy = fit.center[1] - magFitLast.center[1];
+                float dz = fit.center[2] - magFitLast.center[2];
+                stable = sqrtf(dx * dx + dy * dy + dz * dz) <
+                             MAG_CAL_STABLE_CENTER_UT &&
+                         fabsf(fit.radius - magFitLast.radius) <
+                             MAG_CAL_STABLE_RADIUS * magFitLast.radius;
+            }
+            if (fit.valid)
+            {
+                magFitSetCenter(magFit, fit.center);
+            }
+            magFitStableSolves = stable ? magFitStableSolves + 1 : 0;
+            magFitLast = fit;
+            magFitLastSolveCount = magFit.count;
+        }
+    }
 
-        // Hard iron offsets = center of the ellipsoid
+    bool converged = magFitStableSolves >= MAG_CAL_STABLE_SOLVES &&
+                     magFit.count >= MAG_CAL_MIN_SAMPLES &&
+                     magFitCoverage(magFit) >= MAG_CAL_MIN_COVERAGE &&
+                     magFitLast.fitError < MAG_CAL_MAX_FIT_ERROR;
+    if (converged || now - magCalibrationStartTime >= magCalibrationDuration)
+    {
+        finishMagCalibration(converged);
+        return false; // Calibration complete
+    }
+
+    // Log progress every 2 seconds
+    static uint32_t lastLog = 0;
+    if (millis() - lastLog > 2000)
+    {
+        Serial.printf("[MagCal] Progress: %d%% | Samples: %d | Coverage: %d%% | "
+                      "Fit error: %.2f%% | Stable solves: %d\n",
+                      getMagCalibrationProgress(), magCalibration.sampleCount,
+                      magFitCoverage(magFit),
+                      magFitLast.valid ? magFitLast.fitError : -1.0f,
+                      magFitStableSolves);
+        lastLog = millis();
+    }
+
+    return true; // Still calibrating
+}
+
+void SensorManager::finishMagCalibration(bool converged)
+{
+    Serial.printf("[SensorMgr] Magnetometer calibration complete (%s, %lu ms)\n",
+                  converged ? "converged" : "time limit",
+                  (unsigned long)(millis() - magCalibrationStartTime));
+
+    MagEllipsoidSolution fit;
+    magFitSolve(magFit, fit);
+    uint16_t samples = magCalibration.sampleCount;
+    resetMagCalibrationData(magCalibration);
+    magCalibration.sampleCount = samples;
+    magCalibration.coverage = magFitCoverage(magFit);
+
+    if (fit.valid && fit.fitError < 2 * MAG_CAL_MAX_FIT_ERROR)
+    {
+        // Ellipsoid: hard iron = centre, full soft-iron matrix
+        magCalibration.hardIronX = fit.center[0];
+        magCalibration.hardIronY = fit.center[1];
+        magCalibration.hardIronZ = fit.center[2];
+        memcpy(magCalibration.softIron, fit.softIron,
+               sizeof(magCalibration.softIron));
+        magCalibration.fitError = fit.fitError;
+    }
+    else
+    {
+        // Fallback: hard iron = centre of the extents, diagonal scale
+        Serial.println("[SensorMgr] Warning: no valid ellipsoid fit - using "
+                       "min/max extents");
         magCalibration.hardIronX = (magMaxX + magMinX) / 2.0f;
         magCalibration.hardIronY = (magMaxY + magMinY) / 2.0f;
         magCalibration.hardIronZ = (magMaxZ + magMinZ) / 2.0f;
@@ -139,69 +278,41 @@ bool SensorManager::updateMagCalibration()
         // Avoid division by zero
         if (rangeX > 0.1f && rangeY > 0.1f && rangeZ > 0.1f)
         {
-            magCalibration.softIronScaleX = avgRange / rangeX;
-            magCalibration.softIronScaleY = avgRange / rangeY;
-            magCalibration.softIronScaleZ = avgRange / rangeZ;
+            magCalibration.softIron[0] = avgRange / rangeX;
+            magCalibration.softIron[4] = avgRange / rangeY;
+            magCalibration.softIron[8] = avgRange / rangeZ;
         }
         else
         {
-            // Not enough range - use unity scale
-            magCalibration.softIronScaleX = 1.0f;
-            magCalibration.softIronScaleY = 1.0f;
-            magCalibration.softIronScaleZ = 1.0f;
             Serial.println(
                 "[SensorMgr] Warning: Insufficient magnetometer range detected");
         }
-
-        magCalibration.isCalibrated = true;
-        magCalibrationActive = false;
-
-        Serial.printf("[SensorMgr] Hard iron: X=%.2f, Y=%.2f, Z=%.2f uT\n",
-                      magCalibration.hardIronX, magCalibration.hardIronY,
-                      magCalibration.hardIronZ);
-        Serial.printf("[SensorMgr] Soft iron scale: X=%.3f, Y=%.3f, Z=%.3f\n",
-                      magCalibration.softIronScaleX, magCalibration.softIronScaleY,
-                      magCalibration.softIronScaleZ);
-        Serial.printf("[SensorMgr] Samples collected: %d\n",
-                      magCalibration.sampleCount);
-
-        // Auto-save calibration
-        saveMagCalibration();
-
-        return false; // Calibration complete
     }
-
-    // Update magnetometer reading
-    updateOptionalSensors();
-
-    // Track min/max values
-    if (magData.x < magMinX)
-        magMinX = magData.x;
-    if (magData.x > magMaxX)
-        magMaxX = magData.x;
-    if (magData.y < magMinY)
-        magMinY = magData.y;
-    if (magData.y > magMaxY)
-        magMaxY = magData.y;
-    if (magData.z < magMinZ)
-        magMinZ = magData.z;
-    if (magData.z > magMaxZ)
-        magMaxZ = magData.z;
-
-    magCalibration.sampleCount++;
-
-    // Log progress every 2 seconds
-    static uint32_t lastLog = 0;
-    if (millis() - lastLog > 2000)
+    magCalibration.softIronScaleX = magCalibration.softIron[0];
+    magCalibration.softIronScaleY = magCalibration.softIron[4];
+    magCalibration.softIronScaleZ = magCalibration.softIron[8];
+
+    magCalibration.isCalibrated = true;
+    magCalibrationActive = false;
+
+    Serial.printf("[SensorMgr] Hard iron: X=%.2f, Y=%.2f, Z=%.2f uT\n",
+                  magCalibration.hardIronX, magCalibration.hardIronY,
+                  magCalibration.hardIronZ);
+    const float *w = magCalibration.softIron;
+    Serial.printf("[SensorMgr] Soft iron: [%.3f %.3f %.3f][%.3f %.3f %.3f]"
+                  "[%.3f %.3f %.3f]\n",
+                  w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], w[8]);
+    Serial.printf("[SensorMgr] Samples: %d | Coverage: %d%% | Fit error: %.2f%%\n",
+                  magCalibration.sampleCount, magCalibration.coverage,
+                  magCalibration.fitError);
+    if (magCalibration.coverage < MAG_CAL_MIN_COVERAGE)
     {
-        Serial.printf("[MagCal] Progress: %d%% | Samples: %d | Range X:[%.1f,%.1f] "
-                      "Y:[%.1f,%.1f] Z:[%.1f,%.1f]\n",
-                      getMagCalibrationProgress(), magCalibration.sampleCount,
-                      magMinX, magMaxX, magMinY, magMaxY, magMinZ, magMaxZ);
-        lastLog = millis();
+        Serial.println("[SensorMgr] Warning: low direction coverage - rotate "
+                       "through more orientations for a better fit");
     }
 
-    return true; // Still calibrating
+    // Auto-save calibration
+    saveMagCalibration();
 }
 
 uint8_t SensorManager::getMagCalibrationProgress() const
@@ -211,9 +322,13 @@ uint8_t SensorManager::getMagCalibrationProgress() const
         return magCalibration.isCalibrated ? 100 : 0;
     }
 
+    // Whichever is further along: coverage toward the target, or time
     uint32_t elapsed = millis() - magCalibrationStartTime;
-    uint32_t progress = (elapsed * 100) / magCalibrationDuration;
-    return progress > 100 ? 100 : progress;
+    uint32_t byTime = (elapsed * 100) / magCalibrationDuration;
+    uint32_t byCoverage = (uint32_t)magFitCoverage(magFit) * 100 /
+                          MAG_CAL_MIN_COVERAGE;
+    uint32_t progress = byTime > byCoverage ? byTime : byCoverage;
+    return progress > 99 ? 99 : progress;
 }
 
 // ============================================================================
@@ -237,6 +352,10 @@ void SensorManager::saveMagCalibration()
     prefs.putFloat("si_x", magCalibration.softIronScaleX);
     prefs.putFloat("si_y", magCalibration.softIronScaleY);
     prefs.putFloat("si_z", magCalibration.softIronScaleZ);
+    prefs.putBytes("si_m", magCalibration.softIron,
+                   sizeof(magCalibration.softIron));
+    prefs.putUChar("coverage", magCalibration.coverage);
+    prefs.putFloat("fit_err", magCalibration.fitError);
     prefs.putBool("valid", true);
     prefs.putUShort("samples", magCalibration.sampleCount);
 
@@ -259,6 +378,22 @@ bool SensorManager::loadMagCalibration()
         magCalibration.softIronScaleY = prefs.getFloat("si_y", 1.0f);
         magCalibration.softIronScaleZ = prefs.getFloat("si_z", 1.0f);
         magCalibration.sampleCount = prefs.getUShort("samples", 0);
+        magCalibration.coverage = prefs.getUChar("coverage", 0);
+        magCalibration.fitError = prefs.getFloat("fit_err", 0.0f);
+
+        // Older saves only have the diagonal scale
+        if (prefs.getBytesLength("si_m") == sizeof(magCalibration.softIron))
+        {
+            prefs.getBytes("si_m", magCalibration.softIron,
+                           sizeof(magCalibration.softIron));
+        }
+        else
+        {
+            memset(magCalibration.softIron, 0, sizeof(magCalibration.softIron));
+            magCalibration.softIron[0] = magCalibration.softIronScaleX;
+            magCalibration.softIron[4] = magCalibration.softIronScaleY;
+            magCalibration.softIron[8] = magCalibration.softIronScaleZ;
+        }
         magCalibration.isCalibrated = true;
 
         prefs.end();
@@ -282,7 +417,7 @@ void SensorManager::clearMagCalibration()
     prefs.clear();
     prefs.end();
 
-    magCalibration = {0, 0, 0, 1.0f, 1.0f, 1.0f, false, 0};
+    resetMagCalibrationData(magCalibration);
 
     Serial.println("[SensorMgr] Magnetometer calibration cleared");
 }
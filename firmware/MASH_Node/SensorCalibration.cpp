@@ -9,133 +9,272 @@
 #include <Preferences.h>
 
 // ============================================================================
-// Manual Calibration Routines
+// Streaming Still-Window Calibration
 // ============================================================================
+// calibrateSensor()/calibrateGyro() only post a request. updateOptimized()
+// picks it up on the next sample and feeds every requested sensor in
+// parallel with a per-axis Welford mean/variance. A sample that leaves the
+// window's noise band restarts the window (motion rejection); the sensor
+// finishes once the standard error of every mean it needs is below target,
+// or after CAL_MAX_SAMPLES still samples. At 200 Hz a still node converges
+// in ~0.25 s regardless of how many sensors it carries. NVS persistence is
+// deferred to serviceCalibration() on loop().
+//
+// DATASHEET COMPLIANCE NOTICE (full calibration only):
+// This relies on the "System-Level" compensation method. CRITICAL: the
+// device MUST be placed FLAT on a stationary surface. Gravity is expected on
+// +Y (Y-up frame) and subtracted from the Y offset; calibrating in any other
+// orientation leaves the accel offsets incorrect.
+// ============================================================================
+
+static_assert(MAX_SENSORS <= 8, "Calibration masks hold 8 sensors");
+
+namespace
+{
+constexpr uint16_t CAL_MIN_SAMPLES = 40;     // Floor before convergence test
+constexpr uint16_t CAL_MAX_SAMPLES = 200;    // Still samples: accept anyway
+constexpr uint16_t CAL_WARMUP_SAMPLES = 8;   // Before the motion gate arms
+constexpr uint32_t CAL_TIMEOUT_MS = 10000;   // Never still -> fail
+constexpr float CAL_MOTION_GYRO_RADS = 0.05f; // ~3 deg/s from window mean
+constexpr float CAL_MOTION_ACCEL_MS2 = 0.3f;  // From window mean
+constexpr float CAL_MAX_GYRO_RADS = 0.3f;     // Larger than any plausible bias
+constexpr float CAL_GYRO_SEM_RADS = 0.0005f;  // ~0.03 deg/s
+constexpr float CAL_ACCEL_SEM_MS2 = 0.005f;
+} // namespace
+
+void SensorManager::requestCalibration(uint8_t sensorId, bool gyroOnly)
+{
+  uint8_t sensors;
+  if (sensorId == CAL_ALL_SENSORS)
+  {
+    sensors = (uint8_t)((1u << sensorCount) - 1);
+  }
+  else if (sensorId < sensorCount)
+  {
+    sensors = (uint8_t)(1u << sensorId);
+  }
+  else
+  {
+    Serial.printf("[SensorMgr] Invalid sensor ID: %d\n", sensorId);
+    return;
+  }
+
+  uint16_t request = gyroOnly ? (uint16_t)(sensors << 8) : sensors;
+  __atomic_fetch_or(&calRequestMask, request, __ATOMIC_RELEASE);
+}
 
 void SensorManager::calibrateSensor(uint8_t sensorId)
 {
-    if (sensorId >= sensorCount)
-    {
-        Serial.printf("[SensorMgr] Invalid sensor ID: %d\n", sensorId);
-        return;
-    }
+  Serial.printf("[SensorMgr] Calibrating sensor %d - keep device still and "
+                "flat!\n",
+                sensorId);
+  requestCalibration(sensorId, false);
+}
 
-    Serial.printf("[SensorMgr] Calibrating sensor %d - keep device still!\n",
-                  sensorId);
+void SensorManager::calibrateGyro(uint8_t sensorId)
+{
+  Serial.printf(
+      "[SensorMgr] Zeroing Gyros for sensor %d - keep device still!\n",
+      sensorId);
+  requestCalibration(sensorId, true);
+}
 
-    // DATASHEET COMPLIANCE NOTICE:
-    // This manual calibration routine relies on the "System-Level" compensation
-    // method. CRITICAL: The device MUST be placed FLAT (Z-UP) on a stationary
-    // surface. The Z-axis offset calculation hardcodes a subtraction of 1G (9.81
-    // m/s²). If calibrated in any other orientation, the Z-offset will be
-    // incorrect.
+// Sample path: start the windows for every posted request
+void SensorManager::beginRequestedCalibrations()
+{
+  uint16_t request = __atomic_exchange_n(&calRequestMask, 0, __ATOMIC_ACQUIRE);
+  uint8_t full = (uint8_t)request;
+  uint8_t gyro = (uint8_t)(request >> 8);
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < sensorCount; i++)
+  {
+    uint8_t bit = (uint8_t)(1u << i);
+    if (!((full | gyro) & bit))
+      continue;
+
+    StillCalibration &c = stillCal[i];
+    // A full request wins over a gyro-only one (it sets the gyro too)
+    bool gyroOnly = !(full & bit);
+    if ((calActiveMask & bit) && !c.gyroOnly)
+      gyroOnly = false;
+
+    memset(&c, 0, sizeof(c));
+    c.gyroOnly = gyroOnly;
+    c.startMs = now;
+    __atomic_fetch_and(&calFailedMask, (uint8_t)~bit, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&calActiveMask, bit, __ATOMIC_RELEASE);
+  }
+}
 
-    // Research: 200-500ms sufficient for static calibration capture
-    // 50 samples × 10ms = 500ms total (previously 100 samples = 1s)
-    const int numSamples = 50;
-    float accelSumX = 0, accelSumY = 0, accelSumZ = 0;
-    float gyroSumX = 0, gyroSumY = 0, gyroSumZ = 0;
+// Sample path: fail every window past CAL_TIMEOUT_MS. Runs once per pass,
+// not per sample, so a sensor whose frames stop arriving (invalid or
+// outliers) still times out instead of calibrating forever.
+void SensorManager::expireStillCalibrations()
+{
+  uint8_t active = __atomic_load_n(&calActiveMask, __ATOMIC_ACQUIRE);
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < sensorCount; i++)
+  {
+    const uint8_t bit = (uint8_t)(1u << i);
+    if (!(active & bit) || now - stillCal[i].startMs <= CAL_TIMEOUT_MS)
+      continue;
+
+    stillCal[i].progress = 0;
+    __atomic_fetch_or(&calFailedMask, bit, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&calActiveMask, (uint8_t)~bit, __ATOMIC_RELEASE);
+    __atomic_fetch_or(&calResultMask, (uint16_t)(bit << 8), __ATOMIC_RELEASE);
+  }
+}
 
-    if (useMultiplexer && sensorChannels[sensorId] >= 0)
+// Sample path: one Y-up sample {ax, ay, az, gx, gy, gz}
+void SensorManager::feedStillCalibration(uint8_t i, const float *sample)
+{
+  StillCalibration &c = stillCal[i];
+  const uint8_t bit = (uint8_t)(1u << i);
+
+  // Motion rejection: a rotating sensor, or any axis leaving the window's
+  // noise band, restarts the window
+  float gyroMag = sqrtf(sample[3] * sample[3] + sample[4] * sample[4] +
+                        sample[5] * sample[5]);
+  bool moving = gyroMag > CAL_MAX_GYRO_RADS;
+  if (!moving && c.n >= CAL_WARMUP_SAMPLES)
+  {
+    for (uint8_t k = 0; k < 6 && !moving; k++)
     {
-        selectChannel(sensorChannels[sensorId]);
+      float limit = (k < 3) ? CAL_MOTION_ACCEL_MS2 : CAL_MOTION_GYRO_RADS;
+      moving = fabsf(sample[k] - c.mean[k]) > limit;
     }
-
-    for (int i = 0; i < numSamples; i++)
+  }
+  if (moving)
+  {
+    if (c.n > 0)
+      c.motionResets++;
+    c.n = 0;
+    memset(c.mean, 0, sizeof(c.mean));
+    memset(c.m2, 0, sizeof(c.m2));
+    c.progress = 0;
+    return;
+  }
+
+  // Welford update
+  c.n++;
+  for (uint8_t k = 0; k < 6; k++)
+  {
+    float delta = sample[k] - c.mean[k];
+    c.mean[k] += delta / c.n;
+    c.m2[k] += delta * (sample[k] - c.mean[k]);
+  }
+
+  uint8_t progress = (uint8_t)((uint32_t)c.n * 100 / CAL_MAX_SAMPLES);
+  c.progress = progress > 99 ? 99 : progress;
+
+  bool converged = c.n >= CAL_MAX_SAMPLES;
+  if (!converged && c.n >= CAL_MIN_SAMPLES)
+  {
+    // Squared standard error of the mean: variance / n
+    float denom = (float)(c.n - 1) * c.n;
+    converged = true;
+    for (uint8_t k = c.gyroOnly ? 3 : 0; k < 6 && converged; k++)
     {
-        IMUFrame frame;
-        if (sensors[sensorId].readFrame(&frame))
-        {
-            // Transform 2: [-X, +Y, -Z] - must match updateOptimized()
-            // See: firmware/BigPicture/ORIENTATION_PIPELINE.md
-            accelSumX += (-frame.ax_g) * 9.81f;
-            accelSumY += (+frame.ay_g) * 9.81f;
-            accelSumZ += (-frame.az_g) * 9.81f;
-
-            gyroSumX += -frame.gx_rad;
-            gyroSumY += +frame.gy_rad;
-            gyroSumZ += -frame.gz_rad;
-        }
-        delay(10);
+      float target = (k < 3) ? CAL_ACCEL_SEM_MS2 : CAL_GYRO_SEM_RADS;
+      converged = c.m2[k] / denom < target * target;
     }
-
-    // Calculate offsets (Average - Expected)
-    // Expectation for FLAT/LEVEL placement in Y-Up Frame:
-    // Gravity is on Y-axis (+9.81 m/s²)
-    calibration[sensorId].accelOffsetX = accelSumX / numSamples;
-    calibration[sensorId].accelOffsetY =
-        (accelSumY / numSamples) - 9.81f; // Subtract gravity from Y
-    calibration[sensorId].accelOffsetZ = accelSumZ / numSamples;
-    calibration[sensorId].gyroOffsetX = gyroSumX / numSamples;
-    calibration[sensorId].gyroOffsetY = gyroSumY / numSamples;
-    calibration[sensorId].gyroOffsetZ = gyroSumZ / numSamples;
-    calibration[sensorId].isCalibrated = true;
-
-    Serial.printf("[SensorMgr] Calibration complete for sensor %d\n", sensorId);
-    Serial.printf("  Accel offsets: X=%.3f, Y=%.3f, Z=%.3f\n",
-                  calibration[sensorId].accelOffsetX,
-                  calibration[sensorId].accelOffsetY,
-                  calibration[sensorId].accelOffsetZ);
-    Serial.printf("  Gyro offsets: X=%.3f, Y=%.3f, Z=%.3f\n",
-                  calibration[sensorId].gyroOffsetX,
-                  calibration[sensorId].gyroOffsetY,
-                  calibration[sensorId].gyroOffsetZ);
-
-    // Auto-save calibration to NVS
-    saveCalibration(sensorId);
+  }
+  if (!converged)
+    return;
+
+  // Offsets = window mean - expectation (gravity on +Y when flat)
+  if (!c.gyroOnly)
+  {
+    calibration[i].accelOffsetX = c.mean[0];
+    calibration[i].accelOffsetY = c.mean[1] - 9.81f;
+    calibration[i].accelOffsetZ = c.mean[2];
+  }
+  calibration[i].gyroOffsetX = c.mean[3];
+  calibration[i].gyroOffsetY = c.mean[4];
+  calibration[i].gyroOffsetZ = c.mean[5];
+  calibration[i].isCalibrated = true;
+
+  c.progress = 100;
+  __atomic_fetch_and(&calActiveMask, (uint8_t)~bit, __ATOMIC_RELEASE);
+  __atomic_fetch_or(&calResultMask, (uint16_t)bit, __ATOMIC_RELEASE);
 }
 
-void SensorManager::calibrateGyro(uint8_t sensorId)
+bool SensorManager::serviceCalibration()
 {
-    if (sensorId >= sensorCount)
-    {
-        Serial.printf("[SensorMgr] Invalid sensor ID: %d\n", sensorId);
-        return;
-    }
-
-    Serial.printf(
-        "[SensorMgr] Zeroing Gyros for sensor %d - keep device still!\n",
-        sensorId);
-
-    // Quick 500ms capture
-    const int numSamples = 50;
-    float gyroSumX = 0, gyroSumY = 0, gyroSumZ = 0;
+  uint16_t result = __atomic_exchange_n(&calResultMask, 0, __ATOMIC_ACQUIRE);
+  if (result == 0)
+    return false;
 
-    if (useMultiplexer && sensorChannels[sensorId] >= 0)
+  for (uint8_t i = 0; i < sensorCount; i++)
+  {
+    if ((result >> 8) & (1u << i))
     {
-        selectChannel(sensorChannels[sensorId]);
+      Serial.printf("[SensorMgr] Calibration FAILED for sensor %d - not "
+                    "still for long enough, or no valid samples (%u motion "
+                    "resets, %u samples)\n",
+                    i, stillCal[i].motionResets, stillCal[i].n);
     }
-
-    for (int i = 0; i < numSamples; i++)
+    if (!(result & (1u << i)))
+      continue;
+
+    const StillCalibration &c = stillCal[i];
+    Serial.printf("[SensorMgr] %s complete for sensor %d (%u samples, "
+                  "%u motion resets, %lu ms)\n",
+                  c.gyroOnly ? "Gyro Zero" : "Calibration", i, c.n,
+                  c.motionResets, (unsigned long)(millis() - c.startMs));
+    if (!c.gyroOnly)
     {
-        IMUFrame frame;
-        if (sensors[sensorId].readFrame(&frame))
-        {
-            // Transform 2: [-X, +Y, -Z] - must match updateOptimized()
-            // See: firmware/BigPicture/ORIENTATION_PIPELINE.md
-            gyroSumX += -frame.gx_rad;
-            gyroSumY += +frame.gy_rad;
-            gyroSumZ += -frame.gz_rad;
-        }
-        delay(10);
+      Serial.printf("  Accel offsets: X=%.3f, Y=%.3f, Z=%.3f\n",
+                    calibration[i].accelOffsetX,
+                    calibration[i].accelOffsetY,
+                    calibration[i].accelOffsetZ);
     }
+    Serial.printf("  Gyro offsets: X=%.3f, Y=%.3f, Z=%.3f\n",
+                  calibration[i].gyroOffsetX,
+                  calibration[i].gyroOffsetY,
+                  calibration[i].gyroOffsetZ);
 
-    // Update ONLY gyro offsets
-    calibration[sensorId].gyroOffsetX = gyroSumX / numSamples;
-    calibration[sensorId].gyroOffsetY = gyroSumY / numSamples;
-    calibration[sensorId].gyroOffsetZ = gyroSumZ / numSamples;
+    // Auto-save calibration to NVS
+    saveCalibration(i);
+  }
+  return true;
+}
 
-    // Set calibrated flag (assuming if we zero gyros, we want to use the result)
-    calibration[sensorId].isCalibrated = true;
+bool SensorManager::isCalibrating() const
+{
+  return __atomic_load_n(&calRequestMask, __ATOMIC_ACQUIRE) != 0 ||
+         __atomic_load_n(&calActiveMask, __ATOMIC_ACQUIRE) != 0;
+}
 
-    Serial.printf("[SensorMgr] Gyro Zero complete for sensor %d\n", sensorId);
-    Serial.printf("  Gyro offsets: X=%.3f, Y=%.3f, Z=%.3f\n",
-                  calibration[sensorId].gyroOffsetX,
-                  calibration[sensorId].gyroOffsetY,
-                  calibration[sensorId].gyroOffsetZ);
+uint8_t SensorManager::getCalibrationProgress(uint8_t sensorIndex) const
+{
+  if (sensorIndex < MAX_SENSORS)
+  {
+    return stillCal[sensorIndex].progress;
+  }
+  return 0;
+}
 
-    // Auto-save calibration to NVS
-    saveCalibration(sensorId);
+uint8_t SensorManager::getCalibratingMask() const
+{
+  return __atomic_load_n(&calActiveMask, __ATOMIC_ACQUIRE);
+}
+
+uint8_t SensorManager::getCalibrationFailedMask() const
+{
+  return __atomic_load_n(&calFailedMask, __ATOMIC_ACQUIRE);
+}
+
+uint16_t SensorManager::getCalibrationMotionResets(uint8_t sensorIndex) const
+{
+  if (sensorIndex < MAX_SENSORS)
+  {
+    return stillCal[sensorIndex].motionResets;
+  }
+  return 0;
 }
 
 // ============================================================================
@@ -23,7 +23,8 @@ SensorManager::SensorManager()
       zuptMinFrames(10), hasMagnetometer(false), hasBarometer(false),
       lastOptionalSensorUpdate(0), magChannel(-1), baroChannel(-1),
       magCalibrationActive(false), magCalibrationStartTime(0),
-      magCalibrationDuration(15000),
+      magCalibrationDuration(15000), calRequestMask(0), calActiveMask(0),
+      calResultMask(0), calFailedMask(0),
       fifoModeEnabled(false), batchSampleCount(0) // FIFO batch state
 {
   // CRITICAL: Initialize sensorData array to zero to avoid garbage sensorIds
@@ -31,6 +32,7 @@ SensorManager::SensorManager()
   // 88='X')
   memset(sensorData, 0, sizeof(sensorData));
   memset(batchBuffer, 0, sizeof(batchBuffer)); // Initialize batch buffer
+  memset(stillCal, 0, sizeof(stillCal));
 
   // Initialize calibration data with proper defaults
   for (uint8_t i = 0; i < MAX_SENSORS; i++)
@@ -49,7 +51,12 @@ SensorManager::SensorManager()
   baroData = {0, 0, 0};
 
   // Initialize magnetometer calibration
-  magCalibration = {0, 0, 0, 1.0f, 1.0f, 1.0f, false, 0};
+  resetMagCalibrationData(magCalibration);
+  magFitReset(magFit);
+  memset(&magFitLast, 0, sizeof(magFitLast));
+  magFitLastSolveCount = 0;
+  magFitStableSolves = 0;
+  magCalLastSampleMs = 0;
   magMinX = magMaxX = 0;
   magMinY = magMaxY = 0;
   magMinZ = magMaxZ = 0;
@@ -468,6 +475,7 @@ void SensorManager::updateOptimized(float dt)
 
   for (uint8_t i = 0; i < sensorCount; i++)
   {
+    TRACE_EVENT(TRACE_EV_I2C_READ, TRACE_BEGIN, i);
     if (useMultiplexer && sensorChannels[i] >= 0)
     {
       selectChannel(sensorChannels[i]);
@@ -484,6 +492,7 @@ void SensorManager::updateOptimized(float dt)
       failedReads++;
       frameValid[i] = false;
     }
+    TRACE_EVENT(TRACE_EV_I2C_READ, TRACE_END, i);
   }
 
   uint32_t i2cEndTime = micros();
@@ -500,6 +509,15 @@ void SensorManager::updateOptimized(float dt)
   // =========================================================================
   // PHASE 2: DATA PROCESSING (CPU-bound, no I2C blocking)
   // =========================================================================
+  if (__atomic_load_n(&calRequestMask, __ATOMIC_ACQUIRE) != 0)
+  {
+    beginRequestedCalibrations();
+  }
+  if (calActiveMask != 0)
+  {
+    expireStillCalibrations(); // Regardless of frameValid / outliers
+  }
+
   for (uint8_t i = 0; i < sensorCount; i++)
   {
     if (!frameValid[i])
@@ -548,6 +566,14 @@ void SensorManager::updateOptimized(float dt)
     float gy_yup = +gy_raw;
     float gz_yup = -gz_raw;
 
+    // Streaming still-window calibration sees the uncorrected Y-up sample
+    const bool calibrating = (calActiveMask >> i) & 1;
+    if (calibrating)
+    {
+      const float sample[6] = {ax_yup, ay_yup, az_yup, gx_yup, gy_yup, gz_yup};
+      feedStillCalibration(i, sample);
+    }
+
     // Apply calibration
     float ax_cal = (ax_yup - calibration[i].accelOffsetX) * calibration[i].accelScale;
     float ay_cal = (ay_yup - calibration[i].accelOffsetY) * calibration[i].accelScale;
@@ -572,7 +598,7 @@ void SensorManager::updateOptimized(float dt)
     float accelDiff = fabs(accelMag - 9.81f);
     bool isStationary = (gyroMag < zuptGyroThresh) && (accelDiff < zuptAccelThresh);
 
-    if (isStationary)
+    if (isStationary && !calibrating)
     {
       stationaryCount[i]++;
       if (stationaryCount[i] > STATIONARY_FRAMES_FOR_LEARNING)
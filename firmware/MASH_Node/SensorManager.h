@@ -3,6 +3,7 @@
 
 #include "Config.h"
 
+#include "../libraries/IMUConnectCore/src/MagEllipsoidFit.h"
 #include "ICM20649_Research.h"
 #include <Arduino.h>
 #include <Wire.h>
@@ -95,18 +96,45 @@ public:
   void setActivityProfile(ActivityProfile profile);
 
   /**
-   * Calibrate a specific sensor (compute gyro offsets at rest)
-   * @param sensorId Sensor index to calibrate
+   * Start accel + gyro offset calibration (device FLAT and still).
+   * Non-blocking: the sensor is fed from the updateOptimized() sample stream
+   * and finishes once its still window converges. Requested sensors run in
+   * parallel. Call serviceCalibration() from loop() to persist results.
+   * @param sensorId Sensor index, or CAL_ALL_SENSORS
    */
   void calibrateSensor(uint8_t sensorId);
 
   /**
-   * Calibrate gyro bias ONLY (assumes device is stationary but not necessarily
-   * flat)
-   * @param sensorId Sensor index to calibrate
+   * Start gyro bias calibration ONLY (device still, any orientation).
+   * Non-blocking, same engine as calibrateSensor().
+   * @param sensorId Sensor index, or CAL_ALL_SENSORS
    */
   void calibrateGyro(uint8_t sensorId);
 
+  static constexpr uint8_t CAL_ALL_SENSORS = 0xFF;
+
+  /**
+   * Save finished calibrations to NVS and log them (call from loop(), never
+   * from the sensor task: NVS writes block)
+   * @return true if any sensor finished or failed since the last call
+   */
+  bool serviceCalibration();
+
+  /** True while any sensor calibration is requested or running */
+  bool isCalibrating() const;
+
+  /** Calibration progress for one sensor (0-100, 100 = done) */
+  uint8_t getCalibrationProgress(uint8_t sensorIndex) const;
+
+  /** Bitmask of sensors currently calibrating */
+  uint8_t getCalibratingMask() const;
+
+  /** Bitmask of sensors whose last calibration timed out (never still) */
+  uint8_t getCalibrationFailedMask() const;
+
+  /** Times the still window restarted because the sensor moved */
+  uint16_t getCalibrationMotionResets(uint8_t sensorIndex) const;
+
   /**
    * Get calibration data for a sensor
    */
@@ -173,15 +201,20 @@ public:
   /** Get barometer data (only valid if hasBaro() == true) */
   BaroData getBaroData() const { return baroData; }
 
-  /** Update optional sensors (called less frequently than IMUs) */
-  void updateOptionalSensors();
+  /**
+   * Update optional sensors (called less frequently than IMUs)
+   * @return NODE_ENVIRO_HAS_* bits for the readings refreshed by this call
+   */
+  uint8_t updateOptionalSensors();
 
   // ========== Magnetometer Calibration ==========
 
   /**
    * Start magnetometer calibration process
-   * Collects min/max values while user moves sensor in figure-8 pattern
-   * @param durationMs Duration to collect samples (default 15000ms = 15s)
+   * Fits an ellipsoid (hard iron + full soft-iron matrix) incrementally while
+   * the user moves the sensor in a figure-8 pattern, and finishes as soon as
+   * the fit has converged with enough direction coverage
+   * @param durationMs Maximum duration (default 15000ms = 15s)
    */
   void startMagCalibration(uint32_t durationMs = 15000);
 
@@ -201,6 +234,21 @@ public:
    */
   uint8_t getMagCalibrationProgress() const;
 
+  /** Direction coverage of the running calibration (0-100 %) */
+  uint8_t getMagCalibrationCoverage() const
+  {
+    return magCalibrationActive ? magFitCoverage(magFit)
+                                : magCalibration.coverage;
+  }
+
+  /** Latest ellipsoid fit residual, % of field (negative = no valid fit) */
+  float getMagCalibrationFitError() const
+  {
+    if (!magCalibrationActive)
+      return magCalibration.isCalibrated ? magCalibration.fitError : -1.0f;
+    return magFitLast.valid ? magFitLast.fitError : -1.0f;
+  }
+
   /**
    * Get magnetometer calibration data
    */
@@ -301,6 +349,42 @@ private:
   float magMinX, magMaxX;
   float magMinY, magMaxY;
   float magMinZ, magMaxZ;
+  MagEllipsoidFit magFit;
+  MagEllipsoidSolution magFitLast; // Latest solve, for convergence checks
+  uint32_t magFitLastSolveCount;
+  uint8_t magFitStableSolves; // Consecutive solves that barely moved
+  uint32_t magCalLastSampleMs;
+
+  bool readMagnetometer();
+  void finishMagCalibration(bool converged);
+  static void resetMagCalibrationData(MagCalibrationData &cal);
+
+  // ============================================================================
+  // STREAMING STILL-WINDOW CALIBRATION (SensorCalibration.cpp)
+  // ============================================================================
+  // Welford mean/variance per axis, fed from updateOptimized(). Request and
+  // completion masks cross tasks via __atomic builtins; everything else is
+  // owned by the sample path.
+  struct StillCalibration
+  {
+    uint16_t n;      // Samples in the current still window
+    float mean[6];   // ax, ay, az (m/s²), gx, gy, gz (rad/s), Y-up frame
+    float m2[6];     // Sum of squared deviations from the mean
+    uint32_t startMs;
+    uint16_t motionResets;
+    uint8_t progress; // 0-100
+    bool gyroOnly;
+  };
+  StillCalibration stillCal[MAX_SENSORS];
+  uint16_t calRequestMask; // Bits 0-7: full, 8-15: gyro-only (any task)
+  uint8_t calActiveMask;   // Written by the sample path only
+  uint16_t calResultMask;  // Bits 0-7: finished, 8-15: failed (to loop())
+  uint8_t calFailedMask;   // Sticky until the sensor is requested again
+
+  void beginRequestedCalibrations();
+  void expireStillCalibrations();
+  void feedStillCalibration(uint8_t sensorIndex, const float *sample);
+  void requestCalibration(uint8_t sensorId, bool gyroOnly);
 
   // ============================================================================
   // FIFO BATCH READING STATE
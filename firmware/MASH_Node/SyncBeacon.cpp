@@ -7,9 +7,63 @@
 #define DEVICE_ROLE DEVICE_ROLE_NODE
 
 #include "SyncManager.h"
+#include "FlashBlackBox.h"
 #include "PowerStateManager.h"
 #include <esp_wifi.h>
 
+// ============================================================================
+// CHANNEL TUNING
+// ============================================================================
+// Moves the radio and every ESP-NOW peer we send to. Peers registered with a
+// fixed channel refuse to send once the radio is elsewhere, so the broadcast
+// and Gateway peers follow the radio on every retune.
+// ============================================================================
+
+void SyncManager::tuneRadioChannel(uint8_t channel)
+{
+    if (channel == 0 || channel > 14)
+        return;
+
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    radioChannel = channel;
+
+    static const uint8_t broadcastMac[6] = {0xFF, 0xFF, 0xFF,
+                                            0xFF, 0xFF, 0xFF};
+    const uint8_t *peers[2] = {broadcastMac,
+                               gatewayMacDiscovered ? gatewayMac : nullptr};
+    for (const uint8_t *mac : peers)
+    {
+        esp_now_peer_info_t peer = {};
+        if (mac != nullptr && esp_now_get_peer(mac, &peer) == ESP_OK &&
+            peer.channel != channel)
+        {
+            peer.channel = channel;
+            esp_now_mod_peer(&peer);
+        }
+    }
+}
+
+void SyncManager::serviceChannelHop()
+{
+    if (!hopPending)
+        return;
+
+    uint8_t target;
+    portENTER_CRITICAL(&syncStateLock);
+    bool due = hopPending && (int32_t)(micros() - hopSwitchAtUs) >= 0;
+    target = hopChannel;
+    if (due)
+        hopPending = false;
+    portEXIT_CRITICAL(&syncStateLock);
+
+    if (!due)
+        return;
+
+    tuneRadioChannel(target);
+    lastKnownChannel = target;
+    Serial.printf("[TDMA] *** Coordinated hop to channel %u ***\n", target);
+}
+
 // ============================================================================
 // TDMA BEACON HANDLER
 // ============================================================================
@@ -101,6 +155,17 @@ void SyncManager::handleTDMABeacon(const uint8_t *data, int len)
             pipelinePacketSize = 0;
             pipelineSamplesConsumed = 0;
 
+            // Black box frames belong to the old epoch's timeline — discard
+            portENTER_CRITICAL(&syncStateLock);
+            inFlightKind = INFLIGHT_NONE;
+            txCompletionPending = false;
+            portEXIT_CRITICAL(&syncStateLock);
+            lastBackfillFrame = 0xFFFFFFFF;
+            if (blackBox != nullptr)
+            {
+                blackBox->requestClear();
+            }
+
             // Reset PTP/two-way sync state
             twoWayOffset = 0;
             avgRttUs = 0;
@@ -166,16 +231,45 @@ void SyncManager::handleTDMABeacon(const uint8_t *data, int len)
     // ============================================================================
 
     // Check if we need to switch to the Gateway's WiFi channel
-    static uint8_t currentChannel = 0;
-    if (beacon->wifiChannel != 0 && beacon->wifiChannel != currentChannel)
+    if (beacon->wifiChannel != 0 && beacon->wifiChannel != radioChannel)
     {
-        esp_wifi_set_channel(beacon->wifiChannel, WIFI_SECOND_CHAN_NONE);
         Serial.printf("[TDMA] *** Switching to WiFi channel %d (was %d) ***\n",
-                      beacon->wifiChannel, currentChannel);
-        currentChannel = beacon->wifiChannel;
+                      beacon->wifiChannel, radioChannel);
+        tuneRadioChannel(beacon->wifiChannel);
     }
 
     uint32_t localTime = micros();
+
+    // ============================================================================
+    // CHANNEL HOP ANNOUNCEMENT: beacon (frameNumber + hopCountdown) will be on
+    // hopChannel. Retune in the middle of the guard time before it — our slot
+    // is long over by then. Every announcing beacon refreshes the deadline, so
+    // hearing any one of them is enough.
+    // ============================================================================
+    if (len >= (int)offsetof(TDMABeaconPacket, prevTxLatencyUs) &&
+        beacon->hopCountdown > 0 &&
+        beacon->hopChannel >= 1 && beacon->hopChannel <= 14 &&
+        beacon->hopChannel != radioChannel)
+    {
+        uint32_t switchAtUs =
+            localTime +
+            (uint32_t)beacon->hopCountdown * TDMA_FRAME_PERIOD_MS * 1000 -
+            TDMA_GUARD_TIME_US / 2;
+        bool firstNotice;
+        portENTER_CRITICAL(&syncStateLock);
+        firstNotice = !hopPending || hopChannel != beacon->hopChannel;
+        hopChannel = beacon->hopChannel;
+        hopSwitchAtUs = switchAtUs;
+        hopPending = true;
+        portEXIT_CRITICAL(&syncStateLock);
+
+        if (firstNotice)
+        {
+            Serial.printf("[TDMA] Gateway announced hop to channel %u in %u "
+                          "frames\n",
+                          beacon->hopChannel, beacon->hopCountdown);
+        }
+    }
     lastBeaconTime = localTime;
     lastBeaconMillis = millis(); // Track for timeout detection
     // REMOVED: lastSyncCheckTime = millis();
@@ -205,6 +299,7 @@ void SyncManager::handleTDMABeacon(const uint8_t *data, int len)
     // flag is asserted repeatedly while connected (node would keep sending frame
     // 0).
     currentFrameNumber = beacon->frameNumber;
+    TRACE_EVENT(TRACE_EV_BEACON_RX, TRACE_INSTANT, beacon->frameNumber);
 
     // ============================================================================
     // HARDWARE TSF TIMESTAMP SYSTEM (Research-Grade Sync)
@@ -474,6 +569,9 @@ void SyncManager::handleTDMASchedule(const uint8_t *data, int len)
     uint32_t oldOffset = mySlotOffsetUs;
     uint32_t oldWidth = mySlotWidthUs;
 
+    // Older Gateways send no phyRate[] trailer — treat as 6 Mbps
+    const bool hasPhyRates = (len >= (int)sizeof(TDMASchedulePacket));
+
     for (int i = 0; i < scheduleNodeCount; i++)
     {
         if (schedule->slots[i].nodeId == nodeId)
@@ -482,6 +580,16 @@ void SyncManager::handleTDMASchedule(const uint8_t *data, int len)
             mySlotWidthUs = schedule->slots[i].slotWidthUs;
             foundSlot = true;
 
+            uint8_t phyRate =
+                hasPhyRates ? schedule->phyRate[i] : (uint8_t)TDMA_PHY_RATE_6M;
+            if (phyRate >= TDMA_PHY_RATE_COUNT)
+                phyRate = TDMA_PHY_RATE_6M;
+            if (phyRate != mySlotPhyRate && gatewayMacDiscovered)
+            {
+                pinEspNowPhyRate(gatewayMac, phyRate);
+                mySlotPhyRate = phyRate;
+            }
+
             // Only log if slot actually changes (reduces serial spam)
             if (oldOffset != mySlotOffsetUs || oldWidth != mySlotWidthUs ||
                 tdmaNodeState != TDMA_NODE_SYNCED)
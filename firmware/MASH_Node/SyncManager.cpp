@@ -24,13 +24,23 @@ static SyncManager *globalSyncManager = nullptr;
 //   1. Slot width calculations match actual RF behaviour
 //   2. OFDM preamble (20Âµs) replaces DSSS preamble (192Âµs) per TX
 //   3. Mux-node payloads (6 sensors Ã— 4 samples = 609 bytes) fit in 20ms frame
+//
+// Adaptive PHY rate: the Gateway may raise a clean link to a faster 802.11g
+// rate via the TDMA schedule (sized for that rate). The peer is re-pinned to
+// whatever rate our slot was scheduled at; 6 Mbps is always the fallback.
 // ============================================================================
-void pinEspNowPhyRate(const uint8_t *peerMac)
+void pinEspNowPhyRate(const uint8_t *peerMac, uint8_t phyRate)
 {
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+  static const wifi_phy_rate_t RATE_MAP[TDMA_PHY_RATE_COUNT] = {
+      WIFI_PHY_RATE_6M, WIFI_PHY_RATE_12M, WIFI_PHY_RATE_24M,
+      WIFI_PHY_RATE_36M, WIFI_PHY_RATE_54M};
+  if (phyRate >= TDMA_PHY_RATE_COUNT)
+    phyRate = TDMA_PHY_RATE_6M;
+
   esp_now_rate_config_t rateConfig = {};
   rateConfig.phymode = WIFI_PHY_MODE_11G;
-  rateConfig.rate = WIFI_PHY_RATE_6M;
+  rateConfig.rate = RATE_MAP[phyRate];
   rateConfig.ersu = false;
   esp_err_t err = esp_now_set_peer_rate_config(peerMac, &rateConfig);
   if (err != ESP_OK)
@@ -41,12 +51,14 @@ void pinEspNowPhyRate(const uint8_t *peerMac)
   }
   else
   {
-    Serial.printf("[PHY] Pinned 802.11g 6Mbps for %02X:%02X:%02X:%02X:%02X:%02X\n",
+    Serial.printf("[PHY] Pinned 802.11g %uMbps for %02X:%02X:%02X:%02X:%02X:%02X\n",
+                  tdmaPhyRateMbps(phyRate),
                   peerMac[0], peerMac[1], peerMac[2],
                   peerMac[3], peerMac[4], peerMac[5]);
   }
 #else
   (void)peerMac;
+  (void)phyRate;
   Serial.println("[PHY] Rate pinning requires ESP-IDF >= 5.1 â€” skipped");
 #endif
 }
@@ -101,6 +113,9 @@ void SyncManager::onEspNowSent(const wifi_tx_info_t *tx_info,
       g_txStartTime = 0;
     }
     globalSyncManager->txPending = false;
+    // Black box: sendTDMAData() resolves the in-flight frame on its next call
+    globalSyncManager->txCompletionPending = true;
+    globalSyncManager->txLastAcked = (status == ESP_NOW_SEND_SUCCESS);
     if (status == ESP_NOW_SEND_SUCCESS)
     {
       // EXPERT REVIEW FIX: Reset consecutive failures on success
@@ -115,6 +130,8 @@ void SyncManager::onEspNowSent(const wifi_tx_info_t *tx_info,
       globalSyncManager->tdmaDiagTxFail++;
     }
     portEXIT_CRITICAL(&globalSyncManager->syncStateLock);
+    TRACE_EVENT(TRACE_EV_NODE_TX_DONE, TRACE_INSTANT,
+                status == ESP_NOW_SEND_SUCCESS);
   }
 }
 #else
@@ -133,6 +150,9 @@ void SyncManager::onEspNowSent(const uint8_t *mac,
       g_txStartTime = 0;
     }
     globalSyncManager->txPending = false;
+    // Black box: sendTDMAData() resolves the in-flight frame on its next call
+    globalSyncManager->txCompletionPending = true;
+    globalSyncManager->txLastAcked = (status == ESP_NOW_SEND_SUCCESS);
     if (status == ESP_NOW_SEND_SUCCESS)
     {
       // EXPERT REVIEW FIX: Reset consecutive failures on success
@@ -146,6 +166,8 @@ void SyncManager::onEspNowSent(const uint8_t *mac,
       globalSyncManager->tdmaDiagTxFail++;
     }
     portEXIT_CRITICAL(&globalSyncManager->syncStateLock);
+    TRACE_EVENT(TRACE_EV_NODE_TX_DONE, TRACE_INSTANT,
+                status == ESP_NOW_SEND_SUCCESS);
   }
 }
 #endif
@@ -157,7 +179,8 @@ SyncManager::SyncManager()
       gatewayMacDiscovered(false), // Will be set true when we hear a beacon
       tdmaNodeState(TDMA_NODE_UNREGISTERED), currentFrameNumber(0),
       lastBeaconTime(0), lastBeaconMillis(0), mySlotOffsetUs(0),
-      mySlotWidthUs(0), lastRegistrationTime(0), registeredStateStartTime(0),
+      mySlotWidthUs(0), mySlotPhyRate(TDMA_PHY_RATE_6M),
+      lastRegistrationTime(0), registeredStateStartTime(0),
       lastGatewayState(0), consecutiveBeaconLosses(0), lastSyncCheckTime(0),
       inRecoveryMode(false), recoveryModeStartTime(0), lastKnownChannel(1),
       beaconGatewayTimeUs(0),
@@ -174,7 +197,9 @@ SyncManager::SyncManager()
       lastTwoWaySyncTime(0), lastRttUs(0),
       syncProtocolVersion(SYNC_PROTOCOL_VERSION_LEGACY), offsetSampleIndex(0),
       validSampleCount(0), avgRttUs(0), channelScanStart(0),
-      currentScanChannel(0), txPending(false), sendFailCount(0),
+      listenStartMillis(0), currentScanChannel(0),
+      radioChannel(ESP_NOW_CHANNEL), hopPending(false), hopChannel(0),
+      hopSwitchAtUs(0), txPending(false), sendFailCount(0),
       currentBufferPolicy(POLICY_LIVE),
       // Pipelined packet building state
       pipelinePacketSize(0), pipelineSamplesConsumed(0),
@@ -233,6 +258,9 @@ void SyncManager::init(const char *deviceName)
   // Register receive callback
   esp_now_register_recv_cb(OnDataRecv);
 
+  // Beacon silence for channel search counts from here, not from boot
+  listenStartMillis = millis();
+
   // ============================================================================
   // STABILITY FIX: Register send callback for TX pacing
   // ============================================================================
@@ -305,6 +333,7 @@ void SyncManager::reinitEspNow()
   // frequency
   uint8_t ch = lastKnownChannel > 0 ? lastKnownChannel : 1;
   esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
+  radioChannel = ch;
   Serial.printf("[RECOVERY] Forced WiFi Channel to %d\n", ch);
 
   Serial.println("[RECOVERY] Re-initializing ESP-NOW...");
@@ -323,7 +352,7 @@ void SyncManager::reinitEspNow()
   // Re-add Broadcast Peer
   esp_now_peer_info_t peerInfo = {};
   memset(peerInfo.peer_addr, 0xFF, 6);
-  peerInfo.channel = ESP_NOW_CHANNEL;
+  peerInfo.channel = ch;
   peerInfo.ifidx = WIFI_IF_STA; // CRITICAL: Explicitly match interface
   peerInfo.encrypt = false;
   esp_now_add_peer(&peerInfo);
@@ -338,6 +367,7 @@ void SyncManager::reinitEspNow()
     peerInfo.encrypt = false;
     esp_now_add_peer(&peerInfo);
     pinEspNowPhyRate(gatewayMac); // Pin unicast to 802.11g 6 Mbps
+    mySlotPhyRate = TDMA_PHY_RATE_6M; // Next schedule re-pins if faster
     Serial.printf("[RECOVERY] Restored Gateway peer on ch %d\n",
                   peerInfo.channel);
   }
@@ -403,14 +433,35 @@ void SyncManager::update()
   }
 
   // ============================================================================
-  // UNREGISTERED STATE: Retry registration on KNOWN channel (no scanning)
+  // UNREGISTERED STATE: Retry registration on KNOWN channel (no full scan)
   // ============================================================================
-  // The gateway channel is fixed for this system. Channel scanning causes
-  // schedule-loss during re-sync and is intentionally disabled.
+  // A full 13-channel scan causes schedule-loss during re-sync and stays
+  // disabled. The Gateway only hops between TDMA_HOP_CHANNEL_COUNT channels,
+  // so after TDMA_CHANNEL_SEARCH_AFTER_MS of beacon silence we dwell on each
+  // candidate long enough to hear ~20 beacons (covers a missed hop).
   // ============================================================================
   if (tdmaNodeState == TDMA_NODE_UNREGISTERED)
   {
     uint32_t now = millis();
+    // No beacon yet (or reset by recovery): silence runs from first listen
+    uint32_t silentSince =
+        (lastBeaconMillis > 0) ? lastBeaconMillis : listenStartMillis;
+
+    if (now - silentSince > TDMA_CHANNEL_SEARCH_AFTER_MS &&
+        now - channelScanStart > TDMA_CHANNEL_SEARCH_DWELL_MS)
+    {
+      currentScanChannel = (currentScanChannel + 1) % TDMA_HOP_CHANNEL_COUNT;
+      channelScanStart = now;
+      tuneRadioChannel(tdmaHopChannel(currentScanChannel));
+
+      static uint32_t lastSearchLog = 0;
+      if (now - lastSearchLog > 5000)
+      {
+        lastSearchLog = now;
+        Serial.printf("[TDMA] No beacons for %lu ms — searching channel %u\n",
+                      (unsigned long)(now - silentSince), radioChannel);
+      }
+    }
 
     // ========================================================================
     // Recovery mode: aggressively retry registration on known channel
@@ -428,8 +479,9 @@ void SyncManager::update()
         {
           sendTDMARegistration();
           lastRegistrationTime = now;
-          Serial.println(
-              "[RECOVERY] Retrying registration on channel 1...");
+          Serial.printf(
+              "[RECOVERY] Retrying registration on channel %u...\n",
+              radioChannel);
         }
       }
 
@@ -439,15 +491,14 @@ void SyncManager::update()
         Serial.println("[RECOVERY] Timeout! Reinitializing radio...");
         inRecoveryMode = false;
         lastBeaconMillis = 0;
-        // Force channel back to 1 in case it drifted
-        esp_wifi_set_channel(ESP_NOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
+        // Channel search (above) takes over from here
       }
 
       // Fall through to beacon processing below
     }
     // ========================================================================
 
-    // If no beacon is heard yet, remain on the fixed channel and keep retrying.
+    // If no beacon is heard yet, keep retrying (channel search runs above).
   }
 
   // ============================================================================
@@ -586,6 +637,52 @@ void SyncManager::sendEnviroData(SensorManager &sm)
 #endif
 }
 
+void SyncManager::stageEnviroSample(SensorManager &sm, uint8_t fresh)
+{
+#if DEVICE_ROLE == DEVICE_ROLE_NODE
+  NodeEnviroSample sample;
+  memset(&sample, 0, sizeof(sample));
+
+  if ((fresh & NODE_ENVIRO_HAS_MAG) && sm.hasMag())
+  {
+    MagData mag = sm.getMagData();
+    sample.contents |= NODE_ENVIRO_HAS_MAG;
+    sample.mag[0] = (int16_t)(mag.x * 10.0f);
+    sample.mag[1] = (int16_t)(mag.y * 10.0f);
+    sample.mag[2] = (int16_t)(mag.z * 10.0f);
+  }
+
+  if ((fresh & NODE_ENVIRO_HAS_BARO) && sm.hasBaro())
+  {
+    BaroData baro = sm.getBaroData();
+    sample.contents |= NODE_ENVIRO_HAS_BARO;
+    sample.pressureCPa = (uint32_t)(baro.pressure * 10000.0f); // hPa → 0.01 Pa
+    sample.temperatureC = (int16_t)(baro.temperature * 100.0f);
+  }
+
+  if (sample.contents == 0)
+    return;
+
+  // Merge with a reading bufferSample() has not picked up yet
+  portENTER_CRITICAL(&syncStateLock);
+  if (!(sample.contents & NODE_ENVIRO_HAS_MAG) &&
+      (pendingEnviro.contents & NODE_ENVIRO_HAS_MAG))
+  {
+    memcpy(sample.mag, pendingEnviro.mag, sizeof(sample.mag));
+    sample.contents |= NODE_ENVIRO_HAS_MAG;
+  }
+  if (!(sample.contents & NODE_ENVIRO_HAS_BARO) &&
+      (pendingEnviro.contents & NODE_ENVIRO_HAS_BARO))
+  {
+    sample.pressureCPa = pendingEnviro.pressureCPa;
+    sample.temperatureC = pendingEnviro.temperatureC;
+    sample.contents |= NODE_ENVIRO_HAS_BARO;
+  }
+  pendingEnviro = sample;
+  portEXIT_CRITICAL(&syncStateLock);
+#endif
+}
+
 void SyncManager::sendNodeInfo(SensorManager &sm, const char *name)
 {
 #if DEVICE_ROLE == DEVICE_ROLE_NODE
@@ -630,12 +727,44 @@ void SyncManager::sendMagCalibProgress(SensorManager &sm)
   packet.softIronScaleY = cal.softIronScaleY;
   packet.softIronScaleZ = cal.softIronScaleZ;
   packet.sampleCount = cal.sampleCount;
+  memcpy(packet.softIron, cal.softIron, sizeof(packet.softIron));
+
+  // Live metrics while calibrating, stored ones afterwards
+  packet.coverage = sm.getMagCalibrationCoverage();
+  float fitError = sm.getMagCalibrationFitError();
+  packet.fitErrorTenths =
+      fitError < 0 ? 255 : (uint8_t)min(fitError * 10.0f + 0.5f, 254.0f);
 
   // Use auto-discovered Gateway MAC (or fallback to broadcast)
   esp_now_send(gatewayMac, (uint8_t *)&packet, sizeof(packet));
 #endif
 }
 
+bool SyncManager::sendImuCalibProgress(SensorManager &sm)
+{
+#if DEVICE_ROLE == DEVICE_ROLE_NODE
+  ESPNowImuCalibPacket packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.type = IMU_CALIB_PACKET;
+  packet.nodeId = nodeId;
+  packet.sensorCount = sm.getSensorCount();
+  packet.calibratingMask = sm.getCalibratingMask();
+  packet.failedMask = sm.getCalibrationFailedMask();
+  for (uint8_t i = 0; i < packet.sensorCount && i < MAX_SENSORS; i++)
+  {
+    if (sm.isCalibrated(i))
+      packet.calibratedMask |= (uint8_t)(1u << i);
+    packet.progress[i] = sm.getCalibrationProgress(i);
+    packet.motionResets[i] = sm.getCalibrationMotionResets(i);
+  }
+
+  return esp_now_send(gatewayMac, (uint8_t *)&packet, sizeof(packet)) == ESP_OK;
+#else
+  (void)sm;
+  return false;
+#endif
+}
+
 bool SyncManager::sendPowerDiag(uint32_t bootCount, uint32_t brownoutCount,
                                 uint8_t lastResetReason, bool recoveryActive,
                                 uint32_t uptimeMs)
@@ -775,10 +904,11 @@ void SyncManager::onPacketReceived(const uint8_t *senderMac,
     {
       esp_now_peer_info_t peerInfo = {};
       memcpy(peerInfo.peer_addr, gatewayMac, 6);
-      peerInfo.channel = ESP_NOW_CHANNEL;
+      peerInfo.channel = radioChannel;
       peerInfo.encrypt = false;
       esp_now_add_peer(&peerInfo);
       pinEspNowPhyRate(gatewayMac); // Pin unicast to 802.11g 6 Mbps
+      mySlotPhyRate = TDMA_PHY_RATE_6M;
     }
 
     Serial.printf("[Sync] *** AUTO-DISCOVERED Gateway MAC: "
@@ -819,7 +949,7 @@ void SyncManager::onPacketReceived(const uint8_t *senderMac,
   {
     // RELAXED CHECK: Allow if at least expected size (12 bytes)
     // ESP-NOW might add padding or be larger than expected
-    if (len >= sizeof(TDMABeaconPacket))
+    if (len >= (int)TDMA_BEACON_MIN_LEN)
     {
       handleTDMABeacon(data, len);
     }
@@ -827,7 +957,7 @@ void SyncManager::onPacketReceived(const uint8_t *senderMac,
     {
       // Only log if it's actually too small (corruption/noise)
       Serial.printf("[Sync] Packet ignored: type=BEACON len=%d expected=%d\n",
-                    len, sizeof(TDMABeaconPacket));
+                    len, (int)TDMA_BEACON_MIN_LEN);
     }
   }
   else if (type == TDMA_PACKET_SCHEDULE)
@@ -877,6 +1007,11 @@ void SyncManager::onPacketReceived(const uint8_t *senderMac,
       {
         onMagCalibCallback(packet->cmdType, packet->param1);
       }
+      // Trace ring control (start / stop / dump to console)
+      else if (onMagCalibCallback && packet->cmdType == CMD_TRACE_CONTROL)
+      {
+        onMagCalibCallback(packet->cmdType, packet->param1);
+      }
       // Handle AUTO-RESOLVED NODE ID ASSIGNMENT
       else if (packet->cmdType == CMD_SET_NODE_ID)
       {
@@ -3,6 +3,7 @@
 
 #include "../libraries/IMUConnectCore/src/TDMAProtocol.h"
 #include "Config.h"
+#include "../libraries/IMUConnectCore/src/TraceRing.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_idf_version.h>
@@ -49,6 +50,7 @@ struct SyncPacket
 class SensorManager;
 class OTAManager;
 class PowerStateManager;
+class FlashBlackBox;
 
 // Callback type for OTA ACK response (Node -> Gateway)
 typedef std::function<void(const ESPNowOTAAckPacket &ack)> OTAAckCallback;
@@ -83,6 +85,7 @@ struct TDMAFrameBufferEntry
   uint8_t sensorCount;  // Sensors per sample
   uint8_t presentMask;  // Bit i set => sample index i present
   TDMABatchedSensorData samples[TDMA_SAMPLES_PER_FRAME][MAX_SENSORS];
+  NodeEnviroSample enviro; // Inline mag/baro reading (contents == 0: none)
 };
 
 struct TDMASampleBuffer
@@ -110,12 +113,19 @@ public:
   // Send Environmental data (Node mode)
   void sendEnviroData(SensorManager &sm);
 
+  // Queue fresh mag/baro readings (NODE_ENVIRO_HAS_* bits) to ride inline
+  // in the 0x26 packet of the next buffered IMU sample (Node mode, streaming)
+  void stageEnviroSample(SensorManager &sm, uint8_t fresh);
+
   // Send Node Info / Topology (Node mode)
   void sendNodeInfo(SensorManager &sm, const char *name);
 
   // Send Magnetometer calibration progress (Node mode)
   void sendMagCalibProgress(SensorManager &sm);
 
+  // Send IMU calibration progress (Node mode)
+  bool sendImuCalibProgress(SensorManager &sm);
+
   // Send one-shot power diagnostics (Node mode)
   bool sendPowerDiag(uint32_t bootCount, uint32_t brownoutCount,
                      uint8_t lastResetReason, bool recoveryActive,
@@ -144,6 +154,14 @@ public:
 
   // Set Buffer Policy (Live vs Recording)
   void setBufferPolicy(BufferPolicy policy) { currentBufferPolicy = policy; }
+  BufferPolicy getBufferPolicy() const { return currentBufferPolicy; }
+
+  // Attach flash black box (optional). Only used in POLICY_RECORDING.
+  void setBlackBox(FlashBlackBox *bb) { blackBox = bb; }
+
+  // True when RF-outage frames are being spilled to flash instead of dropped.
+  // Also relaxes the freewheel limit so capture continues through beacon loss.
+  bool isBlackBoxCapturing() const;
 
   // Set power state manager for including power state in TDMA registration
   void setPowerStateManager(PowerStateManager *mgr) { powerStateManager = mgr; }
@@ -203,6 +221,11 @@ public:
   // Send buffered samples in our assigned time slot
   void sendTDMAData();
 
+  // Send one historical frame from the flash black box if our slot still has
+  // idle time after the live frame. Returns true if a packet was queued.
+  bool sendBackfillData();
+  bool hasBackfillData() const;
+
   // Check if it's time to transmit (within our slot window)
   bool isInTransmitWindow() const;
 
@@ -250,6 +273,11 @@ public:
   // Get last known WiFi channel (for restoring after BLE events)
   uint8_t getLastKnownChannel() const { return lastKnownChannel; }
 
+  // Apply a Gateway-announced channel hop once its switch time arrives.
+  // Called every ProtocolTask tick (1ms) so the retune lands in the guard
+  // time of the last frame on the old channel.
+  void serviceChannelHop();
+
 private:
   SyncRole currentRole;
   uint32_t timeOffset; // Add this to micros() to get adjusted time
@@ -286,6 +314,7 @@ private:
                                      // check) — volatile for cross-core visibility
   uint16_t mySlotOffsetUs;           // Our assigned slot offset
   uint16_t mySlotWidthUs;            // Our assigned slot width
+  uint8_t mySlotPhyRate;             // TDMAPhyRate our Gateway peer is pinned to
   uint32_t lastRegistrationTime;     // When we last sent registration
   uint32_t registeredStateStartTime; // When we entered REGISTERED state (for
                                      // timeout)
@@ -333,6 +362,9 @@ private:
   uint32_t bufferedSampleFrameNumber;
   uint8_t nextSampleIndexInFrame;
 
+  // Mag/baro reading waiting for the next bufferSample() (syncStateLock)
+  NodeEnviroSample pendingEnviro = {};
+
   // Monotonic counter incremented on each received beacon
   uint32_t beaconSequence;
   uint32_t lastBufferedBeaconSequence;
@@ -369,8 +401,16 @@ private:
 
   // Channel scanning (for finding Gateway's WiFi channel)
   uint32_t channelScanStart;  // When we started scanning current channel
+  uint32_t listenStartMillis; // millis() when ESP-NOW started receiving
   uint8_t currentScanChannel; // Index into scan channel list
 
+  // Coordinated channel hop (announced in beacons, see TDMA_HOP_CHANNELS)
+  uint8_t radioChannel;       // Channel the radio + ESP-NOW peers are on
+  volatile bool hopPending;   // Guarded by syncStateLock
+  uint8_t hopChannel;         // Announced target channel
+  uint32_t hopSwitchAtUs;     // micros() to retune (guard time of last frame)
+  void tuneRadioChannel(uint8_t channel);
+
   // ============================================================================
   // ESP-NOW TX Pacing State (STABILITY FIX)
   // ============================================================================
@@ -382,6 +422,30 @@ private:
   uint32_t consecutiveSendFailures; // Consecutive failures for Zombie detection
   BufferPolicy currentBufferPolicy; // Policy for handling buffer overflows
 
+  // ============================================================================
+  // FLASH BLACK BOX: unACKed frame tracking
+  // ============================================================================
+  // sendTDMAData() pops a frame before esp_now_send(). If the MAC-layer ACK
+  // never arrives, that frame is gone. In POLICY_RECORDING we keep a copy of
+  // the in-flight frame and spill it to flash when the send callback reports
+  // failure (or the TX stall timeout fires).
+  // ============================================================================
+  enum InFlightKind : uint8_t
+  {
+    INFLIGHT_NONE = 0,
+    INFLIGHT_LIVE = 1,
+    INFLIGHT_BACKFILL = 2
+  };
+  FlashBlackBox *blackBox = nullptr;
+  TDMAFrameBufferEntry inFlightFrame;
+  volatile uint8_t inFlightKind = INFLIGHT_NONE;
+  uint32_t inFlightTailEpoch = 0; // BlackBoxCursor of the backfill frame
+  uint16_t inFlightRecord = 0;
+  volatile bool txCompletionPending = false; // Set by send callback
+  volatile bool txLastAcked = false;         // Result of last completed send
+  uint32_t lastBackfillFrame = 0xFFFFFFFF;   // One historical packet per frame
+  void resolveInFlightFrame();
+
   // Periodic TDMA transport diagnostics (delta counters between reports)
   uint32_t tdmaDiagLastReportMs = 0;
   uint16_t tdmaDiagTxAttempts = 0;
@@ -483,8 +547,10 @@ extern SyncManager syncManager;
 // Shared helper functions (used across SyncManager translation units)
 // ============================================================================
 
-// Pin ESP-NOW unicast peer to 802.11g 6 Mbps OFDM for deterministic TDMA slots
-void pinEspNowPhyRate(const uint8_t *peerMac);
+// Pin ESP-NOW unicast peer to a fixed 802.11g OFDM rate (default 6 Mbps) for
+// deterministic TDMA slots
+void pinEspNowPhyRate(const uint8_t *peerMac,
+                      uint8_t phyRate = TDMA_PHY_RATE_6M);
 
 // Build a TDMA data packet from buffered frame samples (keyframe-only)
 size_t buildTDMAPacket(uint8_t *packet,
@@ -493,6 +559,7 @@ size_t buildTDMAPacket(uint8_t *packet,
                        uint32_t frameNumber,
                        uint8_t nodeId, uint8_t syncProtocolVersion,
                        uint16_t lastRttUs, uint32_t timeSinceLastSync,
-                       bool twoWaySyncActive, uint8_t &samplesConsumed);
+                       bool twoWaySyncActive, uint8_t &samplesConsumed,
+                       const NodeEnviroSample *enviro = nullptr);
 
 #endif // SYNC_MANAGER_H
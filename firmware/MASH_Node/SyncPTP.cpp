@@ -113,6 +113,7 @@ void SyncManager::checkSyncHealth()
                     if (addResult == ESP_OK)
                     {
                         pinEspNowPhyRate(gatewayMac); // Pin unicast to 802.11g 6 Mbps
+                        mySlotPhyRate = TDMA_PHY_RATE_6M;
                     }
                     Serial.printf(
                         "[RECOVERY] Re-registered Gateway peer on ch %d (result: "
@@ -3,14 +3,27 @@
 // ============================================================================
 // Extracted from SyncManager.cpp for maintainability.
 // Contains: bufferSample, buildTDMAPacket, sendTDMAData, isInTransmitWindow,
-//           isTDMASynced
+//           isTDMASynced, sendBackfillData (flash black box)
 // ============================================================================
 #define DEVICE_ROLE DEVICE_ROLE_NODE
 
 #include "SyncManager.h"
+#include "FlashBlackBox.h"
+#include "../libraries/IMUConnectCore/src/NodeDataCodec.h"
 #include "SensorManager.h"
 #include "TimingGlobals.h"
 
+bool SyncManager::isBlackBoxCapturing() const
+{
+    return blackBox != nullptr && blackBox->isReady() &&
+           currentBufferPolicy == POLICY_RECORDING;
+}
+
+bool SyncManager::hasBackfillData() const
+{
+    return blackBox != nullptr && blackBox->hasBacklog();
+}
+
 // ============================================================================
 // BUFFER SAMPLE — Store IMU data into the deterministic frame queue
 // ============================================================================
@@ -99,13 +112,24 @@ bool SyncManager::bufferSample(SensorManager &sm)
     // it risks INT_WDT if the other core contends on the same lock.
     // ==========================================================================
 
+    // BLACK BOX: While recording with a flash black box attached, keep
+    // capturing through beacon loss for up to BLACKBOX_MAX_FREEWHEEL_FRAMES.
+    // The frames are spilled to flash and backfilled once the link returns.
+    const uint32_t framePeriodUs = TDMA_FRAME_PERIOD_MS * 1000;
+    const bool blackBoxCapturing = isBlackBoxCapturing();
+    const uint32_t maxFreewheelFrames =
+        blackBoxCapturing ? BLACKBOX_MAX_FREEWHEEL_FRAMES
+                          : 2; // Allow up to 2 missed beacons (40ms)
+    const uint32_t staleLimitUs =
+        blackBoxCapturing ? (maxFreewheelFrames + 1) * framePeriodUs : 1000000;
+
     // FIX: Acquire syncStateLock to read/freewheel sync state atomically.
     // handleBeacon() on Core 0 updates these same variables under this lock.
     portENTER_CRITICAL(&syncStateLock);
     uint32_t timeSinceBeacon = micros() - lastBeaconTime;
 
     // SANITY CHECK: If timeSinceBeacon is huge (>1 second), something is wrong
-    if (timeSinceBeacon > 1000000)
+    if (timeSinceBeacon > staleLimitUs)
     {
         uint32_t staleMs = timeSinceBeacon / 1000; // capture for log
         portEXIT_CRITICAL(&syncStateLock);
@@ -126,8 +150,6 @@ bool SyncManager::bufferSample(SensorManager &sm)
     // If we missed a beacon, advance frame/anchor in bounded steps to keep
     // timestamps and transmit windows consistent. If too many beacons missed,
     // stop buffering until a fresh beacon arrives.
-    const uint32_t framePeriodUs = TDMA_FRAME_PERIOD_MS * 1000;
-    const uint8_t maxFreewheelFrames = 2; // Allow up to 2 missed beacons (40ms)
     uint32_t freewheelFramesCaptured = 0; // For deferred logging OUTSIDE lock
 
     if (timeSinceBeacon > framePeriodUs)
@@ -297,7 +319,17 @@ bool SyncManager::bufferSample(SensorManager &sm)
         // Need a new frame entry
         if (frameQueueCount >= TDMA_FRAME_QUEUE_CAPACITY)
         {
-            if (currentBufferPolicy == POLICY_RECORDING)
+            if (blackBoxCapturing)
+            {
+                // Recording + black box: evict the OLDEST frame to flash
+                // instead of dropping the newest. Nothing is lost; the
+                // evicted frame is backfilled as historical data later.
+                blackBox->spill(frameQueue[frameQueueTail]);
+                frameQueueTail =
+                    (uint8_t)((frameQueueTail + 1) % TDMA_FRAME_QUEUE_CAPACITY);
+                frameQueueCount--;
+            }
+            else if (currentBufferPolicy == POLICY_RECORDING)
             {
                 // Recording: preserve queued history, drop new sample (frame not
                 // enqueued)
@@ -331,6 +363,7 @@ bool SyncManager::bufferSample(SensorManager &sm)
         frameQueue[insertIdx].presentMask = 0;
         memset(frameQueue[insertIdx].samples, 0,
                sizeof(frameQueue[insertIdx].samples));
+        frameQueue[insertIdx].enviro.contents = 0;
         entryIndex = (int)insertIdx;
     }
 
@@ -381,6 +414,18 @@ bool SyncManager::bufferSample(SensorManager &sm)
         }
     }
 
+    // A staged mag/baro reading rides with the IMU sample taken right
+    // after it. One reading per frame; a second one in the same frame
+    // (only possible with a >50Hz optional-sensor rate) replaces the first.
+    portENTER_CRITICAL(&syncStateLock);
+    if (pendingEnviro.contents != 0)
+    {
+        entry->enviro = pendingEnviro;
+        entry->enviro.sampleIndex = sampleIndex;
+        pendingEnviro.contents = 0;
+    }
+    portEXIT_CRITICAL(&syncStateLock);
+
     // Mark this sample index present; complete when all 4 indices present
     entry->presentMask |= (uint8_t)(1U << sampleIndex);
     bool result = ((entry->presentMask & allMask) == allMask);
@@ -464,7 +509,8 @@ size_t buildTDMAPacket(uint8_t *packet,
                        uint32_t frameNumber,
                        uint8_t nodeId, uint8_t syncProtocolVersion,
                        uint16_t lastRttUs, uint32_t timeSinceLastSync,
-                       bool twoWaySyncActive, uint8_t &samplesConsumed)
+                       bool twoWaySyncActive, uint8_t &samplesConsumed,
+                       const NodeEnviroSample *enviro)
 {
     if (frameSampleCount == 0 || frameSamples == nullptr)
     {
@@ -496,15 +542,34 @@ size_t buildTDMAPacket(uint8_t *packet,
     header->flags = NODE_DATA_FLAG_KEYFRAME;
 
     size_t destOffset = sizeof(TDMANodeDataPacket);
+    const size_t rawBlockBytes =
+        (size_t)samplesToSend * sensorCount * sizeof(TDMABatchedSensorData);
+
+    // Lossless delta/varint block (still a keyframe: no state across packets).
+    // Only used if strictly smaller than the raw block.
+    size_t compressedBytes = 0;
+#if TDMA_NODE_DATA_COMPRESSION
+    compressedBytes = encodeCompressedSamples(
+        packet + destOffset, rawBlockBytes - 1, &frameSamples[0][0],
+        samplesToSend, sensorCount, MAX_SENSORS);
+#endif
 
-    // All samples packed as keyframes (no delta encoding)
-    for (uint8_t s = 0; s < samplesToSend; s++)
+    if (compressedBytes > 0)
+    {
+        header->flags |= NODE_DATA_FLAG_COMPRESSED;
+        destOffset += compressedBytes;
+    }
+    else
     {
-        for (uint8_t sensor = 0; sensor < sensorCount; sensor++)
+        // All samples packed as keyframes (no delta encoding)
+        for (uint8_t s = 0; s < samplesToSend; s++)
         {
-            memcpy(packet + destOffset, &frameSamples[s][sensor],
-                   sizeof(TDMABatchedSensorData));
-            destOffset += sizeof(TDMABatchedSensorData);
+            for (uint8_t sensor = 0; sensor < sensorCount; sensor++)
+            {
+                memcpy(packet + destOffset, &frameSamples[s][sensor],
+                       sizeof(TDMABatchedSensorData));
+                destOffset += sizeof(TDMABatchedSensorData);
+            }
         }
     }
 
@@ -546,6 +611,14 @@ size_t buildTDMAPacket(uint8_t *packet,
         destOffset += sizeof(SyncQualityFlags);
     }
 
+    // Inline magnetometer/barometer reading (replaces the 0x04 packet)
+    if (enviro != nullptr && enviro->contents != 0)
+    {
+        header->flags |= NODE_DATA_FLAG_ENVIRO;
+        memcpy(packet + destOffset, enviro, sizeof(NodeEnviroSample));
+        destOffset += sizeof(NodeEnviroSample);
+    }
+
     // CRC
     uint8_t crc = calculateCRC8(packet, destOffset);
     packet[destOffset] = crc;
@@ -593,6 +666,8 @@ void SyncManager::sendTDMAData()
             sendFailCount++;
             tdmaDiagTxFail++;
             tdmaDiagTxStallClears++;
+            txCompletionPending = true; // Treat as NACK for the black box
+            txLastAcked = false;
             portEXIT_CRITICAL(&syncStateLock);
             static uint32_t lastStallLog = 0;
             if (millis() - lastStallLog > 2000)
@@ -608,6 +683,9 @@ void SyncManager::sendTDMAData()
         }
     }
 
+    // Spill the previous frame to flash if its TX was never ACKed
+    resolveInFlightFrame();
+
     const uint8_t allMask = (TDMA_SAMPLES_PER_FRAME >= 8)
                                 ? 0xFF
                                 : (uint8_t)((1U << TDMA_SAMPLES_PER_FRAME) - 1U);
@@ -699,7 +777,8 @@ void SyncManager::sendTDMAData()
         pipelinePacket, frameToSend.samples, TDMA_SAMPLES_PER_FRAME,
         frameToSend.sensorCount, frameToSend.frameNumber,
         nodeId, syncProtocolVersion,
-        lastRttUs, getTimeSinceLastSync(), isTwoWaySyncActive(), samplesConsumed);
+        lastRttUs, getTimeSinceLastSync(), isTwoWaySyncActive(), samplesConsumed,
+        frameToSend.enviro.contents != 0 ? &frameToSend.enviro : nullptr);
     uint32_t tBuild = micros() - tBuildStart;
     if (tBuild > g_packetBuildTimeMax)
         g_packetBuildTimeMax = tBuild;
@@ -709,11 +788,21 @@ void SyncManager::sendTDMAData()
         return;
     }
 
+    // Keep a copy while recording so an unACKed frame can go to flash
+    const bool trackInFlight = isBlackBoxCapturing();
+    if (trackInFlight)
+    {
+        inFlightFrame = frameToSend;
+    }
+
     portENTER_CRITICAL(&syncStateLock);
     tdmaDiagTxAttempts++;
     txPending = true;
     g_txStartTime = micros();
+    txCompletionPending = false;
+    inFlightKind = trackInFlight ? INFLIGHT_LIVE : INFLIGHT_NONE;
     portEXIT_CRITICAL(&syncStateLock);
+    TRACE_EVENT(TRACE_EV_NODE_TX, TRACE_INSTANT, packetSize);
     esp_err_t sendResult = esp_now_send(gatewayMac, pipelinePacket, packetSize);
     if (sendResult != ESP_OK)
     {
@@ -727,6 +816,8 @@ void SyncManager::sendTDMAData()
         consecutiveSendFailures++; // EXPERT REVIEW FIX: Track synchronous failures
                                    // too
         tdmaDiagTxFail++;
+        txCompletionPending = true; // Treat as NACK for the black box
+        txLastAcked = false;
         portEXIT_CRITICAL(&syncStateLock);
         static uint32_t lastSendErrLog = 0;
         if (millis() - lastSendErrLog > 2000)
@@ -748,3 +839,148 @@ void SyncManager::sendTDMAData()
     }
 #endif
 }
+
+// ============================================================================
+// FLASH BLACK BOX — in-flight resolution and historical backfill
+// ============================================================================
+// resolveInFlightFrame(): called before every send. Consumes the completion
+// published by onEspNowSent() and either spills the unACKed live frame to
+// flash, or retires the backfilled frame that the Gateway just ACKed.
+//
+// A lost ACK (Gateway received the frame but the ACK was corrupted) produces a
+// duplicate historical frame. The Gateway records both in its session;
+// session_tool.py keeps one sample per (nodeId, sensor, sample time).
+// ============================================================================
+void SyncManager::resolveInFlightFrame()
+{
+    bool completed = false;
+    bool acked = false;
+    uint8_t kind = INFLIGHT_NONE;
+
+    portENTER_CRITICAL(&syncStateLock);
+    completed = txCompletionPending;
+    acked = txLastAcked;
+    kind = inFlightKind;
+    if (completed)
+    {
+        txCompletionPending = false;
+        inFlightKind = INFLIGHT_NONE;
+    }
+    portEXIT_CRITICAL(&syncStateLock);
+
+    if (!completed || kind == INFLIGHT_NONE || blackBox == nullptr)
+        return;
+
+    if (kind == INFLIGHT_LIVE && !acked &&
+        currentBufferPolicy == POLICY_RECORDING)
+    {
+        blackBox->spill(inFlightFrame);
+    }
+    else if (kind == INFLIGHT_BACKFILL && acked)
+    {
+        BlackBoxCursor cursor = {inFlightTailEpoch, inFlightRecord};
+        blackBox->consumeOldest(cursor);
+    }
+}
+
+// ============================================================================
+// BACKFILL TRANSMISSION (ProtocolTask, inside our own slot only)
+// ============================================================================
+// Trickles at most ONE historical frame per TDMA frame, and only when:
+//   - the live queue has nothing complete to send (live data always wins)
+//   - the previous TX completed and was ACKed (link proven healthy)
+//   - enough of our slot remains for a full packet (never spill into the
+//     next node's slot or the beacon guard)
+// ============================================================================
+bool SyncManager::sendBackfillData()
+{
+#if DEVICE_ROLE == DEVICE_ROLE_NODE
+    if (blackBox == nullptr || !blackBox->hasBacklog())
+        return false;
+
+    bool localTxPending = false;
+    uint32_t capturedFrame = 0;
+    uint32_t capturedBeaconTime = 0;
+    portENTER_CRITICAL(&syncStateLock);
+    localTxPending = txPending;
+    capturedFrame = currentFrameNumber;
+    capturedBeaconTime = lastBeaconTime;
+    portEXIT_CRITICAL(&syncStateLock);
+
+    if (localTxPending)
+        return false;
+
+    resolveInFlightFrame();
+
+    if (consecutiveSendFailures > 0 || capturedFrame == lastBackfillFrame)
+        return false;
+
+    // Remaining idle time in our slot (same virtual-frame math as
+    // isInTransmitWindow)
+    const uint32_t framePeriodUs = TDMA_FRAME_PERIOD_MS * 1000;
+    uint32_t timeInFrame = (micros() - capturedBeaconTime) % framePeriodUs;
+    uint32_t slotEndUs = (uint32_t)mySlotOffsetUs + mySlotWidthUs;
+    const uint32_t guardZoneStartUs = framePeriodUs - TDMA_GUARD_TIME_US;
+    if (slotEndUs > guardZoneStartUs)
+        slotEndUs = guardZoneStartUs;
+    if (timeInFrame + BLACKBOX_BACKFILL_MIN_WINDOW_US > slotEndUs)
+        return false;
+
+    TDMAFrameBufferEntry frame;
+    BlackBoxCursor cursor;
+    if (!blackBox->peekOldest(frame, cursor))
+        return false;
+
+    if (frame.sensorCount == 0 || frame.sensorCount > MAX_SENSORS)
+    {
+        blackBox->consumeOldest(cursor); // Corrupt record — skip it
+        return false;
+    }
+
+    // Historical frames carry no sync-quality block: the PTP state at replay
+    // time says nothing about the state at capture time. Their mag/baro
+    // reading is dropped too — the Gateway only merges enviro into live
+    // sync frames.
+    uint8_t samplesConsumed = 0;
+    size_t packetSize = buildTDMAPacket(
+        pipelinePacket, frame.samples, TDMA_SAMPLES_PER_FRAME,
+        frame.sensorCount, frame.frameNumber, nodeId,
+        SYNC_PROTOCOL_VERSION_LEGACY, 0, 0, false, samplesConsumed);
+    if (packetSize == 0)
+    {
+        blackBox->consumeOldest(cursor);
+        return false;
+    }
+
+    TDMANodeDataPacket *header = (TDMANodeDataPacket *)pipelinePacket;
+    header->flags |= NODE_DATA_FLAG_HISTORICAL;
+    header->reserved = frame.presentMask;
+    pipelinePacket[packetSize - 1] =
+        calculateCRC8(pipelinePacket, packetSize - 1);
+
+    portENTER_CRITICAL(&syncStateLock);
+    txPending = true;
+    g_txStartTime = micros();
+    txCompletionPending = false;
+    inFlightKind = INFLIGHT_BACKFILL;
+    inFlightTailEpoch = cursor.tailEpoch;
+    inFlightRecord = cursor.record;
+    portEXIT_CRITICAL(&syncStateLock);
+
+    lastBackfillFrame = capturedFrame;
+    TRACE_EVENT(TRACE_EV_NODE_TX, TRACE_INSTANT, packetSize);
+    esp_err_t sendResult = esp_now_send(gatewayMac, pipelinePacket, packetSize);
+    if (sendResult != ESP_OK)
+    {
+        portENTER_CRITICAL(&syncStateLock);
+        txPending = false;
+        g_txStartTime = 0;
+        inFlightKind = INFLIGHT_NONE; // Frame stays at the ring tail
+        portEXIT_CRITICAL(&syncStateLock);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,932 @@
+/*******************************************************************************
+ * ColumnarSession.h - Columnar chunked session files for recorded sync streams
+ *
+ * A raw capture (USB dump, sNNNN.msr, webapp export) has to be parsed from
+ * the start to reach minute 40. A columnar session (.mcol) stores the same
+ * 0x25 data as one compressed column per field, per sensor, per
+ * fixed-duration chunk, with an index at the end, so a job reads only the
+ * chunks and columns it asks for.
+ *
+ * File layout (little-endian):
+ *   [ColumnarFileHeader]
+ *   chunk 0: [column data of every block][ColumnarBlockEntry x blockCount]
+ *   chunk 1: ...
+ *   [ColumnarChunkEntry x chunkCount]                   index
+ *   [ColumnarTrailer]                                   last 40 bytes
+ *
+ * Time is session time: microseconds since the first IMU record, unwrapped
+ * from the 32-bit Gateway timestamp. Chunk k holds the rows whose session
+ * time falls in [k * chunkDurationUs, (k+1) * chunkDurationUs); empty
+ * windows have no chunk. A stream restart (timestamp jumping back) carries
+ * on one sample period after the last row and flags the chunk.
+ *
+ * A block is one sensor's rows in one chunk (kind IMU or enviro). Each of
+ * its columns is a run of int32 values coded as varint(zigzag(d[i])) with
+ * the NodeDataCodec.h primitives, in the column order below. d is the
+ * delta v[i] - v[i-1] (v[-1] = 0); time and frame advance by a near
+ * constant step, so they store the delta of that delta instead and cost a
+ * byte per row. The block entry carries each
+ * column's byte length and min/max/sum, so some questions (peak
+ * acceleration, which chunks saw a sensor) need no column data at all.
+ *
+ * Gap fill: a SYNC_SENSOR_FLAG_CORRECTION record replaces the synthesized
+ * row it points at (flags become VALID) as long as that row's chunk is still
+ * open. Chunks stay open COLUMNAR_CORRECTION_GRACE_US past their end, which
+ * covers the largest framesBack, so no correction is lost on a healthy
+ * stream.
+ *
+ * Writer: ColumnarSessionWriter is a SyncStreamDecoder sink. It holds only
+ * the open chunks and one index entry per written chunk, whatever the
+ * session length. Reader: ColumnarSessionReader maps the file and decodes
+ * on demand.
+ *
+ * Tool: mash_columnar.cpp (convert / info / extract / verify).
+ ******************************************************************************/
+
+#ifndef COLUMNAR_SESSION_H
+#define COLUMNAR_SESSION_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "NodeDataCodec.h" // zigzag / varint
+#include "SyncStreamDecoder.h"
+
+#define COLUMNAR_MAGIC 0x4C4F434D         // "MCOL"
+#define COLUMNAR_TRAILER_MAGIC 0x584E4943 // "CINX"
+#define COLUMNAR_VERSION 1
+
+#define COLUMNAR_DEFAULT_CHUNK_US 5000000 // 5s: ~1000 rows per IMU block
+#define COLUMNAR_MAX_CHUNK_US 600000000   // Column times are int32 offsets
+#define COLUMNAR_SAMPLE_PERIOD_US 5000    // 200Hz sync frames
+#define COLUMNAR_RESTART_US 1000000       // Timestamp this far back: restart
+// Longest a correction can trail its frame (framesBack is a uint8_t)
+#define COLUMNAR_CORRECTION_GRACE_US (255 * COLUMNAR_SAMPLE_PERIOD_US)
+
+#define COLUMNAR_KIND_IMU 0
+#define COLUMNAR_KIND_ENVIRO 1
+
+// Columns of an IMU block
+#define COLUMNAR_COL_TIME 0  // µs since chunk start
+#define COLUMNAR_COL_FRAME 1 // SyncFramePacket.frameNumber
+#define COLUMNAR_COL_FLAGS 2 // SYNC_SENSOR_FLAG_*
+#define COLUMNAR_COL_AX 3    // Wire units: m/s^2 x 100, rad/s x 900
+#define COLUMNAR_COL_AY 4
+#define COLUMNAR_COL_AZ 5
+#define COLUMNAR_COL_GX 6
+#define COLUMNAR_COL_GY 7
+#define COLUMNAR_COL_GZ 8
+#define COLUMNAR_IMU_COLUMNS 9
+
+// Columns of an enviro block (time and frame as above)
+#define COLUMNAR_COL_CONTENTS 2 // NODE_ENVIRO_HAS_*
+#define COLUMNAR_COL_MX 3       // 0.1 µT
+#define COLUMNAR_COL_MY 4
+#define COLUMNAR_COL_MZ 5
+#define COLUMNAR_COL_PRESSURE 6 // 0.01 Pa
+#define COLUMNAR_COL_TEMP 7     // 0.01 °C
+#define COLUMNAR_ENVIRO_COLUMNS 8
+
+#define COLUMNAR_MAX_COLUMNS 9
+
+// Chunk flags
+#define COLUMNAR_CHUNK_FLAG_RESTART 0x01 // Timestamps restarted in this chunk
+
+struct __attribute__((packed)) ColumnarFileHeader
+{
+  uint32_t magic; // COLUMNAR_MAGIC
+  uint16_t version;
+  uint16_t headerSize;
+  uint32_t chunkDurationUs;
+  uint32_t firstTimestampUs; // Gateway time of session time 0
+  uint32_t firstFrame;
+  uint8_t reserved[12];
+};
+
+struct __attribute__((packed)) ColumnarColumnStats
+{
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+};
+
+struct __attribute__((packed)) ColumnarBlockEntry
+{
+  uint8_t sensorId;
+  uint8_t kind; // COLUMNAR_KIND_*
+  uint8_t columnCount;
+  uint8_t rawNodeId;
+  uint32_t rows;
+  uint64_t offset; // File offset of the first column
+  uint32_t columnBytes[COLUMNAR_MAX_COLUMNS];
+  ColumnarColumnStats stats[COLUMNAR_MAX_COLUMNS];
+  uint32_t interpolatedRows; // Still synthesized (never corrected)
+  uint32_t reserved;
+};
+
+struct __attribute__((packed)) ColumnarChunkEntry
+{
+  uint64_t startUs; // Window start, session time
+  uint64_t firstUs; // First / last row, session time
+  uint64_t lastUs;
+  uint32_t firstFrame;
+  uint32_t lastFrame;
+  uint64_t dataOffset;      // First column of the first block
+  uint64_t directoryOffset; // ColumnarBlockEntry x blockCount
+  uint32_t crc32;           // Column data + directory
+  uint16_t blockCount;
+  uint16_t flags; // COLUMNAR_CHUNK_FLAG_*
+  uint8_t sensorMask[SESSION_SENSOR_MASK_BYTES]; // IMU sensor IDs present
+};
+
+struct __attribute__((packed)) ColumnarTrailer
+{
+  uint64_t indexOffset;
+  uint32_t chunkCount;
+  uint32_t indexCrc32;
+  uint64_t rows;
+  uint32_t correctionsApplied;
+  uint32_t correctionsLost;
+  uint32_t lateRows; // Arrived after their chunk was written
+  uint32_t magic;    // COLUMNAR_TRAILER_MAGIC
+};
+
+static_assert(sizeof(ColumnarFileHeader) == 32,
+              "ColumnarFileHeader must be exactly 32 bytes (packed)!");
+static_assert(sizeof(ColumnarBlockEntry) == 204,
+              "ColumnarBlockEntry must be exactly 204 bytes (packed)!");
+static_assert(sizeof(ColumnarChunkEntry) == 88,
+              "ColumnarChunkEntry must be exactly 88 bytes (packed)!");
+static_assert(sizeof(ColumnarTrailer) == 40,
+              "ColumnarTrailer must be exactly 40 bytes (packed)!");
+
+inline uint8_t columnarColumnCount(uint8_t kind)
+{
+  return kind == COLUMNAR_KIND_IMU ? COLUMNAR_IMU_COLUMNS
+                                   : COLUMNAR_ENVIRO_COLUMNS;
+}
+
+// Physical units per stored unit (m/s^2, rad/s, µT, Pa, °C); 1 for
+// time, frame and flag columns
+inline double columnarScale(uint8_t kind, uint8_t column)
+{
+  if (kind == COLUMNAR_KIND_IMU)
+  {
+    if (column >= COLUMNAR_COL_AX && column <= COLUMNAR_COL_AZ)
+      return 1.0 / SYNC_FRAME_ACCEL_LSB_PER_MS2;
+    if (column >= COLUMNAR_COL_GX && column <= COLUMNAR_COL_GZ)
+      return 1.0 / SYNC_FRAME_GYRO_LSB_PER_RADS;
+    return 1.0;
+  }
+  if (column >= COLUMNAR_COL_MX && column <= COLUMNAR_COL_MZ)
+    return 0.1;
+  if (column == COLUMNAR_COL_PRESSURE || column == COLUMNAR_COL_TEMP)
+    return 0.01;
+  return 1.0;
+}
+
+// Time and frame columns are delta-of-delta coded
+inline bool columnarSecondOrder(uint8_t column)
+{
+  return column == COLUMNAR_COL_TIME || column == COLUMNAR_COL_FRAME;
+}
+
+// Encode n values into dst (n * NODE_DATA_VARINT_MAX_BYTES bytes); returns
+// the bytes written
+inline size_t columnarEncodeColumn(const int32_t *v, size_t n,
+                                   bool secondOrder, uint8_t *dst)
+{
+  size_t offset = 0;
+  uint32_t prev = 0;
+  uint32_t step = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    uint32_t d = (uint32_t)v[i] - prev;
+    prev = (uint32_t)v[i];
+    if (secondOrder)
+    {
+      const uint32_t dd = d - step;
+      step = d;
+      d = dd;
+    }
+    writeVarint32(dst, n * NODE_DATA_VARINT_MAX_BYTES, offset,
+                  zigzagEncode32((int32_t)d));
+  }
+  return offset;
+}
+
+// Decode one column of rows values. false if the data is short or corrupt.
+inline bool columnarDecodeColumn(const uint8_t *src, size_t len, uint32_t rows,
+                                 bool secondOrder, int32_t *out)
+{
+  size_t offset = 0;
+  uint32_t prev = 0;
+  uint32_t step = 0;
+  for (uint32_t i = 0; i < rows; i++)
+  {
+    uint32_t z;
+    if (!readVarint32(src, len, offset, z))
+      return false;
+    uint32_t d = (uint32_t)zigzagDecode32(z);
+    if (secondOrder)
+    {
+      step += d;
+      d = step;
+    }
+    prev += d;
+    out[i] = (int32_t)prev;
+  }
+  return offset == len;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+class ColumnarSessionWriter
+{
+public:
+  explicit ColumnarSessionWriter(
+      FILE *file, uint32_t chunkDurationUs = COLUMNAR_DEFAULT_CHUNK_US)
+      : out(file), durationUs(chunkDurationUs)
+  {
+    if (durationUs == 0 || durationUs > COLUMNAR_MAX_CHUNK_US)
+      durationUs = COLUMNAR_DEFAULT_CHUNK_US;
+    memset(&header, 0, sizeof(header));
+    memset(&trailer, 0, sizeof(trailer));
+    writeOffset = 0;
+    started = false;
+    failed = false;
+    latestUs = 0;
+    restartPending = false;
+    sealedWindows = 0;
+    // Header is rewritten by finish() once the first row is known
+    write(&header, sizeof(header));
+  }
+
+  ~ColumnarSessionWriter()
+  {
+    for (size_t k = 0; k < open.size(); k++)
+      delete open[k];
+    for (size_t k = 0; k < spare.size(); k++)
+      delete spare[k];
+  }
+
+  // SyncStreamDecoder sink
+  void operator()(const SyncImuBatch &imu, const SyncEnviroBatch &env)
+  {
+    for (size_t i = 0; i < imu.count; i++)
+    {
+      if (imu.flags[i] & SYNC_SENSOR_FLAG_CORRECTION)
+        applyCorrection(imu, i);
+      else
+        addImu(imu, i);
+    }
+    for (size_t i = 0; i < env.count; i++)
+      addEnviro(env, i);
+    // Write every chunk no correction can reach any more
+    while (!open.empty() &&
+           open.front()->startUs + durationUs + COLUMNAR_CORRECTION_GRACE_US <=
+               latestUs)
+      seal();
+  }
+
+  // Write the remaining chunks, the index and the trailer. false on any
+  // write error since construction.
+  bool finish()
+  {
+    while (!open.empty())
+      seal();
+    trailer.indexOffset = writeOffset;
+    trailer.chunkCount = (uint32_t)index.size();
+    trailer.indexCrc32 =
+        crc.compute((const uint8_t *)index.data(),
+                    index.size() * sizeof(ColumnarChunkEntry));
+    trailer.magic = COLUMNAR_TRAILER_MAGIC;
+    write(index.data(), index.size() * sizeof(ColumnarChunkEntry));
+    write(&trailer, sizeof(trailer));
+
+    header.magic = COLUMNAR_MAGIC;
+    header.version = COLUMNAR_VERSION;
+    header.headerSize = sizeof(header);
+    header.chunkDurationUs = durationUs;
+    if (fseek(out, 0, SEEK_SET) != 0 ||
+        fwrite(&header, sizeof(header), 1, out) != 1 || fflush(out) != 0)
+      failed = true;
+    return !failed;
+  }
+
+  const ColumnarTrailer &getTrailer() const { return trailer; }
+  size_t getChunkCount() const { return index.size(); }
+  uint64_t getBytesWritten() const { return writeOffset; }
+
+private:
+  // One sensor's rows of an open chunk
+  struct Series
+  {
+    uint8_t sensorId;
+    uint8_t kind;
+    uint8_t rawNodeId;
+    std::vector<int32_t> col[COLUMNAR_MAX_COLUMNS];
+
+    size_t rows() const { return col[COLUMNAR_COL_TIME].size(); }
+  };
+
+  struct OpenChunk
+  {
+    uint64_t window;
+    uint64_t startUs;
+    ColumnarChunkEntry entry;
+    std::vector<Series> series; // Kept across reuse: capacity stays
+    size_t seriesUsed;
+    int16_t lookup[2][256]; // (kind, sensorId) -> series index, -1 none
+
+    void begin(uint64_t w, uint32_t duration)
+    {
+      window = w;
+      startUs = w * duration;
+      memset(&entry, 0, sizeof(entry));
+      entry.startUs = startUs;
+      entry.firstUs = UINT64_MAX;
+      seriesUsed = 0;
+      memset(lookup, 0xFF, sizeof(lookup));
+    }
+
+    Series &get(uint8_t kind, uint8_t sensorId, uint8_t rawNodeId)
+    {
+      int16_t &slot = lookup[kind][sensorId];
+      if (slot < 0)
+      {
+        if (seriesUsed == series.size())
+          series.push_back(Series());
+        Series &s = series[seriesUsed];
+        s.sensorId = sensorId;
+        s.kind = kind;
+        s.rawNodeId = rawNodeId;
+        for (int c = 0; c < COLUMNAR_MAX_COLUMNS; c++)
+          s.col[c].clear();
+        slot = (int16_t)seriesUsed++;
+      }
+      return series[slot];
+    }
+
+    void note(uint64_t timeUs, uint32_t frame)
+    {
+      if (entry.firstUs == UINT64_MAX)
+      {
+        entry.firstUs = timeUs;
+        entry.firstFrame = frame;
+      }
+      if (timeUs >= entry.lastUs)
+      {
+        entry.lastUs = timeUs;
+        entry.lastFrame = frame;
+      }
+      if (timeUs < entry.firstUs)
+        entry.firstUs = timeUs;
+    }
+  };
+
+  FILE *out;
+  uint32_t durationUs;
+  ColumnarFileHeader header;
+  ColumnarTrailer trailer;
+  uint64_t writeOffset;
+  bool started;
+  bool failed;
+
+  // Timestamp unwrapping (IMU rows drive it; enviro rows follow)
+  uint32_t refTs;
+  uint64_t refUs;
+  uint64_t latestUs;
+  bool restartPending;
+
+  std::deque<OpenChunk *> open; // Ascending window
+  uint64_t sealedWindows;       // Windows below this are written
+  std::vector<OpenChunk *> spare;
+  std::vector<ColumnarChunkEntry> index;
+  std::vector<uint8_t> encoded;
+  std::vector<ColumnarBlockEntry> directory;
+  SyncCrc32 crc;
+
+  void write(const void *data, size_t len)
+  {
+    if (len > 0 && fwrite(data, 1, len, out) != len)
+      failed = true;
+    writeOffset += len;
+  }
+
+  // Session time of an IMU row, advancing the reference
+  uint64_t imuTime(uint32_t ts, uint32_t frame)
+  {
+    if (!started)
+    {
+      started = true;
+      header.firstTimestampUs = ts;
+      header.firstFrame = frame;
+      refTs = ts;
+      refUs = 0;
+      return 0;
+    }
+    const int32_t delta = (int32_t)(ts - refTs);
+    if (delta >= 0)
+    {
+      refUs += (uint32_t)delta;
+    }
+    else if (delta < -COLUMNAR_RESTART_US)
+    {
+      refUs += COLUMNAR_SAMPLE_PERIOD_US;
+      restartPending = true;
+    }
+    else
+    {
+      // Slightly older row: place it, keep the reference
+      const uint32_t back = (uint32_t)-delta;
+      return refUs > back ? refUs - back : 0;
+    }
+    refTs = ts;
+    if (refUs > latestUs)
+      latestUs = refUs;
+    return refUs;
+  }
+
+  // Open chunk for a session time, or NULL if it was already written
+  OpenChunk *chunkFor(uint64_t timeUs)
+  {
+    const uint64_t w = timeUs / durationUs;
+    if (w < sealedWindows)
+      return NULL;
+    size_t k = open.size();
+    while (k > 0 && open[k - 1]->window > w)
+      k--;
+    if (k > 0 && open[k - 1]->window == w)
+      return open[k - 1];
+    OpenChunk *c;
+    if (!spare.empty())
+    {
+      c = spare.back();
+      spare.pop_back();
+    }
+    else
+    {
+      c = new OpenChunk();
+    }
+    c->begin(w, durationUs);
+    open.insert(open.begin() + k, c);
+    return c;
+  }
+
+  void addImu(const SyncImuBatch &imu, size_t i)
+  {
+    const uint64_t t = imuTime(imu.timestampUs[i], imu.frameNumber[i]);
+    OpenChunk *c = chunkFor(t);
+    if (!c)
+    {
+      trailer.lateRows++;
+      return;
+    }
+    if (restartPending)
+    {
+      c->entry.flags |= COLUMNAR_CHUNK_FLAG_RESTART;
+      restartPending = false;
+    }
+    c->note(t, imu.frameNumber[i]);
+    c->entry.sensorMask[imu.sensorId[i] >> 3] |=
+        (uint8_t)(1u << (imu.sensorId[i] & 7));
+    Series &s = c->get(COLUMNAR_KIND_IMU, imu.sensorId[i], imu.rawNodeId[i]);
+    s.col[COLUMNAR_COL_TIME].push_back((int32_t)(t - c->startUs));
+    s.col[COLUMNAR_COL_FRAME].push_back((int32_t)imu.frameNumber[i]);
+    s.col[COLUMNAR_COL_FLAGS].push_back(imu.flags[i]);
+    for (int k = 0; k < SYNC_COL_COUNT; k++)
+      s.col[COLUMNAR_COL_AX + k].push_back(imu.raw[k][i]);
+    trailer.rows++;
+  }
+
+  void addEnviro(const SyncEnviroBatch &env, size_t i)
+  {
+    if (!started)
+    {
+      trailer.lateRows++; // No time base before the first IMU row
+      return;
+    }
+    const int64_t t = (int64_t)refUs + (int32_t)(env.timestampUs[i] - refTs);
+    OpenChunk *c = t >= 0 ? chunkFor((uint64_t)t) : NULL;
+    if (!c)
+    {
+      trailer.lateRows++;
+      return;
+    }
+    c->note((uint64_t)t, env.frameNumber[i]);
+    Series &s =
+        c->get(COLUMNAR_KIND_ENVIRO, env.sensorId[i], env.rawNodeId[i]);
+    s.col[COLUMNAR_COL_TIME].push_back((int32_t)((uint64_t)t - c->startUs));
+    s.col[COLUMNAR_COL_FRAME].push_back((int32_t)env.frameNumber[i]);
+    s.col[COLUMNAR_COL_CONTENTS].push_back(env.contents[i]);
+    // Back to the wire units the batch converted from
+    for (int k = 0; k < 3; k++)
+      s.col[COLUMNAR_COL_MX + k].push_back(
+          (int32_t)lround(env.mag[k][i] * 10.0));
+    s.col[COLUMNAR_COL_PRESSURE].push_back(
+        (int32_t)(uint32_t)llround(env.pressurePa[i] * 100.0));
+    s.col[COLUMNAR_COL_TEMP].push_back(
+        (int32_t)lround(env.temperatureC[i] * 100.0));
+    trailer.rows++;
+  }
+
+  // Overwrite the synthesized row the correction points at, newest chunk
+  // first. Rows of one sensor are in frame order, so the search walks
+  // back at most framesBack rows per chunk.
+  void applyCorrection(const SyncImuBatch &imu, size_t i)
+  {
+    const uint32_t target = imu.frameNumber[i] - imu.aux[i];
+    for (size_t k = open.size(); k-- > 0;)
+    {
+      OpenChunk *c = open[k];
+      const int16_t slot = c->lookup[COLUMNAR_KIND_IMU][imu.sensorId[i]];
+      if (slot < 0)
+        continue;
+      Series &s = c->series[slot];
+      std::vector<int32_t> &frames = s.col[COLUMNAR_COL_FRAME];
+      // Starts after the target: an older chunk has it (frame numbers
+      // restart with the stream, so not across a restart)
+      if (!(c->entry.flags & COLUMNAR_CHUNK_FLAG_RESTART) &&
+          (int32_t)((uint32_t)frames[0] - target) > 0)
+        continue;
+      for (size_t r = frames.size(); r-- > 0;)
+      {
+        const int32_t back = (int32_t)((uint32_t)frames[r] - target);
+        if (back < 0)
+          break;
+        if (back == 0)
+        {
+          s.col[COLUMNAR_COL_FLAGS][r] = SYNC_SENSOR_FLAG_VALID;
+          for (int ax = 0; ax < SYNC_COL_COUNT; ax++)
+            s.col[COLUMNAR_COL_AX + ax][r] = imu.raw[ax][i];
+          trailer.correctionsApplied++;
+          return;
+        }
+      }
+    }
+    trailer.correctionsLost++;
+  }
+
+  // Encode and write the oldest open chunk
+  void seal()
+  {
+    OpenChunk *c = open.front();
+    open.pop_front();
+    sealedWindows = c->window + 1;
+
+    ColumnarChunkEntry &e = c->entry;
+    e.dataOffset = writeOffset;
+    directory.clear();
+    uint32_t crc32 = 0;
+    for (size_t si = 0; si < c->seriesUsed; si++)
+    {
+      const Series &s = c->series[si];
+      ColumnarBlockEntry b;
+      memset(&b, 0, sizeof(b));
+      b.sensorId = s.sensorId;
+      b.kind = s.kind;
+      b.columnCount = columnarColumnCount(s.kind);
+      b.rawNodeId = s.rawNodeId;
+      b.rows = (uint32_t)s.rows();
+      b.offset = writeOffset;
+      for (uint8_t col = 0; col < b.columnCount; col++)
+      {
+        encodeColumn(s.col[col], columnarSecondOrder(col), b.stats[col]);
+        b.columnBytes[col] = (uint32_t)encoded.size();
+        crc32 = crc.compute(encoded.data(), encoded.size(), crc32);
+        write(encoded.data(), encoded.size());
+      }
+      if (s.kind == COLUMNAR_KIND_IMU)
+      {
+        for (size_t r = 0; r < s.rows(); r++)
+          b.interpolatedRows +=
+              (s.col[COLUMNAR_COL_FLAGS][r] & SYNC_SENSOR_FLAG_INTERPOLATED)
+                  ? 1
+                  : 0;
+      }
+      directory.push_back(b);
+    }
+    e.directoryOffset = writeOffset;
+    e.blockCount = (uint16_t)directory.size();
+    const size_t dirBytes = directory.size() * sizeof(ColumnarBlockEntry);
+    e.crc32 = crc.compute((const uint8_t *)directory.data(), dirBytes, crc32);
+    write(directory.data(), dirBytes);
+    index.push_back(e);
+    spare.push_back(c);
+  }
+
+  void encodeColumn(const std::vector<int32_t> &v, bool secondOrder,
+                    ColumnarColumnStats &st)
+  {
+    encoded.resize(v.size() * NODE_DATA_VARINT_MAX_BYTES);
+    encoded.resize(
+        columnarEncodeColumn(v.data(), v.size(), secondOrder, encoded.data()));
+    st.min = v.empty() ? 0 : v[0];
+    st.max = st.min;
+    st.sum = 0;
+    for (size_t i = 0; i < v.size(); i++)
+    {
+      st.min = v[i] < st.min ? v[i] : st.min;
+      st.max = v[i] > st.max ? v[i] : st.max;
+      st.sum += v[i];
+    }
+  }};
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+// Rows of one block within a query's time range. col[c] is filled for the
+// requested columns only.
+struct ColumnarRows
+{
+  const ColumnarChunkEntry *chunk;
+  const ColumnarBlockEntry *block;
+  size_t count;
+  std::vector<uint64_t> timeUs; // Session time
+  std::vector<int32_t> col[COLUMNAR_MAX_COLUMNS];
+};
+
+struct ColumnarQuery
+{
+  uint64_t fromUs; // Session time range [fromUs, toUs)
+  uint64_t toUs;
+  int sensorId;     // -1: every sensor
+  uint8_t kind;     // COLUMNAR_KIND_*
+  uint32_t columns; // Bit per column; time is always decoded
+  bool verifyCrc;   // Check each touched chunk's CRC first
+
+  ColumnarQuery()
+      : fromUs(0), toUs(UINT64_MAX), sensorId(-1), kind(COLUMNAR_KIND_IMU),
+        columns(0xFFFFFFFFu), verifyCrc(false)
+  {
+  }
+};
+
+class ColumnarSessionReader
+{
+public:
+  ColumnarSessionReader() : base(NULL), size(0), trailer(NULL), chunks(NULL)
+  {
+#if defined(_WIN32)
+    fileHandle = INVALID_HANDLE_VALUE;
+    mapHandle = NULL;
+#endif
+    bytesDecoded = 0;
+  }
+  ~ColumnarSessionReader() { close(); }
+
+  // Map a file and check header, trailer and index. false if it is not a
+  // complete columnar session.
+  bool open(const char *path)
+  {
+    close();
+#if defined(_WIN32)
+    fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(fileHandle, &len) || len.QuadPart == 0)
+    {
+      close();
+      return false;
+    }
+    size = (size_t)len.QuadPart;
+    mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapHandle)
+    {
+      close();
+      return false;
+    }
+    base = (const uint8_t *)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    size = (size_t)st.st_size;
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    base = p == MAP_FAILED ? NULL : (const uint8_t *)p;
+#endif
+    if (!base || !validate())
+    {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close()
+  {
+#if defined(_WIN32)
+    if (base)
+      UnmapViewOfFile(base);
+    if (mapHandle)
+      CloseHandle(mapHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+      CloseHandle(fileHandle);
+    mapHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (base)
+      munmap((void *)base, size);
+#endif
+    base = NULL;
+    size = 0;
+    trailer = NULL;
+    chunks = NULL;
+  }
+
+  const ColumnarFileHeader &getHeader() const { return header; }
+  const ColumnarTrailer &getTrailer() const { return *trailer; }
+  size_t getFileSize() const { return size; }
+  size_t chunkCount() const { return trailer ? trailer->chunkCount : 0; }
+  const ColumnarChunkEntry &chunk(size_t k) const { return chunks[k]; }
+
+  // Directory of chunk k (entries are packed; read them with memcpy or
+  // through this pointer, which the mapping keeps valid)
+  const ColumnarBlockEntry *blocks(size_t k) const
+  {
+    return (const ColumnarBlockEntry *)(base + chunks[k].directoryOffset);
+  }
+
+  // First chunk whose rows may reach timeUs or later
+  size_t findChunk(uint64_t timeUs) const
+  {
+    size_t lo = 0;
+    size_t hi = chunkCount();
+    while (lo < hi)
+    {
+      const size_t mid = (lo + hi) / 2;
+      if (chunks[mid].lastUs < timeUs)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  bool chunkCrcValid(size_t k) const
+  {
+    const ColumnarChunkEntry &e = chunks[k];
+    const size_t len = (size_t)(e.directoryOffset - e.dataOffset) +
+                       e.blockCount * sizeof(ColumnarBlockEntry);
+    return crc.compute(base + e.dataOffset, len) == e.crc32;
+  }
+
+  // Decode column c of a block (block.rows values). false if corrupt.
+  bool readColumn(const ColumnarBlockEntry &b, uint8_t c, int32_t *out) const
+  {
+    if (c >= b.columnCount)
+      return false;
+    uint64_t offset = b.offset;
+    for (uint8_t k = 0; k < c; k++)
+      offset += b.columnBytes[k];
+    if (offset + b.columnBytes[c] > size)
+      return false;
+    bytesDecoded += b.columnBytes[c];
+    return columnarDecodeColumn(base + offset, b.columnBytes[c], b.rows,
+                                columnarSecondOrder(c), out);
+  }
+
+  // Call f(const ColumnarRows &) for every block matching q that has rows
+  // in its time range, in chunk order. Only those chunks' directories and
+  // the requested columns are read. false on a corrupt chunk.
+  template <typename F>
+  bool query(const ColumnarQuery &q, F &&f)
+  {
+    ColumnarRows rows;
+    std::vector<int32_t> time;
+    for (size_t k = findChunk(q.fromUs);
+         k < chunkCount() && chunks[k].firstUs < q.toUs; k++)
+    {
+      const ColumnarChunkEntry &e = chunks[k];
+      if (q.verifyCrc && !chunkCrcValid(k))
+        return false;
+      for (uint16_t bi = 0; bi < e.blockCount; bi++)
+      {
+        const ColumnarBlockEntry &b = blocks(k)[bi];
+        if (b.kind != q.kind || (q.sensorId >= 0 && b.sensorId != q.sensorId))
+          continue;
+        time.resize(b.rows);
+        if (!readColumn(b, COLUMNAR_COL_TIME, time.data()))
+          return false;
+        // Window overlaps the range: skip blocks with no row inside it
+        size_t inside = 0;
+        for (uint32_t r = 0; r < b.rows; r++)
+        {
+          const uint64_t t = e.startUs + (uint32_t)time[r];
+          inside += (t >= q.fromUs && t < q.toUs) ? 1 : 0;
+        }
+        if (inside == 0)
+          continue;
+
+        rows.chunk = &e;
+        rows.block = &b;
+        rows.count = 0;
+        rows.timeUs.resize(inside);
+        for (uint8_t c = 1; c < b.columnCount; c++)
+        {
+          if (!(q.columns & (1u << c)))
+          {
+            rows.col[c].clear();
+            continue;
+          }
+          rows.col[c].resize(b.rows);
+          if (!readColumn(b, c, rows.col[c].data()))
+            return false;
+        }
+        for (uint32_t r = 0; r < b.rows; r++)
+        {
+          const uint64_t t = e.startUs + (uint32_t)time[r];
+          if (t < q.fromUs || t >= q.toUs)
+            continue;
+          for (uint8_t c = 1; c < b.columnCount; c++)
+          {
+            if (!rows.col[c].empty())
+              rows.col[c][rows.count] = rows.col[c][r];
+          }
+          rows.timeUs[rows.count++] = t;
+        }
+        for (uint8_t c = 1; c < b.columnCount; c++)
+        {
+          if (!rows.col[c].empty())
+            rows.col[c].resize(rows.count);
+        }
+        rows.timeUs.resize(rows.count);
+        f(static_cast<const ColumnarRows &>(rows));
+      }
+    }
+    return true;
+  }
+
+  // Column bytes decoded since open (what a query actually touched)
+  uint64_t getBytesDecoded() const { return bytesDecoded; }
+
+private:
+  const uint8_t *base;
+  size_t size;
+  ColumnarFileHeader header;
+  const ColumnarTrailer *trailer;
+  const ColumnarChunkEntry *chunks;
+  SyncCrc32 crc;
+  mutable uint64_t bytesDecoded;
+#if defined(_WIN32)
+  HANDLE fileHandle;
+  HANDLE mapHandle;
+#endif
+
+  bool validate()
+  {
+    if (size < sizeof(ColumnarFileHeader) + sizeof(ColumnarTrailer))
+      return false;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != COLUMNAR_MAGIC || header.version != COLUMNAR_VERSION)
+      return false;
+    trailer = (const ColumnarTrailer *)(base + size - sizeof(ColumnarTrailer));
+    if (trailer->magic != COLUMNAR_TRAILER_MAGIC)
+      return false;
+    const uint64_t indexBytes =
+        (uint64_t)trailer->chunkCount * sizeof(ColumnarChunkEntry);
+    if (trailer->indexOffset + indexBytes + sizeof(ColumnarTrailer) != size)
+      return false;
+    chunks = (const ColumnarChunkEntry *)(base + trailer->indexOffset);
+    if (crc.compute((const uint8_t *)chunks, (size_t)indexBytes) !=
+        trailer->indexCrc32)
+      return false;
+    for (size_t k = 0; k < trailer->chunkCount; k++)
+    {
+      if (chunks[k].directoryOffset +
+              (uint64_t)chunks[k].blockCount * sizeof(ColumnarBlockEntry) >
+          trailer->indexOffset)
+        return false;
+    }
+    return true;
+  }
+};
+
+#endif // COLUMNAR_SESSION_H
@@ -0,0 +1,817 @@
+/*******************************************************************************
+ * SyncStreamDecoder.h - Host-side decoder for captured 0x25 sync frame streams
+ *
+ * Turns a Gateway capture into structure-of-arrays batches: one column per
+ * field, accel in m/s^2 and gyro in rad/s as float, ready for numpy-style
+ * batch work. Packet layout, flags and CRC come from the firmware headers
+ * (SyncFrameFormat.h, TDMAProtocol.h, SerialFraming.h, SessionFormat.h), so
+ * the decoder cannot drift from what SyncFrameBuffer emits.
+ *
+ * Input formats (SyncStreamOptions.format):
+ *   SYNC_STREAM_LEGACY   USB stream [len lo][len hi][type][payload] ...,
+ *                        resync byte-wise on implausible frames (same rules
+ *                        as mash-app serialWorker.ts)
+ *   SYNC_STREAM_COBS     USB stream after {"cmd":"FRAMING","mode":"cobs"}
+ *   SYNC_STREAM_SESSION  sNNNN.msr session data file (SESSION_PAGE_SIZE
+ *                        chunks of legacy records)
+ * Frames other than 0x25 are counted and skipped.
+ *
+ * Pipeline: a scalar pass walks the frames (CRC8 by carry-less multiply,
+ * or sliced tables without PCLMUL) and scatters each record's int16
+ * accel/gyro into six raw columns; when a batch fills, one vector pass per
+ * column converts them to float:
+ *   AVX2 (-mavx2 / -march=native), SSE2 (any x86-64), NEON (aarch64),
+ *   otherwise scalar. SYNC_DECODE_SIMD 0 forces the scalar path.
+ * The vector and scalar paths multiply by the same reciprocal, so their
+ * output is bit-identical.
+ *
+ * Usage:
+ *   SyncStreamDecoder dec;                      // legacy, CRC checked
+ *   dec.decodeFile(f, [](const SyncImuBatch &imu, const SyncEnviroBatch &env)
+ *   {
+ *     for (size_t i = 0; i < imu.count; i++) use(imu.value[SYNC_COL_AX][i]);
+ *   });
+ * Batches are reused: copy out what you keep before returning.
+ *
+ * Header-only, C++11, no dependencies beyond the firmware headers. Build a
+ * tool with -I../libraries/IMUConnectCore/src (see sync_decode_bench.cpp).
+ ******************************************************************************/
+
+#ifndef SYNC_STREAM_DECODER_H
+#define SYNC_STREAM_DECODER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "SerialFraming.h"
+#include "SessionFormat.h"
+#include "SyncFrameFormat.h"
+#include "TDMAProtocol.h"
+
+#ifndef SYNC_DECODE_SIMD
+#define SYNC_DECODE_SIMD 1
+#endif
+
+#if SYNC_DECODE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define SYNC_DECODE_SIMD_NAME "AVX2"
+#elif SYNC_DECODE_SIMD && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define SYNC_DECODE_SIMD_NAME "SSE2"
+#elif SYNC_DECODE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define SYNC_DECODE_SIMD_NAME "NEON"
+#else
+#define SYNC_DECODE_SIMD_NAME "scalar"
+#endif
+
+#if SYNC_DECODE_SIMD && defined(__PCLMUL__) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#define SYNC_DECODE_CLMUL 1
+#else
+#define SYNC_DECODE_CLMUL 0
+#endif
+
+#define SYNC_STREAM_LEGACY SERIAL_FRAMING_LEGACY
+#define SYNC_STREAM_COBS SERIAL_FRAMING_COBS
+#define SYNC_STREAM_SESSION 2
+
+#define SYNC_STREAM_MAX_FRAME 4096            // Legacy length sanity limit
+#define SYNC_STREAM_MAX_SYNC_RECORDS 32       // serialWorker.ts 0x25 limit
+#define SYNC_STREAM_MAX_SYNC_FRAME                                             \
+  (SYNC_FRAME_HEADER_SIZE +                                                    \
+   SYNC_STREAM_MAX_SYNC_RECORDS * SYNC_FRAME_SENSOR_SIZE + 1)
+#define SYNC_STREAM_READ_SIZE (4u << 20)      // decodeFile() read size
+#define SYNC_STREAM_DEFAULT_BATCH 4096        // Records per batch (L2)
+
+// Raw / value columns of SyncImuBatch
+#define SYNC_COL_AX 0
+#define SYNC_COL_AY 1
+#define SYNC_COL_AZ 2
+#define SYNC_COL_GX 3
+#define SYNC_COL_GY 4
+#define SYNC_COL_GZ 5
+#define SYNC_COL_COUNT 6
+
+// ============================================================================
+// int16 -> float column conversion
+// ============================================================================
+
+// Reference path; kept out of the auto-vectorizer so the benchmark
+// compares against genuinely scalar code
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+inline void syncInt16ToFloatScalar(const int16_t *in, float *out, size_t n,
+                                   float scale)
+{
+#if defined(__clang__)
+#pragma clang loop vectorize(disable)
+#endif
+  for (size_t i = 0; i < n; i++)
+    out[i] = (float)in[i] * scale;
+}
+
+inline void syncInt16ToFloat(const int16_t *in, float *out, size_t n,
+                             float scale)
+{
+  size_t i = 0;
+#if SYNC_DECODE_SIMD && defined(__AVX2__)
+  const __m256 s = _mm256_set1_ps(scale);
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i lo = _mm_loadu_si128((const __m128i *)(in + i));
+    const __m128i hi = _mm_loadu_si128((const __m128i *)(in + i + 8));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(
+                                                _mm256_cvtepi16_epi32(lo)),
+                                            s));
+    _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(
+                                                    _mm256_cvtepi16_epi32(hi)),
+                                                s));
+  }
+#elif SYNC_DECODE_SIMD && (defined(__SSE2__) || defined(_M_X64))
+  const __m128 s = _mm_set1_ps(scale);
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+    // Sign-extend by placing each int16 in the top half, then shifting down
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+  }
+#elif SYNC_DECODE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+  for (; i + 8 <= n; i += 8)
+  {
+    const int16x8_t v = vld1q_s16(in + i);
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    vst1q_f32(out + i, vmulq_n_f32(lo, scale));
+    vst1q_f32(out + i + 4, vmulq_n_f32(hi, scale));
+  }
+#endif
+  syncInt16ToFloatScalar(in + i, out + i, n - i, scale);
+}
+
+// ============================================================================
+// CRC8 of TDMAProtocol.h
+// ============================================================================
+// The CRC of a message M is M(x) * x^8 mod P, P = x^8 + x^2 + x + 1, and it
+// is linear with a zero initial value.
+//
+// Carry-less multiply (PCLMUL, -mpclmul or -march=native): read 16 bytes
+// at a time as a 128-bit polynomial (byte-swapped, first byte highest) and
+// fold the running remainder forward with
+//   X * x^128 = X_hi * (x^192 mod P) + X_lo * (x^128 mod P)   (mod P)
+// whose products fit in 128 bits. The table CRC of the final 128-bit value
+// is the CRC of everything folded; the tail continues byte-wise.
+//
+// Otherwise tables: each byte of a 16-byte block is pushed through the
+// remaining zero bytes independently, table[j][x] being CRC8_TABLE applied
+// j+1 times. Only the first lookup depends on the running CRC.
+
+struct SyncCrc8
+{
+  uint8_t table[16][256];
+#if SYNC_DECODE_CLMUL
+  __m128i fold;    // lo: x^128 mod P, hi: x^192 mod P
+  __m128i reverse; // pshufb mask reversing byte order
+#endif
+
+  SyncCrc8()
+  {
+    for (int x = 0; x < 256; x++)
+    {
+      table[0][x] = CRC8_TABLE[x];
+      for (int j = 1; j < 16; j++)
+        table[j][x] = CRC8_TABLE[table[j - 1][x]];
+    }
+#if SYNC_DECODE_CLMUL
+    fold = _mm_set_epi64x(xPowModP(192), xPowModP(128));
+    reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                           15);
+#endif
+  }
+
+  static uint8_t xPowModP(unsigned n)
+  {
+    unsigned r = 1;
+    for (unsigned i = 0; i < n; i++)
+    {
+      r <<= 1;
+      if (r & 0x100)
+        r ^= 0x107;
+    }
+    return (uint8_t)r;
+  }
+
+  uint8_t compute(const uint8_t *data, size_t len) const
+  {
+#if SYNC_DECODE_CLMUL
+    if (len >= 32)
+    {
+      __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data),
+                                   reverse);
+      size_t i = 16;
+      for (; i + 16 <= len; i += 16)
+      {
+        const __m128i next = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(data + i)), reverse);
+        x = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, fold, 0x11),
+                                        _mm_clmulepi64_si128(x, fold, 0x00)),
+                          next);
+      }
+      uint8_t folded[16];
+      _mm_storeu_si128((__m128i *)folded, _mm_shuffle_epi8(x, reverse));
+      uint8_t crc = tableCompute(folded, 16);
+      for (; i < len; i++)
+        crc = CRC8_TABLE[crc ^ data[i]];
+      return crc;
+    }
+#endif
+    return tableCompute(data, len);
+  }
+
+  uint8_t tableCompute(const uint8_t *data, size_t len) const
+  {
+    uint8_t crc = 0;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+      const uint8_t *d = data + i;
+      const uint8_t rest =
+          (table[14][d[1]] ^ table[13][d[2]] ^ table[12][d[3]] ^
+           table[11][d[4]]) ^
+          (table[10][d[5]] ^ table[9][d[6]] ^ table[8][d[7]] ^
+           table[7][d[8]]) ^
+          (table[6][d[9]] ^ table[5][d[10]] ^ table[4][d[11]] ^
+           table[3][d[12]]) ^
+          (table[2][d[13]] ^ table[1][d[14]] ^ table[0][d[15]]);
+      crc = table[15][crc ^ d[0]] ^ rest;
+    }
+    for (; i < len; i++)
+      crc = CRC8_TABLE[crc ^ data[i]];
+    return crc;
+  }
+};
+
+// CRC-32 of SerialFraming.h (COBS frames, session chunks).
+// serialFramingCrc32() walks nibbles to stay small on the Gateway; on a host
+// that would cap session and COBS decoding near 0.1 GB/s. With PCLMUL the
+// same fold as SyncCrc8 in the bit-reflected domain, using the constants of
+// the Intel PCLMULQDQ CRC paper (x^(128+32) and x^(128-32) mod P, reflected,
+// pre-shifted one bit); otherwise tables eight bytes per step.
+struct SyncCrc32
+{
+  uint32_t table[8][256];
+#if SYNC_DECODE_CLMUL
+  __m128i fold;
+#endif
+
+  SyncCrc32()
+  {
+    for (uint32_t x = 0; x < 256; x++)
+    {
+      uint32_t c = x;
+      for (int k = 0; k < 8; k++)
+        c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+      table[0][x] = c;
+    }
+    for (uint32_t x = 0; x < 256; x++)
+      for (int j = 1; j < 8; j++)
+        table[j][x] = (table[j - 1][x] >> 8) ^ table[0][table[j - 1][x] & 0xFF];
+#if SYNC_DECODE_CLMUL
+    fold = _mm_set_epi64x(0x0CCAA009ELL, 0x1751997D0LL);
+#endif
+  }
+
+  // Same contract as serialFramingCrc32()
+  uint32_t compute(const uint8_t *data, size_t len, uint32_t crc = 0) const
+  {
+    crc = ~crc;
+#if SYNC_DECODE_CLMUL
+    if (len >= 32)
+    {
+      __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)data),
+                                _mm_cvtsi32_si128((int)crc));
+      size_t i = 16;
+      for (; i + 16 <= len; i += 16)
+      {
+        x = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, fold, 0x00),
+                                        _mm_clmulepi64_si128(x, fold, 0x11)),
+                          _mm_loadu_si128((const __m128i *)(data + i)));
+      }
+      uint8_t folded[16];
+      _mm_storeu_si128((__m128i *)folded, x);
+      return ~tableUpdate(tableUpdate(0, folded, 16), data + i, len - i);
+    }
+#endif
+    return ~tableUpdate(crc, data, len);
+  }
+
+  // Raw register update: no inversion on the way in or out
+  uint32_t tableUpdate(uint32_t crc, const uint8_t *data, size_t len) const
+  {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+      uint32_t lo, hi;
+      memcpy(&lo, data + i, 4);
+      memcpy(&hi, data + i + 4, 4);
+      lo ^= crc;
+      crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+            table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+            table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+            table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+    }
+    for (; i < len; i++)
+      crc = (crc >> 8) ^ table[0][(crc ^ data[i]) & 0xFF];
+    return crc;
+  }
+};
+
+// ============================================================================
+// Output batches
+// ============================================================================
+
+// IMU records (SyncFrameSensorData and SyncFrameCorrectionData), one entry
+// per record. A correction keeps SYNC_SENSOR_FLAG_CORRECTION in flags and
+// carries the corrected frame's distance back in aux; for sensor records
+// aux is the local sensor index (reserved[1]).
+struct SyncImuBatch
+{
+  size_t count;
+  std::vector<uint32_t> frameNumber;
+  std::vector<uint32_t> timestampUs;
+  std::vector<uint8_t> sensorId;
+  std::vector<uint8_t> flags;
+  std::vector<uint8_t> rawNodeId;
+  std::vector<uint8_t> aux;
+  std::vector<int16_t> raw[SYNC_COL_COUNT];  // Wire units
+  std::vector<float> value[SYNC_COL_COUNT]; // m/s^2, rad/s
+
+  void allocate(size_t capacity)
+  {
+    count = 0;
+    frameNumber.resize(capacity);
+    timestampUs.resize(capacity);
+    sensorId.resize(capacity);
+    flags.resize(capacity);
+    rawNodeId.resize(capacity);
+    aux.resize(capacity);
+    for (int c = 0; c < SYNC_COL_COUNT; c++)
+    {
+      raw[c].resize(capacity);
+      value[c].resize(capacity);
+    }
+  }
+
+  // Fill value[] from raw[]
+  void convert(bool simd = true)
+  {
+    for (int c = 0; c < SYNC_COL_COUNT; c++)
+    {
+      const float scale = c < SYNC_COL_GX ? 1.0f / SYNC_FRAME_ACCEL_LSB_PER_MS2
+                                          : 1.0f / SYNC_FRAME_GYRO_LSB_PER_RADS;
+      if (simd)
+        syncInt16ToFloat(raw[c].data(), value[c].data(), count, scale);
+      else
+        syncInt16ToFloatScalar(raw[c].data(), value[c].data(), count, scale);
+    }
+  }
+};
+
+// Magnetometer / barometer records (SyncFrameEnviroData)
+struct SyncEnviroBatch
+{
+  size_t count;
+  std::vector<uint32_t> frameNumber;
+  std::vector<uint32_t> timestampUs;
+  std::vector<uint8_t> sensorId;
+  std::vector<uint8_t> rawNodeId;
+  std::vector<uint8_t> contents; // NODE_ENVIRO_HAS_* bitfield
+  std::vector<float> mag[3];     // µT
+  std::vector<double> pressurePa;
+  std::vector<float> temperatureC;
+
+  void allocate(size_t capacity)
+  {
+    count = 0;
+    frameNumber.resize(capacity);
+    timestampUs.resize(capacity);
+    sensorId.resize(capacity);
+    rawNodeId.resize(capacity);
+    contents.resize(capacity);
+    for (int k = 0; k < 3; k++)
+      mag[k].resize(capacity);
+    pressurePa.resize(capacity);
+    temperatureC.resize(capacity);
+  }
+};
+
+struct SyncStreamStats
+{
+  uint64_t bytes;         // Input bytes consumed
+  uint64_t frames;        // 0x25 frames decoded
+  uint64_t imuRecords;    // Sensor records (incl. corrections)
+  uint64_t corrections;   // SYNC_SENSOR_FLAG_CORRECTION records
+  uint64_t enviroRecords; // SYNC_SENSOR_FLAG_ENVIRO records
+  uint64_t otherFrames;   // Well-formed frames of other packet types
+  uint64_t crcErrors;     // 0x25 CRC8, COBS CRC-32 or session chunk CRC
+  uint64_t malformed;     // 0x25 frames whose size and sensorCount disagree
+  uint64_t resyncBytes;   // Legacy bytes skipped looking for a frame
+  uint64_t badChunks;     // Session pages with a bad header or CRC
+  uint64_t truncatedBytes; // Incomplete tail at finish()
+};
+
+struct SyncStreamOptions
+{
+  uint8_t format;
+  bool verifyCrc;     // 0x25 CRC8, COBS and session chunk CRC-32
+  bool simd;          // false: scalar conversion (benchmarking)
+  size_t batchRecords;
+
+  SyncStreamOptions()
+      : format(SYNC_STREAM_LEGACY), verifyCrc(true), simd(true),
+        batchRecords(SYNC_STREAM_DEFAULT_BATCH)
+  {
+  }
+};
+
+// Same rules as isPlausibleFrame() in mash-app serialWorker.ts
+inline bool syncStreamPlausibleFrame(uint8_t type, size_t frameLen)
+{
+  switch (type)
+  {
+  case SYNC_FRAME_PACKET_TYPE:
+    if (frameLen < SYNC_FRAME_HEADER_SIZE + SYNC_FRAME_SENSOR_SIZE ||
+        frameLen > SYNC_STREAM_MAX_SYNC_FRAME)
+      return false;
+    return (frameLen - SYNC_FRAME_HEADER_SIZE) % SYNC_FRAME_SENSOR_SIZE <= 1;
+  case 0x05:
+    return frameLen == 37 || frameLen == 46;
+  case 0x04:
+    return frameLen == 31;
+  case 0x06:
+    return frameLen >= 2 && frameLen <= SYNC_STREAM_MAX_FRAME;
+  case 0x07:
+    return frameLen >= 6 && frameLen <= 392;
+  case 0x08:
+    return frameLen >= 14 && frameLen <= 494 && (frameLen - 14) % 4 == 0;
+  case 0x09:
+    return frameLen >= 8 && frameLen <= 256;
+  case TDMA_PACKET_NODE_DATA: // Historical backfill passthrough
+    return frameLen >= TDMA_NODE_DATA_HEADER_SIZE + 1 && frameLen <= 250;
+  default:
+    return false;
+  }
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+class SyncStreamDecoder
+{
+public:
+  explicit SyncStreamDecoder(const SyncStreamOptions &options =
+                                 SyncStreamOptions())
+      : opts(options)
+  {
+    if (opts.batchRecords < SYNC_STREAM_MAX_SYNC_RECORDS)
+      opts.batchRecords = SYNC_STREAM_MAX_SYNC_RECORDS;
+    imu.allocate(opts.batchRecords);
+    enviro.allocate(opts.batchRecords);
+    cobsSkip = false;
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Decode as much of data as forms whole frames (whole pages for
+  // sessions) and return the bytes consumed. Present the rest again, with
+  // more data after it, on the next call. sink(imu, enviro) is called each
+  // time a batch fills.
+  template <typename Sink>
+  size_t decode(const uint8_t *data, size_t len, Sink &sink)
+  {
+    size_t used;
+    if (opts.format == SYNC_STREAM_COBS)
+      used = decodeCobs(data, len, sink);
+    else if (opts.format == SYNC_STREAM_SESSION)
+      used = decodeSession(data, len, sink);
+    else
+      used = decodeLegacy(data, len, sink);
+    stats.bytes += used;
+    return used;
+  }
+
+  // End of stream: account the unconsumed tail and hand over the last batch
+  template <typename Sink>
+  void finish(size_t leftoverBytes, Sink &sink)
+  {
+    stats.truncatedBytes += leftoverBytes;
+    flush(sink);
+  }
+
+  // Decode a whole file through a SYNC_STREAM_READ_SIZE buffer. Returns
+  // false on a read error.
+  template <typename Sink>
+  bool decodeFile(FILE *f, Sink &&sink)
+  {
+    std::vector<uint8_t> buf(SYNC_STREAM_READ_SIZE + SYNC_STREAM_MAX_FRAME +
+                             SESSION_PAGE_SIZE);
+    size_t have = 0;
+    for (;;)
+    {
+      const size_t n = fread(buf.data() + have, 1, SYNC_STREAM_READ_SIZE, f);
+      if (n == 0)
+        break;
+      have += n;
+      const size_t used = decode(buf.data(), have, sink);
+      have -= used;
+      memmove(buf.data(), buf.data() + used, have);
+    }
+    finish(have, sink);
+    return !ferror(f);
+  }
+
+  const SyncStreamStats &getStats() const { return stats; }
+
+private:
+  SyncStreamOptions opts;
+  SyncCrc8 crc8;
+  SyncImuBatch imu;
+  SyncEnviroBatch enviro;
+  SyncCrc32 crc32;
+  // Decoded COBS block; runs are copied 16 bytes at a time, so up to 15
+  // bytes past the frame are scratch
+  uint8_t cobsFrame[SYNC_STREAM_MAX_FRAME + SERIAL_COBS_CRC_SIZE + 16];
+  bool cobsSkip; // Dropping an over-long block up to its delimiter
+  SyncStreamStats stats;
+
+  template <typename Sink>
+  void flush(Sink &sink)
+  {
+    if (imu.count == 0 && enviro.count == 0)
+      return;
+    imu.convert(opts.simd);
+    sink(static_cast<const SyncImuBatch &>(imu),
+         static_cast<const SyncEnviroBatch &>(enviro));
+    imu.count = 0;
+    enviro.count = 0;
+  }
+
+  template <typename Sink>
+  size_t decodeLegacy(const uint8_t *data, size_t len, Sink &sink)
+  {
+    size_t pos = 0;
+    while (len - pos >= 2)
+    {
+      const size_t frameLen = data[pos] | (data[pos + 1] << 8);
+      if (frameLen < 3 || frameLen > SYNC_STREAM_MAX_FRAME)
+      {
+        pos++;
+        stats.resyncBytes++;
+        continue;
+      }
+      if (len - pos < 2 + frameLen)
+        break;
+      if (!syncStreamPlausibleFrame(data[pos + 2], frameLen))
+      {
+        pos++;
+        stats.resyncBytes++;
+        continue;
+      }
+      frame(data + pos + 2, frameLen, true, sink);
+      pos += 2 + frameLen;
+    }
+    return pos;
+  }
+
+  // Blocks are found with memchr and decoded a run at a time; same
+  // result as CobsStreamDecoder / cobsDecodeFrame() byte by byte
+  template <typename Sink>
+  size_t decodeCobs(const uint8_t *data, size_t len, Sink &sink)
+  {
+    size_t pos = 0;
+    for (;;)
+    {
+      const uint8_t *end =
+          (const uint8_t *)memchr(data + pos, SERIAL_COBS_DELIMITER, len - pos);
+      if (!end)
+        break;
+      const size_t blockLen = (size_t)(end - data) - pos;
+      if (cobsSkip)
+        cobsSkip = false;
+      else if (blockLen > 0)
+        cobsBlock(data + pos, blockLen, len - pos, sink);
+      pos += blockLen + 1;
+    }
+    // An unterminated block that can no longer be a frame is dropped
+    // rather than held
+    if (len - pos > SERIAL_COBS_MAX_ENCODED(SYNC_STREAM_MAX_FRAME))
+    {
+      if (!cobsSkip)
+        stats.crcErrors++;
+      cobsSkip = true;
+      pos = len;
+    }
+    return pos;
+  }
+
+  template <typename Sink>
+  void cobsBlock(const uint8_t *in, size_t len, size_t readable, Sink &sink)
+  {
+    const size_t capacity = SYNC_STREAM_MAX_FRAME + SERIAL_COBS_CRC_SIZE;
+    size_t r = 0;
+    size_t w = 0;
+    while (r < len)
+    {
+      const uint8_t code = in[r++];
+      const size_t run = code - 1u;
+      if (r + run > len || w + run > capacity)
+      {
+        stats.crcErrors++;
+        return;
+      }
+      if (r + run + 16 <= readable)
+      {
+        for (size_t k = 0; k < run; k += 16)
+          memcpy(cobsFrame + w + k, in + r + k, 16);
+      }
+      else
+      {
+        memcpy(cobsFrame + w, in + r, run);
+      }
+      r += run;
+      w += run;
+      if (code != 0xFF && r < len)
+      {
+        if (w >= capacity)
+        {
+          stats.crcErrors++;
+          return;
+        }
+        cobsFrame[w++] = 0;
+      }
+    }
+    if (w <= SERIAL_COBS_CRC_SIZE)
+    {
+      stats.crcErrors++;
+      return;
+    }
+    const size_t frameLen = w - SERIAL_COBS_CRC_SIZE;
+    uint32_t crc;
+    memcpy(&crc, cobsFrame + frameLen, 4);
+    if (opts.verifyCrc && crc32.compute(cobsFrame, frameLen) != crc)
+    {
+      stats.crcErrors++;
+      return;
+    }
+    frame(cobsFrame, frameLen, !opts.verifyCrc, sink);
+  }
+
+  template <typename Sink>
+  size_t decodeSession(const uint8_t *data, size_t len, Sink &sink)
+  {
+    size_t pos = 0;
+    for (; len - pos >= SESSION_PAGE_SIZE; pos += SESSION_PAGE_SIZE)
+    {
+      const uint8_t *page = data + pos;
+      SessionChunkHeader h;
+      memcpy(&h, page, sizeof(h));
+      // sessionChunkValid(), with the faster CRC
+      bool ok = h.magic == SESSION_CHUNK_MAGIC &&
+                h.version == SESSION_FORMAT_VERSION &&
+                h.usedBytes <= SESSION_CHUNK_PAYLOAD_MAX;
+      if (ok && opts.verifyCrc)
+      {
+        const uint32_t crc =
+            crc32.compute(page, offsetof(SessionChunkHeader, crc32));
+        ok = crc32.compute(page + sizeof(h), h.usedBytes, crc) == h.crc32;
+      }
+      if (!ok)
+      {
+        stats.badChunks++;
+        continue;
+      }
+      const uint8_t *rec = page + sizeof(h);
+      size_t r = 0;
+      while (h.usedBytes - r >= 2)
+      {
+        const size_t frameLen = rec[r] | (rec[r + 1] << 8);
+        if (frameLen == 0 || r + 2 + frameLen > h.usedBytes)
+          break;
+        frame(rec + r + 2, frameLen, !opts.verifyCrc, sink);
+        r += 2 + frameLen;
+      }
+    }
+    return pos;
+  }
+
+  template <typename Sink>
+  // checkCrc8 false: an outer CRC-32 (COBS, session chunk) already passed
+  void frame(const uint8_t *f, size_t len, bool checkCrc8, Sink &sink)
+  {
+    if (f[0] != SYNC_FRAME_PACKET_TYPE)
+    {
+      stats.otherFrames++;
+      return;
+    }
+    if (len < SYNC_FRAME_HEADER_SIZE)
+    {
+      stats.malformed++;
+      return;
+    }
+    const size_t body = len - SYNC_FRAME_HEADER_SIZE;
+    const size_t count = body / SYNC_FRAME_SENSOR_SIZE;
+    const size_t tail = body % SYNC_FRAME_SENSOR_SIZE;
+    if (tail > 1 || f[9] != count || count > SYNC_STREAM_MAX_SYNC_RECORDS)
+    {
+      stats.malformed++;
+      return;
+    }
+    // Frames from before the CRC8 byte was added end on a record boundary
+    if (tail == 1 && checkCrc8 && opts.verifyCrc &&
+        crc8.compute(f, len - 1) != f[len - 1])
+    {
+      stats.crcErrors++;
+      return;
+    }
+
+    if (imu.count + count > opts.batchRecords ||
+        enviro.count + count > opts.batchRecords)
+      flush(sink);
+
+    uint32_t frameNumber, timestampUs;
+    memcpy(&frameNumber, f + 1, 4);
+    memcpy(&timestampUs, f + 5, 4);
+    stats.frames++;
+
+    // Column pointers held in locals: stores through uint8_t columns may
+    // alias anything, which would otherwise reload every vector's data()
+    // after each one
+    uint32_t *colFrame = imu.frameNumber.data();
+    uint32_t *colTime = imu.timestampUs.data();
+    uint8_t *colId = imu.sensorId.data();
+    uint8_t *colFlags = imu.flags.data();
+    uint8_t *colNode = imu.rawNodeId.data();
+    uint8_t *colAux = imu.aux.data();
+    int16_t *colRaw[SYNC_COL_COUNT];
+    for (int c = 0; c < SYNC_COL_COUNT; c++)
+      colRaw[c] = imu.raw[c].data();
+
+    size_t i = imu.count;
+    uint32_t corrections = 0;
+    const uint8_t *rec = f + SYNC_FRAME_HEADER_SIZE;
+    for (size_t s = 0; s < count; s++, rec += SYNC_FRAME_SENSOR_SIZE)
+    {
+      const uint8_t flags = rec[offsetof(SyncFrameSensorData, flags)];
+      if (flags & SYNC_SENSOR_FLAG_ENVIRO)
+      {
+        enviroRecord(rec, frameNumber, timestampUs);
+        continue;
+      }
+
+      // SyncFrameSensorData and SyncFrameCorrectionData share this layout
+      int16_t ag[SYNC_COL_COUNT];
+      memcpy(ag, rec + offsetof(SyncFrameSensorData, a), sizeof(ag));
+      colFrame[i] = frameNumber;
+      colTime[i] = timestampUs;
+      colId[i] = rec[0];
+      colFlags[i] = flags;
+      colNode[i] = rec[14];
+      colAux[i] = rec[15];
+      for (int c = 0; c < SYNC_COL_COUNT; c++)
+        colRaw[c][i] = ag[c];
+      corrections += (flags & SYNC_SENSOR_FLAG_CORRECTION) != 0;
+      i++;
+    }
+    stats.imuRecords += i - imu.count;
+    stats.corrections += corrections;
+    imu.count = i;
+  }
+
+  void enviroRecord(const uint8_t *rec, uint32_t frameNumber,
+                    uint32_t timestampUs)
+  {
+    SyncFrameEnviroData e;
+    memcpy(&e, rec, sizeof(e));
+    const size_t i = enviro.count++;
+    enviro.frameNumber[i] = frameNumber;
+    enviro.timestampUs[i] = timestampUs;
+    enviro.sensorId[i] = e.sensorId;
+    enviro.rawNodeId[i] = e.rawNodeId;
+    enviro.contents[i] = e.contents;
+    for (int k = 0; k < 3; k++)
+      enviro.mag[k][i] = e.mag[k] * 0.1f;
+    enviro.pressurePa[i] = e.pressureCPa * 0.01;
+    enviro.temperatureC[i] = e.temperatureC * 0.01f;
+    stats.enviroRecords++;
+  }
+};
+
+#endif // SYNC_STREAM_DECODER_H
@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * mash_columnar.cpp - Convert recorded sync streams to columnar sessions
+ *
+ * convert: streams a capture (USB dump, sNNNN.msr or webapp export) through
+ *          SyncStreamDecoder into ColumnarSessionWriter. Memory stays flat
+ *          however long the session is.
+ * info:    chunk index and per-sensor summary from the block statistics,
+ *          without decoding any column.
+ * extract: CSV of a time range / sensor / column subset. Reports on stderr
+ *          how many chunks and column bytes were touched.
+ * verify:  decodes the capture again and checks that the columnar file
+ *          holds the same rows (corrections applied), as order-independent
+ *          row hashes.
+ *
+ * Build (from firmware/host):
+ *   g++ -O2 -march=native -I../libraries/IMUConnectCore/src \
+ *       mash_columnar.cpp -o mash_columnar
+ *
+ * Usage:
+ *   ./mash_columnar convert capture.bin run.mcol [--format cobs] [--chunk-ms 5000]
+ *   ./mash_columnar info run.mcol [--chunks]
+ *   ./mash_columnar extract run.mcol --sensor 3 --from 600 --to 660 \
+ *       --columns ax,ay,az > walk.csv
+ *   ./mash_columnar extract run.mcol --enviro > enviro.csv
+ *   ./mash_columnar verify capture.bin run.mcol [--format cobs]
+ ******************************************************************************/
+
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "ColumnarSession.h"
+
+static const char *const imuColumnNames[COLUMNAR_IMU_COLUMNS] = {
+    "time", "frame", "flags", "ax", "ay", "az", "gx", "gy", "gz"};
+static const char *const enviroColumnNames[COLUMNAR_ENVIRO_COLUMNS] = {
+    "time", "frame", "contents", "mx", "my", "mz", "pressure", "temp"};
+
+static const char *columnName(uint8_t kind, uint8_t c)
+{
+  return kind == COLUMNAR_KIND_IMU ? imuColumnNames[c] : enviroColumnNames[c];
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+static int parseFormat(const char *s)
+{
+  if (!strcmp(s, "legacy"))
+    return SYNC_STREAM_LEGACY;
+  if (!strcmp(s, "cobs"))
+    return SYNC_STREAM_COBS;
+  if (!strcmp(s, "session"))
+    return SYNC_STREAM_SESSION;
+  return -1;
+}
+
+// Column list ("ax,gz" or "all") to a ColumnarQuery mask; 0 if unknown
+static uint32_t parseColumns(const char *s, uint8_t kind)
+{
+  if (!strcmp(s, "all"))
+    return 0xFFFFFFFFu;
+  uint32_t mask = 0;
+  while (*s)
+  {
+    const char *end = strchr(s, ',');
+    const size_t len = end ? (size_t)(end - s) : strlen(s);
+    bool found = false;
+    for (uint8_t c = 0; c < columnarColumnCount(kind); c++)
+    {
+      const char *name = columnName(kind, c);
+      if (strlen(name) == len && !strncmp(s, name, len))
+      {
+        mask |= 1u << c;
+        found = true;
+      }
+    }
+    if (!found)
+      return 0;
+    s += len + (end ? 1 : 0);
+  }
+  return mask;
+}
+
+// ============================================================================
+// convert
+// ============================================================================
+
+static int convert(const char *capture, const char *outPath, uint8_t format,
+                   uint32_t chunkMs)
+{
+  FILE *in = fopen(capture, "rb");
+  if (!in)
+  {
+    fprintf(stderr, "cannot open %s\n", capture);
+    return 1;
+  }
+  FILE *out = fopen(outPath, "wb");
+  if (!out)
+  {
+    fprintf(stderr, "cannot create %s\n", outPath);
+    fclose(in);
+    return 1;
+  }
+
+  SyncStreamOptions opts;
+  opts.format = format;
+  SyncStreamDecoder dec(opts);
+  ColumnarSessionWriter writer(out, chunkMs * 1000u);
+  const std::chrono::steady_clock::time_point t0 =
+      std::chrono::steady_clock::now();
+  bool ok = dec.decodeFile(in, writer);
+  ok = writer.finish() && ok;
+  const double s = secondsSince(t0);
+  fclose(in);
+  ok = fclose(out) == 0 && ok;
+
+  const SyncStreamStats &st = dec.getStats();
+  const ColumnarTrailer &tr = writer.getTrailer();
+  printf("%s: %.1f MB -> %.1f MB (%.1f%%), %zu chunks, %llu rows in %.2fs "
+         "(%.0f MB/s)\n",
+         outPath, st.bytes / 1e6, writer.getBytesWritten() / 1e6,
+         st.bytes ? 100.0 * writer.getBytesWritten() / st.bytes : 0.0,
+         writer.getChunkCount(), (unsigned long long)tr.rows, s,
+         st.bytes / s / 1e6);
+  printf("  stream: frames %llu  crcErrors %llu  malformed %llu  badChunks "
+         "%llu\n",
+         (unsigned long long)st.frames, (unsigned long long)st.crcErrors,
+         (unsigned long long)st.malformed, (unsigned long long)st.badChunks);
+  printf("  corrections applied %u  lost %u  late rows %u\n",
+         tr.correctionsApplied, tr.correctionsLost, tr.lateRows);
+  if (!ok)
+    fprintf(stderr, "write failed: %s\n", outPath);
+  return ok ? 0 : 1;
+}
+
+// ============================================================================
+// info
+// ============================================================================
+
+struct SensorSummary
+{
+  uint64_t rows;
+  uint64_t interpolated;
+  uint64_t bytes;
+  uint8_t rawNodeId;
+  int32_t min[COLUMNAR_MAX_COLUMNS];
+  int32_t max[COLUMNAR_MAX_COLUMNS];
+  int64_t sum[COLUMNAR_MAX_COLUMNS];
+};
+
+static int info(const char *path, bool listChunks)
+{
+  ColumnarSessionReader r;
+  if (!r.open(path))
+  {
+    fprintf(stderr, "%s: not a columnar session\n", path);
+    return 1;
+  }
+  const ColumnarFileHeader &h = r.getHeader();
+  const ColumnarTrailer &tr = r.getTrailer();
+  const size_t n = r.chunkCount();
+  const double duration = n ? r.chunk(n - 1).lastUs / 1e6 : 0.0;
+  printf("%s: %.1f MB, %zu chunks of %.1fs, %.1fs, %llu rows\n", path,
+         r.getFileSize() / 1e6, n, h.chunkDurationUs / 1e6, duration,
+         (unsigned long long)tr.rows);
+  printf("  starts at gateway time %u us, frame %u\n", h.firstTimestampUs,
+         h.firstFrame);
+  printf("  corrections applied %u  lost %u  late rows %u\n",
+         tr.correctionsApplied, tr.correctionsLost, tr.lateRows);
+
+  static SensorSummary sensors[2][256];
+  memset(sensors, 0, sizeof(sensors));
+  uint64_t columnBytes[2][COLUMNAR_MAX_COLUMNS] = {};
+  unsigned restarts = 0;
+  for (size_t k = 0; k < n; k++)
+  {
+    const ColumnarChunkEntry &e = r.chunk(k);
+    restarts += (e.flags & COLUMNAR_CHUNK_FLAG_RESTART) ? 1 : 0;
+    if (listChunks)
+    {
+      unsigned imuSensors = 0;
+      for (int b = 0; b < SESSION_SENSOR_MASK_BYTES; b++)
+        imuSensors += __builtin_popcount(e.sensorMask[b]);
+      printf("  chunk %5zu  %9.3f-%9.3fs  frames %u-%u  blocks %u  "
+             "sensors %u%s\n",
+             k, e.firstUs / 1e6, e.lastUs / 1e6, e.firstFrame, e.lastFrame,
+             e.blockCount, imuSensors,
+             (e.flags & COLUMNAR_CHUNK_FLAG_RESTART) ? "  RESTART" : "");
+    }
+    for (uint16_t bi = 0; bi < e.blockCount; bi++)
+    {
+      ColumnarBlockEntry b;
+      memcpy(&b, &r.blocks(k)[bi], sizeof(b));
+      SensorSummary &s = sensors[b.kind & 1][b.sensorId];
+      for (uint8_t c = 0; c < b.columnCount; c++)
+      {
+        if (s.rows == 0 || b.stats[c].min < s.min[c])
+          s.min[c] = b.stats[c].min;
+        if (s.rows == 0 || b.stats[c].max > s.max[c])
+          s.max[c] = b.stats[c].max;
+        s.sum[c] += b.stats[c].sum;
+        s.bytes += b.columnBytes[c];
+        columnBytes[b.kind & 1][c] += b.columnBytes[c];
+      }
+      s.rows += b.rows;
+      s.interpolated += b.interpolatedRows;
+      s.rawNodeId = b.rawNodeId;
+    }
+  }
+  if (restarts)
+    printf("  %u chunks contain a stream restart\n", restarts);
+
+  for (uint8_t kind = 0; kind < 2; kind++)
+  {
+    const uint8_t cols = columnarColumnCount(kind);
+    bool header = false;
+    for (int id = 0; id < 256; id++)
+    {
+      const SensorSummary &s = sensors[kind][id];
+      if (s.rows == 0)
+        continue;
+      if (!header)
+      {
+        printf("%s sensors (mean [min, max] per column, physical units):\n",
+               kind == COLUMNAR_KIND_IMU ? "IMU" : "Enviro");
+        header = true;
+      }
+      printf("  sensor %3d  node %3u  rows %9llu", id, s.rawNodeId,
+             (unsigned long long)s.rows);
+      if (kind == COLUMNAR_KIND_IMU)
+        printf("  interpolated %llu", (unsigned long long)s.interpolated);
+      printf("  %.2f B/row\n", (double)s.bytes / s.rows);
+      printf("   ");
+      for (uint8_t c = 3; c < cols; c++)
+      {
+        const double scale = columnarScale(kind, c);
+        printf(" %s %.3f [%.3f, %.3f]", columnName(kind, c),
+               s.sum[c] * scale / s.rows, s.min[c] * scale, s.max[c] * scale);
+      }
+      printf("\n");
+    }
+    if (header)
+    {
+      printf("  column bytes:");
+      for (uint8_t c = 0; c < cols; c++)
+        printf(" %s %.1fMB", columnName(kind, c), columnBytes[kind][c] / 1e6);
+      printf("\n");
+    }
+  }
+  return 0;
+}
+
+// ============================================================================
+// extract
+// ============================================================================
+
+static int extract(const char *path, const ColumnarQuery &q)
+{
+  ColumnarSessionReader r;
+  if (!r.open(path))
+  {
+    fprintf(stderr, "%s: not a columnar session\n", path);
+    return 1;
+  }
+  const uint8_t cols = columnarColumnCount(q.kind);
+  printf("time_s,sensor");
+  for (uint8_t c = 1; c < cols; c++)
+  {
+    if (q.columns & (1u << c))
+      printf(",%s", columnName(q.kind, c));
+  }
+  printf("\n");
+
+  uint64_t rows = 0;
+  size_t chunks = 0;
+  const ColumnarChunkEntry *lastChunk = NULL;
+  const bool ok = r.query(q, [&](const ColumnarRows &b)
+  {
+    if (b.chunk != lastChunk)
+    {
+      lastChunk = b.chunk;
+      chunks++;
+    }
+    for (size_t i = 0; i < b.count; i++)
+    {
+      printf("%.6f,%u", b.timeUs[i] / 1e6, b.block->sensorId);
+      for (uint8_t c = 1; c < cols; c++)
+      {
+        if (b.col[c].empty())
+          continue;
+        const double scale = columnarScale(q.kind, c);
+        if (scale == 1.0)
+          printf(",%d", b.col[c][i]);
+        else if (q.kind == COLUMNAR_KIND_ENVIRO && c == COLUMNAR_COL_PRESSURE)
+          printf(",%.2f", (uint32_t)b.col[c][i] * scale);
+        else
+          printf(",%.4f", b.col[c][i] * scale);
+      }
+      printf("\n");
+    }
+    rows += b.count;
+  });
+  if (!ok)
+  {
+    fprintf(stderr, "%s: corrupt chunk\n", path);
+    return 1;
+  }
+  fprintf(stderr, "%llu rows from %zu of %zu chunks, %.2f MB of %.2f MB "
+                  "column data decoded\n",
+          (unsigned long long)rows, chunks, r.chunkCount(),
+          r.getBytesDecoded() / 1e6, r.getFileSize() / 1e6);
+  return 0;
+}
+
+// ============================================================================
+// verify
+// ============================================================================
+
+static uint64_t mix64(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDull;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+// Row hash in wire units; summed, so row order does not matter
+static uint64_t rowHash(uint8_t kind, uint8_t sensorId, uint32_t frame,
+                        uint32_t timeUs, const int32_t *v, int n)
+{
+  uint64_t h = mix64(((uint64_t)kind << 40) ^ ((uint64_t)sensorId << 32) ^
+                     frame);
+  h = mix64(h ^ timeUs);
+  for (int k = 0; k < n; k++)
+    h = mix64(h ^ (uint32_t)v[k]);
+  return h;
+}
+
+// Expected side: rows straight from the decoder, with each correction
+// swapping the hash of the row it replaces (the last 256 frames of each
+// sensor are kept, enough for any framesBack)
+struct VerifySink
+{
+  struct Recent
+  {
+    uint32_t frame;
+    uint32_t timeUs;
+    uint64_t hash;
+    bool used;
+  };
+
+  uint64_t sum;
+  uint64_t rows;
+  uint32_t corrections;
+  bool hashTime;
+  std::vector<Recent> recent; // [sensorId][frame & 0xFF]
+
+  VerifySink() : sum(0), rows(0), corrections(0), hashTime(true)
+  {
+    recent.resize(256 * 256);
+  }
+
+  void operator()(const SyncImuBatch &imu, const SyncEnviroBatch &env)
+  {
+    int32_t v[COLUMNAR_MAX_COLUMNS];
+    for (size_t i = 0; i < imu.count; i++)
+    {
+      for (int k = 0; k < SYNC_COL_COUNT; k++)
+        v[1 + k] = imu.raw[k][i];
+      const bool correction = imu.flags[i] & SYNC_SENSOR_FLAG_CORRECTION;
+      const uint32_t frame =
+          correction ? imu.frameNumber[i] - imu.aux[i] : imu.frameNumber[i];
+      Recent &slot = recent[imu.sensorId[i] * 256 + (frame & 0xFF)];
+      if (correction)
+      {
+        if (!slot.used || slot.frame != frame)
+          continue; // Nothing to replace: the writer drops it too
+        v[0] = SYNC_SENSOR_FLAG_VALID;
+        const uint64_t h = rowHash(COLUMNAR_KIND_IMU, imu.sensorId[i], frame,
+                                   hashTime ? slot.timeUs : 0, v, 7);
+        sum += h - slot.hash;
+        slot.hash = h;
+        corrections++;
+        continue;
+      }
+      v[0] = imu.flags[i];
+      slot.frame = frame;
+      slot.timeUs = imu.timestampUs[i];
+      slot.hash = rowHash(COLUMNAR_KIND_IMU, imu.sensorId[i], frame,
+                          hashTime ? slot.timeUs : 0, v, 7);
+      slot.used = true;
+      sum += slot.hash;
+      rows++;
+    }
+    for (size_t i = 0; i < env.count; i++)
+    {
+      v[0] = env.contents[i];
+      for (int k = 0; k < 3; k++)
+        v[1 + k] = (int32_t)lround(env.mag[k][i] * 10.0);
+      v[4] = (int32_t)(uint32_t)llround(env.pressurePa[i] * 100.0);
+      v[5] = (int32_t)lround(env.temperatureC[i] * 100.0);
+      sum += rowHash(COLUMNAR_KIND_ENVIRO, env.sensorId[i],
+                     env.frameNumber[i], hashTime ? env.timestampUs[i] : 0, v,
+                     6);
+      rows++;
+    }
+  }
+};
+
+static int verify(const char *capture, const char *path, uint8_t format)
+{
+  ColumnarSessionReader r;
+  if (!r.open(path))
+  {
+    fprintf(stderr, "%s: not a columnar session\n", path);
+    return 1;
+  }
+  FILE *in = fopen(capture, "rb");
+  if (!in)
+  {
+    fprintf(stderr, "cannot open %s\n", capture);
+    return 1;
+  }
+
+  // Stored times are session times; they map back to gateway time unless
+  // the stream restarted
+  bool restarted = false;
+  for (size_t k = 0; k < r.chunkCount(); k++)
+    restarted |= (r.chunk(k).flags & COLUMNAR_CHUNK_FLAG_RESTART) != 0;
+
+  SyncStreamOptions opts;
+  opts.format = format;
+  SyncStreamDecoder dec(opts);
+  VerifySink expected;
+  expected.hashTime = !restarted;
+  dec.decodeFile(in, expected);
+  fclose(in);
+
+  uint64_t sum = 0;
+  uint64_t rows = 0;
+  bool crcOk = true;
+  for (size_t k = 0; k < r.chunkCount(); k++)
+    crcOk = r.chunkCrcValid(k) && crcOk;
+  const uint32_t t0 = r.getHeader().firstTimestampUs;
+  for (uint8_t kind = 0; kind < 2; kind++)
+  {
+    ColumnarQuery q;
+    q.kind = kind;
+    const int n = kind == COLUMNAR_KIND_IMU ? 7 : 6;
+    crcOk = r.query(q, [&](const ColumnarRows &b)
+    {
+      int32_t v[COLUMNAR_MAX_COLUMNS];
+      for (size_t i = 0; i < b.count; i++)
+      {
+        for (int k = 0; k < n; k++)
+          v[k] = b.col[COLUMNAR_COL_FLAGS + k][i];
+        sum += rowHash(kind, b.block->sensorId,
+                       (uint32_t)b.col[COLUMNAR_COL_FRAME][i],
+                       restarted ? 0 : (uint32_t)(t0 + b.timeUs[i]), v, n);
+      }
+      rows += b.count;
+    }) && crcOk;
+  }
+
+  const ColumnarTrailer &tr = r.getTrailer();
+  const bool ok = crcOk && rows == expected.rows && sum == expected.sum &&
+                  tr.correctionsApplied == expected.corrections &&
+                  tr.lateRows == 0;
+  printf("verify: %s (rows %llu/%llu, corrections %u/%u, late %u, CRC %s%s)\n",
+         ok ? "PASS" : "FAIL", (unsigned long long)rows,
+         (unsigned long long)expected.rows, tr.correctionsApplied,
+         expected.corrections, tr.lateRows, crcOk ? "ok" : "BAD",
+         restarted ? ", times not compared: stream restarted" : "");
+  return ok ? 0 : 1;
+}
+
+// ============================================================================
+// main
+// ============================================================================
+
+static int usage(const char *argv0)
+{
+  fprintf(stderr,
+          "usage: %s convert <capture> <out.mcol> [--format legacy|cobs|"
+          "session] [--chunk-ms N]\n"
+          "       %s info <file.mcol> [--chunks]\n"
+          "       %s extract <file.mcol> [--sensor ID] [--from s] [--to s] "
+          "[--columns ax,ay,...|all] [--enviro]\n"
+          "       %s verify <capture> <file.mcol> [--format ...]\n",
+          argv0, argv0, argv0, argv0);
+  return 2;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+    return usage(argv[0]);
+  const char *cmd = argv[1];
+  const char *paths[2] = {NULL, NULL};
+  int pathCount = 0;
+  int format = SYNC_STREAM_LEGACY;
+  long chunkMs = COLUMNAR_DEFAULT_CHUNK_US / 1000;
+  bool listChunks = false;
+  ColumnarQuery q;
+  const char *columns = "all";
+  for (int i = 2; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--format") && i + 1 < argc)
+      format = parseFormat(argv[++i]);
+    else if (!strcmp(argv[i], "--chunk-ms") && i + 1 < argc)
+      chunkMs = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--chunks"))
+      listChunks = true;
+    else if (!strcmp(argv[i], "--sensor") && i + 1 < argc)
+      q.sensorId = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--from") && i + 1 < argc)
+      q.fromUs = (uint64_t)(atof(argv[++i]) * 1e6);
+    else if (!strcmp(argv[i], "--to") && i + 1 < argc)
+      q.toUs = (uint64_t)(atof(argv[++i]) * 1e6);
+    else if (!strcmp(argv[i], "--columns") && i + 1 < argc)
+      columns = argv[++i];
+    else if (!strcmp(argv[i], "--enviro"))
+      q.kind = COLUMNAR_KIND_ENVIRO;
+    else if (argv[i][0] != '-' && pathCount < 2)
+      paths[pathCount++] = argv[i];
+    else
+      return usage(argv[0]);
+  }
+  if (format < 0 || chunkMs <= 0 ||
+      chunkMs > COLUMNAR_MAX_CHUNK_US / 1000)
+    return usage(argv[0]);
+
+  if (!strcmp(cmd, "convert") && pathCount == 2)
+    return convert(paths[0], paths[1], (uint8_t)format, (uint32_t)chunkMs);
+  if (!strcmp(cmd, "info") && pathCount == 1)
+    return info(paths[0], listChunks);
+  if (!strcmp(cmd, "extract") && pathCount == 1)
+  {
+    q.columns = parseColumns(columns, q.kind);
+    if (q.columns == 0 || q.sensorId > 255)
+      return usage(argv[0]);
+    return extract(paths[0], q);
+  }
+  if (!strcmp(cmd, "verify") && pathCount == 2)
+    return verify(paths[0], paths[1], (uint8_t)format);
+  return usage(argv[0]);
+}
@@ -0,0 +1,476 @@
+/*******************************************************************************
+ * sync_decode_bench.cpp - Throughput benchmark for SyncStreamDecoder.h
+ *
+ * Without a capture, builds a synthetic 200 Hz stream in memory (0x25 frames
+ * with CRC8, an enviro record on every 20th frame, a 0x09 frame now and
+ * then) in the chosen format, checks that the vector and scalar conversions
+ * agree bit for bit and match the encoded values, then decodes the block
+ * over and over until --gb gigabytes have gone through, once with vector
+ * and once with scalar conversion. With a capture file, decodes it from
+ * disk and reports the same figures: if file throughput is well below the
+ * in-memory figure, batch reprocessing is disk-bound, as intended.
+ *
+ * Build (from firmware/host):
+ *   g++ -O2 -march=native -I../libraries/IMUConnectCore/src \
+ *       sync_decode_bench.cpp -o sync_decode_bench
+ *
+ * Usage:
+ *   ./sync_decode_bench                              # legacy, 4 GB
+ *   ./sync_decode_bench --format session --gb 8 --sensors 16
+ *   ./sync_decode_bench --write capture.bin --gb 4   # synthetic file
+ *   ./sync_decode_bench capture.bin --format cobs    # decode a capture
+ *   --no-crc skips CRC checks in the timed runs (shows what they cost)
+ ******************************************************************************/
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "SyncStreamDecoder.h"
+
+#define BENCH_BLOCK_BYTES (64u << 20)
+#define BENCH_ENVIRO_EVERY 20 // Frames per enviro record (10Hz at 200Hz)
+#define BENCH_OTHER_EVERY 200 // Frames per 0x09 status frame
+
+// Throughput runs: touch each batch without adding work per record
+struct BenchSink
+{
+  uint64_t records;
+  uint64_t enviro;
+  double sum;
+
+  BenchSink() : records(0), enviro(0), sum(0) {}
+
+  void operator()(const SyncImuBatch &imu, const SyncEnviroBatch &env)
+  {
+    for (int c = 0; c < SYNC_COL_COUNT && imu.count > 0; c++)
+      sum += imu.value[c][imu.count - 1];
+    records += imu.count;
+    enviro += env.count;
+  }
+};
+
+// Verification: order-dependent hash of every float produced
+struct HashSink
+{
+  uint64_t records;
+  uint64_t bits;
+
+  HashSink() : records(0), bits(0) {}
+
+  void operator()(const SyncImuBatch &imu, const SyncEnviroBatch &)
+  {
+    for (int c = 0; c < SYNC_COL_COUNT; c++)
+    {
+      const float *v = imu.value[c].data();
+      for (size_t i = 0; i < imu.count; i++)
+      {
+        uint32_t u;
+        memcpy(&u, &v[i], 4);
+        bits = bits * 31 + u;
+      }
+    }
+    records += imu.count;
+  }
+};
+
+static uint32_t lcg(uint32_t &state)
+{
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+// One 0x25 frame: header, sensors IMU records, optional enviro, CRC8
+static size_t buildSyncFrame(uint8_t *out, uint32_t frameNumber,
+                             uint8_t sensors, bool withEnviro,
+                             uint32_t &rng)
+{
+  SyncFramePacket h;
+  h.type = SYNC_FRAME_PACKET_TYPE;
+  h.frameNumber = frameNumber;
+  h.timestampUs = frameNumber * 5000u;
+  h.sensorCount = sensors + (withEnviro ? 1 : 0);
+  memcpy(out, &h, sizeof(h));
+  size_t w = sizeof(h);
+  for (uint8_t s = 0; s < sensors; s++)
+  {
+    SyncFrameSensorData d;
+    d.sensorId = (uint8_t)(s + 1);
+    for (int k = 0; k < 3; k++)
+    {
+      d.a[k] = (int16_t)(lcg(rng) & 0xFFFF);
+      d.g[k] = (int16_t)(lcg(rng) & 0xFFFF);
+    }
+    d.flags = SYNC_SENSOR_FLAG_VALID;
+    d.reserved[0] = (uint8_t)(s / 4);
+    d.reserved[1] = (uint8_t)(s % 4);
+    memcpy(out + w, &d, sizeof(d));
+    w += sizeof(d);
+  }
+  if (withEnviro)
+  {
+    SyncFrameEnviroData e;
+    e.sensorId = 1;
+    e.mag[0] = 250;
+    e.mag[1] = -120;
+    e.mag[2] = 410;
+    e.pressureCPa = 10132500;
+    e.temperatureC = 2150;
+    e.flags = SYNC_SENSOR_FLAG_ENVIRO;
+    e.rawNodeId = 0;
+    e.contents = NODE_ENVIRO_HAS_MAG | NODE_ENVIRO_HAS_BARO;
+    memcpy(out + w, &e, sizeof(e));
+    w += sizeof(e);
+  }
+  out[w] = calculateCRC8(out, w);
+  return w + 1;
+}
+
+// Synthetic stream of about targetBytes in the given format. expected*
+// count what a decoder must return.
+static std::vector<uint8_t> buildStream(uint8_t format, uint8_t sensors,
+                                        size_t targetBytes,
+                                        uint64_t &expectedRecords,
+                                        uint64_t &expectedFrames)
+{
+  std::vector<uint8_t> out;
+  out.reserve(targetBytes + SESSION_PAGE_SIZE);
+  uint8_t frame[SYNC_STREAM_MAX_SYNC_FRAME];
+  uint8_t record[2 + SYNC_STREAM_MAX_SYNC_FRAME];
+  uint8_t encoded[SERIAL_COBS_MAX_ENCODED(SYNC_STREAM_MAX_SYNC_FRAME)];
+  uint8_t page[SESSION_PAGE_SIZE];
+  SessionChunkHeader chunk;
+  uint32_t chunkIndex = 0;
+  size_t pageUsed = 0;
+  uint32_t rng = 12345;
+  expectedRecords = 0;
+  expectedFrames = 0;
+
+  sessionChunkBegin(chunk, 1, chunkIndex);
+  for (uint32_t fn = 0; out.size() < targetBytes; fn++)
+  {
+    size_t len;
+    if (fn % BENCH_OTHER_EVERY == BENCH_OTHER_EVERY - 1)
+    {
+      // 0x09-style status frame: never part of a session
+      if (format == SYNC_STREAM_SESSION)
+        continue;
+      len = 16;
+      memset(frame, 0x5A, len);
+      frame[0] = 0x09;
+    }
+    else
+    {
+      len = buildSyncFrame(frame, fn, sensors,
+                           fn % BENCH_ENVIRO_EVERY == 0, rng);
+      expectedRecords += sensors;
+      expectedFrames++;
+    }
+
+    record[0] = (uint8_t)len;
+    record[1] = (uint8_t)(len >> 8);
+    memcpy(record + 2, frame, len);
+    if (format == SYNC_STREAM_COBS)
+    {
+      const size_t n = cobsEncodeFrame(frame, len, encoded, sizeof(encoded));
+      out.insert(out.end(), encoded, encoded + n);
+    }
+    else if (format == SYNC_STREAM_SESSION)
+    {
+      if (pageUsed + 2 + len > SESSION_CHUNK_PAYLOAD_MAX)
+      {
+        sessionChunkSeal(chunk, page + sizeof(chunk));
+        memcpy(page, &chunk, sizeof(chunk));
+        memset(page + sizeof(chunk) + pageUsed, 0xFF,
+               SESSION_CHUNK_PAYLOAD_MAX - pageUsed);
+        out.insert(out.end(), page, page + SESSION_PAGE_SIZE);
+        sessionChunkBegin(chunk, 1, ++chunkIndex);
+        pageUsed = 0;
+      }
+      memcpy(page + sizeof(chunk) + pageUsed, record, 2 + len);
+      sessionChunkAddRecord(chunk, record, 2 + len);
+      pageUsed += 2 + len;
+    }
+    else
+    {
+      out.insert(out.end(), record, record + 2 + len);
+    }
+  }
+  // Session: the last partly filled chunk is dropped with its frames, so
+  // the expected counts only cover whole pages
+  if (format == SYNC_STREAM_SESSION && pageUsed > 0)
+  {
+    expectedFrames -= chunk.recordCount;
+    expectedRecords -= (uint64_t)chunk.recordCount * sensors;
+  }
+  return out;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+static void report(const char *label, uint64_t bytes, uint64_t records,
+                   double seconds)
+{
+  printf("  %-22s %8.2f GB/s  %8.1f M records/s  (%.2f GB in %.2fs)\n", label,
+         bytes / seconds / 1e9, records / seconds / 1e6, bytes / 1e9, seconds);
+}
+
+static void printStats(const SyncStreamStats &s)
+{
+  printf("  frames %llu  imu %llu  corrections %llu  enviro %llu  other %llu\n"
+         "  crcErrors %llu  malformed %llu  resyncBytes %llu  badChunks %llu"
+         "  truncated %llu\n",
+         (unsigned long long)s.frames, (unsigned long long)s.imuRecords,
+         (unsigned long long)s.corrections,
+         (unsigned long long)s.enviroRecords,
+         (unsigned long long)s.otherFrames, (unsigned long long)s.crcErrors,
+         (unsigned long long)s.malformed, (unsigned long long)s.resyncBytes,
+         (unsigned long long)s.badChunks, (unsigned long long)s.truncatedBytes);
+}
+
+// Decode block repeatedly until gb gigabytes have been consumed
+static void runInMemory(const std::vector<uint8_t> &block, uint8_t format,
+                        bool simd, bool verifyCrc, double gb)
+{
+  SyncStreamOptions opts;
+  opts.format = format;
+  opts.simd = simd;
+  opts.verifyCrc = verifyCrc;
+  SyncStreamDecoder dec(opts);
+  BenchSink sink;
+  const uint64_t target = (uint64_t)(gb * 1e9);
+  uint64_t total = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  while (total < target)
+  {
+    const size_t used = dec.decode(block.data(), block.size(), sink);
+    total += block.size();
+    (void)used;
+  }
+  dec.finish(0, sink);
+  report(simd ? "decode (" SYNC_DECODE_SIMD_NAME ")" : "decode (scalar)", total,
+         sink.records, secondsSince(t0));
+}
+
+static void runConvertOnly(uint64_t records, bool simd)
+{
+  SyncImuBatch batch;
+  batch.allocate(SYNC_STREAM_DEFAULT_BATCH);
+  batch.count = SYNC_STREAM_DEFAULT_BATCH;
+  for (int c = 0; c < SYNC_COL_COUNT; c++)
+    for (size_t i = 0; i < batch.count; i++)
+      batch.raw[c][i] = (int16_t)(i * 37 + c);
+  uint64_t done = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  while (done < records)
+  {
+    batch.convert(simd);
+    done += batch.count;
+  }
+  const double s = secondsSince(t0);
+  volatile float keep = batch.value[SYNC_COL_GZ][batch.count - 1];
+  (void)keep;
+  // Input bytes of the conversion alone: 12 per record
+  report(simd ? "convert (" SYNC_DECODE_SIMD_NAME ")" : "convert (scalar)",
+         done * 12, done, s);
+}
+
+static bool verify(const std::vector<uint8_t> &block, uint8_t format,
+                   uint8_t sensors, uint64_t expectedRecords,
+                   uint64_t expectedFrames)
+{
+  SyncStreamOptions opts;
+  opts.format = format;
+  HashSink vec, sca;
+  SyncStreamDecoder a(opts);
+  a.finish(block.size() - a.decode(block.data(), block.size(), vec), vec);
+  opts.simd = false;
+  SyncStreamDecoder b(opts);
+  b.finish(block.size() - b.decode(block.data(), block.size(), sca), sca);
+
+  // First frame re-derived from the generator
+  uint8_t frame[SYNC_STREAM_MAX_SYNC_FRAME];
+  uint32_t rng = 12345;
+  buildSyncFrame(frame, 0, sensors, true, rng);
+  bool valuesOk = true;
+  opts.simd = true;
+  SyncStreamDecoder d(opts);
+  bool first = true;
+  auto check = [&](const SyncImuBatch &imu, const SyncEnviroBatch &)
+  {
+    if (!first)
+      return;
+    first = false;
+    for (uint8_t s = 0; s < sensors; s++)
+    {
+      SyncFrameSensorData r;
+      memcpy(&r, frame + SYNC_FRAME_HEADER_SIZE + s * SYNC_FRAME_SENSOR_SIZE,
+             sizeof(r));
+      for (int k = 0; k < 3; k++)
+      {
+        valuesOk &= imu.value[SYNC_COL_AX + k][s] ==
+                    r.a[k] * (1.0f / SYNC_FRAME_ACCEL_LSB_PER_MS2);
+        valuesOk &= imu.value[SYNC_COL_GX + k][s] ==
+                    r.g[k] * (1.0f / SYNC_FRAME_GYRO_LSB_PER_RADS);
+      }
+      valuesOk &= imu.sensorId[s] == r.sensorId &&
+                  imu.aux[s] == r.reserved[1];
+    }
+  };
+  d.finish(block.size() - d.decode(block.data(), block.size(), check), check);
+
+  // Sliced CRCs against the firmware's own
+  SyncCrc8 crc8;
+  SyncCrc32 crc32;
+  bool crcOk = true;
+  for (size_t n = 0; n < 600 && n < block.size(); n += 7)
+    crcOk &= crc8.compute(block.data(), n) == calculateCRC8(block.data(), n) &&
+             crc32.compute(block.data(), n, 0x1234u) ==
+                 serialFramingCrc32(block.data(), n, 0x1234u);
+
+  // Damaged copy: every fault must be caught, never decoded as data
+  std::vector<uint8_t> bad(block.begin(),
+                           block.begin() + std::min<size_t>(block.size(),
+                                                            4u << 20));
+  for (size_t k = 1000; k < bad.size(); k += 100003)
+    bad[k] ^= 0x10;
+  HashSink badSink, cleanSink;
+  SyncStreamOptions badOpts;
+  badOpts.format = format;
+  SyncStreamDecoder e(badOpts);
+  e.finish(bad.size() - e.decode(bad.data(), bad.size(), badSink), badSink);
+  SyncStreamDecoder g(badOpts);
+  g.finish(bad.size() - g.decode(block.data(), bad.size(), cleanSink),
+           cleanSink);
+  const SyncStreamStats &es = e.getStats();
+  const bool damageOk =
+      es.crcErrors + es.malformed + es.resyncBytes + es.badChunks > 0 &&
+      badSink.records < cleanSink.records;
+
+  const SyncStreamStats &st = a.getStats();
+  const bool ok = vec.bits == sca.bits && vec.records == expectedRecords &&
+                  crcOk && damageOk &&
+                  st.frames == expectedFrames && st.crcErrors == 0 &&
+                  st.malformed == 0 && st.resyncBytes == 0 && valuesOk;
+  printf("verify: %s (vector == scalar: %s, records %llu/%llu, values %s, "
+         "crc %s, damage %s)\n",
+         ok ? "OK" : "FAILED", vec.bits == sca.bits ? "yes" : "NO",
+         (unsigned long long)vec.records, (unsigned long long)expectedRecords,
+         valuesOk ? "ok" : "WRONG", crcOk ? "ok" : "WRONG",
+         damageOk ? "caught" : "MISSED");
+  printStats(st);
+  return ok;
+}
+
+static int parseFormat(const char *s)
+{
+  if (!strcmp(s, "legacy"))
+    return SYNC_STREAM_LEGACY;
+  if (!strcmp(s, "cobs"))
+    return SYNC_STREAM_COBS;
+  if (!strcmp(s, "session"))
+    return SYNC_STREAM_SESSION;
+  return -1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *capture = NULL;
+  const char *writePath = NULL;
+  int format = SYNC_STREAM_LEGACY;
+  double gb = 4.0;
+  int sensors = 12;
+  bool verifyCrc = true;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--format") && i + 1 < argc)
+      format = parseFormat(argv[++i]);
+    else if (!strcmp(argv[i], "--gb") && i + 1 < argc)
+      gb = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--sensors") && i + 1 < argc)
+      sensors = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--no-crc"))
+      verifyCrc = false;
+    else if (!strcmp(argv[i], "--write") && i + 1 < argc)
+      writePath = argv[++i];
+    else if (argv[i][0] != '-')
+      capture = argv[i];
+    else
+      format = -1;
+  }
+  if (format < 0 || sensors < 1 || sensors > SYNC_STREAM_MAX_SYNC_RECORDS - 1 ||
+      gb <= 0)
+  {
+    fprintf(stderr, "usage: %s [capture] [--format legacy|cobs|session] "
+                    "[--gb N] [--sensors 1-31] [--no-crc] [--write out.bin]\n",
+            argv[0]);
+    return 2;
+  }
+
+  const char *names[] = {"legacy", "cobs", "session"};
+  printf("SyncStreamDecoder: %s conversion, %s CRC, %s stream\n",
+         SYNC_DECODE_SIMD_NAME, SYNC_DECODE_CLMUL ? "PCLMUL" : "table",
+         names[format]);
+
+  if (capture)
+  {
+    FILE *f = fopen(capture, "rb");
+    if (!f)
+    {
+      perror(capture);
+      return 1;
+    }
+    SyncStreamOptions opts;
+    opts.format = (uint8_t)format;
+    opts.verifyCrc = verifyCrc;
+    SyncStreamDecoder dec(opts);
+    BenchSink sink;
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool ok = dec.decodeFile(f, sink);
+    const double s = secondsSince(t0);
+    fclose(f);
+    report("file decode", dec.getStats().bytes, sink.records, s);
+    printStats(dec.getStats());
+    return ok ? 0 : 1;
+  }
+
+  uint64_t expectedRecords, expectedFrames;
+  const std::vector<uint8_t> block =
+      buildStream((uint8_t)format, (uint8_t)sensors, BENCH_BLOCK_BYTES,
+                  expectedRecords, expectedFrames);
+  printf("synthetic block: %.1f MB, %d sensors\n", block.size() / 1e6,
+         sensors);
+
+  if (writePath)
+  {
+    FILE *f = fopen(writePath, "wb");
+    if (!f)
+    {
+      perror(writePath);
+      return 1;
+    }
+    // Frame numbers repeat per block; the decoder does not care
+    uint64_t written = 0;
+    while (written < (uint64_t)(gb * 1e9) &&
+           fwrite(block.data(), 1, block.size(), f) == block.size())
+      written += block.size();
+    fclose(f);
+    printf("wrote %.2f GB to %s\n", written / 1e9, writePath);
+    return 0;
+  }
+
+  if (!verify(block, (uint8_t)format, (uint8_t)sensors, expectedRecords,
+              expectedFrames))
+    return 1;
+
+  runInMemory(block, (uint8_t)format, true, verifyCrc, gb);
+  runInMemory(block, (uint8_t)format, false, verifyCrc, gb);
+  runConvertOnly(expectedRecords * 4, true);
+  runConvertOnly(expectedRecords * 4, false);
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * GapFill.h - Synthesize a missing IMU sample from recent ones (SyncFrameBuffer)
+ *
+ * GapFillHistory keeps the last two REAL samples of one sensor, keyed by
+ * sample ordinal (frameNumber * TDMA_SAMPLES_PER_FRAME + sampleIndex).
+ * extrapolate() builds the sample for a later ordinal:
+ *
+ *   GAP_FILL_HOLD    repeat the newest sample
+ *   GAP_FILL_LINEAR  continue the trend of the last two, per axis
+ *   GAP_FILL_GYRO    constant angular rate: gyro held, accel (gravity plus
+ *                    slow linear acceleration) rotated by -w*dt into the
+ *                    sensor's predicted orientation
+ *
+ * Units are the wire units of TDMASensorData: accel m/s^2 * 100, gyro
+ * rad/s * 900. Results saturate at int16. Synthesized samples are never
+ * pushed back into the history, so errors do not compound.
+ *
+ * No locks: the owner serializes access.
+ ******************************************************************************/
+
+#ifndef GAP_FILL_H
+#define GAP_FILL_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define GAP_FILL_OFF 0
+#define GAP_FILL_HOLD 1
+#define GAP_FILL_LINEAR 2
+#define GAP_FILL_GYRO 3
+
+#define GAP_FILL_SAMPLE_PERIOD_S 0.005f // 200Hz sample clock
+#define GAP_FILL_GYRO_LSB 900.0f        // LSB per rad/s
+#define GAP_FILL_REWIND_SAMPLES 64      // Further back: the stream restarted
+
+struct GapFillHistory
+{
+  uint8_t count; // Real samples held (0..2); [1] is the newest
+  uint8_t sensorId;
+  uint8_t rawNodeId;
+  uint8_t localSensorIndex;
+  uint32_t ordinal[2];
+  int16_t a[2][3];
+  int16_t g[2][3];
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  // Record a real sample. Slightly out-of-order or duplicate ordinals are
+  // ignored; a different sensorId (column reassigned) or a jump back of
+  // more than GAP_FILL_REWIND_SAMPLES (frame numbers restarted) restarts
+  // the history.
+  void push(uint32_t sampleOrdinal, uint8_t id, uint8_t nodeId,
+            uint8_t localIndex, const int16_t *accel, const int16_t *gyro)
+  {
+    if (count > 0)
+    {
+      const int32_t step = (int32_t)(sampleOrdinal - ordinal[1]);
+      if (id != sensorId || step < -GAP_FILL_REWIND_SAMPLES)
+        reset();
+      else if (step <= 0)
+        return;
+    }
+    if (count > 0)
+    {
+      ordinal[0] = ordinal[1];
+      memcpy(a[0], a[1], sizeof(a[0]));
+      memcpy(g[0], g[1], sizeof(g[0]));
+    }
+    ordinal[1] = sampleOrdinal;
+    memcpy(a[1], accel, sizeof(a[1]));
+    memcpy(g[1], gyro, sizeof(g[1]));
+    sensorId = id;
+    rawNodeId = nodeId;
+    localSensorIndex = localIndex;
+    if (count < 2)
+      count++;
+  }
+
+  // Samples since the newest real one (0 if none or not later)
+  uint32_t gapTo(uint32_t sampleOrdinal) const
+  {
+    if (count == 0)
+      return 0;
+    const int32_t gap = (int32_t)(sampleOrdinal - ordinal[1]);
+    return gap > 0 ? (uint32_t)gap : 0;
+  }
+
+  // Synthesize the sample at sampleOrdinal. false if there is no history,
+  // the ordinal is not after it, or mode is GAP_FILL_OFF.
+  bool extrapolate(uint8_t mode, uint32_t sampleOrdinal, int16_t *accel,
+                   int16_t *gyro) const
+  {
+    const uint32_t gap = gapTo(sampleOrdinal);
+    if (gap == 0 || mode == GAP_FILL_OFF)
+      return false;
+
+    memcpy(accel, a[1], sizeof(a[1]));
+    memcpy(gyro, g[1], sizeof(g[1]));
+
+    if (mode == GAP_FILL_LINEAR && count == 2)
+    {
+      // Same slope as the last two real samples, however far apart
+      const int32_t span = (int32_t)(ordinal[1] - ordinal[0]);
+      for (uint8_t k = 0; k < 3; k++)
+      {
+        accel[k] = clamp16(a[1][k] + ((int32_t)(a[1][k] - a[0][k]) *
+                                      (int32_t)gap) / span);
+        gyro[k] = clamp16(g[1][k] + ((int32_t)(g[1][k] - g[0][k]) *
+                                     (int32_t)gap) / span);
+      }
+    }
+    else if (mode == GAP_FILL_GYRO)
+    {
+      // A world-fixed vector seen from a sensor turning at w rotates by
+      // -|w|t about w (Rodrigues)
+      float w[3] = {g[1][0] / GAP_FILL_GYRO_LSB, g[1][1] / GAP_FILL_GYRO_LSB,
+                    g[1][2] / GAP_FILL_GYRO_LSB};
+      const float rate = sqrtf(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+      if (rate > 1e-6f)
+      {
+        const float angle = -rate * GAP_FILL_SAMPLE_PERIOD_S * gap;
+        const float c = cosf(angle);
+        const float s = sinf(angle);
+        const float u[3] = {w[0] / rate, w[1] / rate, w[2] / rate};
+        const float v[3] = {(float)a[1][0], (float)a[1][1], (float)a[1][2]};
+        const float cross[3] = {u[1] * v[2] - u[2] * v[1],
+                                u[2] * v[0] - u[0] * v[2],
+                                u[0] * v[1] - u[1] * v[0]};
+        const float dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          accel[k] = clamp16((int32_t)lroundf(v[k] * c + cross[k] * s +
+                                              u[k] * dot * (1.0f - c)));
+        }
+      }
+    }
+    return true;
+  }
+
+  static int16_t clamp16(int32_t v)
+  {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+  }
+};
+
+#endif // GAP_FILL_H
@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * GatewayTelemetry.h - Versioned binary diagnostics (Gateway serial 0x09)
+ *
+ * Replaces the periodic String-built JSON diagnostics. Every packet is a
+ * fixed-layout little-endian struct filled in place on the caller's stack,
+ * so steady-state streaming never touches the heap for telemetry. JSON (0x06)
+ * is kept for interactive command responses and one-off events.
+ *
+ * Serial wire format (after the [len lo][len hi] prefix):
+ *   [0x09][version][kind][uptimeMs u32][kind-specific body]
+ *
+ *   INGEST    (every 5 s)  beacon jitter + per-node packets/expected/samples
+ *   SERIAL_TX (every 5 s)  USB queue depth, drops, heap, overload flag,
+ *                          credit balance + flow mode, batch budget +
+ *                          measured USB drain rate, cumulative credits used
+ *   SYNC      (every 5 s)  SyncFrameBuffer completion counters, RX queue
+ *   LOG       (on demand)  level + UTF-8 text (no terminator; length from
+ *                          the frame length) — replaces JSON "log" frames
+ *   FLOW      (on event)   USB credit flow control: mode changes and gap
+ *                          markers for sync frames the host never received
+ *
+ * Decoders must ignore trailing bytes they do not know about: new fields are
+ * only ever appended, and a layout change that is not an append bumps
+ * TELEMETRY_WIRE_VERSION. Host decoders: mash-app IMUParser.ts.
+ ******************************************************************************/
+
+#ifndef GATEWAY_TELEMETRY_H
+#define GATEWAY_TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TELEMETRY_PACKET_TYPE 0x09
+#define TELEMETRY_WIRE_VERSION 1
+
+#define TELEMETRY_JITTER_BUCKETS 8 // == TDMA_BEACON_JITTER_BUCKETS
+#define TELEMETRY_MAX_NODES 8      // == TDMA_MAX_NODES
+#define TELEMETRY_LOG_MAX_CHARS 160
+
+enum TelemetryKind : uint8_t
+{
+  TELEMETRY_KIND_INGEST = 1,
+  TELEMETRY_KIND_SERIAL_TX = 2,
+  TELEMETRY_KIND_SYNC = 3,
+  TELEMETRY_KIND_LOG = 4,
+  TELEMETRY_KIND_FLOW = 5
+};
+
+enum TelemetryLogLevel : uint8_t
+{
+  TELEMETRY_LOG_INFO = 0,
+  TELEMETRY_LOG_WARN = 1,
+  TELEMETRY_LOG_ERROR = 2
+};
+
+// USB sync-frame flow control (TelemetrySerialTx::flowMode, TelemetryFlow)
+enum TelemetryFlowMode : uint8_t
+{
+  TELEMETRY_FLOW_OPEN = 0,   // No credits granted yet: send everything
+  TELEMETRY_FLOW_CREDIT = 1, // Send only against host-granted credits
+  TELEMETRY_FLOW_LOSSY = 2   // Host starved us: newest frames + gap markers
+};
+
+enum TelemetryFlowEvent : uint8_t
+{
+  TELEMETRY_FLOW_EVENT_MODE = 1, // Flow mode changed
+  TELEMETRY_FLOW_EVENT_GAP = 2   // gapFrames sync frames were not sent
+};
+
+// TelemetrySerialTx::flags
+#define TELEMETRY_SERIAL_FLAG_OVERLOADED 0x01
+#define TELEMETRY_SERIAL_FLAG_STREAMING 0x02
+
+struct __attribute__((packed)) TelemetryHeader
+{
+  uint8_t type;      // TELEMETRY_PACKET_TYPE
+  uint8_t version;   // TELEMETRY_WIRE_VERSION
+  uint8_t kind;      // TelemetryKind
+  uint32_t uptimeMs; // Gateway millis() when the packet was built
+};
+
+struct __attribute__((packed)) TelemetryNodeStats
+{
+  uint8_t nodeId;
+  uint8_t phyMbps;
+  uint16_t packets;         // 0x26 packets received in the window
+  uint16_t expectedPackets; // TDMA frames in the window, 0 if not streaming
+  uint16_t samplesAdded;
+  uint16_t sampleAddFails;
+  uint16_t historical;
+};
+
+struct __attribute__((packed)) TelemetryIngest
+{
+  TelemetryHeader header;
+  uint16_t windowMs;
+  uint8_t channel;
+  uint32_t jitterHist[TELEMETRY_JITTER_BUCKETS]; // Cumulative since boot
+  uint32_t jitterMaxUs;
+  uint32_t txLatencyLastUs;
+  uint32_t txLatencyMaxUs;
+  uint8_t nodeCount;
+  TelemetryNodeStats nodes[TELEMETRY_MAX_NODES]; // Only nodeCount are sent
+};
+
+struct __attribute__((packed)) TelemetrySerialTx
+{
+  TelemetryHeader header;
+  uint32_t frames;
+  uint32_t batches;
+  uint32_t drops;
+  uint32_t dropsDelta; // Since the previous SERIAL_TX packet
+  uint8_t queueFree;
+  uint8_t queueSize;
+  uint16_t freeHeapKB;
+  uint16_t largestFreeBlockKB; // Fragmentation indicator
+  uint8_t flags;               // TELEMETRY_SERIAL_FLAG_*
+  uint32_t credits;            // Unused host credits (sync frames)
+  uint8_t flowMode;            // TelemetryFlowMode
+  uint16_t batchBudget;        // Current adaptive batch byte budget
+  uint16_t drainBytesPerMs;    // Host USB read rate, CDC TX space (EWMA)
+  uint32_t creditsUsed;        // Sync frames sent against credits, ever
+                               // (wraps); hosts diff it to count lost frames
+};
+
+struct __attribute__((packed)) TelemetrySync
+{
+  TelemetryHeader header;
+  uint32_t framesCompleted;
+  uint32_t framesTrulyComplete;
+  uint32_t framesPartial;
+  uint32_t framesIncomplete;
+  uint32_t framesDropped;
+  uint16_t trueSyncRatePermille;
+  uint8_t expectedSensors;
+  uint8_t effectiveSensors;
+  uint32_t syncFramesEmitted;
+  uint32_t beaconsSent;
+  uint32_t espNowRxProcessed;
+  uint32_t espNowRxDropped;
+  uint8_t rxQueueFree;
+  uint8_t rxQueueSize;
+};
+
+struct __attribute__((packed)) TelemetryLog
+{
+  TelemetryHeader header;
+  uint8_t level; // TelemetryLogLevel
+  char message[TELEMETRY_LOG_MAX_CHARS];
+};
+
+struct __attribute__((packed)) TelemetryFlow
+{
+  TelemetryHeader header;
+  uint8_t event;      // TelemetryFlowEvent
+  uint8_t mode;       // TelemetryFlowMode after the event
+  uint32_t credits;   // Unused host credits
+  uint32_t gapFrames; // GAP: sync frames skipped or overwritten
+  uint32_t gapFromUs; // GAP: sample timestamp of the last frame before
+  uint32_t gapToUs;   // GAP: sample timestamp of the first frame after
+};
+
+static_assert(sizeof(TelemetryHeader) == 7, "TelemetryHeader wire size");
+static_assert(sizeof(TelemetryNodeStats) == 12, "TelemetryNodeStats wire size");
+static_assert(sizeof(TelemetrySerialTx) == 43, "TelemetrySerialTx wire size");
+static_assert(sizeof(TelemetrySync) == 49, "TelemetrySync wire size");
+static_assert(offsetof(TelemetryIngest, nodes) == 55, "TelemetryIngest wire size");
+static_assert(sizeof(TelemetryFlow) == 25, "TelemetryFlow wire size");
+
+inline void telemetryBegin(TelemetryHeader &header, TelemetryKind kind,
+                           uint32_t uptimeMs)
+{
+  header.type = TELEMETRY_PACKET_TYPE;
+  header.version = TELEMETRY_WIRE_VERSION;
+  header.kind = kind;
+  header.uptimeMs = uptimeMs;
+}
+
+// USB credit flow: true when credit mode has to fall back to OPEN. A host
+// that was closed, crashed or unplugged never grants again, and the next
+// one may not speak the credit protocol at all. lastCreditMs is the last
+// CREDIT (or legacy PAUSE) received.
+inline bool telemetryCreditFlowExpired(bool creditMode, bool hostConnected,
+                                       uint32_t nowMs, uint32_t lastCreditMs,
+                                       uint32_t idleMs)
+{
+  if (!creditMode)
+    return false;
+  return !hostConnected || nowMs - lastCreditMs >= idleMs;
+}
+
+// Bytes of an INGEST packet carrying nodeCount node entries
+inline size_t telemetryIngestSize(uint8_t nodeCount)
+{
+  return offsetof(TelemetryIngest, nodes) +
+         (size_t)nodeCount * sizeof(TelemetryNodeStats);
+}
+
+// Fills a LOG packet, truncating the message. Returns bytes to send.
+inline size_t telemetryFormatLog(TelemetryLog &packet, TelemetryLogLevel level,
+                                 const char *message, uint32_t uptimeMs)
+{
+  telemetryBegin(packet.header, TELEMETRY_KIND_LOG, uptimeMs);
+  packet.level = level;
+  size_t len = message ? strlen(message) : 0;
+  if (len > TELEMETRY_LOG_MAX_CHARS)
+    len = TELEMETRY_LOG_MAX_CHARS;
+  if (len > 0)
+    memcpy(packet.message, message, len);
+  return offsetof(TelemetryLog, message) + len;
+}
+
+#endif // GATEWAY_TELEMETRY_H
@@ -7,6 +7,7 @@
  * Include this single header to get all library components:
  *   - ConfigBase.h:    Shared configuration constants
  *   - TDMAProtocol.h:  TDMA protocol definitions and helpers
+ *   - NodeDataCodec.h: Lossless compressed 0x26 sample block
  *   - Quaternion.h:    Quaternion data structure
  *   - PacketTypes.h:   ESP-NOW packet definitions
  *
@@ -31,6 +32,7 @@
 #include "ConfigBase.h"
 #include "Quaternion.h"
 #include "TDMAProtocol.h"
+#include "NodeDataCodec.h"
 #include "PacketTypes.h"
 
 #endif  // IMU_CONNECT_CORE_H
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * LatencyHistogram.h - HDR-style log-bucketed latency histogram
+ *
+ * Fixed memory, O(1) record, no floating point. Values (µs) below
+ * 2^LATENCY_HIST_SUB_BITS are counted exactly; above that every power of two
+ * is split into 2^LATENCY_HIST_SUB_BITS linear sub-buckets, so any reported
+ * percentile is within 1/8 (12.5%) of the true value at every scale:
+ *
+ *   bucket  0..7    : 0..7 µs (exact)
+ *   bucket  8..15   : 8..15 µs (exact)
+ *   bucket 16..23   : 16..31 µs (2 µs wide)
+ *   ...
+ *   bucket 168..175 : 8.4..16.7 s (values above are clamped into the last)
+ *
+ * Not thread-safe: give each histogram a single writer, or wrap record() and
+ * snapshots in the owner's lock.
+ *
+ * Serial wire format (Gateway packet 0x08, one or more per stage):
+ *   [0x08][version][stage][subBits][count u32][maxUs u32]
+ *   [firstBucket u8][bucketCount u8][bucketCount x u32 counts]
+ * Counts are cumulative since the last reset; buckets outside the sent range
+ * are zero. Long ranges are split across packets (LATENCY_WIRE_MAX_BUCKETS).
+ ******************************************************************************/
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define LATENCY_HIST_SUB_BITS 3
+#define LATENCY_HIST_SUB_COUNT (1u << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_MAX_MSB 23 // Largest tracked power of two (2^24-1 µs)
+#define LATENCY_HIST_BUCKETS \
+  ((LATENCY_HIST_MAX_MSB - LATENCY_HIST_SUB_BITS + 2) * LATENCY_HIST_SUB_COUNT)
+
+#define LATENCY_PACKET_TYPE 0x08
+#define LATENCY_WIRE_VERSION 1
+#define LATENCY_WIRE_HEADER_SIZE 14
+#define LATENCY_WIRE_MAX_BUCKETS 120 // 14 + 120*4 = 494 bytes per packet
+
+static_assert(LATENCY_HIST_BUCKETS <= 256, "Bucket index must fit in a byte");
+
+// Gateway pipeline stages (all in Gateway micros(); sample timestamps are
+// beacon-derived, i.e. already on the Gateway clock). SERIAL_BATCH and
+// ADD_SAMPLE reuse the histogram for other units: bytes and CPU cycles.
+enum LatencyStage : uint8_t
+{
+  LATENCY_STAGE_AIR = 0,          // Sample capture -> ESP-NOW RX callback
+  LATENCY_STAGE_INGEST_QUEUE = 1, // RX callback -> DataIngestionTask dequeue
+  LATENCY_STAGE_SYNC_WAIT = 2,    // First sample in slot -> 0x25 emitted
+  LATENCY_STAGE_SERIAL_QUEUE = 3, // 0x25 published -> USB write returned
+  LATENCY_STAGE_END_TO_END = 4,   // Sample capture -> USB write returned
+  LATENCY_STAGE_SERIAL_FLUSH = 5, // USB batch opened -> write returned
+  LATENCY_STAGE_SERIAL_BATCH = 6, // USB batch size (bytes)
+  LATENCY_STAGE_ADD_SAMPLE = 7,   // SyncFrameBuffer::addSample() (CPU cycles)
+  LATENCY_STAGE_COUNT = 8
+};
+
+inline uint8_t latencyBucketIndex(uint32_t valueUs)
+{
+  if (valueUs < LATENCY_HIST_SUB_COUNT)
+    return (uint8_t)valueUs;
+  if (valueUs >> (LATENCY_HIST_MAX_MSB + 1))
+    return LATENCY_HIST_BUCKETS - 1;
+  uint8_t msb = 31 - __builtin_clz(valueUs);
+  uint8_t sub = (valueUs >> (msb - LATENCY_HIST_SUB_BITS)) &
+                (LATENCY_HIST_SUB_COUNT - 1);
+  return (uint8_t)((msb - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_COUNT +
+                   sub);
+}
+
+// Smallest value that maps to bucket
+inline uint32_t latencyBucketLowUs(uint8_t bucket)
+{
+  if (bucket < LATENCY_HIST_SUB_COUNT)
+    return bucket;
+  uint8_t msb = bucket / LATENCY_HIST_SUB_COUNT + LATENCY_HIST_SUB_BITS - 1;
+  uint32_t top = LATENCY_HIST_SUB_COUNT + bucket % LATENCY_HIST_SUB_COUNT;
+  return top << (msb - LATENCY_HIST_SUB_BITS);
+}
+
+// Largest value that maps to bucket
+inline uint32_t latencyBucketHighUs(uint8_t bucket)
+{
+  if (bucket < LATENCY_HIST_SUB_COUNT)
+    return bucket;
+  uint8_t msb = bucket / LATENCY_HIST_SUB_COUNT + LATENCY_HIST_SUB_BITS - 1;
+  return latencyBucketLowUs(bucket) + (1u << (msb - LATENCY_HIST_SUB_BITS)) - 1;
+}
+
+struct LatencyHistogram
+{
+  uint32_t counts[LATENCY_HIST_BUCKETS];
+  uint32_t total;
+  uint32_t maxUs;
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  void record(uint32_t valueUs)
+  {
+    counts[latencyBucketIndex(valueUs)]++;
+    total++;
+    if (valueUs > maxUs)
+      maxUs = valueUs;
+  }
+
+  // Highest value equivalent to the given percentile in permille
+  // (500 = p50, 990 = p99, 999 = p99.9). Never above maxUs.
+  uint32_t percentileUs(uint16_t perMille) const
+  {
+    if (total == 0)
+      return 0;
+    // Rank of the sample at this percentile (1-based, rounded up)
+    uint64_t rank = ((uint64_t)total * perMille + 999) / 1000;
+    if (rank == 0)
+      rank = 1;
+    uint64_t seen = 0;
+    for (uint16_t b = 0; b < LATENCY_HIST_BUCKETS; b++)
+    {
+      seen += counts[b];
+      if (seen >= rank)
+      {
+        uint32_t high = latencyBucketHighUs((uint8_t)b);
+        return (high < maxUs) ? high : maxUs;
+      }
+    }
+    return maxUs;
+  }
+
+  // Non-empty bucket range; returns false if the histogram is empty
+  bool occupiedRange(uint8_t &first, uint8_t &last) const
+  {
+    if (total == 0)
+      return false;
+    uint16_t lo = 0;
+    while (lo < LATENCY_HIST_BUCKETS && counts[lo] == 0)
+      lo++;
+    uint16_t hi = LATENCY_HIST_BUCKETS - 1;
+    while (hi > lo && counts[hi] == 0)
+      hi--;
+    first = (uint8_t)lo;
+    last = (uint8_t)hi;
+    return true;
+  }
+
+  // Serialize buckets [first, first + bucketCount) as one wire packet.
+  // Returns bytes written (0 if out does not fit).
+  size_t writeWirePacket(uint8_t stage, uint8_t first, uint8_t bucketCount,
+                         uint8_t *out, size_t maxLen) const
+  {
+    size_t len = LATENCY_WIRE_HEADER_SIZE + (size_t)bucketCount * 4;
+    if (len > maxLen || (uint16_t)first + bucketCount > LATENCY_HIST_BUCKETS)
+      return 0;
+    out[0] = LATENCY_PACKET_TYPE;
+    out[1] = LATENCY_WIRE_VERSION;
+    out[2] = stage;
+    out[3] = LATENCY_HIST_SUB_BITS;
+    memcpy(out + 4, &total, 4);
+    memcpy(out + 8, &maxUs, 4);
+    out[12] = first;
+    out[13] = bucketCount;
+    memcpy(out + LATENCY_WIRE_HEADER_SIZE, &counts[first],
+           (size_t)bucketCount * 4);
+    return len;
+  }
+};
+
+#endif // LATENCY_HISTOGRAM_H
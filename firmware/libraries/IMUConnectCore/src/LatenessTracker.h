@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * LatenessTracker.h - Per-sensor arrival lateness estimate (SyncFrameBuffer)
+ *
+ * Lateness is how long after the first sample of a (frameNumber, sampleIndex)
+ * reaches the Gateway a given sensor's sample for the same moment arrives.
+ * Under TDMA it is mostly the node's slot position in the frame, plus RF and
+ * queueing jitter, plus the odd retry burst. Per sensor:
+ *
+ *   meanUs, devUs  EWMA (1/16) of the lateness and of |lateness - mean|
+ *   counts[]       1ms buckets up to LATENESS_BUCKETS ms (+1 overflow
+ *                  bucket), halved every LATENESS_DECAY_SAMPLES samples, so
+ *                  they describe roughly the last two decay periods
+ *
+ * deadlineUs() is the upper edge of the bucket holding the
+ * LATENESS_QUANTILE_PERMILLE quantile, or the one passed in (at least
+ * LATENESS_MIN_DEADLINE_US):
+ * a slot still missing this sensor may be emitted that long after its first
+ * arrival. If the quantile is in the overflow bucket the sensor has no
+ * adaptive deadline (LATENESS_NO_DEADLINE) and the caller keeps its fixed
+ * timeouts. Before LATENESS_WARMUP_SAMPLES the estimate is not trusted
+ * (warmedUp() false).
+ *
+ * missStreak counts frames emitted without this sensor in a row. From
+ * LATENESS_ABSENT_STREAK on the sensor is absent(): slots stop waiting for
+ * it until its next sample arrives (record() clears the streak).
+ *
+ * No floating point, no locks: the owner serializes access.
+ ******************************************************************************/
+
+#ifndef LATENESS_TRACKER_H
+#define LATENESS_TRACKER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LATENESS_QUANTILE_PERMILLE
+#define LATENESS_QUANTILE_PERMILLE 995
+#endif
+
+#define LATENESS_BUCKET_US 1000
+#define LATENESS_BUCKETS 40            // 0..40ms; beyond goes to overflow
+#define LATENESS_DECAY_SAMPLES 1024    // ~5s of one sensor at 200Hz
+#define LATENESS_EWMA_SHIFT 4          // 1/16 per sample
+#define LATENESS_WARMUP_SAMPLES 64     // ~0.3s of one sensor at 200Hz
+#define LATENESS_MIN_DEADLINE_US 2000  // Never cut a slot tighter than this
+#define LATENESS_ABSENT_STREAK 8       // Missed frames before "absent"
+#define LATENESS_MAX_US 1000000        // Clamp for the EWMAs
+#define LATENESS_NO_DEADLINE UINT32_MAX
+
+struct LatenessTracker
+{
+  uint16_t counts[LATENESS_BUCKETS + 1]; // Last bucket: >= LATENESS_BUCKETS ms
+  uint16_t total;                        // Sum of counts (decays with them)
+  uint16_t sinceDecay;
+  uint32_t meanUs;
+  uint32_t devUs;
+  uint32_t samples; // Since reset, saturates
+  uint8_t missStreak;
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  void record(uint32_t latenessUs)
+  {
+    if (latenessUs > LATENESS_MAX_US)
+      latenessUs = LATENESS_MAX_US;
+    missStreak = 0;
+
+    uint32_t bucket = latenessUs / LATENESS_BUCKET_US;
+    if (bucket > LATENESS_BUCKETS)
+      bucket = LATENESS_BUCKETS;
+    counts[bucket]++;
+    total++;
+    if (++sinceDecay >= LATENESS_DECAY_SAMPLES)
+    {
+      sinceDecay = 0;
+      total = 0;
+      for (uint8_t b = 0; b <= LATENESS_BUCKETS; b++)
+      {
+        counts[b] >>= 1;
+        total += counts[b];
+      }
+    }
+
+    if (samples == 0)
+    {
+      meanUs = latenessUs;
+      devUs = 0;
+    }
+    else
+    {
+      // mean + floor(err/16) never drops below 0 because err >= -mean
+      const int32_t err = (int32_t)latenessUs - (int32_t)meanUs;
+      meanUs = (uint32_t)((int32_t)meanUs + (err >> LATENESS_EWMA_SHIFT));
+      const int32_t absErr = err < 0 ? -err : err;
+      devUs = (uint32_t)((int32_t)devUs +
+                         ((absErr - (int32_t)devUs) >> LATENESS_EWMA_SHIFT));
+    }
+
+    if (samples < UINT32_MAX)
+      samples++;
+  }
+
+  // A frame left without this sensor
+  void noteMissed()
+  {
+    if (missStreak < UINT8_MAX)
+      missStreak++;
+  }
+
+  // Upper edge of the quantile's bucket, or LATENESS_NO_DEADLINE
+  uint32_t quantileUs(uint16_t permille = LATENESS_QUANTILE_PERMILLE) const
+  {
+    if (total == 0)
+      return LATENESS_NO_DEADLINE;
+    const uint32_t rank = ((uint32_t)total * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LATENESS_BUCKETS; b++)
+    {
+      seen += counts[b];
+      if (seen >= rank)
+        return (uint32_t)(b + 1) * LATENESS_BUCKET_US;
+    }
+    return LATENESS_NO_DEADLINE;
+  }
+
+  uint32_t deadlineUs(uint16_t permille = LATENESS_QUANTILE_PERMILLE) const
+  {
+    const uint32_t q = quantileUs(permille);
+    return q < LATENESS_MIN_DEADLINE_US ? LATENESS_MIN_DEADLINE_US : q;
+  }
+
+  bool warmedUp() const { return samples >= LATENESS_WARMUP_SAMPLES; }
+  bool absent() const { return missStreak >= LATENESS_ABSENT_STREAK; }
+};
+
+#endif // LATENESS_TRACKER_H
@@ -0,0 +1,313 @@
+/*******************************************************************************
+ * MagEllipsoidFit.h - Incremental least-squares ellipsoid fit (magnetometer)
+ *
+ * Raw readings of a constant field lie on an ellipsoid: hard iron shifts its
+ * centre, soft iron stretches and rotates it. Fit the general quadric
+ *
+ *   A x² + B y² + C z² + 2D xy + 2E xz + 2F yz + 2G x + 2H y + 2I z = 1
+ *
+ * by least squares. magFitAdd() only updates the normal equations
+ * (sum of phi·phiᵀ and phi, phi = [x² y² z² 2xy 2xz 2yz 2x 2y 2z]), so each
+ * sample is O(1) and no samples are stored. magFitSolve() runs a 9x9
+ * Cholesky solve and can be called as often as the caller likes.
+ *
+ * From the quadric (Q = [[A D E][D B F][E F C]], v = [G H I]):
+ *   centre   c = -Q⁻¹ v                         (hard iron)
+ *   shape    S = Q / (1 + cᵀ Q c)               ((x-c)ᵀ S (x-c) = 1)
+ *   softIron W = sqrt(S) · R,  R = det(S)^(-1/6) (geometric mean radius)
+ * so corrected = W (raw - c) lies on a sphere of radius R, in µT.
+ *
+ * Quality metrics, both O(1) from the running state:
+ *   fitError  RMS algebraic residual of the sums, converted to the RMS
+ *             relative radial error; reported as % of R.
+ *   coverage  share of 26 direction bins (cube faces, edges, corners) that
+ *             have seen a sample. Directions are taken around the centre
+ *             set by magFitSetCenter() (feed back each valid solve), or the
+ *             running min/max midpoint until then.
+ *
+ * Inputs are divided by MAG_FIT_UNIT_UT and the sums are doubles to keep the
+ * normal equations well conditioned. Not thread-safe: single writer.
+ ******************************************************************************/
+
+#ifndef MAG_ELLIPSOID_FIT_H
+#define MAG_ELLIPSOID_FIT_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAG_FIT_PARAMS 9
+#define MAG_FIT_UNIT_UT 50.0f         // Scale: Earth's field is ~25-65 µT
+#define MAG_FIT_DIRECTION_BINS 26
+#define MAG_FIT_BIN_WARMUP 10         // Samples before the centre is trusted
+#define MAG_FIT_BIN_THRESHOLD 0.383f  // sin(22.5°): axis component -> -1/0/+1
+
+struct MagEllipsoidFit
+{
+  double ata[MAG_FIT_PARAMS][MAG_FIT_PARAMS]; // Upper triangle used
+  double atb[MAG_FIT_PARAMS];
+  uint32_t count;
+  uint32_t directionMask; // Bit (q0+1)*9 + (q1+1)*3 + (q2+1), 13 never set
+  float minV[3], maxV[3]; // Running extents (scaled units)
+  float binCenter[3];     // Direction-bin origin (scaled units)
+  bool hasBinCenter;
+};
+
+struct MagEllipsoidSolution
+{
+  bool valid;
+  float center[3];   // Hard iron (µT)
+  float softIron[9]; // Row-major: corrected = softIron * (raw - center)
+  float radius;      // Corrected field magnitude (µT)
+  float fitError;    // RMS radial residual, % of radius
+};
+
+inline void magFitReset(MagEllipsoidFit &f)
+{
+  memset(&f, 0, sizeof(f));
+}
+
+inline void magFitAdd(MagEllipsoidFit &f, float xUt, float yUt, float zUt)
+{
+  const float v[3] = {xUt / MAG_FIT_UNIT_UT, yUt / MAG_FIT_UNIT_UT,
+                      zUt / MAG_FIT_UNIT_UT};
+  const double x = v[0], y = v[1], z = v[2];
+  const double phi[MAG_FIT_PARAMS] = {x * x, y * y, z * z,
+                                      2 * x * y, 2 * x * z, 2 * y * z,
+                                      2 * x, 2 * y, 2 * z};
+
+  for (uint8_t i = 0; i < MAG_FIT_PARAMS; i++)
+  {
+    for (uint8_t j = i; j < MAG_FIT_PARAMS; j++)
+      f.ata[i][j] += phi[i] * phi[j];
+    f.atb[i] += phi[i];
+  }
+
+  for (uint8_t k = 0; k < 3; k++)
+  {
+    if (f.count == 0 || v[k] < f.minV[k])
+      f.minV[k] = v[k];
+    if (f.count == 0 || v[k] > f.maxV[k])
+      f.maxV[k] = v[k];
+  }
+  f.count++;
+
+  // Direction bin around the fitted centre (or the extents' midpoint)
+  if (!f.hasBinCenter && f.count <= MAG_FIT_BIN_WARMUP)
+    return;
+  float d[3], norm = 0;
+  for (uint8_t k = 0; k < 3; k++)
+  {
+    float centre = f.hasBinCenter ? f.binCenter[k]
+                                  : 0.5f * (f.minV[k] + f.maxV[k]);
+    d[k] = v[k] - centre;
+    norm += d[k] * d[k];
+  }
+  if (norm < 1e-6f)
+    return;
+  norm = sqrtf(norm);
+  uint8_t bin = 0;
+  for (uint8_t k = 0; k < 3; k++)
+  {
+    float u = d[k] / norm;
+    int8_t q = (u > MAG_FIT_BIN_THRESHOLD) - (u < -MAG_FIT_BIN_THRESHOLD);
+    bin = bin * 3 + (uint8_t)(q + 1);
+  }
+  f.directionMask |= (1UL << bin);
+}
+
+// Use a fitted hard-iron centre (µT) as the origin for direction bins
+inline void magFitSetCenter(MagEllipsoidFit &f, const float centerUt[3])
+{
+  for (uint8_t k = 0; k < 3; k++)
+    f.binCenter[k] = centerUt[k] / MAG_FIT_UNIT_UT;
+  f.hasBinCenter = true;
+}
+
+// Visited direction bins, 0-100 %
+inline uint8_t magFitCoverage(const MagEllipsoidFit &f)
+{
+  uint32_t mask = f.directionMask;
+  uint8_t bins = 0;
+  while (mask)
+  {
+    mask &= mask - 1;
+    bins++;
+  }
+  return (uint8_t)(bins * 100 / MAG_FIT_DIRECTION_BINS);
+}
+
+// Symmetric 3x3 eigen-decomposition (cyclic Jacobi). a is destroyed; on
+// return its diagonal holds the eigenvalues and the columns of vec the
+// matching eigenvectors.
+inline void magFitEigen3(double a[3][3], double vec[3][3])
+{
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++)
+      vec[i][j] = (i == j) ? 1.0 : 0.0;
+
+  for (uint8_t sweep = 0; sweep < 16; sweep++)
+  {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    if (off < 1e-24)
+      break;
+    for (uint8_t p = 0; p < 2; p++)
+    {
+      for (uint8_t q = p + 1; q < 3; q++)
+      {
+        if (fabs(a[p][q]) < 1e-30)
+          continue;
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = (theta >= 0 ? 1.0 : -1.0) /
+                   (fabs(theta) + sqrt(theta * theta + 1));
+        double c = 1 / sqrt(t * t + 1), s = t * c;
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          double vkp = vec[k][p], vkq = vec[k][q];
+          vec[k][p] = c * vkp - s * vkq;
+          vec[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+// Solve the current normal equations. Returns false (out.valid = false)
+// until the samples pin down a real ellipsoid: too few samples, rotation
+// in a single plane, or a fitted quadric that is not an ellipsoid.
+inline bool magFitSolve(const MagEllipsoidFit &f, MagEllipsoidSolution &out)
+{
+  memset(&out, 0, sizeof(out));
+  if (f.count < 2 * MAG_FIT_PARAMS)
+    return false;
+
+  // Cholesky L·Lᵀ = ata (lower triangle in l)
+  double l[MAG_FIT_PARAMS][MAG_FIT_PARAMS] = {};
+  double trace = 0;
+  for (uint8_t i = 0; i < MAG_FIT_PARAMS; i++)
+    trace += f.ata[i][i];
+  for (uint8_t i = 0; i < MAG_FIT_PARAMS; i++)
+  {
+    for (uint8_t j = 0; j <= i; j++)
+    {
+      double sum = f.ata[j][i];
+      for (uint8_t k = 0; k < j; k++)
+        sum -= l[i][k] * l[j][k];
+      if (i == j)
+      {
+        if (sum <= trace * 1e-12)
+          return false; // Singular: the samples do not span an ellipsoid
+        l[i][i] = sqrt(sum);
+      }
+      else
+      {
+        l[i][j] = sum / l[j][j];
+      }
+    }
+  }
+
+  double p[MAG_FIT_PARAMS];
+  for (uint8_t i = 0; i < MAG_FIT_PARAMS; i++)
+  {
+    double sum = f.atb[i];
+    for (uint8_t k = 0; k < i; k++)
+      sum -= l[i][k] * p[k];
+    p[i] = sum / l[i][i];
+  }
+  for (int8_t i = MAG_FIT_PARAMS - 1; i >= 0; i--)
+  {
+    double sum = p[i];
+    for (uint8_t k = i + 1; k < MAG_FIT_PARAMS; k++)
+      sum -= l[k][i] * p[k];
+    p[i] = sum / l[i][i];
+  }
+
+  // Residual sum of squares: pᵀ·ata·p - 2·pᵀ·atb + N
+  double rss = (double)f.count;
+  for (uint8_t i = 0; i < MAG_FIT_PARAMS; i++)
+  {
+    double row = 0;
+    for (uint8_t j = 0; j < MAG_FIT_PARAMS; j++)
+      row += (i <= j ? f.ata[i][j] : f.ata[j][i]) * p[j];
+    rss += p[i] * row - 2 * p[i] * f.atb[i];
+  }
+
+  // Centre c = -Q⁻¹ v (cofactor inverse)
+  const double q[3][3] = {{p[0], p[3], p[4]},
+                          {p[3], p[1], p[5]},
+                          {p[4], p[5], p[2]}};
+  double det = q[0][0] * (q[1][1] * q[2][2] - q[1][2] * q[2][1]) -
+               q[0][1] * (q[1][0] * q[2][2] - q[1][2] * q[2][0]) +
+               q[0][2] * (q[1][0] * q[2][1] - q[1][1] * q[2][0]);
+  if (fabs(det) < 1e-18)
+    return false;
+  double inv[3][3] = {
+      {q[1][1] * q[2][2] - q[1][2] * q[2][1],
+       q[0][2] * q[2][1] - q[0][1] * q[2][2],
+       q[0][1] * q[1][2] - q[0][2] * q[1][1]},
+      {q[1][2] * q[2][0] - q[1][0] * q[2][2],
+       q[0][0] * q[2][2] - q[0][2] * q[2][0],
+       q[0][2] * q[1][0] - q[0][0] * q[1][2]},
+      {q[1][0] * q[2][1] - q[1][1] * q[2][0],
+       q[0][1] * q[2][0] - q[0][0] * q[2][1],
+       q[0][0] * q[1][1] - q[0][1] * q[1][0]}};
+  const double v[3] = {p[6], p[7], p[8]};
+  double c[3];
+  for (uint8_t i = 0; i < 3; i++)
+    c[i] = -(inv[i][0] * v[0] + inv[i][1] * v[1] + inv[i][2] * v[2]) / det;
+
+  double k = 1;
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++)
+      k += c[i] * q[i][j] * c[j];
+  // k < 0 when the origin lies outside the ellipsoid (hard iron larger than
+  // the field); S = Q/k is still the shape, so only k ≈ 0 is degenerate
+  if (fabs(k) < 1e-9)
+    return false;
+
+  double s[3][3], vec[3][3];
+  for (uint8_t i = 0; i < 3; i++)
+    for (uint8_t j = 0; j < 3; j++)
+      s[i][j] = q[i][j] / k;
+  magFitEigen3(s, vec);
+  if (s[0][0] <= 0 || s[1][1] <= 0 || s[2][2] <= 0)
+    return false; // Hyperboloid: not an ellipsoid
+
+  // Geometric mean radius R = det(S)^(-1/6); W = V·diag(sqrt(λ)·R)·Vᵀ
+  double radius = pow(s[0][0] * s[1][1] * s[2][2], -1.0 / 6.0);
+  double gain[3];
+  for (uint8_t i = 0; i < 3; i++)
+    gain[i] = sqrt(s[i][i]) * radius;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    for (uint8_t j = 0; j < 3; j++)
+    {
+      double w = 0;
+      for (uint8_t e = 0; e < 3; e++)
+        w += vec[i][e] * gain[e] * vec[j][e];
+      out.softIron[i * 3 + j] = (float)w;
+    }
+  }
+
+  for (uint8_t i = 0; i < 3; i++)
+    out.center[i] = (float)c[i] * MAG_FIT_UNIT_UT;
+  out.radius = (float)radius * MAG_FIT_UNIT_UT;
+  // Algebraic residual = k·((x-c)ᵀS(x-c) - 1) ≈ 2k × relative radial error
+  out.fitError = (float)(50.0 * sqrt((rss > 0 ? rss : 0) / f.count) / fabs(k));
+  out.valid = true;
+  return true;
+}
+
+#endif // MAG_ELLIPSOID_FIT_H
@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * NodeDataCodec.h - Lossless compressed payload for 0x26 Node data packets
+ *
+ * A raw 0x26 payload repeats a full 17-byte TDMABatchedSensorData for every
+ * sensor of every sample, including a 32-bit timestamp that only ever moves
+ * by ~5000µs between samples. The compressed variant (NODE_DATA_FLAG_COMPRESSED)
+ * keeps the 10-byte header, SyncQualityFlags and CRC8 unchanged and replaces
+ * only the sample block:
+ *
+ *   [baseTimestampUs : u32 LE]
+ *   [sensorId × sensorCount]                 (identical for every sample)
+ *   for each sample s, for each sensor i:
+ *     varint(zigzag(ts[s][i] - prevTs))      (prevTs starts at base)
+ *     varint(zigzag(a[s][i][k] - a[s-1][i][k]))  k = 0..2 (s=0: vs 0)
+ *     varint(zigzag(g[s][i][k] - g[s-1][i][k]))  k = 0..2 (s=0: vs 0)
+ *
+ * Each packet is self-contained (no state across packets), so a lost packet
+ * never corrupts the next one. Deltas are taken in 32-bit arithmetic, so the
+ * encoding is exact for any int16 input and any timestamp wrap.
+ *
+ * The encoder returns 0 whenever the compressed block would not be strictly
+ * smaller than the raw block — the caller then sends the raw layout, so a
+ * compressed packet is never larger than its raw equivalent.
+ ******************************************************************************/
+
+#ifndef NODE_DATA_CODEC_H
+#define NODE_DATA_CODEC_H
+
+#include "TDMAProtocol.h"
+#include <string.h>
+
+// Worst-case varint length for a zigzag-encoded 32-bit value
+#define NODE_DATA_VARINT_MAX_BYTES 5
+
+// ============================================================================
+// ZigZag / Varint primitives
+// ============================================================================
+
+inline uint32_t zigzagEncode32(int32_t v)
+{
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t zigzagDecode32(uint32_t v)
+{
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Append an unsigned LEB128 varint. Returns false if it would exceed cap.
+inline bool writeVarint32(uint8_t *dst, size_t cap, size_t &offset,
+                          uint32_t value)
+{
+  do
+  {
+    if (offset >= cap)
+      return false;
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value != 0)
+      byte |= 0x80;
+    dst[offset++] = byte;
+  } while (value != 0);
+  return true;
+}
+
+// Read an unsigned LEB128 varint. Returns false on truncation/overlong input.
+inline bool readVarint32(const uint8_t *src, size_t len, size_t &offset,
+                         uint32_t &value)
+{
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7)
+  {
+    if (offset >= len)
+      return false;
+    uint8_t byte = src[offset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+// ============================================================================
+// Sample block encode / decode
+// ============================================================================
+
+// Encode sampleCount × sensorCount samples into dst.
+// samples[s * sampleStride + i] is sensor i of sample s.
+// Returns bytes written, or 0 if the block is not representable (sensorId
+// differs between samples) or would need more than maxBytes.
+inline size_t encodeCompressedSamples(uint8_t *dst, size_t maxBytes,
+                                      const TDMABatchedSensorData *samples,
+                                      uint8_t sampleCount, uint8_t sensorCount,
+                                      size_t sampleStride)
+{
+  if (sampleCount == 0 || sensorCount == 0 ||
+      maxBytes < sizeof(uint32_t) + sensorCount)
+    return 0;
+
+  // Sensor IDs are sent once, so they must not change across samples
+  for (uint8_t s = 1; s < sampleCount; s++)
+  {
+    for (uint8_t i = 0; i < sensorCount; i++)
+    {
+      if (samples[s * sampleStride + i].sensorId != samples[i].sensorId)
+        return 0;
+    }
+  }
+
+  size_t offset = 0;
+  const uint32_t baseTs = samples[0].timestampUs;
+  memcpy(dst, &baseTs, sizeof(baseTs));
+  offset += sizeof(baseTs);
+  for (uint8_t i = 0; i < sensorCount; i++)
+  {
+    dst[offset++] = samples[i].sensorId;
+  }
+
+  uint32_t prevTs = baseTs;
+  for (uint8_t s = 0; s < sampleCount; s++)
+  {
+    for (uint8_t i = 0; i < sensorCount; i++)
+    {
+      const TDMABatchedSensorData &cur = samples[s * sampleStride + i];
+      if (!writeVarint32(dst, maxBytes, offset,
+                         zigzagEncode32((int32_t)(cur.timestampUs - prevTs))))
+        return 0;
+      prevTs = cur.timestampUs;
+
+      for (uint8_t k = 0; k < 3; k++)
+      {
+        int32_t prevA = (s > 0) ? samples[(s - 1) * sampleStride + i].a[k] : 0;
+        if (!writeVarint32(dst, maxBytes, offset,
+                           zigzagEncode32((int32_t)cur.a[k] - prevA)))
+          return 0;
+      }
+      for (uint8_t k = 0; k < 3; k++)
+      {
+        int32_t prevG = (s > 0) ? samples[(s - 1) * sampleStride + i].g[k] : 0;
+        if (!writeVarint32(dst, maxBytes, offset,
+                           zigzagEncode32((int32_t)cur.g[k] - prevG)))
+          return 0;
+      }
+    }
+  }
+  return offset;
+}
+
+// Decode a compressed sample block into out[s * outStride + i].
+// On success, consumed holds the number of bytes read from src.
+inline bool decodeCompressedSamples(const uint8_t *src, size_t len,
+                                    TDMABatchedSensorData *out,
+                                    uint8_t sampleCount, uint8_t sensorCount,
+                                    size_t outStride, size_t &consumed)
+{
+  consumed = 0;
+  if (sampleCount == 0 || sensorCount == 0 ||
+      len < sizeof(uint32_t) + sensorCount)
+    return false;
+
+  size_t offset = 0;
+  uint32_t prevTs;
+  memcpy(&prevTs, src, sizeof(prevTs));
+  offset += sizeof(prevTs);
+  const uint8_t *sensorIds = src + offset;
+  offset += sensorCount;
+
+  for (uint8_t s = 0; s < sampleCount; s++)
+  {
+    for (uint8_t i = 0; i < sensorCount; i++)
+    {
+      TDMABatchedSensorData &cur = out[s * outStride + i];
+      uint32_t raw;
+
+      cur.sensorId = sensorIds[i];
+      if (!readVarint32(src, len, offset, raw))
+        return false;
+      prevTs += (uint32_t)zigzagDecode32(raw);
+      cur.timestampUs = prevTs;
+
+      for (uint8_t k = 0; k < 3; k++)
+      {
+        int32_t prevA = (s > 0) ? out[(s - 1) * outStride + i].a[k] : 0;
+        if (!readVarint32(src, len, offset, raw))
+          return false;
+        cur.a[k] = (int16_t)(prevA + zigzagDecode32(raw));
+      }
+      for (uint8_t k = 0; k < 3; k++)
+      {
+        int32_t prevG = (s > 0) ? out[(s - 1) * outStride + i].g[k] : 0;
+        if (!readVarint32(src, len, offset, raw))
+          return false;
+        cur.g[k] = (int16_t)(prevG + zigzagDecode32(raw));
+      }
+    }
+  }
+
+  consumed = offset;
+  return true;
+}
+
+#endif // NODE_DATA_CODEC_H
@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * SerialFraming.h - Self-synchronising COBS + CRC-32 framing (Gateway USB)
+ *
+ * The legacy USB stream is [len lo][len hi][type][payload] back to back. A
+ * single lost or corrupted byte shifts every later length field, so a host
+ * parser can stay out of step for a long time.
+ *
+ * COBS mode (host sends {"cmd":"FRAMING","mode":"cobs"}):
+ *   0x00 COBS([type][payload][crc32 LE]) 0x00 COBS(...) 0x00 ...
+ * COBS removes every 0x00 from the encoded frame, so 0x00 only ever marks a
+ * frame boundary. After corruption a decoder drops bytes up to the next
+ * 0x00 and the next frame decodes cleanly: recovery costs one frame. The
+ * CRC (IEEE 802.3, same as zlib crc32) rejects the damaged frame instead
+ * of passing garbage on. On ESP32 it is the ROM routine esp_rom_crc32_le().
+ *
+ * Every write chunk starts with a 0x00, so unframed log text printed
+ * between chunks becomes its own (rejected) frame instead of corrupting
+ * the next real one.
+ *
+ * Overhead per frame: 4 CRC bytes + 1 delimiter + 1 byte per 254 bytes.
+ * Host decoders: mash-app SerialFraming.ts, scripts/serial_framing_bench.py,
+ * host/SyncStreamDecoder.h.
+ ******************************************************************************/
+
+#ifndef SERIAL_FRAMING_H
+#define SERIAL_FRAMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+#include "esp_rom_crc.h"
+#endif
+
+#define SERIAL_FRAMING_LEGACY 0
+#define SERIAL_FRAMING_COBS 1
+
+#define SERIAL_COBS_CRC_SIZE 4
+#define SERIAL_COBS_DELIMITER 0x00
+
+// Worst-case encoded size of an n-byte frame: CRC, one code byte per 254
+// bytes (plus the first), trailing delimiter
+#define SERIAL_COBS_MAX_ENCODED(n)                                            \
+  ((n) + SERIAL_COBS_CRC_SIZE + ((n) + SERIAL_COBS_CRC_SIZE) / 254 + 2)
+
+// CRC-32 (IEEE, reflected, init/xorout 0xFFFFFFFF). Pass the previous
+// result as crc to continue over several buffers.
+inline uint32_t serialFramingCrc32(const uint8_t *data, size_t len,
+                                   uint32_t crc = 0)
+{
+#if defined(ESP_PLATFORM)
+  return esp_rom_crc32_le(crc, data, (uint32_t)len);
+#else
+  static const uint32_t nibble[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+      0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ nibble[crc & 0x0F];
+    crc = (crc >> 4) ^ nibble[crc & 0x0F];
+  }
+  return ~crc;
+#endif
+}
+
+// Encode frame + CRC as one COBS block followed by the delimiter.
+// Returns bytes written, or 0 if out is too small.
+inline size_t cobsEncodeFrame(const uint8_t *frame, size_t len, uint8_t *out,
+                              size_t outMax)
+{
+  if (outMax < SERIAL_COBS_MAX_ENCODED(len))
+    return 0;
+
+  uint32_t crc = serialFramingCrc32(frame, len);
+  uint8_t crcBytes[SERIAL_COBS_CRC_SIZE] = {
+      (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16),
+      (uint8_t)(crc >> 24)};
+
+  size_t codeAt = 0;
+  size_t w = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < len + SERIAL_COBS_CRC_SIZE; i++)
+  {
+    uint8_t b = (i < len) ? frame[i] : crcBytes[i - len];
+    if (b == 0)
+    {
+      out[codeAt] = code;
+      codeAt = w++;
+      code = 1;
+      continue;
+    }
+    out[w++] = b;
+    if (++code == 0xFF)
+    {
+      out[codeAt] = code;
+      codeAt = w++;
+      code = 1;
+    }
+  }
+  out[codeAt] = code;
+  out[w++] = SERIAL_COBS_DELIMITER;
+  return w;
+}
+
+// Decode one COBS block (delimiter excluded) and check its CRC. Returns the
+// frame length without CRC, or 0 if the block is malformed, does not fit,
+// or fails the CRC.
+inline size_t cobsDecodeFrame(const uint8_t *in, size_t len, uint8_t *out,
+                              size_t outMax)
+{
+  size_t r = 0;
+  size_t w = 0;
+  while (r < len)
+  {
+    uint8_t code = in[r++];
+    if (code == 0)
+      return 0;
+    for (uint8_t i = 1; i < code; i++)
+    {
+      if (r >= len || w >= outMax || in[r] == 0)
+        return 0;
+      out[w++] = in[r++];
+    }
+    if (code != 0xFF && r < len)
+    {
+      if (w >= outMax)
+        return 0;
+      out[w++] = 0;
+    }
+  }
+  if (w <= SERIAL_COBS_CRC_SIZE)
+    return 0;
+
+  size_t frameLen = w - SERIAL_COBS_CRC_SIZE;
+  uint32_t crc = (uint32_t)out[frameLen] | ((uint32_t)out[frameLen + 1] << 8) |
+                 ((uint32_t)out[frameLen + 2] << 16) |
+                 ((uint32_t)out[frameLen + 3] << 24);
+  return serialFramingCrc32(out, frameLen) == crc ? frameLen : 0;
+}
+
+// Re-encode a legacy record stream ([len lo][len hi][frame] ...) as COBS
+// frames, preceded by one delimiter. Stops at the first record that does
+// not fit; consumed reports how many input bytes were encoded so the
+// caller can write out and continue. A malformed record ends the stream.
+inline size_t cobsEncodeRecords(const uint8_t *records, size_t len,
+                                uint8_t *out, size_t outMax, size_t &consumed)
+{
+  consumed = 0;
+  if (outMax == 0)
+    return 0;
+  size_t w = 0;
+  out[w++] = SERIAL_COBS_DELIMITER;
+  while (consumed + 2 <= len)
+  {
+    size_t frameLen = records[consumed] | (records[consumed + 1] << 8);
+    if (frameLen == 0 || consumed + 2 + frameLen > len)
+    {
+      consumed = len; // Not a record stream: drop the rest
+      break;
+    }
+    size_t n = cobsEncodeFrame(records + consumed + 2, frameLen, out + w,
+                               outMax - w);
+    if (n == 0)
+      break;
+    w += n;
+    consumed += 2 + frameLen;
+  }
+  return (consumed > 0) ? w : 0;
+}
+
+// Byte-at-a-time decoder (host tools and tests; the Gateway only encodes)
+template <size_t MaxFrame>
+struct CobsStreamDecoder
+{
+  uint8_t block[SERIAL_COBS_MAX_ENCODED(MaxFrame)];
+  uint8_t frame[MaxFrame + SERIAL_COBS_CRC_SIZE];
+  size_t blockLen;
+  bool overflowed;
+  uint32_t frames;
+  uint32_t badFrames; // CRC or COBS errors (empty blocks are not counted)
+
+  void reset()
+  {
+    blockLen = 0;
+    overflowed = false;
+    frames = 0;
+    badFrames = 0;
+  }
+
+  // Returns the decoded frame length once a delimiter closes a valid frame
+  // (frame[] holds it until the next call), otherwise 0
+  size_t push(uint8_t b)
+  {
+    if (b != SERIAL_COBS_DELIMITER)
+    {
+      if (blockLen < sizeof(block))
+        block[blockLen++] = b;
+      else
+        overflowed = true;
+      return 0;
+    }
+    size_t n = 0;
+    if (blockLen > 0)
+    {
+      n = overflowed ? 0 : cobsDecodeFrame(block, blockLen, frame, sizeof(frame));
+      if (n > 0)
+        frames++;
+      else
+        badFrames++;
+    }
+    blockLen = 0;
+    overflowed = false;
+    return n;
+  }
+};
+
+#endif // SERIAL_FRAMING_H
@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * SessionFormat.h - On-gateway session recording format (SessionRecorder)
+ *
+ * A session is two append-only files in /sessions on LittleFS or SD:
+ *   sNNNN.msr  data: fixed SESSION_PAGE_SIZE chunks, one flash erase block
+ *              each, so chunk k always starts at k * SESSION_PAGE_SIZE
+ *   sNNNN.idx  index: one SessionChunkHeader per chunk, in chunk order
+ *
+ * Chunk layout (little-endian):
+ *   [SessionChunkHeader][records ...][0xFF padding to SESSION_PAGE_SIZE]
+ * Records are the serial wire records [len lo][len hi][0x25 frame], copied
+ * unchanged from SyncFrameRing. A record never straddles two chunks.
+ * Historical 0x26 packets (black box backfill, NODE_DATA_FLAG_HISTORICAL)
+ * are stored the same way, interleaved in arrival order; they count toward
+ * usedBytes only, never toward the frame index below.
+ *
+ * The header carries the seek index for its chunk: frame-number range,
+ * sync timestamp range and a 256-bit mask of the sensor IDs it contains.
+ * A host seeks by reading the small .idx file, then fetching only the
+ * chunks it needs. The CRC covers the header (crc field excluded) and the
+ * used payload, so a torn last chunk after power loss is detected.
+ *
+ * Download (USB, {"cmd":"RECORD","action":"download",...}) streams files
+ * as 0x0A frames:
+ *   [0x0A][fileKind][sessionId u16][offset u32][fileSize u32][bytes...]
+ * fileKind 0 = index, 1 = data. A piece with no bytes ends the transfer.
+ * Host side: firmware/scripts/session_tool.py, firmware/host/SyncStreamDecoder.h
+ ******************************************************************************/
+
+#ifndef SESSION_FORMAT_H
+#define SESSION_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "SerialFraming.h" // serialFramingCrc32
+
+#define SESSION_FORMAT_VERSION 1
+#define SESSION_CHUNK_MAGIC 0x4352534D // "MSRC"
+
+// One flash erase block; also a multiple of the SD sector size
+#define SESSION_PAGE_SIZE 4096
+
+#define SESSION_SENSOR_MASK_BYTES 32 // One bit per uint8_t sensor ID
+
+// Chunk flags
+#define SESSION_CHUNK_FLAG_GAP 0x01   // Frames were dropped before this chunk
+#define SESSION_CHUNK_FLAG_FINAL 0x02 // Last chunk of a cleanly closed session
+
+// Download stream (serial packet 0x0A)
+#define SESSION_PACKET_TYPE 0x0A
+#define SESSION_FILE_INDEX 0
+#define SESSION_FILE_DATA 1
+#define SESSION_DOWNLOAD_HEADER_SIZE 12
+#define SESSION_DOWNLOAD_PIECE_MAX 1024
+
+struct __attribute__((packed)) SessionChunkHeader
+{
+  uint32_t magic; // SESSION_CHUNK_MAGIC
+  uint8_t version;
+  uint8_t flags; // SESSION_CHUNK_FLAG_*
+  uint16_t sessionId;
+  uint32_t chunkIndex;
+  uint16_t recordCount;
+  uint16_t usedBytes; // Record bytes after the header
+  uint32_t firstFrame; // SyncFramePacket.frameNumber of the first record
+  uint32_t lastFrame;
+  uint32_t firstTimestampUs; // SyncFramePacket.timestampUs
+  uint32_t lastTimestampUs;
+  uint32_t droppedFrames; // Recorder-sink drops since session start
+  uint8_t sensorMask[SESSION_SENSOR_MASK_BYTES];
+  uint32_t crc32; // Header up to here + usedBytes of records
+};
+
+static_assert(sizeof(SessionChunkHeader) == 72,
+              "SessionChunkHeader must be exactly 72 bytes (packed)!");
+
+#define SESSION_CHUNK_PAYLOAD_MAX (SESSION_PAGE_SIZE - sizeof(SessionChunkHeader))
+
+// Start a fresh chunk header
+inline void sessionChunkBegin(SessionChunkHeader &h, uint16_t sessionId,
+                              uint32_t chunkIndex)
+{
+  memset(&h, 0, sizeof(h));
+  h.magic = SESSION_CHUNK_MAGIC;
+  h.version = SESSION_FORMAT_VERSION;
+  h.sessionId = sessionId;
+  h.chunkIndex = chunkIndex;
+}
+
+// Account one [len][0x25 frame] record (already copied into the payload).
+// Other record types and frames shorter than the 10-byte sync header only
+// count toward usedBytes.
+inline void sessionChunkAddRecord(SessionChunkHeader &h, const uint8_t *record,
+                                  size_t recordLen)
+{
+  h.usedBytes += (uint16_t)recordLen;
+  if (recordLen < 2 + 10 || record[2] != 0x25)
+    return;
+
+  const uint8_t *frame = record + 2;
+  uint32_t frameNumber, timestampUs;
+  memcpy(&frameNumber, frame + 1, 4);
+  memcpy(&timestampUs, frame + 5, 4);
+  if (h.recordCount == 0)
+  {
+    h.firstFrame = frameNumber;
+    h.firstTimestampUs = timestampUs;
+  }
+  h.lastFrame = frameNumber;
+  h.lastTimestampUs = timestampUs;
+  h.recordCount++;
+
+  const size_t frameLen = recordLen - 2;
+  uint8_t sensorCount = frame[9];
+  for (uint8_t s = 0; s < sensorCount; s++)
+  {
+    size_t offset = 10 + (size_t)s * 16;
+    if (offset >= frameLen)
+      break;
+    uint8_t id = frame[offset];
+    h.sensorMask[id >> 3] |= (uint8_t)(1u << (id & 7));
+  }
+}
+
+inline uint32_t sessionChunkCrc(const SessionChunkHeader &h,
+                                const uint8_t *payload)
+{
+  uint32_t crc = serialFramingCrc32((const uint8_t *)&h,
+                                    offsetof(SessionChunkHeader, crc32));
+  return serialFramingCrc32(payload, h.usedBytes, crc);
+}
+
+// Seal the chunk: fill the CRC. The caller pads the page with 0xFF.
+inline void sessionChunkSeal(SessionChunkHeader &h, const uint8_t *payload)
+{
+  h.crc32 = sessionChunkCrc(h, payload);
+}
+
+// Check a chunk read back from a data file (page = SESSION_PAGE_SIZE bytes)
+inline bool sessionChunkValid(const uint8_t *page)
+{
+  SessionChunkHeader h;
+  memcpy(&h, page, sizeof(h));
+  if (h.magic != SESSION_CHUNK_MAGIC || h.version != SESSION_FORMAT_VERSION ||
+      h.usedBytes > SESSION_CHUNK_PAYLOAD_MAX)
+    return false;
+  return sessionChunkCrc(h, page + sizeof(h)) == h.crc32;
+}
+
+inline bool sessionChunkHasSensor(const SessionChunkHeader &h, uint8_t id)
+{
+  return (h.sensorMask[id >> 3] >> (id & 7)) & 1;
+}
+
+#endif // SESSION_FORMAT_H
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * SyncFrameFormat.h - 0x25 sync frame wire format (Gateway -> host)
+ *
+ * One source of truth for the records SyncFrameBuffer emits and every host
+ * consumer parses: the firmware includes it through SyncFrameBuffer.h, the
+ * host decoder (firmware/host/SyncStreamDecoder.h) includes it directly, so
+ * it must stay free of Arduino and ESP-IDF headers.
+ *
+ *   [SyncFramePacket 10 bytes][sensorCount x 16-byte record][CRC8]
+ *
+ * The CRC8 (TDMAProtocol.h calculateCRC8) covers everything before it.
+ * Records are SyncFrameSensorData, SyncFrameEnviroData or
+ * SyncFrameCorrectionData, told apart by their flags byte. All fields are
+ * little-endian.
+ ******************************************************************************/
+
+#ifndef SYNC_FRAME_FORMAT_H
+#define SYNC_FRAME_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Sync Frame Packet Format (0x25 - ABSOLUTE)
+// ============================================================================
+// Original format: 16 bytes per sensor, all values absolute (quaternion removed)
+// Used for: Keyframes, first packet after connection, error recovery
+// Max sensors @ 200Hz: ~20 (limited by BLE 65 KB/s)
+
+#define SYNC_FRAME_PACKET_TYPE 0x25
+
+// Per-sensor data in sync frame (16 bytes - fixed size for easy parsing)
+// Quaternion removed: VQF fusion runs in webapp from accel+gyro raw data.
+struct __attribute__((packed)) SyncFrameSensorData
+{
+  uint8_t sensorId;    // Unique sensor ID (nodeId + localIndex)
+  int16_t a[3];        // Accelerometer (x, y, z) scaled by 100 (m/s²)
+  int16_t g[3];        // Gyroscope (x, y, z) scaled by 900 (rad/s)
+  uint8_t flags;       // Bit 0: valid, Bit 1: interpolated, Bits 2-7: reserved
+  uint8_t reserved[2]; // Padding to 16 bytes
+};
+
+// Sync Frame packet header
+struct __attribute__((packed)) SyncFramePacket
+{
+  uint8_t type;         // 0x25 = SYNC_FRAME_PACKET_TYPE
+  uint32_t frameNumber; // Monotonic frame counter
+  uint32_t timestampUs; // Synchronized timestamp (beacon-derived)
+  uint8_t sensorCount;  // Number of sensors in this frame
+                        // Followed by sensorCount × SyncFrameSensorData
+};
+
+#define SYNC_FRAME_HEADER_SIZE sizeof(SyncFramePacket)
+#define SYNC_FRAME_SENSOR_SIZE sizeof(SyncFrameSensorData)
+
+// Wire LSB per unit of SyncFrameSensorData.a / .g
+#define SYNC_FRAME_ACCEL_LSB_PER_MS2 100.0f
+#define SYNC_FRAME_GYRO_LSB_PER_RADS 900.0f
+
+// ============================================================================
+// Compile-time verification of packed struct layout
+// ============================================================================
+// If these fail, the compiler is NOT respecting __attribute__((packed)) and
+// the webapp parser will read corrupted sensorCount values at byte offset 9.
+static_assert(sizeof(SyncFramePacket) == 10,
+              "SyncFramePacket must be exactly 10 bytes (packed)!");
+static_assert(sizeof(SyncFrameSensorData) == 16,
+              "SyncFrameSensorData must be exactly 16 bytes (packed)!");
+static_assert(offsetof(SyncFramePacket, type) == 0,
+              "SyncFramePacket.type must be at offset 0!");
+static_assert(offsetof(SyncFramePacket, frameNumber) == 1,
+              "SyncFramePacket.frameNumber must be at offset 1!");
+static_assert(offsetof(SyncFramePacket, timestampUs) == 5,
+              "SyncFramePacket.timestampUs must be at offset 5!");
+static_assert(offsetof(SyncFramePacket, sensorCount) == 9,
+              "SyncFramePacket.sensorCount must be at offset 9!");
+
+// Flags for SyncFrameSensorData
+#define SYNC_SENSOR_FLAG_VALID 0x01
+#define SYNC_SENSOR_FLAG_INTERPOLATED 0x02
+#define SYNC_SENSOR_FLAG_ENVIRO 0x04     // Record is a SyncFrameEnviroData
+#define SYNC_SENSOR_FLAG_CORRECTION 0x08 // Record is a SyncFrameCorrectionData
+
+// Mag/baro record in the same 16-byte grid (sensorId and flags at the same
+// offsets). Units as NodeEnviroSample.
+struct __attribute__((packed)) SyncFrameEnviroData
+{
+  uint8_t sensorId;     // Compact ID of the node's first sensor
+  int16_t mag[3];       // Magnetometer (x, y, z), uncalibrated, 0.1 µT
+  uint32_t pressureCPa; // Barometric pressure, 0.01 Pa
+  int16_t temperatureC; // Barometer temperature, 0.01 °C
+  uint8_t flags;        // SYNC_SENSOR_FLAG_ENVIRO
+  uint8_t rawNodeId;    // Physical node ID (as reserved[0] of IMU records)
+  uint8_t contents;     // NODE_ENVIRO_HAS_* bitfield
+};
+
+static_assert(sizeof(SyncFrameEnviroData) == SYNC_FRAME_SENSOR_SIZE,
+              "SyncFrameEnviroData must match the 16-byte sensor record!");
+static_assert(offsetof(SyncFrameEnviroData, flags) ==
+                  offsetof(SyncFrameSensorData, flags),
+              "SyncFrameEnviroData.flags must share the sensor flags offset!");
+
+// Real sample for a record an earlier frame synthesized (gap fill). Same
+// grid as SyncFrameSensorData; reserved[1] becomes the distance back.
+struct __attribute__((packed)) SyncFrameCorrectionData
+{
+  uint8_t sensorId;   // Compact sensor ID, as in the corrected record
+  int16_t a[3];       // Accelerometer, as SyncFrameSensorData
+  int16_t g[3];       // Gyroscope, as SyncFrameSensorData
+  uint8_t flags;      // SYNC_SENSOR_FLAG_CORRECTION
+  uint8_t rawNodeId;  // Physical node ID (as reserved[0] of IMU records)
+  uint8_t framesBack; // Corrected frame = this frameNumber - framesBack
+};
+
+static_assert(sizeof(SyncFrameCorrectionData) == SYNC_FRAME_SENSOR_SIZE,
+              "SyncFrameCorrectionData must match the 16-byte sensor record!");
+static_assert(offsetof(SyncFrameCorrectionData, flags) ==
+                  offsetof(SyncFrameSensorData, flags),
+              "SyncFrameCorrectionData.flags must share the sensor flags offset!");
+
+#endif // SYNC_FRAME_FORMAT_H
@@ -47,7 +47,13 @@
 #ifndef TDMA_PROTOCOL_H
 #define TDMA_PROTOCOL_H
 
+#if defined(ARDUINO)
 #include <Arduino.h>
+#else
+// Host tools (firmware/host) share the packet definitions and CRC8
+#include <stddef.h>
+#include <stdint.h>
+#endif
 
 // ============================================================================
 // TDMA Timing Constants
@@ -103,6 +109,55 @@
 // Maximum nodes supported
 #define TDMA_MAX_NODES 8
 
+// ============================================================================
+// CHANNEL AGILITY — Gateway-coordinated channel hop
+// ============================================================================
+// The Gateway only ever moves between the three non-overlapping 2.4 GHz
+// channels. A hop is announced in TDMA_CHANNEL_HOP_LEAD_BEACONS consecutive
+// beacons (hopChannel/hopCountdown), and every node retunes in the guard time
+// of the last frame on the old channel, so the next beacon is heard on the
+// new one. A node that missed every announcement finds the Gateway again by
+// dwelling on each candidate in turn (no full 13-channel scan).
+// ============================================================================
+#define TDMA_HOP_CHANNEL_COUNT 3
+#define TDMA_CHANNEL_HOP_LEAD_BEACONS 25  // 500ms of announcements
+#define TDMA_CHANNEL_SEARCH_AFTER_MS 2000 // Beacon silence before searching
+#define TDMA_CHANNEL_SEARCH_DWELL_MS 400  // ~20 beacon periods per candidate
+
+inline uint8_t tdmaHopChannel(uint8_t index)
+{
+  static const uint8_t CHANNELS[TDMA_HOP_CHANNEL_COUNT] = {1, 6, 11};
+  return CHANNELS[index % TDMA_HOP_CHANNEL_COUNT];
+}
+
+// ============================================================================
+// BEACON TIMING — period jitter histogram
+// ============================================================================
+// The Gateway buckets |beacon period - TDMA_FRAME_PERIOD| of every periodic
+// beacon, measured between the TSF stamps taken as each beacon is handed to
+// the MAC. Bucket i counts jitter below tdmaBeaconJitterBucketEdgeUs(i); the
+// last bucket collects everything >= 1ms (including missed ticks).
+// ============================================================================
+#define TDMA_BEACON_JITTER_BUCKETS 8
+
+inline uint32_t tdmaBeaconJitterBucketEdgeUs(uint8_t bucket)
+{
+  static const uint32_t EDGES[TDMA_BEACON_JITTER_BUCKETS - 1] = {
+      10, 25, 50, 100, 250, 500, 1000};
+  return (bucket < TDMA_BEACON_JITTER_BUCKETS - 1) ? EDGES[bucket] : 0xFFFFFFFF;
+}
+
+inline uint8_t tdmaBeaconJitterBucket(uint32_t absJitterUs)
+{
+  uint8_t bucket = 0;
+  while (bucket < TDMA_BEACON_JITTER_BUCKETS - 1 &&
+         absJitterUs >= tdmaBeaconJitterBucketEdgeUs(bucket))
+  {
+    bucket++;
+  }
+  return bucket;
+}
+
 // ============================================================================
 // 200Hz OUTPUT ARCHITECTURE (20 sensors max @ 200Hz time-synced)
 // ============================================================================
@@ -215,15 +270,28 @@ struct __attribute__((packed)) TDMABeaconPacket
   uint8_t
       flags; // Upper nibble: TDMA state, Lower nibble: sync protocol version
   // NEW: TSF timestamp for hardware-level synchronization (Phase 0)
-  uint64_t gatewayTsfUs; // Gateway TSF timestamp (from esp_wifi_get_tsf_time)
+  uint64_t gatewayTsfUs; // Gateway TSF captured as this beacon is handed to
+                         // the MAC (esp_wifi_get_tsf_time, esp_timer fallback)
   // PTP STAGGERING: Which node should perform PTP exchange this frame
   // This prevents multiple nodes doing PTP simultaneously, which can corrupt
   // timestamps. Value 0xFF means no node should do PTP this frame. Nodes should
   // only send DELAY_REQ when (ptpSlotNode == myNodeId) OR (ptpSlotNode == 0xFF
   // && initial calibration)
   uint8_t ptpSlotNode;
+  // CHANNEL HOP: appended so older Nodes (len >= their sizeof) still parse.
+  // hopCountdown > 0 means the beacon of frame (frameNumber + hopCountdown)
+  // and everything after it is sent on hopChannel.
+  uint8_t hopChannel;   // Target WiFi channel (0 = no hop pending)
+  uint8_t hopCountdown; // Beacons until the hop takes effect
+  // BEACON TIMING: queue-to-air latency of the PREVIOUS beacon (its send-done
+  // TSF minus its gatewayTsfUs). Actual emission of beacon N-1 is
+  // gatewayTsfUs(N-1) + prevTxLatencyUs. 0xFFFF = unknown.
+  uint16_t prevTxLatencyUs;
 };
 
+// Minimum beacon length a Node accepts (pre-channel-hop Gateways)
+#define TDMA_BEACON_MIN_LEN offsetof(TDMABeaconPacket, hopChannel)
+
 // Node Registration Packet (Node → Gateway)
 // Sent during discovery phase
 struct __attribute__((packed)) TDMARegisterPacket
@@ -238,6 +306,37 @@ struct __attribute__((packed)) TDMARegisterPacket
   char nodeName[16];   // Human-readable name
 };
 
+// ============================================================================
+// ADAPTIVE PHY RATE (per node, chosen by Gateway, carried in the schedule)
+// ============================================================================
+// 802.11g OFDM rate ladder for Node → Gateway unicast. Each step raises
+// N_DBPS (data bits per 4µs OFDM symbol), shrinking the airtime term.
+// 6/12/24 Mbps are mandatory basic rates, so the ACK goes at the data rate;
+// above 24 Mbps the ACK falls back to the highest basic rate (24 Mbps).
+// ============================================================================
+enum TDMAPhyRate : uint8_t
+{
+  TDMA_PHY_RATE_6M = 0,  // BPSK 1/2 — robust default (previously pinned)
+  TDMA_PHY_RATE_12M = 1, // QPSK 1/2
+  TDMA_PHY_RATE_24M = 2, // 16-QAM 1/2
+  TDMA_PHY_RATE_36M = 3, // 16-QAM 3/4
+  TDMA_PHY_RATE_54M = 4, // 64-QAM 3/4
+  TDMA_PHY_RATE_COUNT = 5
+};
+
+// Data bits per OFDM symbol (N_DBPS) for a TDMAPhyRate
+inline uint16_t tdmaPhyRateBitsPerSymbol(uint8_t rate)
+{
+  static const uint16_t N_DBPS[TDMA_PHY_RATE_COUNT] = {24, 48, 96, 144, 216};
+  return (rate < TDMA_PHY_RATE_COUNT) ? N_DBPS[rate] : N_DBPS[0];
+}
+
+inline uint8_t tdmaPhyRateMbps(uint8_t rate)
+{
+  static const uint8_t MBPS[TDMA_PHY_RATE_COUNT] = {6, 12, 24, 36, 54};
+  return (rate < TDMA_PHY_RATE_COUNT) ? MBPS[rate] : MBPS[0];
+}
+
 // Slot Schedule Packet (Gateway → All Nodes, broadcast)
 // Sent after discovery, contains all slot assignments
 struct __attribute__((packed)) TDMASchedulePacket
@@ -251,6 +350,9 @@ struct __attribute__((packed)) TDMASchedulePacket
     uint16_t slotOffsetUs; // Microseconds offset from beacon
     uint16_t slotWidthUs;  // Allowed transmission window
   } slots[TDMA_MAX_NODES];
+  // Appended after slots[] so older Nodes (which size slots from the packet
+  // length and cap at TDMA_MAX_NODES) still parse the schedule unchanged.
+  uint8_t phyRate[TDMA_MAX_NODES]; // TDMAPhyRate per slot (same index)
 };
 
 // Batched Data Packet (Node → Gateway)
@@ -341,6 +443,41 @@ struct __attribute__((packed)) SyncQualityFlags
 // Node data packet flags
 #define NODE_DATA_FLAG_KEYFRAME 0x02 // Bit 1: All samples are absolute (always set)
 #define NODE_DATA_FLAG_SYNC_V2 0x04  // Bit 2: Contains sync quality metadata
+// Bit 3: Backfilled from the Node's flash black box after an RF outage.
+// The frame is NOT live — the Gateway must not feed it into SyncFrameBuffer
+// (its slot expired long ago) and instead forwards it verbatim to the host
+// and into the active session recording (SessionRecorder), where
+// session_tool.py splices it in on export.
+// For historical packets, 'reserved' carries the frame's presentMask so
+// partially captured frames can be reconstructed.
+#define NODE_DATA_FLAG_HISTORICAL 0x08
+// Bit 4: Sample block uses the lossless delta/varint layout (NodeDataCodec.h)
+// instead of raw TDMABatchedSensorData records. Header, SyncQualityFlags and
+// CRC8 are unchanged. Decided per packet — the Node falls back to the raw
+// layout whenever compression would not save bytes.
+#define NODE_DATA_FLAG_COMPRESSED 0x10
+// Bit 5: A NodeEnviroSample (magnetometer/barometer) sits just before the
+// CRC8. Attached to roughly one live packet in five (10 Hz optional sensors
+// vs 50 Hz frames); replaces the separate 0x04 ESPNowEnviroPacket while
+// streaming. Never set on HISTORICAL packets.
+#define NODE_DATA_FLAG_ENVIRO 0x20
+
+// Node-side switch for the compressed sample block. The Gateway always
+// decodes both layouts; slot sizing assumes the compressed budget below.
+#ifndef TDMA_NODE_DATA_COMPRESSION
+#define TDMA_NODE_DATA_COMPRESSION 1
+#endif
+
+// Slot-sizing budget per sensor-sample for compressed packets. Typical
+// 200Hz body-motion data encodes to 7-12 bytes (vs 17 raw): 1-2 B timestamp
+// delta + 6 axes of 1-2 B zigzag varints. Lossless compression has no
+// worst-case gain, so a packet may exceed the budget — the airtime overrun is
+// capped by TDMA_COMPRESSED_MAX_OVERRUN_US (see calculateSlotWidth).
+#define TDMA_COMPRESSED_SAMPLE_BUDGET 12
+
+// Maximum airtime a raw (incompressible) packet may overrun a compressed-
+// sized slot by. Borrowed from the 500µs ISR/RTOS safety margin.
+#define TDMA_COMPRESSED_MAX_OVERRUN_US 250
 
 // Node data packet header (10 bytes)
 struct __attribute__((packed)) TDMANodeDataPacket
@@ -351,15 +488,37 @@ struct __attribute__((packed)) TDMANodeDataPacket
   uint8_t flags;        // NODE_DATA_FLAG_* bitfield
   uint8_t sampleCount;  // Total samples (1-4)
   uint8_t sensorCount;  // Sensors per sample
-  uint8_t reserved;     // Alignment padding
+  uint8_t reserved;     // Alignment padding (presentMask if HISTORICAL)
   // Payload:
   //   [TDMABatchedSensorData × sampleCount × sensorCount] (17 bytes each)
+  //     or, if NODE_DATA_FLAG_COMPRESSED, the NodeDataCodec.h sample block
   //   Optional: [SyncQualityFlags] (7 bytes) if NODE_DATA_FLAG_SYNC_V2 set
+  //   Optional: [NodeEnviroSample] (14 bytes) if NODE_DATA_FLAG_ENVIRO set
   //   [CRC8] - always last byte
 };
 
 #define TDMA_NODE_DATA_HEADER_SIZE 10
 
+// NodeEnviroSample.contents bits
+#define NODE_ENVIRO_HAS_MAG 0x01
+#define NODE_ENVIRO_HAS_BARO 0x02
+
+// Slower-rate optional sensor reading carried inline in a 0x26 packet.
+// sampleIndex names the IMU sample of the same frame the reading was taken
+// next to (within one 5ms sample period), so the Gateway can stamp it with
+// that sample's sync timestamp. Units match the 0x25 enviro record.
+struct __attribute__((packed)) NodeEnviroSample
+{
+  uint8_t contents;     // NODE_ENVIRO_HAS_* bitfield
+  uint8_t sampleIndex;  // 0..TDMA_SAMPLES_PER_FRAME-1
+  int16_t mag[3];       // Magnetometer (x, y, z), uncalibrated, 0.1 µT
+  uint32_t pressureCPa; // Barometric pressure, 0.01 Pa
+  int16_t temperatureC; // Barometer temperature, 0.01 °C
+};
+
+static_assert(sizeof(NodeEnviroSample) == 14,
+              "NodeEnviroSample must be exactly 14 bytes (packed)!");
+
 // Sync protocol version in beacon flags (lower 4 bits)
 #define SYNC_PROTOCOL_VERSION_LEGACY 0x01 // One-way sync (original)
 #define SYNC_PROTOCOL_VERSION_PTP_V2 0x02 // Two-way PTP-Lite with Kalman filter
@@ -538,8 +697,77 @@ inline uint8_t calculatePacketsPerFrame(uint8_t sensorCount)
 //   ACK           = 20µs + 4µs × ceil((22 + 112) / 24) = 44µs
 //
 //   T_rf = 74 + 4 × ceil((326 + 8 × payload) / 24)  µs
+//
+// Adaptive PHY rate: with a faster TDMAPhyRate, N_DBPS replaces 24 above and
+// the TDMA_SLOT_MIN_WIDTH_US floor is lowered by exactly the airtime saved
+// versus 6 Mbps (the floor's stack-latency and margin terms do not scale
+// with rate, only its airtime term does).
+//
+// Compressed payloads (NODE_DATA_FLAG_COMPRESSED) are sized from
+// TDMA_COMPRESSED_SAMPLE_BUDGET, but never more than
+// TDMA_COMPRESSED_MAX_OVERRUN_US below the raw airtime — so even an
+// incompressible frame (sent raw) only eats into the safety margin.
 // ============================================================================
-inline uint16_t calculateSlotWidth(uint8_t sensorCount)
+
+// RF transaction time (data frame + SIFS + ACK) for a 0x26 payload
+inline uint32_t calculateNodeDataAirtimeUs(uint32_t payloadBytes,
+                                           uint8_t phyRate = TDMA_PHY_RATE_6M)
+{
+  //    OFDM symbol count: ceil((22 + 8×(38 + payload)) / N_DBPS)
+  //    Numerator avoids float: (326 + 8*payload + N_DBPS-1) / N_DBPS
+  const uint32_t nDbps = tdmaPhyRateBitsPerSymbol(phyRate);
+  uint32_t ofdmBits = 326 + 8 * payloadBytes;    // SERVICE+TAIL + frame+payload bits
+  uint32_t ofdmSyms = (ofdmBits + nDbps - 1) / nDbps; // ceil division by N_DBPS
+  uint32_t dataFrameUs = 20 + 4 * ofdmSyms;      // preamble + data symbols
+
+  //    ACK (14 bytes = 134 bits incl. SERVICE+TAIL) at min(rate, 24 Mbps)
+  const uint32_t ackDbps =
+      tdmaPhyRateBitsPerSymbol(phyRate > TDMA_PHY_RATE_24M
+                                   ? (uint8_t)TDMA_PHY_RATE_24M
+                                   : phyRate);
+  uint32_t ackUs = 20 + 4 * ((134 + ackDbps - 1) / ackDbps);
+  return dataFrameUs + 10 + ackUs; // + SIFS + ACK
+}
+
+// Raw 0x26 payload: header + 4 × sensors × 17 + CRC
+// The optional trailers (SyncQualityFlags, NodeEnviroSample: 21 bytes, ~28µs
+// at 6 Mbps) are not budgeted; they come out of the safety margin.
+inline uint32_t calculateNodeDataPayloadBytes(uint8_t sensorCount)
+{
+  return TDMA_NODE_DATA_HEADER_SIZE +
+         (TDMA_SAMPLES_PER_FRAME * sensorCount * TDMA_SENSOR_DATA_SIZE) + 1;
+}
+
+// Compressed 0x26 slot budget: header + base timestamp + sensor IDs +
+// 4 × sensors × budget + CRC
+inline uint32_t calculateCompressedPayloadBudget(uint8_t sensorCount)
+{
+  return TDMA_NODE_DATA_HEADER_SIZE + sizeof(uint32_t) + sensorCount +
+         (TDMA_SAMPLES_PER_FRAME * sensorCount * TDMA_COMPRESSED_SAMPLE_BUDGET) +
+         1;
+}
+
+// Airtime the slot is sized for (raw, or compressed budget with capped overrun)
+inline uint32_t calculateSlotAirtimeUs(uint8_t sensorCount, bool compressed,
+                                       uint8_t phyRate)
+{
+  uint32_t airtimeUs = calculateNodeDataAirtimeUs(
+      calculateNodeDataPayloadBytes(sensorCount), phyRate);
+  if (compressed)
+  {
+    uint32_t budgetUs = calculateNodeDataAirtimeUs(
+        calculateCompressedPayloadBudget(sensorCount), phyRate);
+    uint32_t floorUs = (airtimeUs > TDMA_COMPRESSED_MAX_OVERRUN_US)
+                           ? airtimeUs - TDMA_COMPRESSED_MAX_OVERRUN_US
+                           : 0;
+    airtimeUs = (budgetUs > floorUs) ? budgetUs : floorUs;
+  }
+  return airtimeUs;
+}
+
+inline uint16_t calculateSlotWidth(uint8_t sensorCount,
+                                   bool compressed = TDMA_NODE_DATA_COMPRESSION,
+                                   uint8_t phyRate = TDMA_PHY_RATE_6M)
 {
   if (sensorCount == 0)
     return TDMA_SLOT_MIN_WIDTH_US;
@@ -548,25 +776,24 @@ inline uint16_t calculateSlotWidth(uint8_t sensorCount)
   //    build (~200µs) + ESP-NOW stack (~800µs) + margin (~500µs)
   const uint32_t FIXED_OVERHEAD_US = 1500;
 
-  // 2. RF airtime — 802.11g OFDM @ 6 Mbps
-  uint32_t payloadBytes =
-      TDMA_NODE_DATA_HEADER_SIZE +
-      (TDMA_SAMPLES_PER_FRAME * sensorCount * TDMA_SENSOR_DATA_SIZE) + 1;
-
-  //    OFDM symbol count: ceil((22 + 8×(38 + payload)) / 24)
-  //    Numerator avoids float: (326 + 8*payload + 23) / 24   (integer ceil)
-  uint32_t ofdmBits = 326 + 8 * payloadBytes; // SERVICE+TAIL + frame+payload bits
-  uint32_t ofdmSyms = (ofdmBits + 23) / 24;   // ceil division by N_DBPS
-  uint32_t dataFrameUs = 20 + 4 * ofdmSyms;   // preamble + data symbols
-  uint32_t airtimeUs = dataFrameUs + 10 + 44; // + SIFS + ACK
+  // 2. RF airtime — 802.11g OFDM at the node's PHY rate
+  uint32_t airtimeUs = calculateSlotAirtimeUs(sensorCount, compressed, phyRate);
 
   // 3. Total slot width
   uint32_t totalUs = FIXED_OVERHEAD_US + airtimeUs;
 
-  // 4. Enforce minimum (WiFi stack jitter floor)
-  if (totalUs < TDMA_SLOT_MIN_WIDTH_US)
+  // 4. Enforce minimum (WiFi stack jitter floor), less the airtime a faster
+  //    PHY rate saves over the 6 Mbps reference the floor was tuned at
+  uint32_t minWidthUs = TDMA_SLOT_MIN_WIDTH_US;
+  if (phyRate != TDMA_PHY_RATE_6M)
   {
-    return TDMA_SLOT_MIN_WIDTH_US;
+    uint32_t refAirtimeUs =
+        calculateSlotAirtimeUs(sensorCount, compressed, TDMA_PHY_RATE_6M);
+    minWidthUs -= (refAirtimeUs - airtimeUs);
+  }
+  if (totalUs < minWidthUs)
+  {
+    return (uint16_t)minWidthUs;
   }
 
   // 5. Prevent uint16_t overflow (high sensor counts)
@@ -580,7 +807,9 @@ inline uint16_t calculateSlotWidth(uint8_t sensorCount)
 
 // Calculate total frame time needed for all nodes
 // With v2.0: Much simpler - each node gets one fixed-width slot
-inline uint32_t calculateFrameTime(uint8_t nodeCount, uint8_t *sensorCounts)
+// phyRates (optional): TDMAPhyRate per node, defaults to 6 Mbps
+inline uint32_t calculateFrameTime(uint8_t nodeCount, uint8_t *sensorCounts,
+                                   const uint8_t *phyRates = nullptr)
 {
   if (nodeCount == 0)
     return TDMA_BEACON_DURATION_US;
@@ -591,7 +820,9 @@ inline uint32_t calculateFrameTime(uint8_t nodeCount, uint8_t *sensorCounts)
   for (uint8_t i = 0; i < nodeCount; i++)
   {
     uint8_t sensors = (sensorCounts != nullptr) ? sensorCounts[i] : 1;
-    totalSlotTime += calculateSlotWidth(sensors);
+    uint8_t rate = (phyRates != nullptr) ? phyRates[i] : (uint8_t)TDMA_PHY_RATE_6M;
+    totalSlotTime +=
+        calculateSlotWidth(sensors, TDMA_NODE_DATA_COMPRESSION, rate);
   }
 
   // Total: beacon + first gap + slots + inter-slot gaps + guard time
@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * TraceRing.h - Per-core event trace ring (Gateway + Node)
+ *
+ * Fixed-size ring of 8-byte events per CPU core, timestamped with that core's
+ * cycle counter. Recording is one relaxed atomic increment plus an 8-byte
+ * store into the calling core's own ring — no locks, no logging. While
+ * stopped, TRACE_EVENT costs a load and a branch; with ENABLE_TRACE_RING 0
+ * (Config.h) it compiles out entirely.
+ *
+ * Cores never share a ring. Tasks on the same core share it through the
+ * atomic head, so every event gets its own slot even under preemption.
+ *
+ * CLOCKS: CCOUNT is per-core and the counters of the two cores are not
+ * aligned. stop() samples (CCOUNT, esp_timer_get_time()) on every core and
+ * the host converter maps each core's cycles onto the shared esp_timer
+ * timeline through that anchor. CCOUNT wraps every ~17.9s at 240MHz; the
+ * ring covers well under a second of busy pipeline, so (anchor - cycles)
+ * is always unambiguous.
+ *
+ * DUMP FORMAT (little-endian chunks of at most TRACE_DUMP_CHUNK_MAX bytes;
+ * the transport adds its own framing — Gateway: serial frame type 0x07,
+ * Node: "#TRACE <hex>" console lines):
+ *   header: [0x01][version][role][deviceId][coreCount][cpuMhz u16]
+ *           coreCount x [anchorCycles u32][anchorUs u64][recorded u32]
+ *   events: [0x02][core][firstIndex u32][count u8] count x TraceEvent
+ *   end:    [0x03][eventsSent u32]
+ * Host side: firmware/scripts/trace_to_chrome.py
+ *
+ * Include after Config.h. Exactly one translation unit per firmware defines
+ * the `traceRing` instance.
+ ******************************************************************************/
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <Arduino.h>
+
+#ifndef ENABLE_TRACE_RING
+#define ENABLE_TRACE_RING 0
+#endif
+
+// Events kept per core (power of two). 8 bytes each.
+#ifndef TRACE_RING_EVENTS_PER_CORE
+#define TRACE_RING_EVENTS_PER_CORE 1024
+#endif
+
+#define TRACE_DUMP_VERSION 1
+#define TRACE_DUMP_EVENTS_PER_CHUNK 48
+#define TRACE_DUMP_CHUNK_MAX (7 + TRACE_DUMP_EVENTS_PER_CHUNK * 8)
+
+// Dump chunk kinds
+#define TRACE_CHUNK_HEADER 0x01
+#define TRACE_CHUNK_EVENTS 0x02
+#define TRACE_CHUNK_END 0x03
+
+// Device roles in the dump header
+#define TRACE_ROLE_GATEWAY 0
+#define TRACE_ROLE_NODE 1
+
+// CMD_TRACE_CONTROL param1 (Gateway → Node command forward)
+#define TRACE_CONTROL_STOP 0
+#define TRACE_CONTROL_START 1
+#define TRACE_CONTROL_DUMP 2
+
+// ============================================================================
+// Event catalogue (keep in sync with EVENT_NAMES in trace_to_chrome.py)
+// ============================================================================
+enum TraceEventId : uint8_t
+{
+  // Gateway
+  TRACE_EV_BEACON_TX = 1,      // I: beacon handed to MAC, arg = frame (low 16)
+  TRACE_EV_BEACON_TX_DONE = 2, // I: broadcast send-done
+  TRACE_EV_ESPNOW_RX = 3,      // I: ESP-NOW RX callback, arg = packet type
+  TRACE_EV_ADD_SAMPLE = 4,     // B/E: one 0x26 packet into SyncFrameBuffer,
+                               //      B arg = nodeId, E arg = samples added
+  TRACE_EV_FRAME_COMPLETE = 5, // B/E: getCompleteFrame, E arg = 0x25 bytes
+  TRACE_EV_FORCE_EMIT = 6,     // I: partial slot forced out, arg = sensors
+  TRACE_EV_SERIAL_WRITE = 7,   // B/E: USB Serial.write, arg = bytes
+
+  // Node
+  TRACE_EV_I2C_READ = 16,     // B/E: one sensor burst read, arg = sensor
+  TRACE_EV_NODE_TX = 17,      // I: 0x26 handed to esp_now_send, arg = bytes
+  TRACE_EV_NODE_TX_DONE = 18, // I: send callback, arg = 1 if ACKed
+  TRACE_EV_BEACON_RX = 19,    // I: beacon accepted, arg = frame (low 16)
+};
+
+enum TracePhase : uint8_t
+{
+  TRACE_INSTANT = 0,
+  TRACE_BEGIN = 1,
+  TRACE_END = 2
+};
+
+struct __attribute__((packed)) TraceEvent
+{
+  uint32_t cycles; // Recording core's CCOUNT
+  uint8_t id;      // TraceEventId
+  uint8_t phase;   // TracePhase
+  uint16_t arg;
+};
+
+// Receives one dump chunk; called from the dumping task
+typedef void (*TraceDumpSink)(const uint8_t *chunk, size_t len, void *ctx);
+
+#if ENABLE_TRACE_RING
+
+#include <esp_timer.h>
+#if portNUM_PROCESSORS > 1
+#include <esp_ipc.h>
+#endif
+
+static_assert((TRACE_RING_EVENTS_PER_CORE &
+               (TRACE_RING_EVENTS_PER_CORE - 1)) == 0,
+              "TRACE_RING_EVENTS_PER_CORE must be a power of two");
+static_assert(sizeof(TraceEvent) == 8, "TraceEvent must stay 8 bytes");
+
+class TraceRing
+{
+public:
+  void start()
+  {
+    enabled = false;
+    for (uint8_t c = 0; c < portNUM_PROCESSORS; c++)
+    {
+      head[c] = 0;
+    }
+    enabled = true;
+  }
+
+  // Stops recording and anchors every core's CCOUNT to esp_timer
+  void stop()
+  {
+    enabled = false;
+    captureAnchor();
+#if portNUM_PROCESSORS > 1
+    esp_ipc_call_blocking(xPortGetCoreID() == 0 ? 1 : 0, captureAnchorIpc,
+                          this);
+#endif
+    anchored = true;
+  }
+
+  bool isEnabled() const { return enabled; }
+
+  inline void record(uint8_t id, uint8_t phase, uint16_t arg)
+  {
+    if (!enabled)
+      return;
+    uint32_t core = xPortGetCoreID();
+    uint32_t cycles = ESP.getCycleCount();
+    uint32_t index = __atomic_fetch_add(&head[core], 1, __ATOMIC_RELAXED);
+    TraceEvent &e = events[core][index & (TRACE_RING_EVENTS_PER_CORE - 1)];
+    e.cycles = cycles;
+    e.id = id;
+    e.phase = phase;
+    e.arg = arg;
+  }
+
+  // Stops recording (if running) and streams the rings oldest-first.
+  // Returns the number of events sent.
+  uint32_t dump(uint8_t role, uint8_t deviceId, TraceDumpSink sink, void *ctx)
+  {
+    if (enabled || !anchored)
+    {
+      stop();
+    }
+
+    uint8_t chunk[TRACE_DUMP_CHUNK_MAX];
+    size_t n = 0;
+    chunk[n++] = TRACE_CHUNK_HEADER;
+    chunk[n++] = TRACE_DUMP_VERSION;
+    chunk[n++] = role;
+    chunk[n++] = deviceId;
+    chunk[n++] = portNUM_PROCESSORS;
+    uint16_t mhz = (uint16_t)getCpuFrequencyMhz();
+    n = put(chunk, n, &mhz, sizeof(mhz));
+    for (uint8_t c = 0; c < portNUM_PROCESSORS; c++)
+    {
+      n = put(chunk, n, &anchorCycles[c], sizeof(anchorCycles[c]));
+      n = put(chunk, n, &anchorUs[c], sizeof(anchorUs[c]));
+      n = put(chunk, n, &head[c], sizeof(head[c]));
+    }
+    sink(chunk, n, ctx);
+
+    uint32_t sent = 0;
+    for (uint8_t c = 0; c < portNUM_PROCESSORS; c++)
+    {
+      uint32_t recorded = head[c];
+      uint32_t first = (recorded > TRACE_RING_EVENTS_PER_CORE)
+                           ? recorded - TRACE_RING_EVENTS_PER_CORE
+                           : 0;
+      for (uint32_t index = first; index < recorded;)
+      {
+        uint32_t count = recorded - index;
+        if (count > TRACE_DUMP_EVENTS_PER_CHUNK)
+          count = TRACE_DUMP_EVENTS_PER_CHUNK;
+
+        n = 0;
+        chunk[n++] = TRACE_CHUNK_EVENTS;
+        chunk[n++] = c;
+        n = put(chunk, n, &index, sizeof(index));
+        chunk[n++] = (uint8_t)count;
+        for (uint32_t k = 0; k < count; k++)
+        {
+          n = put(chunk, n,
+                  &events[c][(index + k) & (TRACE_RING_EVENTS_PER_CORE - 1)],
+                  sizeof(TraceEvent));
+        }
+        sink(chunk, n, ctx);
+        index += count;
+        sent += count;
+      }
+    }
+
+    n = 0;
+    chunk[n++] = TRACE_CHUNK_END;
+    n = put(chunk, n, &sent, sizeof(sent));
+    sink(chunk, n, ctx);
+    return sent;
+  }
+
+private:
+  TraceEvent events[portNUM_PROCESSORS][TRACE_RING_EVENTS_PER_CORE];
+  uint32_t head[portNUM_PROCESSORS] = {};
+  uint32_t anchorCycles[portNUM_PROCESSORS] = {};
+  int64_t anchorUs[portNUM_PROCESSORS] = {};
+  volatile bool enabled = false;
+  bool anchored = false;
+
+  void captureAnchor()
+  {
+    uint32_t core = xPortGetCoreID();
+    anchorCycles[core] = ESP.getCycleCount();
+    anchorUs[core] = esp_timer_get_time();
+  }
+
+  static void captureAnchorIpc(void *arg)
+  {
+    static_cast<TraceRing *>(arg)->captureAnchor();
+  }
+
+  static size_t put(uint8_t *dst, size_t offset, const void *src, size_t len)
+  {
+    memcpy(dst + offset, src, len);
+    return offset + len;
+  }
+};
+
+extern TraceRing traceRing;
+
+#define TRACE_EVENT(id, phase, arg) \
+  traceRing.record((id), (phase), (uint16_t)(arg))
+
+#else
+
+#define TRACE_EVENT(id, phase, arg) \
+  do                                \
+  {                                 \
+  } while (0)
+
+#endif // ENABLE_TRACE_RING
+
+#endif // TRACE_RING_H
@@ -0,0 +1,307 @@
+"""
+serial_framing_bench.py - Reference decoders + resync benchmark for Gateway USB framing
+
+Framing (firmware/libraries/IMUConnectCore/src/SerialFraming.h):
+  legacy: [len lo][len hi][type][payload] back to back
+  cobs:   0x00 COBS([type][payload][crc32 LE]) 0x00 ...  (after FRAMING ack)
+
+The benchmark builds a synthetic 200 Hz stream (0x25 sync frames with a few
+0x06 / 0x09 frames mixed in), injects one fault per trial (dropped byte,
+flipped byte, or a burst of log text) and decodes it with both reference
+decoders. Per fault it reports frames lost, garbage frames accepted as valid,
+and bytes from the fault until the decoder delivers a correct frame again.
+The legacy decoder mirrors mash-app serialWorker.ts; the COBS decoder mirrors
+SerialFraming.ts.
+
+Usage:
+  python serial_framing_bench.py                    # synthetic benchmark
+  python serial_framing_bench.py --trials 2000 --sensors 12
+  python serial_framing_bench.py capture.bin --mode cobs   # decode a capture
+"""
+
+import argparse
+import random
+import struct
+import sys
+import time
+import zlib
+
+MAX_FRAME_LEN = 4096
+COBS_FALLBACK_BAD_FRAMES = 8
+
+
+# ============================================================================
+# Encoders
+# ============================================================================
+
+
+def legacy_encode(frame):
+    return struct.pack("<H", len(frame)) + frame
+
+
+def cobs_encode(frame):
+    body = frame + struct.pack("<I", zlib.crc32(frame))
+    out = bytearray([0])
+    code_at = 0
+    code = 1
+    for b in body:
+        if b == 0:
+            out[code_at] = code
+            code_at = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_at] = code
+            code_at = len(out)
+            out.append(0)
+            code = 1
+    out[code_at] = code
+    out.append(0)
+    return bytes(out)
+
+
+# ============================================================================
+# Reference decoders
+# ============================================================================
+
+
+def is_plausible_frame(packet_type, frame_len):
+    """Same rules as isPlausibleFrame() in serialWorker.ts."""
+    if packet_type == 0x25:
+        if frame_len < 26 or frame_len > 10 + 32 * 16 + 1:
+            return False
+        return (frame_len - 10) % 16 in (0, 1)
+    if packet_type == 0x05:
+        return frame_len in (37, 46)
+    if packet_type == 0x04:
+        return frame_len == 31
+    if packet_type == 0x06:
+        return 2 <= frame_len <= MAX_FRAME_LEN
+    if packet_type == 0x07:
+        return 6 <= frame_len <= 392
+    if packet_type == 0x08:
+        return 14 <= frame_len <= 494 and (frame_len - 14) % 4 == 0
+    if packet_type == 0x09:
+        return 8 <= frame_len <= 256
+    return False
+
+
+class LegacyDecoder:
+    """Length-prefix parser with byte-wise resync on implausible frames."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.resync_bytes = 0
+
+    def push(self, data):
+        self.buf.extend(data)
+        frames = []
+        pos = 0
+        buf = self.buf
+        while len(buf) - pos >= 2:
+            frame_len = buf[pos] | (buf[pos + 1] << 8)
+            if frame_len < 3 or frame_len > MAX_FRAME_LEN:
+                pos += 1
+                self.resync_bytes += 1
+                continue
+            if len(buf) - pos < 2 + frame_len:
+                break
+            if not is_plausible_frame(buf[pos + 2], frame_len):
+                pos += 1
+                self.resync_bytes += 1
+                continue
+            frames.append(bytes(buf[pos + 2 : pos + 2 + frame_len]))
+            pos += 2 + frame_len
+        del buf[:pos]
+        return frames
+
+
+def cobs_decode_block(block):
+    out = bytearray()
+    r = 0
+    while r < len(block):
+        code = block[r]
+        r += 1
+        if code == 0 or r + code - 1 > len(block):
+            return None
+        out.extend(block[r : r + code - 1])
+        r += code - 1
+        if code != 0xFF and r < len(block):
+            out.append(0)
+    if len(out) <= 4:
+        return None
+    frame, crc = bytes(out[:-4]), struct.unpack("<I", out[-4:])[0]
+    return frame if zlib.crc32(frame) == crc else None
+
+
+class CobsDecoder:
+    """Delimiter-driven COBS decoder; rejects frames that fail the CRC."""
+
+    def __init__(self):
+        self.block = bytearray()
+        self.bad_frames = 0
+        self.consecutive_bad = 0
+
+    def push(self, data):
+        frames = []
+        start = 0
+        while True:
+            end = data.find(0, start)
+            if end < 0:
+                self.block.extend(data[start:])
+                return frames
+            self.block.extend(data[start:end])
+            start = end + 1
+            if not self.block:
+                continue
+            frame = cobs_decode_block(bytes(self.block))
+            self.block.clear()
+            if frame is None:
+                self.bad_frames += 1
+                self.consecutive_bad += 1
+            else:
+                self.consecutive_bad = 0
+                frames.append(frame)
+
+    @property
+    def lost_framing(self):
+        return self.consecutive_bad >= COBS_FALLBACK_BAD_FRAMES
+
+
+# ============================================================================
+# Synthetic stream + fault injection
+# ============================================================================
+
+
+def make_frames(count, sensors, rng):
+    frames = []
+    for seq in range(count):
+        if seq % 200 == 199:
+            frames.append(b"\x06" + b'{"type":"sync_status","seq":%d}' % seq)
+            continue
+        if seq % 100 == 50:
+            frames.append(b"\x09\x01\x02" + struct.pack("<I", seq) + bytes(28))
+            continue
+        header = struct.pack("<BIIB", 0x25, seq, seq * 5000, sensors)
+        body = bytearray()
+        for s in range(sensors):
+            quat = [rng.randint(-16384, 16384) for _ in range(4)]
+            body += struct.pack("<B4h3hB", s, *quat, 0, rng.randint(0, 50), 0, 1)
+        frames.append(header + bytes(body))
+    return frames
+
+
+def inject(stream, kind, pos, rng):
+    if kind == "drop":
+        return stream[:pos] + stream[pos + 1 :]
+    if kind == "flip":
+        flipped = stream[pos] ^ (1 << rng.randrange(8))
+        return stream[:pos] + bytes([flipped]) + stream[pos + 1 :]
+    text = b"[Sync] Node %d late beacon, resync\r\n" % rng.randrange(10)
+    return stream[:pos] + text + stream[pos:]
+
+
+def run_trial(decoder, frames, encoded, kind, rng, chunk=64):
+    offsets = []
+    stream = bytearray()
+    for e in encoded:
+        offsets.append(len(stream))
+        stream += e
+    # Fault somewhere in the middle third, so recovery is always observable
+    pos = rng.randrange(len(stream) // 3, 2 * len(stream) // 3)
+    damaged = inject(bytes(stream), kind, pos, rng)
+
+    got = []
+    for i in range(0, len(damaged), chunk):
+        got.extend(decoder.push(damaged[i : i + chunk]))
+
+    valid = set(frames)
+    garbage = sum(1 for f in got if f not in valid)
+    lost = len(frames) - sum(1 for f in got if f in valid)
+
+    # First good frame that starts after the fault
+    fault_frame = next(
+        i for i in range(len(offsets)) if i + 1 == len(offsets) or offsets[i + 1] > pos
+    )
+    recovery_bytes = None
+    got_set = set(got)
+    for i in range(fault_frame, len(frames)):
+        if frames[i] in got_set and offsets[i] > pos:
+            recovery_bytes = offsets[i] - pos
+            break
+    return lost, garbage, recovery_bytes
+
+
+def benchmark(args):
+    rng = random.Random(args.seed)
+    frames = make_frames(args.frames, args.sensors, rng)
+    encoders = {"legacy": legacy_encode, "cobs": cobs_encode}
+    decoders = {"legacy": LegacyDecoder, "cobs": CobsDecoder}
+
+    print(f"{args.frames} frames, {args.sensors} sensors/frame, {args.trials} trials per fault")
+    for mode in ("legacy", "cobs"):
+        encoded = [encoders[mode](f) for f in frames]
+        total = sum(len(e) for e in encoded)
+        raw = sum(len(f) for f in frames)
+
+        t0 = time.perf_counter()
+        decoded = decoders[mode]().push(b"".join(encoded))
+        dt = time.perf_counter() - t0
+        assert decoded == frames, f"{mode}: clean stream did not round-trip"
+
+        print(f"\n[{mode}] overhead {100.0 * (total - raw) / raw:.1f}%  "
+              f"decode {total / dt / 1e6:.2f} MB/s (Python)")
+        print(f"  {'fault':<6} {'lost/fault':>10} {'max lost':>9} {'garbage':>8} "
+              f"{'recover p50':>12} {'recover max':>12}")
+        for kind in ("drop", "flip", "text"):
+            losses, garbage, recover = [], 0, []
+            for _ in range(args.trials):
+                lost, bad, rec = run_trial(decoders[mode](), frames, encoded, kind, rng)
+                losses.append(lost)
+                garbage += bad
+                if rec is not None:
+                    recover.append(rec)
+            recover.sort()
+            p50 = recover[len(recover) // 2] if recover else -1
+            worst = recover[-1] if recover else -1
+            print(f"  {kind:<6} {sum(losses) / len(losses):>10.2f} {max(losses):>9} "
+                  f"{garbage:>8} {p50:>10} B {worst:>10} B")
+
+
+def decode_capture(path, mode):
+    with open(path, "rb") as f:
+        data = f.read()
+    decoder = CobsDecoder() if mode == "cobs" else LegacyDecoder()
+    frames = decoder.push(data)
+    types = {}
+    for frame in frames:
+        types[frame[0]] = types.get(frame[0], 0) + 1
+    summary = ", ".join(f"0x{t:02x}: {n}" for t, n in sorted(types.items()))
+    print(f"{path}: {len(frames)} frames ({summary})")
+    if mode == "cobs":
+        print(f"  bad frames: {decoder.bad_frames}")
+    else:
+        print(f"  resync bytes skipped: {decoder.resync_bytes}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("capture", nargs="?", help="Raw Gateway USB capture to decode")
+    parser.add_argument("--mode", choices=("legacy", "cobs"), default="cobs")
+    parser.add_argument("--frames", type=int, default=600)
+    parser.add_argument("--sensors", type=int, default=6)
+    parser.add_argument("--trials", type=int, default=300)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    if args.capture:
+        decode_capture(args.capture, args.mode)
+    else:
+        benchmark(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
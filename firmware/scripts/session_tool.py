@@ -0,0 +1,517 @@
+"""
+session_tool.py - Download and decode sessions recorded on the Gateway
+
+Format: firmware/libraries/IMUConnectCore/src/SessionFormat.h
+  sNNNN.idx  one 72-byte chunk header per chunk (seek index)
+  sNNNN.msr  4096-byte chunks: [header][len][0x25 frame]... [0xFF padding]
+             (historical 0x26 backfill packets are interleaved as records)
+
+Usage:
+  python session_tool.py --port COM5 list
+  python session_tool.py --port COM5 download 3 -o session3
+  python session_tool.py --port COM5 download 3 --chunk 40 --count 10 -o part
+  python session_tool.py info session3.msr
+  python session_tool.py csv session3.msr -o session3.csv --from-ms 5000 --to-ms 9000
+  python session_tool.py csv session3.msr -o enviro3.csv --enviro
+
+download writes <out>.idx and <out>.msr. A partial download (--chunk/--count)
+leaves the missing chunks zero-filled; info and csv skip them. The Gateway
+must not be recording, and downloads run in legacy USB framing.
+
+Records the Gateway synthesized (gap fill) have flags 3 in the CSV. When the
+session holds the late real sample for one, csv writes that instead, flags 1.
+Samples a Node backfilled from its flash black box after an RF outage (0x26
+packets flagged HISTORICAL) replace synthesized records and fill sensors
+missing from a frame, also with flags 1. Duplicate backfills (lost ACKs) are
+merged by (node, sensor, sample time).
+"""
+
+import argparse
+import collections
+import json
+import struct
+import sys
+import time
+import zlib
+
+BAUD_RATE = 921600
+
+PACKET_JSON = 0x06
+PACKET_SESSION = 0x0A
+FILE_INDEX, FILE_DATA = 0, 1
+
+PAGE_SIZE = 4096
+CHUNK_MAGIC = 0x4352534D
+CHUNK_FLAG_GAP = 0x01
+CHUNK_FLAG_FINAL = 0x02
+
+# SessionChunkHeader (72 bytes, crc32 last)
+HEADER = struct.Struct("<IBBHIHHIIIII32sI")
+assert HEADER.size == 72
+HEADER_FIELDS = (
+    "magic", "version", "flags", "session", "chunk", "records", "used",
+    "first_frame", "last_frame", "first_ts", "last_ts", "dropped", "mask", "crc",
+)
+
+SYNC_HEADER = struct.Struct("<BIIB")
+SYNC_SENSOR = struct.Struct("<B3h3hBBB")  # ..., flags, rawNodeId, sensor index
+# Multi-rate mag/baro record (SyncFrameEnviroData), same 16-byte grid
+SYNC_ENVIRO = struct.Struct("<B3hIhBBB")
+SYNC_FLAG_ENVIRO = 0x04
+# Late real sample for a gap-filled record (SyncFrameCorrectionData)
+SYNC_CORRECTION = struct.Struct("<B3h3hBBB")
+SYNC_FLAG_VALID, SYNC_FLAG_INTERPOLATED = 0x01, 0x02
+SYNC_FLAG_CORRECTION = 0x08
+CORRECTION_MAX_BACK = 255  # framesBack is one byte
+ENVIRO_HAS_MAG, ENVIRO_HAS_BARO = 0x01, 0x02
+
+# Historical 0x26 node data (TDMANodeDataPacket + samples, TDMAProtocol.h)
+PACKET_SYNC = 0x25
+PACKET_NODE_DATA = 0x26
+NODE_HEADER = struct.Struct("<BBIBBBB")  # presentMask in the last byte
+NODE_SAMPLE = struct.Struct("<BI3h3h")  # TDMABatchedSensorData
+NODE_FLAG_HISTORICAL = 0x08
+NODE_FLAG_COMPRESSED = 0x10
+SAMPLE_PERIOD_US = 5000  # A sample matches the frame within half a period
+
+
+# ============================================================================
+# File decoding
+# ============================================================================
+
+
+def parse_header(buf, offset=0):
+    h = dict(zip(HEADER_FIELDS, HEADER.unpack_from(buf, offset)))
+    h["sensors"] = [i for i in range(256) if h["mask"][i >> 3] >> (i & 7) & 1]
+    return h
+
+
+def chunk_valid(page):
+    h = parse_header(page)
+    if h["magic"] != CHUNK_MAGIC or h["used"] > PAGE_SIZE - HEADER.size:
+        return False
+    crc = zlib.crc32(page[: HEADER.size - 4])
+    crc = zlib.crc32(page[HEADER.size : HEADER.size + h["used"]], crc)
+    return crc == h["crc"]
+
+
+def read_chunks(path):
+    """Yield (header, payload) for every valid chunk of a .msr file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    for offset in range(0, len(data) - PAGE_SIZE + 1, PAGE_SIZE):
+        page = data[offset : offset + PAGE_SIZE]
+        if not chunk_valid(page):
+            continue
+        h = parse_header(page)
+        yield h, page[HEADER.size : HEADER.size + h["used"]]
+
+
+def iter_frames(payload):
+    """Yield raw frames from a chunk payload ([len lo][len hi][frame]...)."""
+    i = 0
+    while i + 2 <= len(payload):
+        n = payload[i] | (payload[i + 1] << 8)
+        if n == 0 or i + 2 + n > len(payload):
+            break
+        yield payload[i + 2 : i + 2 + n]
+        i += 2 + n
+
+
+def decode_sync_frame(frame):
+    """Return (frame_number, ts, sensors, enviro, corrections) for one 0x25 frame.
+
+    enviro holds the mag/baro records: (sid, node, contents, mx, my, mz [uT],
+    pressure [hPa], temperature [C]). corrections holds late real samples for
+    gap-filled records of earlier frames: (sid, frames_back, ax, ..., gz).
+    """
+    _, frame_number, ts, count = SYNC_HEADER.unpack_from(frame, 0)
+    sensors = []
+    enviro = []
+    corrections = []
+    for s in range(count):
+        offset = SYNC_HEADER.size + s * SYNC_SENSOR.size
+        if offset + SYNC_SENSOR.size > len(frame):
+            break
+        if frame[offset + 13] & SYNC_FLAG_ENVIRO:
+            sid, mx, my, mz, pressure, temp, _, node, contents = \
+                SYNC_ENVIRO.unpack_from(frame, offset)
+            enviro.append((sid, node, contents, mx / 10.0, my / 10.0, mz / 10.0,
+                           pressure / 10000.0, temp / 100.0))
+            continue
+        if frame[offset + 13] & SYNC_FLAG_CORRECTION:
+            sid, ax, ay, az, gx, gy, gz, _, _, back = \
+                SYNC_CORRECTION.unpack_from(frame, offset)
+            corrections.append((sid, back, ax / 100.0, ay / 100.0, az / 100.0,
+                                gx / 900.0, gy / 900.0, gz / 900.0))
+            continue
+        sid, ax, ay, az, gx, gy, gz, flags, node, index = \
+            SYNC_SENSOR.unpack_from(frame, offset)
+        sensors.append((sid, ax / 100.0, ay / 100.0, az / 100.0,
+                        gx / 900.0, gy / 900.0, gz / 900.0, flags, node, index))
+    return frame_number, ts, sensors, enviro, corrections
+
+
+def read_varint(buf, offset):
+    value = shift = 0
+    while shift < 35:
+        byte = buf[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+    raise ValueError("varint too long")
+
+
+def zigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_historical(frame):
+    """Return [(node, sensor_index, ts, ax, ..., gz)] for a historical 0x26 packet.
+
+    Only sample indices set in presentMask are returned. Raw and compressed
+    (NodeDataCodec.h) sample blocks are both handled.
+    """
+    if len(frame) < NODE_HEADER.size + 1:
+        return []
+    _, node, _, flags, samples, count, present = NODE_HEADER.unpack_from(frame, 0)
+    if not flags & NODE_FLAG_HISTORICAL or count == 0:
+        return []
+    block = []  # [sample][sensor] -> (ts, a[3], g[3])
+    offset = NODE_HEADER.size
+    try:
+        if flags & NODE_FLAG_COMPRESSED:
+            ts = struct.unpack_from("<I", frame, offset)[0]
+            offset += 4 + count  # Base timestamp, sensor IDs
+            for s in range(samples):
+                row = []
+                for i in range(count):
+                    v, offset = read_varint(frame, offset)
+                    ts = (ts + zigzag(v)) & 0xFFFFFFFF
+                    axes = []
+                    for k in range(6):
+                        v, offset = read_varint(frame, offset)
+                        prev = block[s - 1][i][1][k] if s > 0 else 0
+                        axes.append((prev + zigzag(v) + 0x8000) % 0x10000 - 0x8000)
+                    row.append((ts, axes))
+                block.append(row)
+        else:
+            for s in range(samples):
+                row = []
+                for i in range(count):
+                    _, ts, *axes = NODE_SAMPLE.unpack_from(frame, offset)
+                    offset += NODE_SAMPLE.size
+                    row.append((ts, axes))
+                block.append(row)
+    except (IndexError, struct.error, ValueError):
+        return []
+    out = []
+    for s, row in enumerate(block):
+        if not present >> s & 1:
+            continue
+        for i, (ts, axes) in enumerate(row):
+            out.append((node, i, ts, axes[0] / 100.0, axes[1] / 100.0,
+                        axes[2] / 100.0, axes[3] / 900.0, axes[4] / 900.0,
+                        axes[5] / 900.0))
+    return out
+
+
+def ts_diff(a, b):
+    """a - b for 32-bit microsecond timestamps, across the wrap."""
+    d = (a - b) & 0xFFFFFFFF
+    return d - (1 << 32) if d >= 1 << 31 else d
+
+
+class Backfill:
+    """Historical samples of a session, found by (node, sensor index, time)."""
+
+    def __init__(self, path):
+        self.samples = {}  # (node, index, ts // period) -> {ts: values}
+        self.sensor_ids = {}  # (node, index) -> sensor ID in the 0x25 frames
+        self.packets = 0
+        self.used = 0
+        for _, payload in read_chunks(path):
+            for frame in iter_frames(payload):
+                if frame[0] == PACKET_NODE_DATA:
+                    self.packets += 1
+                    for node, index, ts, *values in decode_historical(frame):
+                        key = (node, index, ts // SAMPLE_PERIOD_US)
+                        # Duplicates (lost ACK) land on the same entry
+                        self.samples.setdefault(key, {})[ts] = values
+                elif frame[0] == PACKET_SYNC:
+                    for s in decode_sync_frame(frame)[2]:
+                        if s[8]:  # rawNodeId 0: firmware without identity
+                            self.sensor_ids[(s[8], s[9])] = s[0]
+
+    def find(self, node, index, frame_ts):
+        """Backfilled [ax, ..., gz] of the sample taken at frame_ts, or None."""
+        bucket = frame_ts // SAMPLE_PERIOD_US
+        for b in (bucket - 1, bucket, bucket + 1):
+            for ts, values in self.samples.get((node, index, b), {}).items():
+                if abs(ts_diff(ts, frame_ts)) <= SAMPLE_PERIOD_US // 2:
+                    return values
+        return None
+
+    def splice(self, ts, rows, sensor):
+        """Replace synthesized rows of one frame, add missing sensors."""
+        if not self.samples:
+            return
+        present = set()
+        for row in rows:
+            present.add(row[0])
+            if row[7] & SYNC_FLAG_INTERPOLATED:
+                values = self.find(row[8], row[9], ts)
+                if values:
+                    row[1:8] = values + [SYNC_FLAG_VALID]
+                    self.used += 1
+        for (node, index), sid in self.sensor_ids.items():
+            if sid in present or (sensor is not None and sid != sensor):
+                continue
+            values = self.find(node, index, ts)
+            if values:
+                rows.append([sid] + values + [SYNC_FLAG_VALID, node, index])
+                self.used += 1
+
+
+def info(args):
+    chunks = list(read_chunks(args.file))
+    if not chunks:
+        print(f"{args.file}: no valid chunks")
+        return 1
+    first, last = chunks[0][0], chunks[-1][0]
+    frames = sum(h["records"] for h, _ in chunks)
+    backfill = sum(1 for _, payload in chunks for frame in iter_frames(payload)
+                   if frame[0] == PACKET_NODE_DATA)
+    gaps = [h["chunk"] for h, _ in chunks if h["flags"] & CHUNK_FLAG_GAP]
+    sensors = sorted({s for h, _ in chunks for s in h["sensors"]})
+    print(f"session {first['session']}: {len(chunks)} chunks, {frames} frames, "
+          f"{(last['last_ts'] - first['first_ts']) / 1e6:.2f} s")
+    print(f"  frames {first['first_frame']}..{last['last_frame']}, "
+          f"dropped {last['dropped']}, gaps before chunks {gaps or 'none'}")
+    print(f"  sensors {sensors}")
+    if backfill:
+        print(f"  {backfill} black box backfill packets")
+    print(f"  {'complete' if last['flags'] & CHUNK_FLAG_FINAL else 'not closed cleanly'}")
+    if args.verbose:
+        for h, _ in chunks:
+            print(f"  chunk {h['chunk']:5d}: frames {h['first_frame']}..{h['last_frame']} "
+                  f"ts {h['first_ts']}..{h['last_ts']} records {h['records']}")
+    return 0
+
+
+def export_csv(args):
+    from_us = None if args.from_ms is None else args.from_ms * 1000
+    to_us = None if args.to_ms is None else args.to_ms * 1000
+    rows = 0
+    base_ts = None
+    backfill = None if args.enviro else Backfill(args.file)
+    # IMU rows wait until no later correction can reach them
+    held = collections.OrderedDict()  # frame_number -> (ts, [row lists])
+
+    def flush(before):
+        nonlocal rows
+        while held and (before is None or next(iter(held)) < before):
+            frame_number, (ts, frame_rows) = held.popitem(last=False)
+            backfill.splice(ts, frame_rows, args.sensor)  # After corrections
+            for sid, ax, ay, az, gx, gy, gz, flags, *_ in frame_rows:
+                out.write(f"{frame_number},{ts},{sid},{ax:.2f},{ay:.2f},{az:.2f},"
+                          f"{gx:.3f},{gy:.3f},{gz:.3f},{flags}\n")
+                rows += 1
+
+    with open(args.output, "w") as out:
+        if args.enviro:
+            out.write("frame,timestamp_us,sensor,node,mx,my,mz,pressure_hpa,temperature_c\n")
+        else:
+            out.write("frame,timestamp_us,sensor,ax,ay,az,gx,gy,gz,flags\n")
+        for h, payload in read_chunks(args.file):
+            if base_ts is None:
+                base_ts = h["first_ts"]
+            # Chunk index: skip whole chunks outside the window or sensor set
+            if from_us is not None and h["last_ts"] - base_ts < from_us:
+                continue
+            if to_us is not None and h["first_ts"] - base_ts > to_us:
+                break
+            if h["records"] == 0:
+                continue  # Backfill packets only
+            if (args.sensor is not None and args.sensor not in h["sensors"]
+                    and not (backfill and backfill.samples)):
+                continue
+            for frame in iter_frames(payload):
+                if frame[0] != PACKET_SYNC:
+                    continue  # Backfill packets: read up front by Backfill
+                frame_number, ts, sensors, enviro, corrections = \
+                    decode_sync_frame(frame)
+                if not args.enviro:
+                    if held and frame_number <= next(reversed(held)):
+                        flush(None)  # Frame numbers restarted (Gateway reset)
+                    for sid, back, *values in corrections:
+                        target = held.get(frame_number - back)
+                        for row in target[1] if target else ():
+                            if row[0] == sid and row[7] & SYNC_FLAG_INTERPOLATED:
+                                row[1:8] = values + [SYNC_FLAG_VALID]
+                    flush(frame_number - CORRECTION_MAX_BACK)
+                rel = ts - base_ts
+                if (from_us is not None and rel < from_us) or (to_us is not None and rel > to_us):
+                    continue
+                if args.enviro:
+                    for sid, node, contents, mx, my, mz, pressure, temp in enviro:
+                        if args.sensor is not None and sid != args.sensor:
+                            continue
+                        mag = (f"{mx:.1f},{my:.1f},{mz:.1f}"
+                               if contents & ENVIRO_HAS_MAG else ",,")
+                        baro = (f"{pressure:.4f},{temp:.2f}"
+                                if contents & ENVIRO_HAS_BARO else ",")
+                        out.write(f"{frame_number},{ts},{sid},{node},{mag},{baro}\n")
+                        rows += 1
+                    continue
+                held[frame_number] = (ts, [list(s) for s in sensors
+                                           if args.sensor is None or s[0] == args.sensor])
+        flush(None)
+    print(f"wrote {rows} rows to {args.output}")
+    if backfill and backfill.packets:
+        print(f"  {backfill.used} samples from {backfill.packets} backfill packets")
+    return 0
+
+
+# ============================================================================
+# Serial transport (legacy framing)
+# ============================================================================
+
+
+def read_frames(ser, buf):
+    """Append new serial bytes to buf and yield complete frames."""
+    buf.extend(ser.read(4096))
+    i = 0
+    while i + 3 <= len(buf):
+        n = buf[i] | (buf[i + 1] << 8)
+        kind = buf[i + 2]
+        plausible = (
+            (kind == PACKET_SESSION and 12 <= n <= 12 + 1024)
+            or (kind == PACKET_JSON and 2 <= n <= 4096)
+            or (kind == 0x25 and 10 <= n <= 10 + 32 * 16 + 1)
+        )
+        if not plausible:
+            i += 1
+            continue
+        if i + 2 + n > len(buf):
+            break
+        yield bytes(buf[i + 2 : i + 2 + n])
+        i += 2 + n
+    del buf[:i]
+
+
+def command(ser, cmd, timeout=3.0):
+    """Send a RECORD command and return its JSON response."""
+    ser.write((json.dumps(cmd) + "\n").encode())
+    buf = bytearray()
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        for frame in read_frames(ser, buf):
+            if frame[0] != PACKET_JSON:
+                continue
+            try:
+                msg = json.loads(frame[1:].decode("utf-8", errors="replace"))
+            except ValueError:
+                continue
+            if msg.get("type") == "recorder" or msg.get("success") is False:
+                return msg
+    raise TimeoutError("no response from Gateway")
+
+
+def download(ser, args):
+    cmd = {"cmd": "RECORD", "action": "download", "session": args.session,
+           "chunk": args.chunk, "count": args.count}
+    ser.reset_input_buffer()
+    ser.write((json.dumps(cmd) + "\n").encode())
+
+    files = {FILE_INDEX: bytearray(), FILE_DATA: bytearray()}
+    done = set()
+    buf = bytearray()
+    deadline = time.time() + 5.0
+    while len(done) < 2 and time.time() < deadline:
+        for frame in read_frames(ser, buf):
+            if frame[0] == PACKET_JSON:
+                try:
+                    msg = json.loads(frame[1:].decode("utf-8", errors="replace"))
+                except ValueError:
+                    continue
+                if msg.get("success") is False:
+                    print(f"Gateway refused: {msg.get('error')}", file=sys.stderr)
+                    return 1
+                continue
+            if frame[0] != PACKET_SESSION:
+                continue
+            kind, session, offset, size = struct.unpack_from("<BHII", frame, 1)
+            if session != args.session:
+                continue
+            body = frame[12:]
+            target = files[kind]
+            if len(target) < size:
+                target.extend(bytes(size - len(target)))
+            target[offset : offset + len(body)] = body
+            if not body:
+                done.add(kind)
+            deadline = time.time() + 2.0  # Keep going while pieces flow
+
+    with open(args.output + ".idx", "wb") as f:
+        f.write(files[FILE_INDEX])
+    with open(args.output + ".msr", "wb") as f:
+        f.write(files[FILE_DATA])
+    valid = sum(1 for _ in read_chunks(args.output + ".msr"))
+    print(f"session {args.session}: {len(files[FILE_INDEX]) // HEADER.size} chunks "
+          f"indexed, {valid} valid chunks downloaded -> {args.output}.msr")
+    return 0 if len(done) == 2 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--port", help="Gateway serial port (list/download)")
+    sub = parser.add_subparsers(dest="action", required=True)
+
+    sub.add_parser("list", help="List sessions stored on the Gateway")
+    dl = sub.add_parser("download", help="Download a session")
+    dl.add_argument("session", type=int)
+    dl.add_argument("--chunk", type=int, default=0, help="First data chunk")
+    dl.add_argument("--count", type=int, default=0, help="Data chunks (0 = all)")
+    dl.add_argument("-o", "--output", default=None)
+
+    inf = sub.add_parser("info", help="Summarise a downloaded .msr file")
+    inf.add_argument("file")
+    inf.add_argument("-v", "--verbose", action="store_true")
+
+    csv = sub.add_parser("csv", help="Export a downloaded .msr file as CSV")
+    csv.add_argument("file")
+    csv.add_argument("-o", "--output", required=True)
+    csv.add_argument("--from-ms", type=int, default=None)
+    csv.add_argument("--to-ms", type=int, default=None)
+    csv.add_argument("--sensor", type=int, default=None)
+    csv.add_argument("--enviro", action="store_true",
+                     help="Export the inline magnetometer/barometer records")
+
+    args = parser.parse_args()
+    if args.action == "info":
+        return info(args)
+    if args.action == "csv":
+        return export_csv(args)
+
+    if not args.port:
+        parser.error("--port is required for list/download")
+    import serial
+
+    ser = serial.Serial(args.port, BAUD_RATE, timeout=0.2)
+    try:
+        if args.action == "list":
+            msg = command(ser, {"cmd": "RECORD", "action": "list"})
+            for s in msg.get("sessions", []):
+                print(json.dumps(s))
+            return 0
+        args.output = args.output or f"s{args.session:04d}"
+        return download(ser, args)
+    finally:
+        ser.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
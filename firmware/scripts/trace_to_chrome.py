@@ -0,0 +1,226 @@
+"""
+trace_to_chrome.py - Convert MASH trace ring dumps to Chrome/Perfetto trace JSON
+
+Inputs (any mix, one process per device in the output):
+  - Gateway USB capture: raw serial bytes containing length-prefixed 0x07
+    frames ({"cmd":"TRACE","action":"dump"}). Other frames are skipped.
+  - Node console log: "#TRACE <hex>" lines printed by the Node on its USB port.
+  - --port COM5: live Gateway capture (start, wait --seconds, dump).
+
+Usage:
+  python trace_to_chrome.py gateway.bin node1.log -o trace.json
+  python trace_to_chrome.py --port COM5 --seconds 5 -o trace.json
+
+Open the result in https://ui.perfetto.dev or chrome://tracing.
+Timestamps are esp_timer microseconds of each device. Gateway and Nodes do
+not share a clock, so compare spans across devices by shape, not absolute ts.
+Dump format: firmware/libraries/IMUConnectCore/src/TraceRing.h
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+BAUD_RATE = 921600
+
+PACKET_TRACE = 0x07
+CHUNK_HEADER = 0x01
+CHUNK_EVENTS = 0x02
+CHUNK_END = 0x03
+
+ROLE_NAMES = {0: "Gateway", 1: "Node"}
+PHASE_INSTANT, PHASE_BEGIN, PHASE_END = 0, 1, 2
+
+# Keep in sync with TraceEventId (TraceRing.h)
+EVENT_NAMES = {
+    1: "beacon_tx",
+    2: "beacon_tx_done",
+    3: "espnow_rx",
+    4: "add_sample",
+    5: "frame_complete",
+    6: "force_emit",
+    7: "serial_write",
+    16: "i2c_read",
+    17: "node_tx",
+    18: "node_tx_done",
+    19: "beacon_rx",
+}
+
+
+# ============================================================================
+# Chunk extraction
+# ============================================================================
+
+
+def chunks_from_binary(data):
+    """Yield 0x07 payloads from a raw [len lo][len hi][type][payload] stream."""
+    i = 0
+    while i + 3 <= len(data):
+        frame_len = data[i] | (data[i + 1] << 8)
+        if data[i + 2] == PACKET_TRACE and 6 <= frame_len <= 392:
+            end = i + 2 + frame_len
+            if end <= len(data):
+                yield bytes(data[i + 3 : end])
+                i = end
+                continue
+        i += 1  # Not a trace frame (or log noise): resync byte-wise
+
+
+def chunks_from_text(text):
+    for line in text.splitlines():
+        marker = line.find("#TRACE ")
+        if marker < 0:
+            continue
+        try:
+            yield bytes.fromhex(line[marker + 7 :].strip())
+        except ValueError:
+            continue
+
+
+def read_chunks(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if b"#TRACE " in data:
+        return list(chunks_from_text(data.decode("utf-8", errors="replace")))
+    return list(chunks_from_binary(data))
+
+
+# ============================================================================
+# Dump decoding
+# ============================================================================
+
+
+def decode_dumps(chunks):
+    """Group chunks into dumps: dict(header..., events=[(core, cycles, id, phase, arg)])."""
+    dumps = []
+    current = None
+    for chunk in chunks:
+        kind = chunk[0]
+        if kind == CHUNK_HEADER and len(chunk) >= 7:
+            _, version, role, device_id, core_count, mhz = struct.unpack_from(
+                "<BBBBBH", chunk, 0
+            )
+            cores = []
+            for c in range(core_count):
+                cores.append(struct.unpack_from("<IqI", chunk, 7 + c * 16))
+            current = {
+                "version": version,
+                "role": role,
+                "device": device_id,
+                "mhz": mhz or 240,
+                "cores": cores,
+                "events": [],
+            }
+            dumps.append(current)
+        elif kind == CHUNK_EVENTS and current is not None and len(chunk) >= 7:
+            core, _first, count = struct.unpack_from("<BIB", chunk, 1)
+            for k in range(count):
+                offset = 7 + k * 8
+                if offset + 8 > len(chunk):
+                    break
+                cycles, ev, phase, arg = struct.unpack_from("<IBBH", chunk, offset)
+                current["events"].append((core, cycles, ev, phase, arg))
+        elif kind == CHUNK_END and current is not None:
+            (sent,) = struct.unpack_from("<I", chunk, 1)
+            if sent != len(current["events"]):
+                print(
+                    f"warning: {ROLE_NAMES.get(current['role'], '?')} "
+                    f"{current['device']}: {len(current['events'])}/{sent} events",
+                    file=sys.stderr,
+                )
+            current = None
+    return dumps
+
+
+def to_chrome(dumps):
+    out = []
+    for d in dumps:
+        pid = d["role"] * 256 + d["device"]
+        name = ROLE_NAMES.get(d["role"], "Device")
+        if d["role"] != 0:
+            name += f" {d['device']}"
+        out.append({"ph": "M", "pid": pid, "name": "process_name", "args": {"name": name}})
+        for core in range(len(d["cores"])):
+            out.append(
+                {"ph": "M", "pid": pid, "tid": core, "name": "thread_name",
+                 "args": {"name": f"core {core}"}}
+            )
+
+        open_spans = {}
+        for core, cycles, ev, phase, arg in d["events"]:
+            anchor_cycles, anchor_us, _recorded = d["cores"][core]
+            # CCOUNT is 32-bit; the ring spans far less than one wrap
+            ts = anchor_us - ((anchor_cycles - cycles) & 0xFFFFFFFF) / d["mhz"]
+            ev_name = EVENT_NAMES.get(ev, f"event_{ev}")
+            key = (core, ev)
+            if phase == PHASE_BEGIN:
+                open_spans[key] = (ts, arg)
+            elif phase == PHASE_END and key in open_spans:
+                begin_ts, begin_arg = open_spans.pop(key)
+                out.append(
+                    {"ph": "X", "pid": pid, "tid": core, "name": ev_name,
+                     "ts": begin_ts, "dur": max(ts - begin_ts, 0.0),
+                     "args": {"begin": begin_arg, "end": arg}}
+                )
+            else:
+                out.append(
+                    {"ph": "i", "s": "t", "pid": pid, "tid": core,
+                     "name": ev_name, "ts": ts, "args": {"arg": arg}}
+                )
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+# ============================================================================
+# Live capture
+# ============================================================================
+
+
+def capture_live(port, seconds):
+    import serial
+
+    ser = serial.Serial(port, BAUD_RATE, timeout=0.2)
+    ser.write(b'{"cmd":"TRACE","action":"start"}\n')
+    print(f"Tracing for {seconds}s...")
+    time.sleep(seconds)
+    ser.reset_input_buffer()
+    ser.write(b'{"cmd":"TRACE","action":"dump"}\n')
+
+    data = bytearray()
+    deadline = time.time() + 3.0
+    while time.time() < deadline:
+        block = ser.read(4096)
+        if block:
+            data.extend(block)
+            deadline = time.time() + 0.5  # Keep reading while the dump flows
+    ser.close()
+    return list(chunks_from_binary(data))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("inputs", nargs="*", help="Gateway .bin captures / Node logs")
+    parser.add_argument("--port", help="Gateway serial port for a live capture")
+    parser.add_argument("--seconds", type=float, default=5.0)
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    chunks = []
+    if args.port:
+        chunks.extend(capture_live(args.port, args.seconds))
+    for path in args.inputs:
+        chunks.extend(read_chunks(path))
+    if not chunks:
+        parser.error("no trace chunks found (give input files or --port)")
+
+    dumps = decode_dumps(chunks)
+    trace = to_chrome(dumps)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    total = sum(len(d["events"]) for d in dumps)
+    print(f"Wrote {args.output}: {len(dumps)} dump(s), {total} events")
+
+
+if __name__ == "__main__":
+    main()
@@ -180,9 +180,13 @@ struct MagData
 struct MagCalibrationData
 {
   float hardIronX, hardIronY, hardIronZ;
-  float softIronScaleX, softIronScaleY, softIronScaleZ;
+  float softIronScaleX, softIronScaleY, softIronScaleZ; // Diagonal of softIron
   bool isCalibrated;
   uint16_t sampleCount;
+  // Full soft-iron matrix, row-major: corrected = softIron * (raw - hardIron)
+  float softIron[9];
+  uint8_t coverage; // % of field directions seen while calibrating
+  float fitError;   // Ellipsoid fit RMS radial residual, % (0 = min/max fit)
 };
 
 struct BaroData
@@ -331,6 +335,7 @@ struct __attribute__((packed)) ESPNowOTAAbortPacket
 #define MAG_CALIB_PACKET 0x09
 #define POWER_DIAG_PACKET 0x0A
 #define TDMA_DIAG_PACKET 0x0B
+#define IMU_CALIB_PACKET 0x0C
 #define RADIO_MODE_BLE_OFF 0x00
 #define RADIO_MODE_BLE_ON 0x01
 
@@ -359,6 +364,9 @@ struct __attribute__((packed)) ESPNowMagCalibPacket
   float hardIronX, hardIronY, hardIronZ;
   float softIronScaleX, softIronScaleY, softIronScaleZ;
   uint16_t sampleCount;
+  uint8_t coverage;        // % of field directions seen
+  uint8_t fitErrorTenths;  // Ellipsoid fit residual, 0.1 % units (255 = n/a)
+  float softIron[9];       // Row-major soft-iron matrix
 };
 
 // Node power diagnostics (one-shot on sync/recovery) for brownout visibility
@@ -388,10 +396,25 @@ struct __attribute__((packed)) ESPNowTDMADiagPacket
   uint32_t currentFrame;
 };
 
+// IMU (accel/gyro) calibration progress: sent every 250 ms while a node's
+// streaming still-window calibration runs, plus once when a sensor finishes
+struct __attribute__((packed)) ESPNowImuCalibPacket
+{
+  uint8_t type;
+  uint8_t nodeId;
+  uint8_t sensorCount;
+  uint8_t calibratingMask; // Bit per local sensor index
+  uint8_t failedMask;      // Last attempt timed out (never still)
+  uint8_t calibratedMask;
+  uint8_t progress[MAX_SENSORS]; // 0-100
+  uint16_t motionResets[MAX_SENSORS];
+};
+
 #define CMD_MAG_CALIBRATE 0x50
 #define CMD_MAG_CLEAR 0x51
 #define CMD_GYRO_CALIBRATE 0x52
 #define CMD_SET_NODE_ID 0x53
+#define CMD_TRACE_CONTROL 0x54 // param1 = TRACE_CONTROL_* (TraceRing.h)
 
 // ============================================================================
 // Safe Serial Logging Macros
@@ -4,12 +4,23 @@
  *
  * Comprehensive tests for ESP-NOW v2.0 TDMA protocol implementation.
  *
- * Tests validate:
- * 1. Packet size calculations for 1-9 sensor configurations
- * 2. Single-packet guarantee for all practical configs
- * 3. 200Hz timing feasibility
- * 4. Frame time calculations
- * 5. Slot width calculations
+ * Tests validate (numbered as the Test Group sections below):
+ * 1-9. Packet size calculations for 1-9 sensor configurations,
+ *      single-packet guarantee for all practical configs, 200Hz timing
+ *      feasibility, frame time and slot width calculations
+ * 10. Compressed 0x26 sample block (lossless round-trip, slot bounds)
+ * 11. Adaptive PHY rate slot sizing and schedule layout
+ * 12. Channel hop beacon layout and search timing
+ * 13. Beacon timing trailer and jitter histogram buckets
+ * 14. Latency histogram buckets, percentiles and wire packet
+ * 15. Binary telemetry (0x09) wire layout
+ * 16. COBS + CRC-32 USB framing (round-trip, single-frame resync)
+ * 17. Session recorder chunk header (index fields, sensor mask, CRC)
+ * 18. Incremental magnetometer ellipsoid fit (soft iron, coverage, planar)
+ * 19. Inline magnetometer/barometer section in 0x26 (layout, tail extraction)
+ * 20. Adaptive lateness tracker (quantile deadline, decay, absent streak)
+ * 21. Sync frame gap fill (hold, linear, constant-rate gyro, history order)
+ * 22. USB credit flow fallback to OPEN (host silent or disconnected)
  *
  * Upload to any ESP32 to run tests - no WiFi/BLE needed.
  *
@@ -19,6 +30,14 @@
 
 #include <Arduino.h>
 #include "../../libraries/IMUConnectCore/src/TDMAProtocol.h"
+#include "../../libraries/IMUConnectCore/src/NodeDataCodec.h"
+#include "../../libraries/IMUConnectCore/src/LatencyHistogram.h"
+#include "../../libraries/IMUConnectCore/src/GatewayTelemetry.h"
+#include "../../libraries/IMUConnectCore/src/SerialFraming.h"
+#include "../../libraries/IMUConnectCore/src/SessionFormat.h"
+#include "../../libraries/IMUConnectCore/src/MagEllipsoidFit.h"
+#include "../../libraries/IMUConnectCore/src/LatenessTracker.h"
+#include "../../libraries/IMUConnectCore/src/GapFill.h"
 
 // Test counters
 static uint16_t testsRun = 0;
@@ -263,11 +282,11 @@ void testSlotWidths()
     // With 802.11g 6 Mbps OFDM model, airtime is much lower.
     // Most sensor counts fit within the 2500µs minimum slot width.
     // Only very high sensor counts (>= ~7) exceed the minimum.
-    uint16_t slot0 = calculateSlotWidth(0);
-    uint16_t slot1 = calculateSlotWidth(1);
-    uint16_t slot3 = calculateSlotWidth(3);
-    uint16_t slot6 = calculateSlotWidth(6);
-    uint16_t slot9 = calculateSlotWidth(9);
+    uint16_t slot0 = calculateSlotWidth(0, false);
+    uint16_t slot1 = calculateSlotWidth(1, false);
+    uint16_t slot3 = calculateSlotWidth(3, false);
+    uint16_t slot6 = calculateSlotWidth(6, false);
+    uint16_t slot9 = calculateSlotWidth(9, false);
 
     Serial.printf("  0 sensor slot: %d us\n", slot0);
     Serial.printf("  1 sensor slot: %d us\n", slot1);
@@ -421,6 +440,758 @@ void testV1vsV2Comparison()
                   (float)V2_MAX_PAYLOAD / V1_MAX_PAYLOAD);
 }
 
+// ============================================================================
+// Test Group 10: Compressed 0x26 Sample Block
+// ============================================================================
+void testCompressedNodeData()
+{
+    Serial.println("\n=== Test Group 10: Compressed 0x26 Sample Block ===\n");
+
+    // ZigZag keeps small magnitudes small in both directions
+    TEST_ASSERT_EQUAL(0, zigzagEncode32(0), "zigzag(0) = 0");
+    TEST_ASSERT_EQUAL(1, zigzagEncode32(-1), "zigzag(-1) = 1");
+    TEST_ASSERT_EQUAL(2, zigzagEncode32(1), "zigzag(1) = 2");
+    TEST_ASSERT(zigzagDecode32(zigzagEncode32(-65535)) == -65535,
+                "zigzag round-trips full int16 delta range");
+
+    // Realistic frame: 4 sensors, gravity on Z, small motion, 5ms spacing
+    TDMABatchedSensorData in[TDMA_SAMPLES_PER_FRAME][TDMA_MAX_SENSORS_PER_NODE];
+    TDMABatchedSensorData out[TDMA_SAMPLES_PER_FRAME][TDMA_MAX_SENSORS_PER_NODE];
+    const uint8_t sensors = TDMA_MAX_SENSORS_PER_NODE;
+    for (uint8_t s = 0; s < TDMA_SAMPLES_PER_FRAME; s++)
+    {
+        for (uint8_t i = 0; i < sensors; i++)
+        {
+            in[s][i].sensorId = 10 + i;
+            in[s][i].timestampUs = 0xFFFFF000UL + s * 5000; // Crosses wrap
+            in[s][i].a[0] = (int16_t)(12 * s - 7 * i);
+            in[s][i].a[1] = (int16_t)(-30 + 3 * s);
+            in[s][i].a[2] = (int16_t)(981 + s - i);
+            in[s][i].g[0] = (int16_t)(150 * s);
+            in[s][i].g[1] = (int16_t)(-2 - i);
+            in[s][i].g[2] = (int16_t)(40 - 9 * s);
+        }
+    }
+
+    const size_t rawBytes =
+        TDMA_SAMPLES_PER_FRAME * sensors * sizeof(TDMABatchedSensorData);
+    uint8_t buf[ESPNOW_MAX_PAYLOAD];
+    size_t encoded = encodeCompressedSamples(buf, rawBytes - 1, &in[0][0],
+                                             TDMA_SAMPLES_PER_FRAME, sensors,
+                                             TDMA_MAX_SENSORS_PER_NODE);
+    Serial.printf("  4 sensors x 4 samples: %u B raw -> %u B compressed\n",
+                  (unsigned)rawBytes, (unsigned)encoded);
+    TEST_ASSERT(encoded > 0 && encoded < rawBytes,
+                "Typical frame compresses below raw size");
+    TEST_ASSERT(encoded <= sizeof(uint32_t) + sensors +
+                               TDMA_SAMPLES_PER_FRAME * sensors *
+                                   TDMA_COMPRESSED_SAMPLE_BUDGET,
+                "Typical frame fits TDMA_COMPRESSED_SAMPLE_BUDGET");
+
+    size_t consumed = 0;
+    bool decoded = decodeCompressedSamples(buf, encoded, &out[0][0],
+                                           TDMA_SAMPLES_PER_FRAME, sensors,
+                                           TDMA_MAX_SENSORS_PER_NODE, consumed);
+    TEST_ASSERT(decoded && consumed == encoded, "Compressed block decodes");
+    TEST_ASSERT(memcmp(in, out, sizeof(in)) == 0,
+                "Round-trip is bit-exact (lossless)");
+
+    // Truncated input must be rejected, never partially decoded
+    TEST_ASSERT(!decodeCompressedSamples(buf, encoded - 1, &out[0][0],
+                                         TDMA_SAMPLES_PER_FRAME, sensors,
+                                         TDMA_MAX_SENSORS_PER_NODE, consumed),
+                "Truncated block is rejected");
+
+    // Incompressible (full-scale alternating) data falls back to raw
+    for (uint8_t s = 0; s < TDMA_SAMPLES_PER_FRAME; s++)
+    {
+        for (uint8_t i = 0; i < sensors; i++)
+        {
+            for (uint8_t k = 0; k < 3; k++)
+            {
+                in[s][i].a[k] = (s & 1) ? 32767 : -32768;
+                in[s][i].g[k] = (s & 1) ? -32768 : 32767;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(0,
+                      (int)encodeCompressedSamples(buf, rawBytes - 1, &in[0][0],
+                                                   TDMA_SAMPLES_PER_FRAME, sensors,
+                                                   TDMA_MAX_SENSORS_PER_NODE),
+                      "Incompressible frame returns 0 (caller sends raw)");
+
+    // Slot sizing: compressed slot never wider than raw, and a raw packet
+    // overruns a compressed slot by at most TDMA_COMPRESSED_MAX_OVERRUN_US
+    for (uint8_t s = 1; s <= 20; s++)
+    {
+        uint16_t rawSlot = calculateSlotWidth(s, false);
+        uint16_t compSlot = calculateSlotWidth(s, true);
+        char msg[100];
+        snprintf(msg, sizeof(msg),
+                 "%d sensors: compressed slot %u <= raw %u (overrun <= %u)",
+                 s, compSlot, rawSlot, TDMA_COMPRESSED_MAX_OVERRUN_US);
+        TEST_ASSERT(compSlot <= rawSlot &&
+                        rawSlot - compSlot <= TDMA_COMPRESSED_MAX_OVERRUN_US,
+                    msg);
+    }
+    TEST_ASSERT(calculateNodeDataAirtimeUs(calculateCompressedPayloadBudget(4)) <
+                    calculateNodeDataAirtimeUs(calculateNodeDataPayloadBytes(4)),
+                "4-sensor compressed budget airtime < raw airtime");
+}
+
+// ============================================================================
+// Test Group 11: Adaptive PHY Rate Slot Sizing
+// ============================================================================
+void testPhyRateSlotWidths()
+{
+    Serial.println("\n=== Test Group 11: Adaptive PHY Rate Slot Sizing ===\n");
+
+    // Default rate must reproduce the 6 Mbps sizing bit-for-bit
+    for (uint8_t s = 1; s <= TDMA_MAX_SENSORS_PER_NODE; s++)
+    {
+        TEST_ASSERT_EQUAL(calculateSlotWidth(s, false),
+                          calculateSlotWidth(s, false, TDMA_PHY_RATE_6M),
+                          "6 Mbps slot width unchanged (raw)");
+        TEST_ASSERT_EQUAL(calculateSlotWidth(s, true),
+                          calculateSlotWidth(s, true, TDMA_PHY_RATE_6M),
+                          "6 Mbps slot width unchanged (compressed)");
+    }
+
+    // 6 Mbps 14-byte ACK = 44us, and 54 Mbps ACKs go at 24 Mbps
+    TEST_ASSERT_EQUAL(20 + 4 * 14 + 10 + 44, calculateNodeDataAirtimeUs(0),
+                      "Empty-payload airtime at 6 Mbps");
+    TEST_ASSERT(calculateNodeDataAirtimeUs(0, TDMA_PHY_RATE_54M) >=
+                    20 + 4 + 10 + 28,
+                "54 Mbps airtime keeps a 24 Mbps ACK");
+
+    // Faster rates never need a wider slot
+    for (uint8_t s = 1; s <= TDMA_MAX_SENSORS_PER_NODE; s++)
+    {
+        for (uint8_t r = 1; r < TDMA_PHY_RATE_COUNT; r++)
+        {
+            TEST_ASSERT(calculateSlotWidth(s, true, r) <=
+                            calculateSlotWidth(s, true, r - 1),
+                        "Slot width non-increasing with PHY rate");
+        }
+        Serial.printf("  %u sensors: 6M=%u us, 54M=%u us\n", s,
+                      calculateSlotWidth(s, true, TDMA_PHY_RATE_6M),
+                      calculateSlotWidth(s, true, TDMA_PHY_RATE_54M));
+    }
+
+    // Invalid rate indices fall back to 6 Mbps
+    TEST_ASSERT_EQUAL(tdmaPhyRateMbps(TDMA_PHY_RATE_6M),
+                      tdmaPhyRateMbps(TDMA_PHY_RATE_COUNT),
+                      "Out-of-range rate maps to 6 Mbps");
+
+    // phyRate[] trailer must not disturb the slot layout older Nodes parse
+    TEST_ASSERT_EQUAL(offsetof(TDMASchedulePacket, phyRate),
+                      3 + sizeof(((TDMASchedulePacket *)0)->slots),
+                      "phyRate[] appended after slots[]");
+    TEST_ASSERT(sizeof(TDMASchedulePacket) <= ESPNOW_MAX_PAYLOAD,
+                "Schedule with phyRate[] fits in one ESP-NOW packet");
+}
+
+// ============================================================================
+// Test Group 12: Coordinated Channel Hop
+// ============================================================================
+void testChannelHop()
+{
+    Serial.println("\n=== Test Group 12: Coordinated Channel Hop ===\n");
+
+    // Hop fields are appended; pre-hop beacons stay parseable
+    TEST_ASSERT_EQUAL(TDMA_BEACON_MIN_LEN, offsetof(TDMABeaconPacket, hopChannel),
+                      "Hop fields follow ptpSlotNode");
+    TEST_ASSERT_EQUAL(offsetof(TDMABeaconPacket, prevTxLatencyUs),
+                      TDMA_BEACON_MIN_LEN + 2,
+                      "Hop fields are exactly 2 bytes");
+
+    // Candidates must be mutually non-overlapping (5 channels apart)
+    for (uint8_t i = 1; i < TDMA_HOP_CHANNEL_COUNT; i++)
+    {
+        TEST_ASSERT(tdmaHopChannel(i) - tdmaHopChannel(i - 1) >= 5,
+                    "Hop candidates do not overlap");
+    }
+
+    // Retune lands inside the guard time, after every slot has ended
+    TEST_ASSERT(TDMA_GUARD_TIME_US / 2 > 0 &&
+                    TDMA_GUARD_TIME_US / 2 < TDMA_GUARD_TIME_US,
+                "Node retune point is inside the guard time");
+
+    // A node that misses every announcement still finds the Gateway quickly
+    uint32_t worstSearchMs = TDMA_CHANNEL_SEARCH_AFTER_MS +
+                             TDMA_HOP_CHANNEL_COUNT * TDMA_CHANNEL_SEARCH_DWELL_MS;
+    Serial.printf("  Worst-case re-acquire after missed hop: %lu ms\n",
+                  (unsigned long)worstSearchMs);
+    TEST_ASSERT(TDMA_CHANNEL_SEARCH_DWELL_MS >= 10 * TDMA_FRAME_PERIOD_MS,
+                "Search dwell hears >= 10 beacon periods per channel");
+    TEST_ASSERT(TDMA_CHANNEL_HOP_LEAD_BEACONS >= 10,
+                "Hop announced in enough beacons to survive 10% loss");
+}
+
+// ============================================================================
+// Test Group 13: Beacon Timing
+// ============================================================================
+void testBeaconTiming()
+{
+    Serial.println("\n=== Test Group 13: Beacon Timing ===\n");
+
+    // TX latency trailer is appended after the hop fields
+    TEST_ASSERT_EQUAL(sizeof(TDMABeaconPacket),
+                      offsetof(TDMABeaconPacket, prevTxLatencyUs) + 2,
+                      "prevTxLatencyUs is the last beacon field");
+
+    // Histogram bucket boundaries
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(0), 0, "0us -> first bucket");
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(9), 0, "9us -> first bucket");
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(10), 1, "10us -> second bucket");
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(999), TDMA_BEACON_JITTER_BUCKETS - 2,
+                      "999us -> last bounded bucket");
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(1000), TDMA_BEACON_JITTER_BUCKETS - 1,
+                      "1ms -> overflow bucket");
+    TEST_ASSERT_EQUAL(tdmaBeaconJitterBucket(TDMA_FRAME_PERIOD_MS * 1000),
+                      TDMA_BEACON_JITTER_BUCKETS - 1,
+                      "Missed beacon -> overflow bucket");
+
+    bool monotonic = true;
+    for (uint8_t i = 1; i < TDMA_BEACON_JITTER_BUCKETS; i++)
+    {
+        if (tdmaBeaconJitterBucketEdgeUs(i) <= tdmaBeaconJitterBucketEdgeUs(i - 1))
+            monotonic = false;
+    }
+    TEST_ASSERT(monotonic, "Bucket edges strictly increase");
+    TEST_ASSERT(tdmaBeaconJitterBucketEdgeUs(TDMA_BEACON_JITTER_BUCKETS - 2) <=
+                    TDMA_GUARD_TIME_US,
+                "Bounded buckets resolve jitter within the guard time");
+}
+
+// ============================================================================
+// Test Group 14: Latency Histogram
+// ============================================================================
+void testLatencyHistogram()
+{
+    Serial.println("\n=== Test Group 14: Latency Histogram ===\n");
+
+    TEST_ASSERT_EQUAL(LATENCY_HIST_BUCKETS, 176, "176 buckets cover 0..16.7s");
+
+    // Every value lands in a bucket whose bounds contain it
+    bool bounded = true;
+    bool precise = true;
+    const uint32_t probes[] = {0, 1, 7, 8, 15, 16, 17, 31, 32, 999, 1000,
+                               5000, 20000, 65535, 1000000, 16777215};
+    for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+    {
+        uint8_t b = latencyBucketIndex(probes[i]);
+        if (probes[i] < latencyBucketLowUs(b) || probes[i] > latencyBucketHighUs(b))
+            bounded = false;
+        if ((latencyBucketHighUs(b) - latencyBucketLowUs(b)) * 8 >
+            latencyBucketLowUs(b))
+            precise = false;
+    }
+    TEST_ASSERT(bounded, "Bucket bounds contain every probe value");
+    TEST_ASSERT(precise, "Bucket width <= 1/8 of its value");
+
+    bool contiguous = true;
+    for (uint16_t b = 1; b < LATENCY_HIST_BUCKETS; b++)
+    {
+        if (latencyBucketLowUs(b) != latencyBucketHighUs(b - 1) + 1)
+            contiguous = false;
+    }
+    TEST_ASSERT(contiguous, "Buckets tile the range without gaps");
+    TEST_ASSERT_EQUAL(latencyBucketIndex(0xFFFFFFFF), LATENCY_HIST_BUCKETS - 1,
+                      "Huge values clamp into the last bucket");
+
+    // 1000 samples: 1..1000 us
+    static LatencyHistogram h;
+    h.reset();
+    for (uint32_t v = 1; v <= 1000; v++)
+    {
+        h.record(v);
+    }
+    TEST_ASSERT_EQUAL(h.total, 1000, "Total counts every sample");
+    TEST_ASSERT_EQUAL(h.maxUs, 1000, "Max tracked exactly");
+    uint32_t p50 = h.percentileUs(500);
+    uint32_t p99 = h.percentileUs(990);
+    TEST_ASSERT(p50 >= 500 && p50 <= 500 + 500 / 8, "p50 within one bucket");
+    TEST_ASSERT(p99 >= 990 && p99 <= 1000, "p99 within one bucket, <= max");
+    TEST_ASSERT_EQUAL(h.percentileUs(999), 1000, "p99.9 capped at max");
+
+    // Wire packet
+    uint8_t first = 0, last = 0;
+    TEST_ASSERT(h.occupiedRange(first, last), "Non-empty range found");
+    TEST_ASSERT_EQUAL(first, 1, "Range starts at first occupied bucket");
+    TEST_ASSERT_EQUAL(last, latencyBucketIndex(1000), "Range ends at max bucket");
+    uint8_t packet[LATENCY_WIRE_HEADER_SIZE + LATENCY_WIRE_MAX_BUCKETS * 4];
+    uint8_t n = (uint8_t)(last - first + 1);
+    size_t len = h.writeWirePacket(LATENCY_STAGE_END_TO_END, first, n, packet,
+                                   sizeof(packet));
+    TEST_ASSERT_EQUAL(len, LATENCY_WIRE_HEADER_SIZE + n * 4, "Packet length");
+    TEST_ASSERT_EQUAL(packet[0], LATENCY_PACKET_TYPE, "Packet type 0x08");
+    uint32_t wireTotal;
+    memcpy(&wireTotal, packet + 4, 4);
+    TEST_ASSERT_EQUAL(wireTotal, 1000, "Total on the wire");
+    TEST_ASSERT(LATENCY_WIRE_HEADER_SIZE + LATENCY_WIRE_MAX_BUCKETS * 4 <= 510,
+                "Max packet fits a 512-byte serial frame");
+}
+
+// ============================================================================
+// Test Group 15: Binary Telemetry
+// ============================================================================
+void testGatewayTelemetry()
+{
+    Serial.println("\n=== Test Group 15: Binary Telemetry ===\n");
+
+    TEST_ASSERT_EQUAL(TELEMETRY_JITTER_BUCKETS, TDMA_BEACON_JITTER_BUCKETS,
+                      "Jitter buckets match TDMAProtocol");
+    TEST_ASSERT_EQUAL(TELEMETRY_MAX_NODES, TDMA_MAX_NODES,
+                      "Node capacity matches TDMAProtocol");
+    TEST_ASSERT_EQUAL(telemetryIngestSize(0), 55, "INGEST header is 55 bytes");
+    TEST_ASSERT_EQUAL(telemetryIngestSize(TELEMETRY_MAX_NODES), 151,
+                      "Full INGEST packet is 151 bytes");
+
+    TelemetryIngest ingest;
+    telemetryBegin(ingest.header, TELEMETRY_KIND_INGEST, 0x12345678);
+    const uint8_t *raw = (const uint8_t *)&ingest;
+    TEST_ASSERT_EQUAL(raw[0], TELEMETRY_PACKET_TYPE, "Packet type 0x09");
+    TEST_ASSERT_EQUAL(raw[2], TELEMETRY_KIND_INGEST, "Kind at byte 2");
+    TEST_ASSERT(raw[3] == 0x78 && raw[6] == 0x12, "Uptime little-endian at 3..6");
+
+    TelemetryLog log;
+    size_t len = telemetryFormatLog(log, TELEMETRY_LOG_WARN, "queue pressure", 1);
+    TEST_ASSERT_EQUAL(len, 8 + 14, "LOG length = header + level + text");
+    TEST_ASSERT(memcmp(log.message, "queue pressure", 14) == 0,
+                "LOG text copied without terminator");
+
+    char longText[TELEMETRY_LOG_MAX_CHARS + 40];
+    memset(longText, 'x', sizeof(longText) - 1);
+    longText[sizeof(longText) - 1] = '\0';
+    len = telemetryFormatLog(log, TELEMETRY_LOG_INFO, longText, 1);
+    TEST_ASSERT_EQUAL(len, 8 + TELEMETRY_LOG_MAX_CHARS, "LOG text truncated");
+    TEST_ASSERT(sizeof(TelemetryLog) + 2 <= 512 &&
+                    sizeof(TelemetryIngest) + 2 <= 512,
+                "Largest packet fits a 512-byte serial frame");
+
+    TEST_ASSERT_EQUAL(offsetof(TelemetrySerialTx, credits), 30,
+                      "SERIAL_TX credit fields appended after v1 layout");
+    TEST_ASSERT_EQUAL(offsetof(TelemetrySerialTx, batchBudget), 35,
+                      "SERIAL_TX batching fields appended after credit fields");
+    TEST_ASSERT_EQUAL(offsetof(TelemetrySerialTx, creditsUsed), 39,
+                      "SERIAL_TX credits used appended after batching fields");
+    TelemetryFlow flow;
+    telemetryBegin(flow.header, TELEMETRY_KIND_FLOW, 0);
+    flow.gapFrames = 0x0102;
+    raw = (const uint8_t *)&flow;
+    TEST_ASSERT(raw[2] == TELEMETRY_KIND_FLOW && raw[13] == 0x02 &&
+                    raw[14] == 0x01,
+                "FLOW gapFrames little-endian at 13..16");
+}
+
+// ============================================================================
+// Test Group 16: COBS + CRC-32 USB Framing
+// ============================================================================
+void testSerialFraming()
+{
+    Serial.println("\n=== Test Group 16: COBS + CRC-32 USB Framing ===\n");
+
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT(serialFramingCrc32(check, sizeof(check)) == 0xCBF43926,
+                "CRC-32 matches zlib / ROM crc32_le check value");
+
+    // Sync-frame-like payload with zeros and a run longer than 254 bytes
+    static uint8_t frame[400];
+    frame[0] = 0x25;
+    for (size_t i = 1; i < sizeof(frame); i++)
+    {
+        frame[i] = (i < 300) ? (uint8_t)(i % 200 + 1) : (uint8_t)(i % 7 == 0 ? 0 : i);
+    }
+    static uint8_t encoded[SERIAL_COBS_MAX_ENCODED(sizeof(frame))];
+    size_t n = cobsEncodeFrame(frame, sizeof(frame), encoded, sizeof(encoded));
+    TEST_ASSERT(n > 0 && memchr(encoded, 0, n - 1) == nullptr &&
+                    encoded[n - 1] == SERIAL_COBS_DELIMITER,
+                "Encoded frame holds no 0x00 before its delimiter");
+
+    static uint8_t decoded[sizeof(frame) + SERIAL_COBS_CRC_SIZE];
+    size_t m = cobsDecodeFrame(encoded, n - 1, decoded, sizeof(decoded));
+    TEST_ASSERT(m == sizeof(frame) && memcmp(decoded, frame, m) == 0,
+                "Frame round-trips through COBS + CRC");
+    encoded[10] ^= 0x01;
+    TEST_ASSERT_EQUAL(0, cobsDecodeFrame(encoded, n - 1, decoded, sizeof(decoded)),
+                      "Corrupted frame fails the CRC");
+
+    // Legacy records -> COBS stream; one dropped byte costs one frame
+    static uint8_t records[8 * (2 + 42)];
+    size_t recordLen = 0;
+    for (uint8_t f = 0; f < 8; f++)
+    {
+        records[recordLen++] = 42;
+        records[recordLen++] = 0;
+        records[recordLen++] = 0x25;
+        for (uint8_t i = 1; i < 42; i++)
+        {
+            records[recordLen++] = (uint8_t)((f + i) % 5 == 0 ? 0 : f * 31 + i);
+        }
+    }
+    static uint8_t stream[1 + 8 * SERIAL_COBS_MAX_ENCODED(42)];
+    size_t consumed = 0;
+    size_t streamLen = cobsEncodeRecords(records, recordLen, stream,
+                                         sizeof(stream), consumed);
+    TEST_ASSERT(consumed == recordLen && stream[0] == SERIAL_COBS_DELIMITER,
+                "Record stream encoded whole, led by a delimiter");
+
+    static CobsStreamDecoder<64> decoder;
+    decoder.reset();
+    uint8_t good = 0;
+    const size_t dropAt = 20; // Inside the first frame
+    for (size_t i = 0; i < streamLen; i++)
+    {
+        if (i != dropAt && decoder.push(stream[i]) > 0)
+        {
+            good++;
+        }
+    }
+    TEST_ASSERT_EQUAL(7, good, "Dropped byte loses exactly one frame");
+    TEST_ASSERT_EQUAL(1, decoder.badFrames, "Damaged frame counted as bad");
+
+    size_t partial = cobsEncodeRecords(records, recordLen, stream, 100, consumed);
+    TEST_ASSERT(consumed > 0 && consumed < recordLen && partial <= 100,
+                "Small output buffer stops on a record boundary");
+}
+
+// ============================================================================
+// Test Group 17: Session Recorder Chunk Format
+// ============================================================================
+void testSessionFormat()
+{
+    Serial.println("\n=== Test Group 17: Session Recorder Chunk Format ===\n");
+
+    TEST_ASSERT_EQUAL(72, sizeof(SessionChunkHeader), "Chunk header is 72 bytes");
+    TEST_ASSERT_EQUAL(68, offsetof(SessionChunkHeader, crc32),
+                      "CRC is the last header field");
+
+    // Page = header + three 2-sensor 0x25 records (ids 3 and 200)
+    static uint8_t page[SESSION_PAGE_SIZE];
+    SessionChunkHeader h;
+    sessionChunkBegin(h, 7, 12);
+    uint8_t *payload = page + sizeof(SessionChunkHeader);
+    for (uint32_t f = 0; f < 3; f++)
+    {
+        uint8_t *record = payload + h.usedBytes;
+        const uint16_t frameLen = 10 + 2 * 16;
+        memset(record, 0, 2 + frameLen);
+        record[0] = (uint8_t)frameLen;
+        record[2] = 0x25;
+        uint32_t frameNumber = 1000 + f;
+        uint32_t timestampUs = 5000000 + f * 5000;
+        memcpy(record + 3, &frameNumber, 4);
+        memcpy(record + 7, &timestampUs, 4);
+        record[11] = 2;
+        record[12] = 3;
+        record[12 + 16] = 200;
+        sessionChunkAddRecord(h, record, 2 + frameLen);
+    }
+    TEST_ASSERT(h.recordCount == 3 && h.usedBytes == 3 * 44,
+                "Records counted with their length prefix");
+    TEST_ASSERT(h.firstFrame == 1000 && h.lastFrame == 1002 &&
+                    h.firstTimestampUs == 5000000 && h.lastTimestampUs == 5010000,
+                "Frame and timestamp range cover the chunk");
+    TEST_ASSERT(sessionChunkHasSensor(h, 3) && sessionChunkHasSensor(h, 200) &&
+                    !sessionChunkHasSensor(h, 4),
+                "Sensor mask holds exactly the recorded IDs");
+
+    sessionChunkSeal(h, payload);
+    memcpy(page, &h, sizeof(h));
+    TEST_ASSERT(sessionChunkValid(page), "Sealed chunk validates");
+    payload[5] ^= 0x10;
+    TEST_ASSERT(!sessionChunkValid(page), "Corrupted record fails the chunk CRC");
+    payload[5] ^= 0x10;
+    page[offsetof(SessionChunkHeader, lastFrame)] ^= 0x01;
+    TEST_ASSERT(!sessionChunkValid(page), "Corrupted index field fails the chunk CRC");
+}
+
+// ============================================================================
+// Test Group 18: Magnetometer Ellipsoid Fit
+// ============================================================================
+// Deterministic field directions (golden-spiral sphere), distorted by a
+// symmetric soft-iron matrix plus a hard iron larger than the field, so the
+// origin lies outside the ellipsoid
+static void magTestRaw(uint16_t i, uint16_t n, float raw[3])
+{
+    static const float distort[9] = {1.30f, 0.10f, 0.05f,
+                                     0.10f, 0.90f, -0.08f,
+                                     0.05f, -0.08f, 1.10f};
+    static const float hardIron[3] = {30.0f, -12.0f, 45.0f};
+    float z = 1.0f - 2.0f * (i + 0.5f) / n;
+    float r = sqrtf(1.0f - z * z);
+    float phi = i * 2.39996323f;
+    float m[3] = {48.0f * r * cosf(phi), 48.0f * r * sinf(phi), 48.0f * z};
+    for (uint8_t k = 0; k < 3; k++)
+    {
+        raw[k] = distort[k * 3] * m[0] + distort[k * 3 + 1] * m[1] +
+                 distort[k * 3 + 2] * m[2] + hardIron[k];
+    }
+}
+
+void testMagEllipsoidFit()
+{
+    Serial.println("\n=== Test Group 18: Magnetometer Ellipsoid Fit ===\n");
+
+    static MagEllipsoidFit fit;
+    MagEllipsoidSolution sol;
+    magFitReset(fit);
+    const uint16_t n = 200;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        float raw[3];
+        magTestRaw(i, n, raw);
+        magFitAdd(fit, raw[0], raw[1], raw[2]);
+        // Feed each valid centre back for the direction bins, as the node does
+        if (i % 10 == 9 && magFitSolve(fit, sol))
+            magFitSetCenter(fit, sol.center);
+    }
+    TEST_ASSERT(magFitSolve(fit, sol), "Full-sphere samples give a valid fit");
+    TEST_ASSERT(fabsf(sol.center[0] - 30.0f) < 0.05f &&
+                    fabsf(sol.center[1] + 12.0f) < 0.05f &&
+                    fabsf(sol.center[2] - 45.0f) < 0.05f,
+                "Hard iron recovered as the ellipsoid centre");
+    TEST_ASSERT(sol.fitError < 0.1f, "Noise-free fit error is ~0%");
+    TEST_ASSERT(fabsf(sol.softIron[1] - sol.softIron[3]) < 1e-4f &&
+                    fabsf(sol.softIron[1]) > 0.01f,
+                "Soft-iron matrix is symmetric with off-diagonal terms");
+    TEST_ASSERT(magFitCoverage(fit) >= 90, "Full sphere covers the direction bins");
+
+    // Every corrected reading lands on one sphere
+    float minMag = 1e9f, maxMag = 0;
+    for (uint16_t i = 0; i < 50; i++)
+    {
+        float raw[3];
+        magTestRaw(i * 3 + 1, 151, raw);
+        float d[3] = {raw[0] - sol.center[0], raw[1] - sol.center[1],
+                      raw[2] - sol.center[2]};
+        float mag = 0;
+        for (uint8_t k = 0; k < 3; k++)
+        {
+            float c = sol.softIron[k * 3] * d[0] + sol.softIron[k * 3 + 1] * d[1] +
+                      sol.softIron[k * 3 + 2] * d[2];
+            mag += c * c;
+        }
+        mag = sqrtf(mag);
+        minMag = mag < minMag ? mag : minMag;
+        maxMag = mag > maxMag ? mag : maxMag;
+    }
+    TEST_ASSERT(maxMag - minMag < 0.01f * sol.radius,
+                "Corrected magnitudes agree within 1%");
+
+    // Rotation in a single plane cannot pin down an ellipsoid
+    magFitReset(fit);
+    for (uint16_t i = 0; i < 100; i++)
+    {
+        float a = i * 0.1f;
+        magFitAdd(fit, 40.0f * cosf(a), 40.0f * sinf(a), 5.0f);
+    }
+    TEST_ASSERT(!magFitSolve(fit, sol) && !sol.valid,
+                "Planar rotation is rejected as singular");
+    TEST_ASSERT(magFitCoverage(fit) < 50, "Planar rotation leaves low coverage");
+}
+
+// ============================================================================
+// Test Group 19: Inline Enviro Section (0x26)
+// ============================================================================
+void testNodeEnviroSection()
+{
+    Serial.println("\n=== Test Group 19: Inline Enviro Section (0x26) ===\n");
+
+    const uint8_t knownFlags = NODE_DATA_FLAG_KEYFRAME | NODE_DATA_FLAG_SYNC_V2 |
+                               NODE_DATA_FLAG_HISTORICAL |
+                               NODE_DATA_FLAG_COMPRESSED;
+    TEST_ASSERT((NODE_DATA_FLAG_ENVIRO & knownFlags) == 0,
+                "ENVIRO flag does not collide with other 0x26 flags");
+    TEST_ASSERT(offsetof(NodeEnviroSample, mag) == 2 &&
+                    offsetof(NodeEnviroSample, pressureCPa) == 8 &&
+                    offsetof(NodeEnviroSample, temperatureC) == 12,
+                "NodeEnviroSample field offsets are packed");
+
+    // Raw 2-sensor packet with sync quality and enviro trailers, as the
+    // Node builds it
+    const uint8_t sensorCount = 2;
+    uint8_t packet[ESPNOW_MAX_PAYLOAD];
+    memset(packet, 0, sizeof(packet));
+    TDMANodeDataPacket *header = (TDMANodeDataPacket *)packet;
+    header->type = TDMA_PACKET_NODE_DATA;
+    header->nodeId = 5;
+    header->frameNumber = 4242;
+    header->flags = NODE_DATA_FLAG_KEYFRAME | NODE_DATA_FLAG_SYNC_V2 |
+                    NODE_DATA_FLAG_ENVIRO;
+    header->sampleCount = TDMA_SAMPLES_PER_FRAME;
+    header->sensorCount = sensorCount;
+    size_t len = TDMA_NODE_DATA_HEADER_SIZE +
+                 TDMA_SAMPLES_PER_FRAME * sensorCount * TDMA_SENSOR_DATA_SIZE;
+    len += sizeof(SyncQualityFlags);
+
+    NodeEnviroSample env;
+    memset(&env, 0, sizeof(env));
+    env.contents = NODE_ENVIRO_HAS_MAG | NODE_ENVIRO_HAS_BARO;
+    env.sampleIndex = 2;
+    env.mag[0] = -215; // -21.5 µT
+    env.mag[1] = 120;
+    env.mag[2] = 480;
+    env.pressureCPa = 10132500; // 1013.25 hPa
+    env.temperatureC = 2345;
+    memcpy(packet + len, &env, sizeof(env));
+    len += sizeof(env);
+    packet[len] = calculateCRC8(packet, len);
+    len++;
+
+    TEST_ASSERT(verifyCRC8(packet, len), "CRC8 covers the enviro section");
+    TEST_ASSERT(len == calculateNodeDataPayloadBytes(sensorCount) +
+                           sizeof(SyncQualityFlags) + sizeof(NodeEnviroSample),
+                "Enviro adds 14 bytes on top of the raw payload");
+
+    // Gateway side: the section is found from the tail, whatever the
+    // sample block layout
+    NodeEnviroSample out;
+    memcpy(&out, packet + len - 1 - sizeof(NodeEnviroSample), sizeof(out));
+    TEST_ASSERT(memcmp(&out, &env, sizeof(out)) == 0 && out.sampleIndex == 2,
+                "Enviro section is recovered intact from before the CRC8");
+    TEST_ASSERT(len <= ESPNOW_MAX_PAYLOAD,
+                "Packet with enviro still fits one ESP-NOW frame");
+}
+
+// ============================================================================
+// Test Group 20: Adaptive Lateness Tracker
+// ============================================================================
+void testLatenessTracker()
+{
+    Serial.println("\n=== Test Group 20: Adaptive Lateness Tracker ===\n");
+
+    static LatenessTracker t;
+    t.reset();
+    TEST_ASSERT(!t.warmedUp() && t.deadlineUs() == LATENESS_NO_DEADLINE,
+                "Empty tracker has no deadline");
+
+    // Second TDMA slot: 5.0..5.9ms behind the first arrival
+    for (uint16_t i = 0; i < LATENESS_WARMUP_SAMPLES; i++)
+        t.record(5000 + (i % 10) * 100);
+    TEST_ASSERT(t.warmedUp(), "Warm after LATENESS_WARMUP_SAMPLES");
+    TEST_ASSERT_EQUAL(6000, t.deadlineUs(), "Deadline is the quantile bucket's upper edge");
+    TEST_ASSERT(t.meanUs >= 5000 && t.meanUs < 6000, "EWMA mean tracks the slot offset");
+
+    // Retries 20ms late on 2% of samples: more than the quantile may skip
+    for (uint16_t i = 0; i < 1000; i++)
+        t.record(i % 50 == 0 ? 20500 : 5000 + (i % 10) * 100);
+    TEST_ASSERT_EQUAL(21000, t.deadlineUs(), "2% retries pull the deadline out to cover them");
+
+    // Clean traffic: halving every LATENESS_DECAY_SAMPLES forgets the retries
+    for (uint16_t i = 0; i < 8 * LATENESS_DECAY_SAMPLES; i++)
+        t.record(5000 + (i % 10) * 100);
+    TEST_ASSERT_EQUAL(6000, t.deadlineUs(), "Old retries decay out of the quantile");
+    TEST_ASSERT(t.total <= 2 * LATENESS_DECAY_SAMPLES, "Decayed counts stay bounded");
+
+    // Mostly beyond the histogram: no adaptive deadline, fixed timeouts rule
+    t.reset();
+    for (uint16_t i = 0; i < 100; i++)
+        t.record(i % 2 ? 2000 : 50000);
+    TEST_ASSERT(t.deadlineUs() == LATENESS_NO_DEADLINE,
+                "Quantile in the overflow bucket gives no deadline");
+
+    // Tiny lateness is floored
+    t.reset();
+    for (uint16_t i = 0; i < 100; i++)
+        t.record(100);
+    TEST_ASSERT_EQUAL((uint32_t)LATENESS_MIN_DEADLINE_US, t.deadlineUs(),
+                      "Deadline never below LATENESS_MIN_DEADLINE_US");
+
+    // Absent after a streak of missed frames, present again on the next sample
+    for (uint8_t i = 0; i < LATENESS_ABSENT_STREAK - 1; i++)
+        t.noteMissed();
+    TEST_ASSERT(!t.absent(), "Not absent before the streak completes");
+    t.noteMissed();
+    TEST_ASSERT(t.absent(), "Absent after LATENESS_ABSENT_STREAK missed frames");
+    t.record(300);
+    TEST_ASSERT(!t.absent(), "A new sample clears the absent streak");
+}
+
+// ============================================================================
+// Test Group 21: Sync Frame Gap Fill
+// ============================================================================
+void testGapFill()
+{
+    Serial.println("\n=== Test Group 21: Sync Frame Gap Fill ===\n");
+
+    static GapFillHistory h;
+    h.reset();
+    int16_t a[3], g[3];
+    TEST_ASSERT(!h.extrapolate(GAP_FILL_HOLD, 10, a, g), "No history, no fill");
+
+    // Turning at 2 rad/s about z, gravity tilted in x: 500*cos/sin + 843
+    const int16_t g0[3] = {0, 0, 1800};
+    const int16_t a0[3] = {500, 0, 843};
+    const int16_t a1[3] = {500, -5, 843}; // 0.01 rad later
+    h.push(100, 7, 42, 1, a0, g0);
+    h.push(101, 7, 42, 1, a1, g0);
+    TEST_ASSERT(h.count == 2 && h.ordinal[1] == 101, "Two real samples held");
+
+    h.push(100, 7, 42, 1, a0, g0);
+    TEST_ASSERT(h.ordinal[1] == 101 && h.ordinal[0] == 100,
+                "Out-of-order sample does not move the history back");
+
+    TEST_ASSERT(h.gapTo(101) == 0 && !h.extrapolate(GAP_FILL_HOLD, 101, a, g),
+                "Nothing to fill at or before the newest sample");
+    TEST_ASSERT(!h.extrapolate(GAP_FILL_OFF, 103, a, g), "OFF never fills");
+
+    TEST_ASSERT(h.extrapolate(GAP_FILL_HOLD, 103, a, g) && a[1] == -5 &&
+                    g[2] == 1800,
+                "HOLD repeats the newest sample");
+
+    TEST_ASSERT(h.extrapolate(GAP_FILL_LINEAR, 103, a, g) && a[0] == 500 &&
+                    a[1] == -15 && a[2] == 843,
+                "LINEAR continues the last step");
+
+    // 3 samples on from 101: 0.03 rad more, a = Rz(-0.04) * a0
+    TEST_ASSERT(h.extrapolate(GAP_FILL_GYRO, 104, a, g), "GYRO fills");
+    TEST_ASSERT(abs(a[0] - 500) <= 1 && abs(a[1] + 20) <= 1 && a[2] == 843 &&
+                    g[2] == 1800,
+                "GYRO rotates accel about the gyro axis, holds the rate");
+
+    int16_t big[3] = {32000, -32000, 0};
+    int16_t big2[3] = {32700, -32700, 0};
+    h.reset();
+    h.push(0, 7, 42, 1, big, g0);
+    h.push(1, 7, 42, 1, big2, g0);
+    h.extrapolate(GAP_FILL_LINEAR, 4, a, g);
+    TEST_ASSERT(a[0] == INT16_MAX && a[1] == INT16_MIN, "LINEAR saturates at int16");
+
+    // Frame numbers restarted, or the column went to another sensor
+    h.push(1000, 7, 42, 1, a0, g0);
+    h.push(1000 - GAP_FILL_REWIND_SAMPLES - 1, 7, 42, 1, a1, g0);
+    TEST_ASSERT(h.count == 1 && h.a[1][1] == -5, "Large rewind restarts the history");
+    h.push(2000, 9, 43, 0, a0, g0);
+    TEST_ASSERT(h.count == 1 && h.sensorId == 9 && h.rawNodeId == 43,
+                "New sensor in the column restarts the history");
+}
+
+// ============================================================================
+// Test Group 22: USB Credit Flow Fallback
+// ============================================================================
+void testCreditFlowFallback()
+{
+    Serial.println("\n=== Test Group 22: USB Credit Flow Fallback ===\n");
+
+    const uint32_t idleMs = 3000;
+    TEST_ASSERT(!telemetryCreditFlowExpired(false, false, 100000, 0, idleMs),
+                "OPEN stream never expires");
+    TEST_ASSERT(!telemetryCreditFlowExpired(true, true, 12999, 10000, idleMs),
+                "Credit mode holds while CREDITs keep arriving");
+    TEST_ASSERT(telemetryCreditFlowExpired(true, true, 13000, 10000, idleMs),
+                "No CREDIT for the idle window falls back to OPEN");
+    TEST_ASSERT(telemetryCreditFlowExpired(true, false, 10001, 10000, idleMs),
+                "USB host disconnect falls back to OPEN at once");
+    TEST_ASSERT(!telemetryCreditFlowExpired(true, true, 1000, 0xFFFFFC18u,
+                                            idleMs),
+                "Idle window survives the millis() wrap (2 s elapsed)");
+    TEST_ASSERT(telemetryCreditFlowExpired(true, true, 3000, 0xFFFFFC18u,
+                                           idleMs),
+                "Idle window expires across the millis() wrap (4 s elapsed)");
+}
+
 // ============================================================================
 // Main Setup/Loop
 // ============================================================================
@@ -445,6 +1216,19 @@ void setup()
     testPacketStructure();
     test200HzDataRate();
     testV1vsV2Comparison();
+    testCompressedNodeData();
+    testPhyRateSlotWidths();
+    testChannelHop();
+    testBeaconTiming();
+    testLatencyHistogram();
+    testGatewayTelemetry();
+    testSerialFraming();
+    testSessionFormat();
+    testMagEllipsoidFit();
+    testNodeEnviroSection();
+    testLatenessTracker();
+    testGapFill();
+    testCreditFlowFallback();
 
     // Print final summary
     Serial.println("\n╔═══════════════════════════════════════════════════════════════╗");
@@ -25,6 +25,15 @@ OFDM_SIFS_US = 10
 OFDM_ACK_US = 44  # 20µs preamble + 24µs (14-byte ACK at 6 Mbps)
 FRAME_OVERHEAD_BYTES = 38  # MAC(24) + vendor(10) + FCS(4)
 
+# Adaptive PHY rate ladder (TDMAPhyRate): Mbps -> N_DBPS.
+# ACKs go at min(rate, 24 Mbps), the highest mandatory basic rate.
+PHY_RATE_N_DBPS = {6: 24, 12: 48, 24: 96, 36: 144, 54: 216}
+ACK_BITS = 134  # SERVICE(16) + 14-byte ACK + TAIL(6)
+
+# Compressed 0x26 slot budget (NodeDataCodec.h)
+TDMA_COMPRESSED_SAMPLE_BUDGET = 12
+TDMA_COMPRESSED_MAX_OVERRUN_US = 250
+
 # Stress parameters
 RANDOM_DISTRIBUTIONS = 1000
 PACKET_LOSS_PROB = 0.10  # 10% beacon loss
@@ -43,27 +52,53 @@ class Result:
     est_success_rate: float
 
 
-def calculate_slot_width(sensor_count: int) -> int:
-    if sensor_count <= 0:
-        return 0
+def node_data_airtime_us(payload_bytes: int, rate_mbps: int = 6) -> int:
+    # 802.11g OFDM airtime calculation
+    # OFDM symbols: ceil((SERVICE(16) + TAIL(6) + 8*(overhead+payload)) / N_DBPS)
+    n_dbps = PHY_RATE_N_DBPS[rate_mbps]
+    ofdm_bits = 326 + 8 * payload_bytes  # 22 + 8*38 + 8*payload = 326 + 8*payload
+    ofdm_syms = (ofdm_bits + n_dbps - 1) // n_dbps  # ceil division
+    data_frame_us = OFDM_PREAMBLE_US + OFDM_SYMBOL_US * ofdm_syms
+    ack_dbps = PHY_RATE_N_DBPS[min(rate_mbps, 24)]
+    ack_us = OFDM_PREAMBLE_US + OFDM_SYMBOL_US * ((ACK_BITS + ack_dbps - 1) // ack_dbps)
+    return data_frame_us + OFDM_SIFS_US + ack_us
+
 
-    payload_bytes = (
+def slot_airtime_us(sensor_count: int, compressed: bool, rate_mbps: int) -> int:
+    raw_payload = (
         TDMA_NODE_DATA_HEADER_SIZE
         + (TDMA_SAMPLES_PER_FRAME * sensor_count * TDMA_SENSOR_DATA_SIZE)
         + 1
     )
+    airtime_us = node_data_airtime_us(raw_payload, rate_mbps)
+    if compressed:
+        budget_payload = (
+            TDMA_NODE_DATA_HEADER_SIZE
+            + 4
+            + sensor_count
+            + TDMA_SAMPLES_PER_FRAME * sensor_count * TDMA_COMPRESSED_SAMPLE_BUDGET
+            + 1
+        )
+        budget_us = node_data_airtime_us(budget_payload, rate_mbps)
+        airtime_us = max(budget_us, max(airtime_us - TDMA_COMPRESSED_MAX_OVERRUN_US, 0))
+    return airtime_us
 
-    # 802.11g OFDM @ 6 Mbps airtime calculation
-    # OFDM symbols: ceil((SERVICE(16) + TAIL(6) + 8*(overhead+payload)) / N_DBPS)
-    ofdm_bits = 326 + 8 * payload_bytes  # 22 + 8*38 + 8*payload = 326 + 8*payload
-    ofdm_syms = (ofdm_bits + OFDM_N_DBPS - 1) // OFDM_N_DBPS  # ceil division
-    data_frame_us = OFDM_PREAMBLE_US + OFDM_SYMBOL_US * ofdm_syms
-    airtime_us = data_frame_us + OFDM_SIFS_US + OFDM_ACK_US
 
+def calculate_slot_width(
+    sensor_count: int, compressed: bool = False, rate_mbps: int = 6
+) -> int:
+    if sensor_count <= 0:
+        return 0
+
+    airtime_us = slot_airtime_us(sensor_count, compressed, rate_mbps)
     total_us = FIXED_OVERHEAD_US + airtime_us
 
-    if total_us < TDMA_SLOT_MIN_WIDTH_US:
-        total_us = TDMA_SLOT_MIN_WIDTH_US
+    # Jitter floor, less the airtime a faster rate saves over 6 Mbps
+    min_width_us = TDMA_SLOT_MIN_WIDTH_US - (
+        slot_airtime_us(sensor_count, compressed, 6) - airtime_us
+    )
+    if total_us < min_width_us:
+        total_us = min_width_us
 
     if total_us > 0xFFFF:
         total_us = 0xFFFF
@@ -71,11 +106,13 @@ def calculate_slot_width(sensor_count: int) -> int:
     return int(total_us)
 
 
-def calculate_frame_time(sensor_counts):
+def calculate_frame_time(sensor_counts, compressed=False, rate_mbps=6):
     if not sensor_counts:
         return TDMA_BEACON_DURATION_US
 
-    total_slot_time = sum(calculate_slot_width(s) for s in sensor_counts)
+    total_slot_time = sum(
+        calculate_slot_width(s, compressed, rate_mbps) for s in sensor_counts
+    )
     frame_time = (
         TDMA_BEACON_DURATION_US
         + TDMA_FIRST_SLOT_GAP_US
@@ -160,6 +197,33 @@ def run():
                 f"- total={r.total_sensors}, nodes={r.node_count}, avg={r.avg_frame_us:.0f}us, max={r.max_frame_us:.0f}us"
             )
 
+    print_phy_rate_capacity()
+
+
+def max_nodes_in_frame(sensors_per_node, compressed, rate_mbps):
+    nodes = 0
+    while nodes < MAX_NODES and calculate_frame_time(
+        [sensors_per_node] * (nodes + 1), compressed, rate_mbps
+    ) <= TDMA_FRAME_PERIOD_US:
+        nodes += 1
+    return nodes
+
+
+def print_phy_rate_capacity():
+    # Nodes per 20ms frame when every node runs at the same PHY rate.
+    # The 1500us fixed per-slot overhead and 2500us floor dominate at these
+    # payload sizes, so faster rates buy slot time, not multiples of capacity.
+    print("\nAdaptive PHY rate capacity (nodes per frame, all nodes at rate):")
+    print("rate\tcomp\t" + "\t".join(f"{s}s/node" for s in range(1, 5)))
+    for rate in PHY_RATE_N_DBPS:
+        for compressed in (False, True):
+            caps = [max_nodes_in_frame(s, compressed, rate) for s in range(1, 5)]
+            widths = [calculate_slot_width(s, compressed, rate) for s in range(1, 5)]
+            print(
+                f"{rate}M\t{'y' if compressed else 'n'}\t"
+                + "\t".join(f"{c} ({w}us)" for c, w in zip(caps, widths))
+            )
+
 
 if __name__ == "__main__":
     random.seed(1337)
@@ -4,24 +4,36 @@ import type {
   ConnectionStatus,
 } from "./IConnection";
 import { SerialConnection } from "./SerialConnection";
+import { WebSocketConnection } from "./WebSocketConnection";
 
 /**
  * Connection Manager
  *
  * Manages USB Serial connection to the Gateway hardware.
  * The Gateway communicates with sensor nodes via ESP-NOW WiFi protocol.
+ * connect("websocket", { url }) streams the same 0x25 frames over the
+ * Gateway's WebSocket (port 81) instead.
  */
 export class ConnectionManager {
   activeConnection: IConnection;
   private serial: SerialConnection;
+  private websocket: WebSocketConnection;
 
   constructor() {
     this.serial = new SerialConnection();
+    this.websocket = new WebSocketConnection();
     this.activeConnection = this.serial;
   }
 
   // Proxies
-  async connect(_type?: string, params?: unknown) {
+  async connect(type?: string, params?: unknown) {
+    const next = type === "websocket" ? this.websocket : this.serial;
+    if (next !== this.activeConnection) {
+      if (this.activeConnection.status !== "disconnected") {
+        await this.activeConnection.disconnect();
+      }
+      this.activeConnection = next;
+    }
     return this.activeConnection.connect(params);
   }
 
@@ -35,10 +47,12 @@ export class ConnectionManager {
 
   onData(cb: (data: ConnectionData) => void) {
     this.serial.onData(cb);
+    this.websocket.onData(cb);
   }
 
   onStatus(cb: (status: ConnectionStatus) => void) {
     this.serial.onStatus(cb);
+    this.websocket.onStatus(cb);
   }
 
   // Accessors
@@ -46,8 +60,12 @@ export class ConnectionManager {
     return this.serial;
   }
 
-  getActiveType(): "serial" {
-    return "serial";
+  getWebSocket() {
+    return this.websocket;
+  }
+
+  getActiveType(): IConnection["type"] {
+    return this.activeConnection.type;
   }
 
   getDeviceName(): string | undefined {
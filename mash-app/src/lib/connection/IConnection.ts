@@ -19,7 +19,7 @@ export type ConnectionData =
   | JSONPacket;
 
 export interface IConnection {
-  type: "serial";
+  type: "serial" | "websocket";
   status: ConnectionStatus;
 
   connect(params?: unknown): Promise<void>;
@@ -100,6 +100,9 @@ const TRUSTED_SYNC_IDS_TTL_MS = 1000;
 // Expected-range enforcement is handled in useDeviceStore/useNetworkStore.
 const ENFORCE_TRUSTED_SYNC_IDS_FILTER = false;
 
+// Gateway USB flow modes (TelemetryFlowMode, GatewayTelemetry.h)
+const FLOW_MODES = ["open", "credit", "lossy"];
+
 // ============================================================================
 // PIPELINE FIX: Drop-point counters — expose silent filter events
 // ============================================================================
@@ -243,6 +246,11 @@ function trackSyncFrameDiag(
  * - 0x05: Node info/discovery
  * - 0x25: SYNC FRAME - Cross-node synchronized data (absolute values)
  * - 0x06: JSON status/command response
+ * - 0x07: Trace ring dump chunk (ignored; see firmware/scripts/trace_to_chrome.py)
+ * - 0x26: Historical node data, black box backfill (ignored; see
+ *         firmware/scripts/session_tool.py)
+ * - 0x08: Gateway latency histogram (surfaced as a JSON "latency_histogram")
+ * - 0x09: Gateway binary telemetry (surfaced as JSON diag / "log" packets)
  */
 
 export class IMUParser {
@@ -281,6 +289,49 @@ export class IMUParser {
       return packets;
     }
 
+    // --- TRACE RING DUMP (0x07) --- host tooling only
+    if (data.getUint8(0) === 0x07) {
+      return packets;
+    }
+
+    // --- HISTORICAL NODE DATA (0x26) --- black box backfill after an RF
+    // outage. Live fusion has moved on by the time it arrives; the Gateway
+    // session recording keeps it and session_tool.py splices it on export.
+    if (data.getUint8(0) === 0x26) {
+      return packets;
+    }
+
+    // --- LATENCY HISTOGRAM (0x08) --- see LatencyHistogram.h
+    // [0x08][ver][stage][subBits][count u32][maxUs u32][first u8][n u8][n x u32]
+    if (data.getUint8(0) === 0x08) {
+      if (len < 14) return packets;
+      const bucketCount = data.getUint8(13);
+      if (len < 14 + bucketCount * 4) return packets;
+      const counts: number[] = [];
+      for (let i = 0; i < bucketCount; i++) {
+        counts.push(data.getUint32(14 + i * 4, true));
+      }
+      packets.push({
+        type: "latency_histogram",
+        stage: data.getUint8(2),
+        subBits: data.getUint8(3),
+        count: data.getUint32(4, true),
+        maxUs: data.getUint32(8, true),
+        firstBucket: data.getUint8(12),
+        counts,
+      } as JSONPacket);
+      return packets;
+    }
+
+    // --- BINARY TELEMETRY (0x09) --- see GatewayTelemetry.h
+    if (data.getUint8(0) === 0x09) {
+      const telemetry = IMUParser.parseTelemetryPacket(data);
+      if (telemetry) {
+        packets.push(telemetry);
+      }
+      return packets;
+    }
+
     // --- JSON STATUS / COMMAND RESPONSE (0x06) ---
     if (data.getUint8(0) === 0x06) {
       let text = "";
@@ -339,12 +390,27 @@ export class IMUParser {
     //   [0]: Sensor ID
     //   [1-6]: Accelerometer (3x int16 LE) - scaled by 100 (m/s²)
     //   [7-12]: Gyroscope (3x int16 LE) - scaled by 900 (°/s)
-    //   [13]: Flags (reserved)
+    //   [13]: Flags (0x01 valid, 0x02 interpolated, 0x04 enviro,
+    //         0x08 correction)
     //   [14-15]: Reserved (rawNodeId, localSensorIndex)
     // Quaternion removed: VQF fusion runs in webapp from accel+gyro.
+    //
+    // Multi-rate extension: records flagged 0x04 carry a node's
+    // magnetometer/barometer reading sampled at this frame's timestamp
+    // (see parseSyncEnviroRecord). They follow the IMU records and are
+    // counted in the sensor count.
+    //
+    // Gap fill: records flagged 0x01|0x02 were synthesized by the Gateway
+    // for a sensor the frame was missing; they count as valid. If the real
+    // sample arrives later, a following frame carries it as a 0x08 record
+    // ([15] = frames back). Live fusion has moved on by then, so those are
+    // skipped here (session_tool.py applies them to recordings).
     // =========================================================================
     const SYNC_FRAME_HEADER_SIZE = 10;
     const SYNC_FRAME_SENSOR_SIZE = 16;
+    const SYNC_SENSOR_FLAG_INTERPOLATED = 0x02;
+    const SYNC_SENSOR_FLAG_ENVIRO = 0x04;
+    const SYNC_SENSOR_FLAG_CORRECTION = 0x08;
     const MAX_REASONABLE_SYNC_SENSORS = 32;
 
     if (len >= SYNC_FRAME_HEADER_SIZE && data.getUint8(0) === 0x25) {
@@ -476,6 +542,8 @@ export class IMUParser {
 
       const timestampSec = timestampUs / 1_000_000;
       const syncSensorIds: number[] = [];
+      let enviroRecords = 0;
+      let correctionRecords = 0;
 
       // Pre-validate: on recovered frames, check accel magnitudes before accepting.
       // Garbage data will have random int16 values; real accel data should have
@@ -526,6 +594,19 @@ export class IMUParser {
         const flags = data.getUint8(sensorOffset + 13);
         const isValid = (flags & 0x01) !== 0;
 
+        if (flags & SYNC_SENSOR_FLAG_ENVIRO) {
+          enviroRecords++;
+          packets.push(
+            IMUParser.parseSyncEnviroRecord(data, sensorOffset, timestampUs),
+          );
+          continue;
+        }
+
+        if (flags & SYNC_SENSOR_FLAG_CORRECTION) {
+          correctionRecords++;
+          continue;
+        }
+
         // S1-FIX: Physical identity from reserved bytes (Offsets 14-15)
         // reserved[0] = rawNodeId (MAC-derived physical node ID, 0 = legacy FW)
         // reserved[1] = localSensorIndex (sensor's index within its node, 0-based)
@@ -587,6 +668,8 @@ export class IMUParser {
           // S1-FIX: Physical identity (0 = legacy firmware without identity)
           rawNodeId: rawNodeId > 0 ? rawNodeId : undefined,
           localSensorIndex: rawNodeId > 0 ? localSensorIndex : undefined,
+          interpolated:
+            (flags & SYNC_SENSOR_FLAG_INTERPOLATED) !== 0 ? true : undefined,
           // OPP-2: Frame completeness metadata (populated after sensor loop)
         };
 
@@ -598,11 +681,14 @@ export class IMUParser {
         reportSyncedSamples(syncSensorIds, 1, frameNumber, [timestampUs]);
       }
 
+      // Completeness counts IMU records only
+      const imuSensorCount = sensorCount - enviroRecords - correctionRecords;
+
       // OPP-2: Enrich all parsed packets with frame completeness metadata
       const completeness0x25 = {
         validCount: syncSensorIds.length,
-        expectedCount: sensorCount,
-        isComplete: syncSensorIds.length >= sensorCount,
+        expectedCount: imuSensorCount,
+        isComplete: syncSensorIds.length >= imuSensorCount,
       };
       for (const pkt of packets) {
         if ("quaternion" in pkt) {
@@ -611,14 +697,14 @@ export class IMUParser {
       }
 
       // Track sync completeness diagnostics
-      trackSyncFrameDiag(sensorCount, syncSensorIds, "0x25", frameNumber);
+      trackSyncFrameDiag(imuSensorCount, syncSensorIds, "0x25", frameNumber);
 
       // Learn trusted sensor IDs from complete, contiguous frames.
       // SAFETY: Only learn when the header sensorCount matches the frame-length-
       // inferred count. This prevents corrupted headers from poisoning the set.
       if (
-        syncSensorIds.length === sensorCount &&
-        sensorCount >= 2 &&
+        syncSensorIds.length === imuSensorCount &&
+        imuSensorCount >= 2 &&
         (inferredFromLen <= 0 || sensorCount === inferredFromLen) &&
         areConsecutiveModulo256(syncSensorIds)
       ) {
@@ -631,11 +717,11 @@ export class IMUParser {
       if (now - _lastSyncFrameLog > 5000) {
         _lastSyncFrameLog = now;
         console.debug(
-          `[SYNC FRAME 0x25] frame#=${frameNumber}, sensors parsed: ${syncSensorIds.length}/${sensorCount} [${syncSensorIds.join(",")}]`,
+          `[SYNC FRAME 0x25] frame#=${frameNumber}, sensors parsed: ${syncSensorIds.length}/${imuSensorCount} [${syncSensorIds.join(",")}]`,
         );
       }
       // Track incomplete frames
-      if (syncSensorIds.length < sensorCount) {
+      if (syncSensorIds.length < imuSensorCount) {
         _incompleteSyncFrames++;
       }
 
@@ -687,6 +773,195 @@ export class IMUParser {
     };
   }
 
+  /**
+   * Parse Gateway binary telemetry (0x09, GatewayTelemetry.h) into the same
+   * JSON shapes the firmware used to send as text, so consumers keyed on
+   * `type` are unchanged. Header: [0x09][version][kind][uptimeMs u32].
+   * Fields are only ever appended, so trailing bytes are ignored.
+   */
+  static parseTelemetryPacket(data: DataView): JSONPacket | null {
+    const len = data.byteLength;
+    if (len < 8 || data.getUint8(0) !== 0x09 || data.getUint8(1) !== 1) {
+      return null;
+    }
+    const kind = data.getUint8(2);
+    const uptimeMs = data.getUint32(3, true);
+
+    // INGEST: 5 s window, beacon timing, per-node delivery
+    if (kind === 1 && len >= 55) {
+      const jitterHist: number[] = [];
+      for (let b = 0; b < 8; b++) {
+        jitterHist.push(data.getUint32(10 + b * 4, true));
+      }
+      const nodeCount = data.getUint8(54);
+      const nodes: JSONPacket[] = [];
+      for (let i = 0; i < nodeCount && 55 + (i + 1) * 12 <= len; i++) {
+        const o = 55 + i * 12;
+        const packets = data.getUint16(o + 2, true);
+        const expectedPackets = data.getUint16(o + 4, true);
+        nodes.push({
+          nodeId: data.getUint8(o),
+          phyMbps: data.getUint8(o + 1),
+          packets,
+          expectedPackets,
+          lossPermille:
+            expectedPackets > 0
+              ? Math.max(0, 1000 - Math.round((packets * 1000) / expectedPackets))
+              : undefined,
+          samplesAdded: data.getUint16(o + 6, true),
+          sampleAddFails: data.getUint16(o + 8, true),
+          historical: data.getUint16(o + 10, true),
+        });
+      }
+      return {
+        type: "gateway_ingest_diag",
+        uptime_ms: uptimeMs,
+        window_ms: data.getUint16(7, true),
+        channel: data.getUint8(9),
+        beacon: {
+          jitterHist,
+          jitterMaxUs: data.getUint32(42, true),
+          txLatencyUs: data.getUint32(46, true),
+          txLatencyMaxUs: data.getUint32(50, true),
+        },
+        nodes,
+      };
+    }
+
+    // SERIAL_TX: USB queue health [+ credit balance, flow mode]
+    // [+ adaptive batch budget, USB drain rate] [+ cumulative credits used]
+    if (kind === 2 && len >= 30) {
+      const flags = data.getUint8(29);
+      const flow =
+        len >= 35
+          ? {
+              credits: data.getUint32(30, true),
+              flowMode: FLOW_MODES[data.getUint8(34)] ?? "unknown",
+            }
+          : {};
+      const batching =
+        len >= 39
+          ? {
+              batchBudgetBytes: data.getUint16(35, true),
+              drainBytesPerMs: data.getUint16(37, true),
+            }
+          : {};
+      const creditsUsed =
+        len >= 43 ? { creditsUsed: data.getUint32(39, true) } : {};
+      return {
+        type: "gateway_serial_diag",
+        uptime_ms: uptimeMs,
+        frames: data.getUint32(7, true),
+        batches: data.getUint32(11, true),
+        drops: data.getUint32(15, true),
+        dropsDelta: data.getUint32(19, true),
+        queueFree: data.getUint8(23),
+        queueSize: data.getUint8(24),
+        heapKB: data.getUint16(25, true),
+        largestFreeBlockKB: data.getUint16(27, true),
+        overloaded: (flags & 0x01) !== 0,
+        isStreaming: (flags & 0x02) !== 0,
+        ...flow,
+        ...batching,
+        ...creditsUsed,
+      };
+    }
+
+    // SYNC: SyncFrameBuffer completion + ESP-NOW RX queue
+    if (kind === 3 && len >= 49) {
+      return {
+        type: "gateway_sync_diag",
+        uptime_ms: uptimeMs,
+        framesCompleted: data.getUint32(7, true),
+        framesTrulyComplete: data.getUint32(11, true),
+        framesPartial: data.getUint32(15, true),
+        framesIncomplete: data.getUint32(19, true),
+        framesDropped: data.getUint32(23, true),
+        trueSyncRate: data.getUint16(27, true) / 10,
+        expectedSensors: data.getUint8(29),
+        effectiveSensors: data.getUint8(30),
+        syncFramesEmitted: data.getUint32(31, true),
+        beacons: data.getUint32(35, true),
+        espNowRxProcessed: data.getUint32(39, true),
+        espNowRxDropped: data.getUint32(43, true),
+        rxQueueFree: data.getUint8(47),
+        rxQueueSize: data.getUint8(48),
+      };
+    }
+
+    // LOG: [level u8][UTF-8 text to end of frame]
+    if (kind === 4) {
+      const level = data.getUint8(7);
+      return {
+        type: "log",
+        level: ["info", "warn", "error"][level] ?? "log",
+        message: new TextDecoder().decode(
+          new Uint8Array(data.buffer, data.byteOffset + 8, len - 8),
+        ),
+        ts: uptimeMs,
+      };
+    }
+
+    // FLOW: USB credit flow control mode change or gap marker
+    if (kind === 5 && len >= 25) {
+      return {
+        type: "gateway_flow",
+        uptime_ms: uptimeMs,
+        event: data.getUint8(7) === 2 ? "gap" : "mode",
+        mode: FLOW_MODES[data.getUint8(8)] ?? "unknown",
+        credits: data.getUint32(9, true),
+        gapFrames: data.getUint32(13, true),
+        gapFromUs: data.getUint32(17, true),
+        gapToUs: data.getUint32(21, true),
+      };
+    }
+
+    return null;
+  }
+
+  /**
+   * Parse a 0x25 multi-rate enviro record (SyncFrameEnviroData, 16 bytes):
+   *   [0]: Sensor ID (node's first sensor)
+   *   [1-6]: Magnetometer (3x int16 LE) - 0.1 µT, uncalibrated
+   *   [7-10]: Pressure (uint32 LE) - 0.01 Pa
+   *   [11-12]: Temperature (int16 LE) - 0.01 °C
+   *   [13]: Flags (0x04)   [14]: rawNodeId   [15]: contents (1 mag, 2 baro)
+   */
+  static parseSyncEnviroRecord(
+    data: DataView,
+    offset: number,
+    timestampUs: number,
+  ): EnvironmentalDataPacket {
+    const contents = data.getUint8(offset + 15);
+    const rawNodeId = data.getUint8(offset + 14);
+    const envPacket: EnvironmentalDataPacket = {
+      timestamp: performance.now(),
+      timestampUs,
+      sensorId: data.getUint8(offset),
+      rawNodeId: rawNodeId > 0 ? rawNodeId : undefined,
+    };
+
+    if (contents & 0x01) {
+      const x = data.getInt16(offset + 1, true) / 10.0;
+      const y = data.getInt16(offset + 3, true) / 10.0;
+      const z = data.getInt16(offset + 5, true) / 10.0;
+      let heading = (Math.atan2(y, x) * 180) / Math.PI;
+      if (heading < 0) heading += 360;
+      envPacket.magnetometer = { x, y, z, heading };
+    }
+
+    if (contents & 0x02) {
+      const pressure = data.getUint32(offset + 7, true) / 10000.0; // hPa
+      envPacket.barometer = {
+        pressure,
+        temperature: data.getInt16(offset + 11, true) / 100.0,
+        altitude: 44330.0 * (1.0 - Math.pow(pressure / 1013.25, 0.1903)),
+      };
+    }
+
+    return envPacket;
+  }
+
   /**
    * Parse environmental packet (0x04 format).
    * Returns null if not an environmental packet.
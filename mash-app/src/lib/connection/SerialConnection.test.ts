@@ -42,6 +42,91 @@ describe("SerialConnection queue safety", () => {
     expect(flowSpy).toHaveBeenCalledWith(true);
   });
 
+  it("grants USB credits as sync frames are consumed and withholds them when congested", () => {
+    const conn = new SerialConnection() as any;
+    const sendSpy = vi
+      .spyOn(conn, "sendCommand")
+      .mockImplementation(async () => {});
+    conn.writer = {};
+    conn.lastFlowControlMs = -Infinity;
+
+    conn.topUpCredits();
+    expect(sendSpy).toHaveBeenLastCalledWith("CREDIT", { frames: 256 });
+
+    conn.onSyncFramesConsumed(100); // Less than half the window used
+    expect(sendSpy).toHaveBeenCalledTimes(1);
+    conn.onSyncFramesConsumed(50);
+    expect(sendSpy).toHaveBeenLastCalledWith("CREDIT", { frames: 150 });
+
+    conn.maybeAdjustFlowControl(true);
+    conn.onSyncFramesConsumed(256);
+    expect(sendSpy).toHaveBeenCalledTimes(2);
+  });
+
+  it("keeps credit mode alive while withholding and regrants after the gateway reopens", () => {
+    const conn = new SerialConnection() as any;
+    const sendSpy = vi
+      .spyOn(conn, "sendCommand")
+      .mockImplementation(async () => {});
+    vi.spyOn(console, "warn").mockImplementation(() => {});
+    const now = vi.spyOn(performance, "now").mockReturnValue(10_000);
+    conn.writer = {};
+    conn.lastFlowControlMs = -Infinity;
+
+    conn.topUpCredits(); // 256 outstanding
+    conn.maybeAdjustFlowControl(true);
+    conn.onSyncFramesConsumed(10);
+    expect(sendSpy).toHaveBeenCalledTimes(1);
+
+    // Withholding: a zero-frame CREDIT at most once per keepalive period
+    now.mockReturnValue(11_000);
+    conn.onSyncFramesConsumed(10);
+    expect(sendSpy).toHaveBeenLastCalledWith("CREDIT", { frames: 0 });
+    conn.onSyncFramesConsumed(10);
+    expect(sendSpy).toHaveBeenCalledTimes(2);
+
+    // Gateway back to OPEN (streaming restarted): earlier grants are gone
+    conn.flowPaused = false;
+    conn.dispatchParsedPackets(
+      [{ type: "gateway_flow", event: "mode", mode: "open", credits: 0 }],
+      "USB Serial",
+    );
+    expect(sendSpy).toHaveBeenLastCalledWith("CREDIT", { frames: 256 });
+    expect(conn.creditsOutstanding).toBe(256);
+  });
+
+  it("writes off credits spent on lost frames from cumulative counters", () => {
+    const conn = new SerialConnection() as any;
+    const sendSpy = vi
+      .spyOn(conn, "sendCommand")
+      .mockImplementation(async () => {});
+    vi.spyOn(console, "log").mockImplementation(() => {});
+    conn.writer = {};
+
+    conn.topUpCredits(); // 256 outstanding
+    const diag = (creditsUsed: number, syncFramesBefore: number) => ({
+      type: "gateway_serial_diag",
+      credits: 0,
+      creditsUsed,
+      syncFramesBefore,
+    });
+
+    // First report only sets the baseline, even with a stale low balance
+    conn.dispatchParsedPackets([diag(0xfffffff0, 0)], "USB Serial");
+    expect(conn.creditsOutstanding).toBe(256);
+
+    // 150 sent across the u32 wrap, 60 arrived: 90 were lost
+    conn.onSyncFramesConsumed(60);
+    conn.dispatchParsedPackets([diag(150 - 16, 0)], "USB Serial");
+    expect(sendSpy).toHaveBeenLastCalledWith("CREDIT", { frames: 150 });
+    expect(conn.creditsOutstanding).toBe(256);
+
+    // Everything sent arrived (stamped position within the batch)
+    conn.onSyncFramesConsumed(50);
+    conn.dispatchParsedPackets([diag(150 - 16 + 50, 0)], "USB Serial", 110);
+    expect(conn.creditsOutstanding).toBe(206);
+  });
+
   it("enriches IMU packets with the last sync_status completeness contract", () => {
     const conn = new SerialConnection() as unknown as {
       dispatchParsedPackets: (packets: unknown[], deviceName: string) => void;
@@ -5,7 +5,12 @@ import type {
 } from "./IConnection";
 import { IMUParser } from "./IMUParser";
 import { RingBuffer } from "./RingBuffer";
-import { reportSerialLoss } from "./SyncedSampleStats";
+import {
+  CobsFrameDecoder,
+  parseFramingAck,
+  type SerialFramingMode,
+} from "./SerialFraming";
+import { reportGatewayFlowGap, reportSerialLoss } from "./SyncedSampleStats";
 import { useOptionalSensorsStore } from "../../store/useOptionalSensorsStore";
 import { useNetworkStore } from "../../store/useNetworkStore";
 import { makeDeviceKey } from "../deviceKey";
@@ -25,9 +30,24 @@ const ESPRESSIF_VID = 0x303a;
 // ============================================================================
 const USB_CDC_BAUD_RATE = 921600;
 
-const SERIAL_RING_HIGH_WATERMARK = 98304; // 96KB (allow larger burst absorption before PAUSE)
+const SERIAL_RING_HIGH_WATERMARK = 98304; // 96KB (allow larger burst absorption before withholding credits)
 const SERIAL_RING_LOW_WATERMARK = 32768; // 32KB
 const FLOW_CONTROL_COOLDOWN_MS = 500;
+
+// USB credit flow control: the gateway sends one 0x25 sync frame per credit
+// and holds the rest in its frame ring. One window ~= the gateway ring depth
+// (256 frames, ~1.3 s at 200 Hz); topped up once half of it is consumed.
+const SERIAL_CREDIT_WINDOW = 256;
+const SERIAL_CREDIT_REFILL = SERIAL_CREDIT_WINDOW / 2;
+// The gateway falls back to OPEN after 3 s without a CREDIT; while credits
+// are withheld a zero-frame CREDIT keeps credit mode (and lossy) in force
+const SERIAL_CREDIT_KEEPALIVE_MS = 1000;
+
+// COBS framing (SerialFraming.ts) is requested on connect and again whenever
+// the stream falls back to legacy framing, a few times at most so gateway
+// firmware without FRAMING support is not asked forever
+const FRAMING_REQUEST_INTERVAL_MS = 2000;
+const FRAMING_MAX_REQUESTS = 3;
 const PARSE_TIME_BUDGET_MS = 10;
 const PARSE_MAX_FRAMES_PER_TICK = 256;
 const MAX_PENDING_PARSE_FRAMES = 4096;
@@ -104,6 +124,30 @@ function isPlausibleFrame(packetType: number, frameLen: number): boolean {
     return frameLen >= 2 && frameLen <= 4096;
   }
 
+  // 0x07 trace ring dump chunk (type + 5..391 byte chunk); framed here so a
+  // dump does not desync the stream, then ignored by IMUParser
+  if (packetType === 0x07) {
+    return frameLen >= 6 && frameLen <= 392;
+  }
+
+  // 0x08 latency histogram: 14-byte header + up to 120 u32 bucket counts
+  if (packetType === 0x08) {
+    return frameLen >= 14 && frameLen <= 494 && (frameLen - 14) % 4 === 0;
+  }
+
+  // 0x09 binary telemetry: 7-byte header + kind body (largest today is 168;
+  // slack for appended fields)
+  if (packetType === 0x09) {
+    return frameLen >= 8 && frameLen <= 256;
+  }
+
+  // 0x26 historical node data (black box backfill): 10-byte header + samples
+  // + CRC8, at most one ESP-NOW payload. Framed so it does not desync the
+  // stream; live fusion skips it (session_tool.py splices recordings)
+  if (packetType === 0x26) {
+    return frameLen >= 11 && frameLen <= 250;
+  }
+
   return false;
 }
 
@@ -124,8 +168,16 @@ export class SerialConnection implements IConnection {
   private pendingFrames: Uint8Array[] = [];
   private pendingFrameStart = 0;
   private parseScheduled = false;
-  private flowPaused = false;
+  private flowPaused = false; // Credits withheld (parse backlog)
   private lastFlowControlMs = 0;
+  private creditsOutstanding = 0; // Granted, not yet consumed
+  private lastCreditSentMs = 0;
+  private syncFramesConsumed = 0; // Cumulative, in stream order
+  private lastCreditReport: { used: number; consumed: number } | null = null;
+  private framing: SerialFramingMode = "legacy";
+  private cobsDecoder = new CobsFrameDecoder(4096); // Main-thread fallback
+  private framingRequests = 0;
+  private lastFramingRequestMs = 0;
 
   private stopReadLoop = false;
   private isDisconnecting = false;
@@ -283,6 +335,17 @@ export class SerialConnection implements IConnection {
 
       this.readLoopPromise = this.startReadLoop();
       this.isConnecting = false;
+      this.flowPaused = false;
+      this.creditsOutstanding = 0;
+      this.lastCreditSentMs = 0;
+      this.syncFramesConsumed = 0;
+      this.lastCreditReport = null;
+      this.topUpCredits();
+      this.framing = "legacy";
+      this.cobsDecoder.reset();
+      this.framingRequests = 0;
+      this.lastFramingRequestMs = 0;
+      this.requestCobsFraming();
       console.log(
         "[SerialConnection] Read loop started, setting status to connected",
       );
@@ -474,7 +537,44 @@ export class SerialConnection implements IConnection {
     }
 
     const deviceName = this.deviceName || "USB Serial";
+    const frames: Uint8Array[] = [];
+
+    if (this.framing === "cobs") {
+      this.extractCobsFrames(chunk, frames);
+    } else {
+      this.extractLegacyFrames(chunk, frames);
+      if (this.framing === "cobs" && this.ringBuffer.length > 0) {
+        // Bytes after the ack are already COBS
+        this.extractCobsFrames(
+          this.ringBuffer.read(this.ringBuffer.length),
+          frames,
+        );
+      }
+    }
+    if (this.framing === "legacy") this.requestCobsFraming();
+
+    if (!this._onData || frames.length === 0) return;
 
+    this.debugStats.framesExtracted += frames.length;
+    this.debugStats.lastFrameMs = Date.now();
+
+    this.enqueueFrames(frames);
+    this.scheduleParse(deviceName);
+    this.maybeAdjustFlowControl(false);
+  }
+
+  private extractCobsFrames(bytes: Uint8Array, frames: Uint8Array[]) {
+    const badBefore = this.cobsDecoder.badFrames;
+    this.cobsDecoder.push(bytes, frames);
+    if (this.cobsDecoder.lostFraming) {
+      this.setFraming("legacy");
+    }
+    const bad = this.cobsDecoder.badFrames - badBefore;
+    if (bad > 0) reportSerialLoss(0, bad);
+  }
+
+  // Legacy length-prefixed frames; stops right after a COBS ack
+  private extractLegacyFrames(chunk: Uint8Array, frames: Uint8Array[]) {
     // Zero-copy append to ring buffer (no allocation)
     this.ringBuffer.write(chunk);
 
@@ -483,7 +583,6 @@ export class SerialConnection implements IConnection {
       this.maybeAdjustFlowControl(true);
     }
 
-    const frames: Uint8Array[] = [];
     const MAX_FRAME_LEN = 4096;
     const MIN_FRAME_LEN = 3;
     let resyncAttempts = 0;
@@ -530,16 +629,11 @@ export class SerialConnection implements IConnection {
       const frame = this.ringBuffer.read(frameLen);
       frames.push(frame);
       resyncAttempts = 0;
+      if (packetType === 0x06 && parseFramingAck(frame) === "cobs") {
+        this.setFraming("cobs");
+        break;
+      }
     }
-
-    if (!this._onData || frames.length === 0) return;
-
-    this.debugStats.framesExtracted += frames.length;
-    this.debugStats.lastFrameMs = Date.now();
-
-    this.enqueueFrames(frames);
-    this.scheduleParse(deviceName);
-    this.maybeAdjustFlowControl(false);
   }
 
   private getPendingFrameCount(): number {
@@ -591,6 +685,8 @@ export class SerialConnection implements IConnection {
         const syncFrames = Array.isArray(data.syncFrames)
           ? data.syncFrames
           : [];
+        const syncFrameBase = this.syncFramesConsumed;
+        this.onSyncFramesConsumed(syncFrames.length);
         if (syncFrames.length > 0) {
           const now = Date.now();
           if (now - this.lastSyncMetaLogMs > 2000) {
@@ -688,7 +784,7 @@ export class SerialConnection implements IConnection {
         }
         if (packets.length > 0) {
           const deviceName = this.deviceName || "USB Serial";
-          this.dispatchParsedPackets(packets, deviceName);
+          this.dispatchParsedPackets(packets, deviceName, syncFrameBase);
         }
       };
 
@@ -720,6 +816,7 @@ export class SerialConnection implements IConnection {
     overflowEvents?: number;
     overflowBytes?: number;
     ringLength?: number;
+    framing?: SerialFramingMode;
     rawAsciiPreview?: string;
   }) {
     // Report serial-layer losses to the pipeline loss aggregator
@@ -735,6 +832,11 @@ export class SerialConnection implements IConnection {
       this.maybeAdjustFlowControl(false);
     }
 
+    if (stats.framing === "cobs" || stats.framing === "legacy") {
+      if (stats.framing !== this.framing) this.setFraming(stats.framing);
+      if (this.framing === "legacy") this.requestCobsFraming();
+    }
+
     if (
       typeof stats.rawAsciiPreview === "string" &&
       stats.rawAsciiPreview.length > 0
@@ -763,14 +865,23 @@ export class SerialConnection implements IConnection {
     const packets: any[] = [];
     const start = performance.now();
     let processed = 0;
+    let syncFrames = 0;
+    const syncFrameBase = this.syncFramesConsumed;
 
     while (this.pendingFrameStart < this.pendingFrames.length) {
       const frame = this.pendingFrames[this.pendingFrameStart++];
       if (!frame) break;
+      if (frame[0] === 0x25) syncFrames++;
 
       const parsed = IMUParser.parseSingleFrame(
         new DataView(frame.buffer, frame.byteOffset, frame.byteLength),
       );
+      for (const packet of parsed) {
+        // Stream position for credit reconciliation
+        if ((packet as any).type === "gateway_serial_diag") {
+          (packet as any).syncFramesBefore = syncFrames;
+        }
+      }
       if (parsed.length > 0) packets.push(...parsed);
 
       processed++;
@@ -779,8 +890,9 @@ export class SerialConnection implements IConnection {
     }
 
     if (packets.length > 0) {
-      this.dispatchParsedPackets(packets, deviceName);
+      this.dispatchParsedPackets(packets, deviceName, syncFrameBase);
     }
+    this.onSyncFramesConsumed(syncFrames);
 
     if (this.pendingFrameStart > 0) {
       if (
@@ -797,7 +909,11 @@ export class SerialConnection implements IConnection {
     }
   }
 
-  private dispatchParsedPackets(packets: any[], deviceName: string) {
+  private dispatchParsedPackets(
+    packets: any[],
+    deviceName: string,
+    syncFrameBase = this.syncFramesConsumed,
+  ) {
     this.debugStats.packetsDispatched += packets.length;
     this.debugStats.lastPacketMs = Date.now();
 
@@ -836,6 +952,32 @@ export class SerialConnection implements IConnection {
           console.log(
             `[SerialConnection] Gateway pipeline: uptime=${diag.uptime_ms ?? "?"}ms tdma=${diag.tdmaRunning ? "running" : "not-running"} streaming=${diag.isStreaming ? "on" : "off"} nodes=${diag.nodeCount ?? 0} rxProcessed=${diag.espNowRxProcessed ?? 0} rxDropped=${diag.espNowRxDropped ?? 0} syncFrames=${diag.syncFramesEmitted ?? 0} beacons=${diag.beacons ?? 0}`,
           );
+        } else if (typedPacket.type === "gateway_flow") {
+          const flow = packet as {
+            event?: string;
+            mode?: string;
+            credits?: number;
+            gapFrames?: number;
+          };
+          if (flow.event === "gap") {
+            reportGatewayFlowGap(flow.gapFrames ?? 0);
+          } else {
+            console.warn(
+              `[SerialConnection] Gateway USB flow mode: ${flow.mode ?? "?"} (credits=${flow.credits ?? 0})`,
+            );
+            if (flow.mode === "open") this.onGatewayFlowOpen();
+          }
+        } else if (typedPacket.type === "gateway_serial_diag") {
+          const diag = packet as {
+            creditsUsed?: number;
+            syncFramesBefore?: number;
+          };
+          if (typeof diag.creditsUsed === "number") {
+            this.reconcileCredits(
+              diag.creditsUsed,
+              syncFrameBase + (diag.syncFramesBefore ?? 0),
+            );
+          }
         } else if (typedPacket.type === "gateway_ingest_diag") {
           const diag = packet as {
             window_ms?: number;
@@ -844,13 +986,17 @@ export class SerialConnection implements IConnection {
               packets?: number;
               samplesAdded?: number;
               sampleAddFails?: number;
+              lossPermille?: number;
             }>;
           };
           const windowMs = diag.window_ms ?? 0;
           const nodeParts = Array.isArray(diag.nodes)
             ? diag.nodes.map(
                 (n) =>
-                  `n${n.nodeId ?? "?"}:pkts=${n.packets ?? 0},added=${n.samplesAdded ?? 0},fails=${n.sampleAddFails ?? 0}`,
+                  `n${n.nodeId ?? "?"}:pkts=${n.packets ?? 0},added=${n.samplesAdded ?? 0},fails=${n.sampleAddFails ?? 0}` +
+                  (n.lossPermille !== undefined
+                    ? `,loss=${(n.lossPermille / 10).toFixed(1)}%`
+                    : ""),
               )
             : [];
           console.log(
@@ -919,9 +1065,9 @@ export class SerialConnection implements IConnection {
 
     if (forcePause || ringLength >= SERIAL_RING_HIGH_WATERMARK) {
       if (!this.flowPaused) {
+        // Stop granting: the gateway holds frames, then declares lossy mode
         this.flowPaused = true;
         this.lastFlowControlMs = now;
-        void this.pauseDataFlow();
       }
       return;
     }
@@ -929,7 +1075,7 @@ export class SerialConnection implements IConnection {
     if (this.flowPaused && ringLength <= SERIAL_RING_LOW_WATERMARK) {
       this.flowPaused = false;
       this.lastFlowControlMs = now;
-      void this.resumeDataFlow();
+      this.topUpCredits();
     }
   }
 
@@ -964,27 +1110,101 @@ export class SerialConnection implements IConnection {
       workerRingLength: this.workerRingLength,
       pendingFrames: this.getPendingFrameCount(),
       flowPaused: this.flowPaused,
+      creditsOutstanding: this.creditsOutstanding,
+      framing: this.framing,
+      cobsFrames: this.cobsDecoder.frames,
+      cobsBadFrames: this.cobsDecoder.badFrames,
       lastAsciiPreview: this.debugStats.lastAsciiPreview,
     };
   }
 
   // ===========================================================================
-  // OPP-7: USB Serial Flow Control
+  // USB Serial Flow Control (credit window)
+  // ===========================================================================
+  // The Gateway sends one 0x25 frame per credit. Credits are granted as sync
+  // frames are consumed here, so a stalled tab stops granting and the
+  // Gateway holds data in its ring instead of overflowing ours; if the stall
+  // persists it switches to lossy mode and reports gaps (gateway_flow).
+  //
+  // Frames lost between the gateway and the parser never come back as
+  // consumption, so each SERIAL_TX diag reconciles cumulative counters: the
+  // gateway's credits used since the previous report, against the sync
+  // frames consumed here between the two diags in stream order. The
+  // difference was spent on frames that never arrived. Diffing totals (not
+  // the gateway's balance, up to 5 s stale) keeps grants still in flight
+  // out of the comparison, and a lost diag just widens the next interval.
+  // ===========================================================================
+
+  private onSyncFramesConsumed(count: number) {
+    if (count <= 0) return;
+    this.syncFramesConsumed += count;
+    this.creditsOutstanding = Math.max(0, this.creditsOutstanding - count);
+    this.topUpCredits();
+  }
+
+  private reconcileCredits(gatewayUsed: number, consumed: number) {
+    const last = this.lastCreditReport;
+    this.lastCreditReport = { used: gatewayUsed, consumed };
+    if (!last) return;
+
+    // u32 wrap on the gateway counter; frames sent in OPEN mode (no credit
+    // used) make this negative and are ignored
+    const used = (gatewayUsed - last.used) >>> 0;
+    const lost = used - (consumed - last.consumed);
+    if (lost <= 0 || used >= 0x80000000) return;
+
+    this.creditsOutstanding = Math.max(0, this.creditsOutstanding - lost);
+    this.topUpCredits();
+  }
+
+  private topUpCredits() {
+    if (!this.writer) return;
+    const now = performance.now();
+    if (this.flowPaused) {
+      if (now - this.lastCreditSentMs < SERIAL_CREDIT_KEEPALIVE_MS) return;
+      this.lastCreditSentMs = now;
+      void this.sendCommand("CREDIT", { frames: 0 });
+      return;
+    }
+    const threshold = SERIAL_CREDIT_WINDOW - SERIAL_CREDIT_REFILL;
+    if (this.creditsOutstanding > threshold) return;
+    const frames = SERIAL_CREDIT_WINDOW - this.creditsOutstanding;
+    this.creditsOutstanding += frames;
+    this.lastCreditSentMs = now;
+    void this.sendCommand("CREDIT", { frames });
+  }
+
+  // The gateway dropped its credit state (streaming start/stop, or it saw
+  // no CREDIT for a while): grants still counted here are gone
+  private onGatewayFlowOpen() {
+    this.creditsOutstanding = 0;
+    this.lastCreditReport = null;
+    this.topUpCredits();
+  }
+
+  // ===========================================================================
+  // USB framing (SerialFraming.ts)
   // ===========================================================================
-  // Sends PAUSE/RESUME commands to Gateway to control data flow.
-  // Gateway stops enqueuing IMU data frames when paused (command responses
-  // still flow). Use when the app can't process data fast enough.
+  // The worker (or the main-thread fallback) switches decoders on the
+  // gateway's framing ack; this side only decides when to ask for COBS.
   // ===========================================================================
 
-  /** Pause Gateway IMU data transmission */
-  async pauseDataFlow(): Promise<void> {
-    await this.sendCommand("PAUSE");
-    console.debug("[SerialConnection] Sent PAUSE to Gateway");
+  private setFraming(mode: SerialFramingMode) {
+    if (mode === this.framing) return;
+    console.info(`[SerialConnection] USB framing: ${this.framing} -> ${mode}`);
+    this.framing = mode;
+    this.cobsDecoder.reset();
+    // A working COBS link earns a fresh set of requests for the next fallback
+    if (mode === "cobs") this.framingRequests = 0;
   }
 
-  /** Resume Gateway IMU data transmission */
-  async resumeDataFlow(): Promise<void> {
-    await this.sendCommand("RESUME");
-    console.debug("[SerialConnection] Sent RESUME to Gateway");
+  private requestCobsFraming() {
+    if (!this.writer || this.framing === "cobs") return;
+    if (this.framingRequests >= FRAMING_MAX_REQUESTS) return;
+    const now = Date.now();
+    if (now - this.lastFramingRequestMs < FRAMING_REQUEST_INTERVAL_MS) return;
+    this.lastFramingRequestMs = now;
+    this.framingRequests++;
+    void this.sendCommand("FRAMING", { mode: "cobs" });
   }
 }
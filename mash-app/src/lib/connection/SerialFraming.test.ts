@@ -0,0 +1,107 @@
+import { describe, expect, it } from "vitest";
+import {
+  COBS_FALLBACK_BAD_FRAMES,
+  CobsFrameDecoder,
+  cobsDecodeFrame,
+  cobsEncodeFrame,
+  crc32,
+  parseFramingAck,
+} from "./SerialFraming";
+
+function syncFrame(seed: number, sensors = 3): Uint8Array {
+  const frame = new Uint8Array(10 + sensors * 16);
+  frame[0] = 0x25;
+  for (let i = 1; i < frame.length; i++) {
+    frame[i] = (seed * 31 + i * 7) % 5 === 0 ? 0 : (seed + i) & 0xff;
+  }
+  return frame;
+}
+
+function concat(parts: Uint8Array[]): Uint8Array {
+  const out = new Uint8Array(parts.reduce((n, p) => n + p.length, 0));
+  let offset = 0;
+  for (const p of parts) {
+    out.set(p, offset);
+    offset += p.length;
+  }
+  return out;
+}
+
+describe("SerialFraming", () => {
+  it("matches the zlib / ESP32 ROM CRC-32", () => {
+    expect(crc32(new TextEncoder().encode("123456789"))).toBe(0xcbf43926);
+  });
+
+  it("round-trips frames with zeros and long zero-free runs", () => {
+    const long = new Uint8Array(700).map((_, i) => (i % 250) + 1);
+    for (const frame of [syncFrame(1), new Uint8Array([0x06, 0, 0, 0]), long]) {
+      const encoded = cobsEncodeFrame(frame);
+      expect(encoded.subarray(0, -1).includes(0)).toBe(false);
+      expect(encoded[encoded.length - 1]).toBe(0);
+      expect(cobsDecodeFrame(encoded, 0, encoded.length - 1)).toEqual(frame);
+    }
+  });
+
+  it("rejects a corrupted frame", () => {
+    const encoded = cobsEncodeFrame(syncFrame(2));
+    encoded[5] ^= 0x40;
+    expect(cobsDecodeFrame(encoded, 0, encoded.length - 1)).toBeNull();
+  });
+
+  it("loses only the damaged frame after a dropped byte", () => {
+    const frames = Array.from({ length: 20 }, (_, i) => syncFrame(i));
+    const stream = concat([new Uint8Array([0]), ...frames.map(cobsEncodeFrame)]);
+    const damaged = concat([stream.subarray(0, 200), stream.subarray(201)]);
+
+    const decoder = new CobsFrameDecoder(4096);
+    const out: Uint8Array[] = [];
+    // Split across chunks the way Web Serial delivers it
+    for (let i = 0; i < damaged.length; i += 61) {
+      decoder.push(damaged.subarray(i, i + 61), out);
+    }
+
+    expect(out.length).toBe(frames.length - 1);
+    expect(decoder.badFrames).toBe(1);
+    expect(out[out.length - 1]).toEqual(frames[frames.length - 1]);
+  });
+
+  it("isolates unframed log text between chunks", () => {
+    const text = new TextEncoder().encode("[Sync] node 3 registered\n");
+    const stream = concat([
+      new Uint8Array([0]),
+      cobsEncodeFrame(syncFrame(3)),
+      text,
+      new Uint8Array([0]),
+      cobsEncodeFrame(syncFrame(4)),
+    ]);
+    const decoder = new CobsFrameDecoder(4096);
+    const out: Uint8Array[] = [];
+    decoder.push(stream, out);
+    expect(out).toEqual([syncFrame(3), syncFrame(4)]);
+  });
+
+  it("reports lost framing when a legacy stream arrives", () => {
+    const legacy: number[] = [];
+    for (let i = 0; i < COBS_FALLBACK_BAD_FRAMES + 2; i++) {
+      const frame = syncFrame(i);
+      legacy.push(frame.length & 0xff, frame.length >> 8, ...frame);
+    }
+    const decoder = new CobsFrameDecoder(4096);
+    decoder.push(new Uint8Array(legacy), []);
+    expect(decoder.lostFraming).toBe(true);
+  });
+
+  it("recognises framing acks", () => {
+    const ack = (json: string) =>
+      concat([new Uint8Array([0x06]), new TextEncoder().encode(json)]);
+    expect(parseFramingAck(ack('{"type":"framing","mode":"cobs"}'))).toBe(
+      "cobs",
+    );
+    expect(parseFramingAck(ack('{"type":"framing","mode":"legacy"}'))).toBe(
+      "legacy",
+    );
+    expect(
+      parseFramingAck(ack('{"type":"flow","status":"paused"}')),
+    ).toBeNull();
+  });
+});
@@ -0,0 +1,173 @@
+// ============================================================================
+// Gateway USB framing: COBS + CRC-32 (firmware SerialFraming.h)
+// ============================================================================
+// Legacy stream: [len lo][len hi][type][payload] back to back. One lost byte
+// shifts every later length, so the length-prefix parser has to resync.
+//
+// COBS stream, after {"cmd":"FRAMING","mode":"cobs"} is acknowledged by the
+// JSON frame {"type":"framing","mode":"cobs"}:
+//   0x00 COBS([type][payload][crc32 LE]) 0x00 COBS(...) 0x00 ...
+// 0x00 only ever marks a frame boundary, so after corruption the decoder
+// drops one frame and the next delimiter puts it back in step. The gateway
+// always sends the ack in legacy framing, so a host that lost track of the
+// mode (e.g. the gateway rebooted) simply asks again.
+// ============================================================================
+
+export type SerialFramingMode = "legacy" | "cobs";
+
+const CRC_SIZE = 4;
+
+// Consecutive bad COBS frames before assuming the gateway went back to
+// legacy framing (reboot) and re-requesting COBS
+export const COBS_FALLBACK_BAD_FRAMES = 8;
+
+const CRC32_TABLE = (() => {
+  const table = new Uint32Array(256);
+  for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+    table[n] = c >>> 0;
+  }
+  return table;
+})();
+
+/** CRC-32 (IEEE 802.3, zlib), same as the ESP32 ROM esp_rom_crc32_le(0, ...) */
+export function crc32(data: Uint8Array, start = 0, end = data.length): number {
+  let crc = 0xffffffff;
+  for (let i = start; i < end; i++) {
+    crc = CRC32_TABLE[(crc ^ data[i]) & 0xff] ^ (crc >>> 8);
+  }
+  return (crc ^ 0xffffffff) >>> 0;
+}
+
+/** Encode one frame as COBS(frame + CRC) followed by the 0x00 delimiter */
+export function cobsEncodeFrame(frame: Uint8Array): Uint8Array {
+  const crc = crc32(frame);
+  const body = new Uint8Array(frame.length + CRC_SIZE);
+  body.set(frame);
+  new DataView(body.buffer).setUint32(frame.length, crc, true);
+
+  const out = new Uint8Array(body.length + Math.floor(body.length / 254) + 2);
+  let codeAt = 0;
+  let w = 1;
+  let code = 1;
+  for (const b of body) {
+    if (b === 0) {
+      out[codeAt] = code;
+      codeAt = w++;
+      code = 1;
+      continue;
+    }
+    out[w++] = b;
+    if (++code === 0xff) {
+      out[codeAt] = code;
+      codeAt = w++;
+      code = 1;
+    }
+  }
+  out[codeAt] = code;
+  out[w++] = 0;
+  return out.subarray(0, w);
+}
+
+/**
+ * Decode one COBS block (delimiter excluded) and verify its CRC.
+ * Returns the frame without CRC, or null if malformed or corrupted.
+ */
+export function cobsDecodeFrame(
+  block: Uint8Array,
+  start = 0,
+  end = block.length,
+): Uint8Array | null {
+  const out = new Uint8Array(end - start);
+  let r = start;
+  let w = 0;
+  while (r < end) {
+    const code = block[r++];
+    if (code === 0) return null;
+    for (let i = 1; i < code; i++) {
+      if (r >= end || block[r] === 0) return null;
+      out[w++] = block[r++];
+    }
+    if (code !== 0xff && r < end) out[w++] = 0;
+  }
+  if (w <= CRC_SIZE) return null;
+
+  const frameLen = w - CRC_SIZE;
+  const expected =
+    (out[frameLen] |
+      (out[frameLen + 1] << 8) |
+      (out[frameLen + 2] << 16) |
+      (out[frameLen + 3] << 24)) >>>
+    0;
+  if (crc32(out, 0, frameLen) !== expected) return null;
+  return out.subarray(0, frameLen);
+}
+
+/**
+ * Mode named by a framing ack (0x06 JSON {"type":"framing","mode":...}),
+ * or null if the frame is something else
+ */
+export function parseFramingAck(frame: Uint8Array): SerialFramingMode | null {
+  if (frame.length < 20 || frame.length > 64 || frame[0] !== 0x06) return null;
+  const text = new TextDecoder().decode(frame.subarray(1));
+  if (!text.includes('"type":"framing"')) return null;
+  if (text.includes('"mode":"cobs"')) return "cobs";
+  if (text.includes('"mode":"legacy"')) return "legacy";
+  return null;
+}
+
+/** Streaming COBS decoder: bytes in, CRC-checked frames out */
+export class CobsFrameDecoder {
+  private block: Uint8Array;
+  private blockLen = 0;
+  private overflowed = false;
+
+  frames = 0;
+  badFrames = 0; // COBS/CRC errors (empty blocks between delimiters are not)
+  consecutiveBad = 0;
+
+  constructor(maxFrameLen: number) {
+    this.block = new Uint8Array(
+      maxFrameLen + CRC_SIZE + Math.ceil((maxFrameLen + CRC_SIZE) / 254) + 1,
+    );
+  }
+
+  reset() {
+    this.blockLen = 0;
+    this.overflowed = false;
+    this.consecutiveBad = 0;
+  }
+
+  /** Appends every complete valid frame in bytes to out */
+  push(bytes: Uint8Array, out: Uint8Array[]) {
+    for (let i = 0; i < bytes.length; i++) {
+      const b = bytes[i];
+      if (b !== 0) {
+        if (this.blockLen < this.block.length) this.block[this.blockLen++] = b;
+        else this.overflowed = true;
+        continue;
+      }
+      if (this.blockLen > 0) {
+        const frame = this.overflowed
+          ? null
+          : cobsDecodeFrame(this.block, 0, this.blockLen);
+        if (frame) {
+          out.push(frame);
+          this.frames++;
+          this.consecutiveBad = 0;
+        } else {
+          this.badFrames++;
+          this.consecutiveBad++;
+        }
+      }
+      this.blockLen = 0;
+      this.overflowed = false;
+    }
+  }
+
+  /** True once the stream no longer looks like COBS (gateway reset) */
+  get lostFraming(): boolean {
+    return this.consecutiveBad >= COBS_FALLBACK_BAD_FRAMES;
+  }
+}
@@ -147,6 +147,8 @@ interface PipelineLossStats {
   serialOverflowBytes: number;
   /** Frames skipped during serial resync (framing errors) */
   serialResyncEvents: number;
+  /** Frames the gateway declared unsent (USB credit starvation / lapping) */
+  gatewayFlowDrops: number;
   /** Frames rejected by CRC check */
   crcRejectCount: number;
   /** Sensors rejected by parser (invalid + untrusted + corruptFrame) */
@@ -159,6 +161,7 @@ const pipelineLoss: PipelineLossStats = {
   frameGapDrops: 0,
   serialOverflowBytes: 0,
   serialResyncEvents: 0,
+  gatewayFlowDrops: 0,
   crcRejectCount: 0,
   parserRejectCount: 0,
   deliveredFrames: 0,
@@ -175,6 +178,14 @@ export function reportSerialLoss(
   pipelineLoss.serialResyncEvents += resyncEvents;
 }
 
+/**
+ * Report a gateway gap marker (0x09 FLOW). These frames also show up as
+ * frame-number gaps; this records that the gateway dropped them on purpose.
+ */
+export function reportGatewayFlowGap(frames: number): void {
+  pipelineLoss.gatewayFlowDrops += frames;
+}
+
 /**
  * Report parser-level rejections (called from IMUParser).
  */
@@ -214,6 +225,7 @@ function resetPipelineLoss(): void {
   pipelineLoss.frameGapDrops = 0;
   pipelineLoss.serialOverflowBytes = 0;
   pipelineLoss.serialResyncEvents = 0;
+  pipelineLoss.gatewayFlowDrops = 0;
   pipelineLoss.crcRejectCount = 0;
   pipelineLoss.parserRejectCount = 0;
   pipelineLoss.deliveredFrames = 0;
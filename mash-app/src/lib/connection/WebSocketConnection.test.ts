@@ -0,0 +1,54 @@
+import { describe, expect, it } from "vitest";
+import { splitLengthPrefixedFrames } from "./WebSocketConnection";
+
+function record(frame: Uint8Array): Uint8Array {
+  const out = new Uint8Array(2 + frame.length);
+  out[0] = frame.length & 0xff;
+  out[1] = frame.length >> 8;
+  out.set(frame, 2);
+  return out;
+}
+
+function concat(parts: Uint8Array[]): Uint8Array {
+  const out = new Uint8Array(parts.reduce((n, p) => n + p.length, 0));
+  let offset = 0;
+  for (const p of parts) {
+    out.set(p, offset);
+    offset += p.length;
+  }
+  return out;
+}
+
+function syncFrame(seed: number, sensors = 3): Uint8Array {
+  const frame = new Uint8Array(10 + sensors * 16);
+  frame[0] = 0x25;
+  for (let i = 1; i < frame.length; i++) frame[i] = (seed + i) & 0xff;
+  return frame;
+}
+
+describe("WebSocketConnection batch parsing", () => {
+  it("splits a batch into its length-prefixed frames", () => {
+    const frames = [syncFrame(1), syncFrame(2, 8), syncFrame(3, 1)];
+    const out = splitLengthPrefixedFrames(concat(frames.map(record)));
+
+    expect(out).toHaveLength(3);
+    out.forEach((f, i) =>
+      expect(Array.from(f)).toEqual(Array.from(frames[i])),
+    );
+  });
+
+  it("keeps whole frames before a truncated record", () => {
+    const batch = concat([record(syncFrame(1)), record(syncFrame(2))]);
+    const out = splitLengthPrefixedFrames(batch.subarray(0, batch.length - 5));
+
+    expect(out).toHaveLength(1);
+    expect(out[0][0]).toBe(0x25);
+  });
+
+  it("returns nothing for an empty or zero-length record", () => {
+    expect(splitLengthPrefixedFrames(new Uint8Array(0))).toHaveLength(0);
+    expect(
+      splitLengthPrefixedFrames(new Uint8Array([0, 0, 0x25])),
+    ).toHaveLength(0);
+  });
+});
@@ -0,0 +1,181 @@
+import type {
+  IConnection,
+  ConnectionStatus,
+  ConnectionData,
+} from "./IConnection";
+import { IMUParser } from "./IMUParser";
+import { makeDeviceKey } from "../deviceKey";
+import type { IMUDataPacket } from "../protocol/DeviceInterface";
+
+// ============================================================================
+// Gateway WebSocket (port 81)
+// ============================================================================
+// The gateway's WebSocketManager batches 0x25 sync frames into binary
+// messages whose body is the USB byte stream: [len lo][len hi][frame]
+// repeated, whole frames only. Text messages are JSON (welcome and command
+// responses). Commands go out as one JSON text message each.
+//
+// No credits: the gateway backs a slow client off on its own and drops the
+// oldest frames for it, so there is nothing to grant from this side.
+// ============================================================================
+const DEFAULT_GATEWAY_WS_URL = "ws://192.168.4.1:81/";
+const MAX_FRAME_LEN = 4096;
+
+/**
+ * Split one binary batch into its length-prefixed frames. A truncated or
+ * oversized record ends the batch: frames are never split across messages,
+ * so the rest cannot be resynchronised.
+ */
+export function splitLengthPrefixedFrames(batch: Uint8Array): Uint8Array[] {
+  const frames: Uint8Array[] = [];
+  let offset = 0;
+  while (offset + 2 <= batch.length) {
+    const len = batch[offset] | (batch[offset + 1] << 8);
+    offset += 2;
+    if (len === 0 || len > MAX_FRAME_LEN || offset + len > batch.length) {
+      break;
+    }
+    frames.push(batch.subarray(offset, offset + len));
+    offset += len;
+  }
+  return frames;
+}
+
+export class WebSocketConnection implements IConnection {
+  type: "websocket" = "websocket";
+  status: ConnectionStatus = "disconnected";
+
+  private socket: WebSocket | null = null;
+  private url = DEFAULT_GATEWAY_WS_URL;
+
+  private _onData: ((data: ConnectionData) => void) | null = null;
+  private _onStatus: ((status: ConnectionStatus) => void) | null = null;
+
+  private stats = {
+    messages: 0,
+    frames: 0,
+    truncatedBatches: 0,
+  };
+
+  onData(callback: (data: ConnectionData) => void) {
+    this._onData = callback;
+  }
+
+  onStatus(callback: (status: ConnectionStatus) => void) {
+    this._onStatus = callback;
+  }
+
+  getDeviceName(): string | undefined {
+    return this.socket ? this.url : undefined;
+  }
+
+  getStats() {
+    return { ...this.stats };
+  }
+
+  private setStatus(status: ConnectionStatus) {
+    this.status = status;
+    if (this._onStatus) this._onStatus(status);
+  }
+
+  async connect(params?: { url?: string }) {
+    if (this.socket) await this.disconnect();
+
+    this.url = params?.url ?? DEFAULT_GATEWAY_WS_URL;
+    this.stats = { messages: 0, frames: 0, truncatedBatches: 0 };
+    this.setStatus("connecting");
+
+    const socket = new WebSocket(this.url);
+    socket.binaryType = "arraybuffer";
+    this.socket = socket;
+
+    await new Promise<void>((resolve) => {
+      socket.onopen = () => {
+        this.setStatus("connected");
+        resolve();
+      };
+      socket.onerror = () => {
+        if (this.status === "connecting") {
+          console.error(`[WebSocketConnection] Could not open ${this.url}`);
+          this.socket = null;
+          this.setStatus("error");
+          resolve();
+        }
+      };
+    });
+
+    socket.onmessage = (event) => this.handleMessage(event.data);
+    socket.onclose = () => {
+      if (this.socket === socket) {
+        this.socket = null;
+        this.setStatus("disconnected");
+      }
+    };
+  }
+
+  async disconnect() {
+    const socket = this.socket;
+    this.socket = null;
+    if (socket) socket.close();
+    this.setStatus("disconnected");
+  }
+
+  async sendCommand(cmd: string, params?: unknown) {
+    if (!this.socket || this.socket.readyState !== WebSocket.OPEN) return;
+    const payload = params ? { cmd, ...params } : { cmd };
+    this.socket.send(JSON.stringify(payload));
+  }
+
+  private handleMessage(data: unknown) {
+    this.stats.messages++;
+
+    if (typeof data === "string") {
+      try {
+        const packet = JSON.parse(data);
+        window.dispatchEvent(
+          new CustomEvent("json-packet", { detail: packet }),
+        );
+        this._onData?.(packet as ConnectionData);
+      } catch {
+        console.warn("[WebSocketConnection] Ignoring non-JSON text message");
+      }
+      return;
+    }
+
+    if (!(data instanceof ArrayBuffer)) return;
+
+    const batch = new Uint8Array(data);
+    const frames = splitLengthPrefixedFrames(batch);
+    const consumed = frames.reduce((n, f) => n + 2 + f.length, 0);
+    if (consumed !== batch.length) this.stats.truncatedBatches++;
+    this.stats.frames += frames.length;
+
+    const imuPackets: IMUDataPacket[] = [];
+    for (const frame of frames) {
+      const parsed = IMUParser.parseSingleFrame(
+        new DataView(frame.buffer, frame.byteOffset, frame.byteLength),
+      );
+      for (const packet of parsed) {
+        if ("accelerometer" in packet) {
+          imuPackets.push(packet as IMUDataPacket);
+        } else {
+          this._onData?.(packet as ConnectionData);
+        }
+      }
+    }
+
+    if (imuPackets.length > 0) {
+      this._onData?.(
+        imuPackets.map((p) => ({
+          ...p,
+          deviceId: makeDeviceKey(
+            p.rawNodeId,
+            p.localSensorIndex,
+            p.sensorId ?? 0,
+          ),
+          sourceGateway: this.url,
+        })),
+      );
+    }
+  }
+}
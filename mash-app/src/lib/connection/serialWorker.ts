@@ -2,6 +2,11 @@
 
 import { IMUParser } from "./IMUParser";
 import { RingBuffer } from "./RingBuffer";
+import {
+  CobsFrameDecoder,
+  parseFramingAck,
+  type SerialFramingMode,
+} from "./SerialFraming";
 
 type WorkerInbound = {
   type: "chunk";
@@ -15,6 +20,7 @@ type WorkerStats = {
   overflowEvents: number;
   overflowBytes: number;
   ringLength: number;
+  framing: SerialFramingMode;
   rawAsciiPreview?: string;
 };
 
@@ -36,6 +42,11 @@ const MAX_FRAME_LEN = 4096;
 const MIN_FRAME_LEN = 3;
 const MAX_RESYNC_ATTEMPTS = 128;
 
+// Switched by the gateway's framing ack; back to legacy if COBS stops
+// decoding (the main thread then asks for COBS again)
+let framing: SerialFramingMode = "legacy";
+const cobsDecoder = new CobsFrameDecoder(MAX_FRAME_LEN);
+
 function isPlausibleFrame(packetType: number, frameLen: number): boolean {
   // 0x25 sync frame: header(10) + N*16 sensor slots [+ optional CRC byte]
   if (packetType === 0x25) {
@@ -61,16 +72,106 @@ function isPlausibleFrame(packetType: number, frameLen: number): boolean {
     return frameLen >= 2 && frameLen <= MAX_FRAME_LEN;
   }
 
+  // 0x07 trace ring dump chunk (type + 5..391 byte chunk); framed here so a
+  // dump does not desync the stream, then ignored by IMUParser
+  if (packetType === 0x07) {
+    return frameLen >= 6 && frameLen <= 392;
+  }
+
+  // 0x08 latency histogram: 14-byte header + up to 120 u32 bucket counts
+  if (packetType === 0x08) {
+    return frameLen >= 14 && frameLen <= 494 && (frameLen - 14) % 4 === 0;
+  }
+
+  // 0x09 binary telemetry: 7-byte header + kind body (largest today is 168;
+  // slack for appended fields)
+  if (packetType === 0x09) {
+    return frameLen >= 8 && frameLen <= 256;
+  }
+
+  // 0x26 historical node data (black box backfill): 10-byte header + samples
+  // + CRC8, at most one ESP-NOW payload. Framed so it does not desync the
+  // stream; live fusion skips it (session_tool.py splices recordings)
+  if (packetType === 0x26) {
+    return frameLen >= 11 && frameLen <= 250;
+  }
+
   return false;
 }
 
 function handleChunk(chunk: Uint8Array): WorkerOutbound {
-  ringBuffer.write(chunk);
-  const overflow = ringBuffer.drainOverflowStats();
   const rawAsciiPreview = getAsciiPreview(chunk);
-
   const frames: Uint8Array[] = [];
+  let resyncEvents = 0;
+  let overflow = { events: 0, bytes: 0 };
+
+  if (framing === "cobs") {
+    resyncEvents += extractCobsFrames(chunk, frames);
+  } else {
+    ringBuffer.write(chunk);
+    overflow = ringBuffer.drainOverflowStats();
+    resyncEvents += extractLegacyFrames(frames);
+    if (framing === "cobs" && ringBuffer.length > 0) {
+      // Bytes after the ack are already COBS
+      resyncEvents += extractCobsFrames(
+        ringBuffer.read(ringBuffer.length),
+        frames,
+      );
+    }
+  }
+
   const syncFrames: WorkerOutbound["syncFrames"] = [];
+  const packets: any[] = [];
+  for (const frame of frames) {
+    if (frame[0] === 0x25) {
+      const meta = extractSyncFrameMeta(frame);
+      if (meta) syncFrames.push(meta);
+    }
+
+    const parsed = IMUParser.parseSingleFrame(
+      new DataView(frame.buffer, frame.byteOffset, frame.byteLength),
+    );
+    for (const packet of parsed) {
+      // Stream position for credit reconciliation (SerialConnection)
+      if ((packet as any).type === "gateway_serial_diag") {
+        (packet as any).syncFramesBefore = syncFrames.length;
+      }
+    }
+    if (parsed.length > 0) packets.push(...parsed);
+  }
+
+  return {
+    type: "parsed",
+    packets,
+    stats: {
+      chunkBytes: chunk.length,
+      framesExtracted: frames.length,
+      resyncEvents,
+      overflowEvents: overflow.events,
+      overflowBytes: overflow.bytes,
+      ringLength: ringBuffer.length,
+      framing,
+      rawAsciiPreview,
+    },
+    syncFrames,
+  };
+}
+
+// COBS: every bad frame counts as one resync event
+function extractCobsFrames(bytes: Uint8Array, frames: Uint8Array[]): number {
+  const badBefore = cobsDecoder.badFrames;
+  cobsDecoder.push(bytes, frames);
+  // Acks are sent in legacy framing, so a gateway back in legacy mode shows
+  // up here as a run of bad frames
+  if (cobsDecoder.lostFraming) {
+    framing = "legacy";
+    cobsDecoder.reset();
+  }
+  return cobsDecoder.badFrames - badBefore;
+}
+
+// Legacy length-prefixed frames from ringBuffer; stops after a COBS ack
+function extractLegacyFrames(frames: Uint8Array[]): number {
   let resyncAttempts = 0;
   let resyncEvents = 0;
 
@@ -110,35 +211,15 @@ function handleChunk(chunk: Uint8Array): WorkerOutbound {
     ringBuffer.skip(2);
     const frame = ringBuffer.read(frameLen);
     frames.push(frame);
-    if (packetType === 0x25) {
-      const meta = extractSyncFrameMeta(frame);
-      if (meta) syncFrames.push(meta);
-    }
     resyncAttempts = 0;
+    if (packetType === 0x06 && parseFramingAck(frame) === "cobs") {
+      framing = "cobs";
+      cobsDecoder.reset();
+      break;
+    }
   }
 
-  const packets: any[] = [];
-  for (const frame of frames) {
-    const parsed = IMUParser.parseSingleFrame(
-      new DataView(frame.buffer, frame.byteOffset, frame.byteLength),
-    );
-    if (parsed.length > 0) packets.push(...parsed);
-  }
-
-  return {
-    type: "parsed",
-    packets,
-    stats: {
-      chunkBytes: chunk.length,
-      framesExtracted: frames.length,
-      resyncEvents,
-      overflowEvents: overflow.events,
-      overflowBytes: overflow.bytes,
-      ringLength: ringBuffer.length,
-      rawAsciiPreview,
-    },
-    syncFrames,
-  };
+  return resyncEvents;
 }
 
 function getAsciiPreview(chunk: Uint8Array): string | undefined {
@@ -207,12 +288,27 @@ function extractSyncFrameMeta(frame: Uint8Array): {
   }
 
   const validSensorIds: number[] = [];
+  let enviroRecords = 0;
+  let correctionRecords = 0;
   for (let s = 0; s < sensorCount; s++) {
     const offset = headerSize + s * sensorSize;
     const sensorId = view.getUint8(offset);
     const flags = view.getUint8(offset + 13);
     const isValid = (flags & 0x01) !== 0;
 
+    // Multi-rate mag/baro records are not IMU sensors
+    if (flags & 0x04) {
+      enviroRecords++;
+      continue;
+    }
+
+    // Late real samples for an earlier frame (0x08): not part of this
+    // frame's sensor set, same as IMUParser
+    if (flags & 0x08) {
+      correctionRecords++;
+      continue;
+    }
+
     // PIPELINE FIX: Removed duplicate quaternion magnitude check.
     // IMUParser already performs this check with proper diagnostic counters.
     // Having it here silently excluded sensors from validSensorIds, making
@@ -221,7 +317,12 @@ function extractSyncFrameMeta(frame: Uint8Array): {
     if (isValid) validSensorIds.push(sensorId);
   }
 
-  return { frameNumber, timestampUs, sensorCount, validSensorIds };
+  return {
+    frameNumber,
+    timestampUs,
+    sensorCount: sensorCount - enviroRecords - correctionRecords,
+    validSensorIds,
+  };
 }
 
 self.onmessage = (event: MessageEvent<WorkerInbound>) => {
@@ -42,6 +42,9 @@ export interface IMUDataPacket {
   /** S1-FIX: Sensor's local index within its node (0-based).
    *  Combined with rawNodeId, uniquely identifies a physical sensor. */
   localSensorIndex?: number;
+  /** Synthesized by the Gateway's gap fill from this sensor's recent
+   *  samples (0x25 flag 0x02); the real sample never made the frame. */
+  interpolated?: boolean;
   /** OPP-2: Frame completeness metadata */
   frameCompleteness?: {
     validCount: number;
@@ -74,6 +77,12 @@ export interface BarometerData {
 /** Low-frequency environmental sensor packet (magnetometer + barometer) */
 export interface EnvironmentalDataPacket {
   timestamp: number;
+  /** Gateway sync timestamp, when carried inline in a 0x25 sync frame */
+  timestampUs?: number;
+  /** Sensor ID of the reporting node's first sensor (0x25 only) */
+  sensorId?: number;
+  /** Physical node ID (0x25 only) */
+  rawNodeId?: number;
   magnetometer?: MagnetometerData;
   barometer?: BarometerData;
 }
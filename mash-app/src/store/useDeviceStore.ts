@@ -229,9 +229,9 @@ export const useDeviceStore = create<DeviceState>((set, get) => {
           if (serialStartup) {
             // In serial mode the gateway prints unframed boot logs until START.
             // Send START early so subsequent command responses stay cleanly framed.
+            // USB flow control: SerialConnection grants frame credits itself.
             await connectionManager.sendCommand("START");
             await new Promise((r) => setTimeout(r, 100));
-            await connectionManager.sendCommand("RESUME");
             connectionManager
               .sendCommand("GET_PENDING_NODES")
               .catch((e) =>